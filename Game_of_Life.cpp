@@ -7,13 +7,24 @@
  * @date March, 2020
  */
 
+#include <algorithm>
+#include <climits>
+#include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
 
 // Uses cxxopts from https://github.com/jarro2783/cxxopts under the MIT license
 #include "cxxopts/cxxopts.hxx"
 
+#include "checkpointer.h"
+#include "control_channel.h"
+#include "frame_writer.h"
+#include "gpu_world.h"
 #include "grid.h"
+#include "rule.h"
+#include "snapshot.h"
+#include "stats.h"
 #include "world.h"
 #include "zoo.h"
 
@@ -26,9 +37,25 @@ int main(int argc, char *argv[]) {
     options.add_options()
             ("f,file", "Load an ascii file from the provided path.",  cxxopts::value<std::string>())
             ("o,output", "Save an ascii file to the provided path.",  cxxopts::value<std::string>())
+            ("crop", "Crop the file saved by --output to the smallest box holding every alive cell, or to a single dead cell if none are alive.", cxxopts::value<bool>()->default_value("false"))
             ("s,steps","The number of steps to simulate the world.", cxxopts::value<int>()->default_value("10"))
+            ("g,generation", "Run until the world reaches generation N, instead of for --steps steps.", cxxopts::value<std::uint64_t>())
+            ("seconds", "Stop early once the run has taken T seconds of wall-clock time. 0 disables it.", cxxopts::value<double>()->default_value("0"))
+            ("headless", "Print no boards, only the generation, population and speed, for worlds too large to print.", cxxopts::value<bool>()->default_value("false"))
+            ("control", "Read commands from stdin while running: status, snapshot, snapshot <path>, stop and help.", cxxopts::value<bool>()->default_value("false"))
             ("e,every","Print world to the console every N steps. 0 disables printing.", cxxopts::value<int>()->default_value("0"))
+            ("frames", "Record the worlds printed by --every to the provided path instead, as a recording of their differences.", cxxopts::value<std::string>())
             ("t,toroidal", "Simulate the Game of Life on a torus.", cxxopts::value<bool>()->default_value("false"))
+            ("r,rule", "The Life-like rule to simulate in B/S notation, such as B36/S23.", cxxopts::value<std::string>()->default_value("B3/S23"))
+            ("j,threads", "The number of threads to step the world with. 0 uses every core.", cxxopts::value<int>()->default_value("1"))
+            ("engine", "The engine to step the world with, either cpu or gpu.", cxxopts::value<std::string>()->default_value("cpu"))
+            ("stats", "Write the step and file statistics to the provided path, once per --every steps and at the end.", cxxopts::value<std::string>())
+            ("stats-format", "The format of --stats, either json for JSON lines or prometheus for the final totals as Prometheus text.", cxxopts::value<std::string>()->default_value("json"))
+            ("checkpoint", "Save checkpoints to files starting with the provided path, on its own thread, and at the end.", cxxopts::value<std::string>())
+            ("checkpoint-every", "Also save a checkpoint every N generations. 0 disables it.", cxxopts::value<int>()->default_value("0"))
+            ("checkpoint-seconds", "Also save a checkpoint every T seconds. 0 disables it.", cxxopts::value<double>()->default_value("0"))
+            ("checkpoint-format", "The format of --checkpoint, either snapshot or binary for .bgol.", cxxopts::value<std::string>()->default_value("snapshot"))
+            ("resume", "Resume from the latest checkpoint saved with the provided path, and run until generation --steps.", cxxopts::value<std::string>())
             ("h,help", "Print usage.");
 
     // Actually parse the command line arguments
@@ -44,6 +71,13 @@ int main(int argc, char *argv[]) {
     const int  steps    = result["steps"].as<int>();
     const int  every    = result["every"].as<int>();
     const bool toroidal = result["toroidal"].as<bool>();
+    const int  threads  = result["threads"].as<int>();
+    const bool headless = result["headless"].as<bool>();
+    const double budget = result["seconds"].as<double>();
+    if (budget < 0) {
+        std::cerr << "The number of seconds cannot be negative." << std::endl;
+        std::exit(-1);
+    }
 
     // Start with an empty grid
     Grid grid;
@@ -59,34 +93,369 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    // Construct a world from the parsed grid
+    // Construct a world from the parsed grid, or from the latest checkpoint at its generation and rule
+    if (result.count("file") && result.count("resume")) {
+        std::cerr << "Only one of --file and --resume can be given." << std::endl;
+        std::exit(-1);
+    }
     World world(grid);
+    if (result.count("resume")) {
+        try {
+            world = Checkpointer::resume(result["resume"].as<std::string>());
+        }
+        catch (const std::exception &ex) {
+            std::cerr << ex.what() << std::endl;
+            std::exit(-1);
+        }
+    }
+
+    // Spread each step across the requested number of threads
+    if (threads < 0) {
+        std::cerr << "The number of threads cannot be negative." << std::endl;
+        std::exit(-1);
+    }
+    world.set_threads((unsigned int) threads);
+
+    // Step with the requested rule instead of Conway's Game of Life, a resumed world keeps its own rule
+    try {
+        if (!result.count("resume")) {
+            world.set_rule(Rule(result["rule"].as<std::string>()));
+        }
+    }
+    catch (const std::exception &ex) {
+        std::cerr << ex.what() << std::endl;
+        std::exit(-1);
+    }
+
+    // Console output is formatted and written on its own thread, so printing never holds up the simulation
+    FrameWriter console(std::cout);
+
+    // Frames can be recorded to a file as binary deltas rather than printed
+    std::ofstream frames_file;
+    std::unique_ptr<FrameWriter> recorded_frames;
+    if (result.count("frames")) {
+        frames_file.open(result["frames"].as<std::string>(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!frames_file) {
+            std::cerr << "The path given for --frames cannot be opened." << std::endl;
+            std::exit(-1);
+        }
+        recorded_frames.reset(new FrameWriter(frames_file, FrameWriter::DELTA));
+    }
+    FrameWriter& frames = recorded_frames ? *recorded_frames : console;
+
+    // Statistics can be appended as JSON lines while the world runs, or written once at the end for Prometheus
+    std::ofstream stats_file;
+    const std::string stats_format = result["stats-format"].as<std::string>();
+    if (stats_format != "json" && stats_format != "prometheus") {
+        std::cerr << "The format given for --stats-format must be json or prometheus." << std::endl;
+        std::exit(-1);
+    }
+    if (result.count("stats")) {
+        stats_file.open(result["stats"].as<std::string>(), std::ios::out | std::ios::trunc);
+        if (!stats_file) {
+            std::cerr << "The path given for --stats cannot be opened." << std::endl;
+            std::exit(-1);
+        }
+    }
+
+    // Checkpoints are copied and handed to a writer thread, so saving them never stalls the simulation
+    std::unique_ptr<Checkpointer> checkpoints;
+    const std::string checkpoint_format = result["checkpoint-format"].as<std::string>();
+    if (checkpoint_format != "snapshot" && checkpoint_format != "binary") {
+        std::cerr << "The format given for --checkpoint-format must be snapshot or binary." << std::endl;
+        std::exit(-1);
+    }
+    if (result["checkpoint-every"].as<int>() < 0 || result["checkpoint-seconds"].as<double>() < 0) {
+        std::cerr << "The checkpoint intervals cannot be negative." << std::endl;
+        std::exit(-1);
+    }
+    if (result.count("checkpoint")) {
+        checkpoints.reset(new Checkpointer(result["checkpoint"].as<std::string>(),
+                                           checkpoint_format == "binary" ? Checkpointer::BINARY : Checkpointer::SNAPSHOT));
+        checkpoints->set_interval((std::uint64_t) result["checkpoint-every"].as<int>(),
+                                  result["checkpoint-seconds"].as<double>());
+    }
+
+    // The GPU engine keeps the world on the device, and only copies it back for the states that are printed
+    const std::string engine = result["engine"].as<std::string>();
+    if (engine != "cpu" && engine != "gpu") {
+        std::cerr << "The engine given for --engine must be cpu or gpu." << std::endl;
+        std::exit(-1);
+    }
+#if GOL_WITH_CUDA
+    std::unique_ptr<GpuWorld> gpu_world;
+    if (engine == "gpu") {
+        try {
+            gpu_world.reset(new GpuWorld(world.get_state()));
+            gpu_world->set_rule(world.get_rule());
+            gpu_world->set_generation(world.get_generation());
+        }
+        catch (const std::exception &ex) {
+            std::cerr << ex.what() << std::endl;
+            std::exit(-1);
+        }
+    }
+#else
+    if (engine == "gpu") {
+        std::cerr << "The gpu engine is not built into this program, build it with -DGOL_WITH_CUDA=1." << std::endl;
+        std::exit(-1);
+    }
+#endif
+
+    // Print the initial state of the grid, or only its population when headless
+    console.write("Initial state...\nAlive " + std::to_string(world.get_alive_cells()) +
+                  " | Dead " + std::to_string(world.get_dead_cells()) + "\n");
+    if (!headless) {
+        console.write(world.get_state());
+        console.write("\n");
+    }
+
+    // Commands typed while running are read on their own thread, and answered between steps
+    std::unique_ptr<ControlChannel> control;
+    if (result["control"].as<bool>()) {
+        control.reset(new ControlChannel(0));
+    }
 
-    // Print the initial state of the grid
-    std::cout << "Initial state..." << std::endl
-              << "Alive " << world.get_alive_cells() << " | Dead " << world.get_dead_cells()  << std::endl
-              << world.get_state() << std::endl;
+    // The generation, population and state of whichever engine is running
+    auto current_generation = [&]() -> std::uint64_t {
+#if GOL_WITH_CUDA
+        if (gpu_world) {
+            return gpu_world->get_generation();
+        }
+#endif
+        return world.get_generation();
+    };
+    auto current_alive_cells = [&]() -> std::uint64_t {
+#if GOL_WITH_CUDA
+        if (gpu_world) {
+            return gpu_world->get_alive_cells();
+        }
+#endif
+        return world.get_alive_cells();
+    };
+    auto current_state = [&]() -> Grid {
+#if GOL_WITH_CUDA
+        if (gpu_world) {
+            return gpu_world->get_state();
+        }
+#endif
+        return world.get_state();
+    };
+    const std::uint64_t total_cells = (std::uint64_t) world.get_width() * world.get_height();
+    const Stats::Clock::time_point run_start = Stats::Clock::now();
+    auto format_status = [&]() {
+        const std::uint64_t alive_cells = current_alive_cells();
+        return "Generation " + std::to_string(current_generation()) + " | Alive " + std::to_string(alive_cells) +
+               " | Dead " + std::to_string(total_cells - alive_cells) + " | Seconds " +
+               std::to_string(Stats::get_seconds(run_start, Stats::Clock::now())) + "\n";
+    };
+
+    // Answer every waiting command, returning true if the run should stop
+    auto answer_commands = [&]() {
+        bool stop = false;
+        for (const std::string& command : control->take_commands()) {
+            if (command == "status") {
+                console.write(format_status());
+            } else if (command == "snapshot") {
+                if (!checkpoints) {
+                    console.write("The snapshot command needs --checkpoint, or a path to save to.\n");
+                    continue;
+                }
+                // A failed save is reported and the run carries on, rather than ending it
+                try {
+                    checkpoints->checkpoint(current_state(), current_generation(), world.get_rule());
+                    console.write("Checkpoint of generation " + std::to_string(current_generation()) + " queued.\n");
+                }
+                catch (const std::exception &ex) {
+                    console.write("Could not save a checkpoint: " + std::string(ex.what()) + "\n");
+                }
+            } else if (command.compare(0, 9, "snapshot ") == 0) {
+                const std::string path = command.substr(9);
+                try {
+                    Snapshot::save(path, current_state(), current_generation(), world.get_rule().get_name());
+                    console.write("Saved generation " + std::to_string(current_generation()) + " to " + path + "\n");
+                }
+                catch (const std::exception &ex) {
+                    console.write("Could not save " + path + ": " + std::string(ex.what()) + "\n");
+                }
+            } else if (command == "stop") {
+                console.write("Stopping at generation " + std::to_string(current_generation()) + "\n");
+                stop = true;
+            } else if (command == "help") {
+                console.write("Commands: status, snapshot, snapshot <path>, stop and help.\n");
+            } else {
+                console.write("Unknown command: " + command + "\n");
+            }
+        }
+        return stop;
+    };
+
+    // Run until the target generation, carrying on from the generation of a resumed world
+    const std::uint64_t target = result.count("generation") ? result["generation"].as<std::uint64_t>()
+                                                            : (std::uint64_t) std::max(steps, 0);
+    const std::uint64_t first_generation = world.get_generation();
+    const std::uint64_t first_step = std::min(first_generation, target);
+    // A resumed run that has already reached the target ends on the checkpoint it was loaded from
+    bool saved_last = result.count("resume") && first_step >= target;
+    for (std::uint64_t step = first_step; step < target; step++) {
+#if GOL_WITH_CUDA
+        // Steps between printed states, checkpoints and commands are queued on the device together, without
+        // waiting, but every 64 steps they are waited on when commands or a time budget need the run to keep pace
+        if (gpu_world) {
+            const bool print = (every > 0) && (step % (std::uint64_t) every == 0);
+            const bool save = checkpoints && checkpoints->is_due(step + 1);
+            const bool command = control && control->has_commands();
+            saved_last = save;
+            try {
+                const bool poll = (budget > 0 || control) && ((step + 1) % 64 == 0);
+                if (print || save || command || poll || step == target - 1) {
+                    // GpuWorld::advance takes an unsigned int, so a longer run is queued in several calls
+                    while (gpu_world->get_generation() < step + 1) {
+                        gpu_world->advance((unsigned int) std::min<std::uint64_t>(step + 1 - gpu_world->get_generation(),
+                                                                                  UINT_MAX), toroidal);
+                    }
+                }
+                if (print && headless) {
+                    console.write(format_status());
+                } else if (print) {
+                    frames.write("Step " + std::to_string(step + 1) + " of " + std::to_string(target) + "\n");
+                    frames.write(gpu_world->get_state(), step + 1);
+                    frames.write("\n");
+                }
+                if (save) {
+                    checkpoints->checkpoint(gpu_world->get_state(), gpu_world->get_generation(), gpu_world->get_rule());
+                }
+                if (command && answer_commands()) {
+                    break;
+                }
+                // Counting the population waits on the queued steps, so the clock sees them finish
+                if (poll) {
+                    gpu_world->get_alive_cells();
+                    if (budget > 0 && Stats::get_seconds(run_start, Stats::Clock::now()) >= budget) {
+                        break;
+                    }
+                }
+            }
+            catch (const std::exception &ex) {
+                std::cerr << ex.what() << std::endl;
+                std::exit(-1);
+            }
+            continue;
+        }
+#endif
+        // Generations up to the next printed state, checkpoint or poll for commands and the time budget go in one
+        // call, so World::advance can block generations together and skip cycles
+        std::uint64_t end = target;
+        if (every > 0) {
+            end = std::min(end, step + 1 + ((std::uint64_t) every - step % (std::uint64_t) every) % (std::uint64_t) every);
+        }
+        if (checkpoints) {
+            end = std::min(end, checkpoints->get_next_due(step));
+        }
+        if (budget > 0 || control) {
+            end = std::min(end, step + 64 - step % 64);
+        }
+        end = std::min(end, step + UINT_MAX);
+        world.advance((unsigned int) (end - step), toroidal);
+        step = end - 1;
+        const bool print = (every > 0) && (step % (std::uint64_t) every == 0);
+        const bool save = checkpoints && checkpoints->is_due(end);
+        const bool command = control && control->has_commands();
+        saved_last = save;
+        if (save) {
+            try {
+                checkpoints->checkpoint(world);
+            }
+            catch (const std::exception &ex) {
+                std::cerr << ex.what() << std::endl;
+                std::exit(-1);
+            }
+        }
 
-    // Perform the requested number of update steps
-    for (int step = 0; step < steps; step++) {
-        world.step(toroidal);
+        // Print the state of the grid every N steps, or only its population when headless
+        if (print) {
+            if (headless) {
+                console.write(format_status());
+            } else {
+                frames.write("Step " + std::to_string(step + 1) + " of " + std::to_string(target) + "\n");
+                frames.write(world.get_state(), step + 1);
+                frames.write("\n");
+            }
+            if (stats_file.is_open() && stats_format == "json") {
+                stats_file << Stats::format_json(world.get_stats(), Zoo::get_io_stats(), world.get_generation());
+            }
+        }
 
-        // Print the state of the grid every N steps
-        if ((every > 0) && (step % every == 0)) {
-            std::cout << "Step " << (step + 1) << " of " << steps << std::endl
-                      << world.get_state() << std::endl;
+        // Stop early when asked to, or when the time budget is spent
+        try {
+            if (command && answer_commands()) {
+                break;
+            }
+        }
+        catch (const std::exception &ex) {
+            std::cerr << ex.what() << std::endl;
+            std::exit(-1);
+        }
+        if (budget > 0 && Stats::get_seconds(run_start, Stats::Clock::now()) >= budget) {
+            break;
         }
     }
 
-    // Print the final state of the grid
-    std::cout << "Final state..." << std::endl
-              << "Alive " << world.get_alive_cells() << " | Dead " << world.get_dead_cells()  << std::endl
-              << world.get_state() << std::endl;
+#if GOL_WITH_CUDA
+    // Copy the final state back once, so the output below is the same for either engine
+    if (gpu_world) {
+        try {
+            World final_world(gpu_world->get_state());
+            final_world.set_rule(gpu_world->get_rule());
+            final_world.set_generation(gpu_world->get_generation());
+            std::swap(world, final_world);
+        }
+        catch (const std::exception &ex) {
+            std::cerr << ex.what() << std::endl;
+            std::exit(-1);
+        }
+    }
+#endif
 
-    // Attempt to save to the output directory if a path was given
+    // Print the final state of the grid, or only its generation, population and speed when headless
+    const double run_seconds = Stats::get_seconds(run_start, Stats::Clock::now());
+    console.write("Final state...\nAlive " + std::to_string(world.get_alive_cells()) +
+                  " | Dead " + std::to_string(world.get_dead_cells()) + "\n");
+    if (headless) {
+        const std::uint64_t run_steps = world.get_generation() - first_generation;
+        console.write("Generation " + std::to_string(world.get_generation()) + " | Steps " + std::to_string(run_steps) +
+                      " | Seconds " + std::to_string(run_seconds) + " | Cell updates per second " +
+                      std::to_string(run_seconds > 0 ? (double) run_steps * total_cells / run_seconds : 0.0) + "\n");
+    } else {
+        console.write(world.get_state());
+        console.write("\n");
+    }
+    try {
+        console.flush();
+        if (recorded_frames) {
+            recorded_frames->flush();
+        }
+    }
+    catch (const std::exception &ex) {
+        std::cerr << ex.what() << std::endl;
+        std::exit(-1);
+    }
+
+    // Attempt to save to the output directory if a path was given, cropped to the alive cells if asked
     if (result.count("output")) {
         try {
-            Zoo::save_ascii(result["output"].as<std::string>(), world.get_state());
+            if (result["crop"].as<bool>()) {
+                // An empty world is saved as one dead cell, since a 0x0 grid cannot be loaded back
+                const Grid::Summary summary = world.get_summary();
+                if (summary.alive_cells == 0) {
+                    Zoo::save_ascii(result["output"].as<std::string>(), Grid(1));
+                } else {
+                    Zoo::save_ascii(result["output"].as<std::string>(),
+                                    world.get_region((int) summary.x0, (int) summary.y0, (int) summary.x1, (int) summary.y1));
+                }
+            } else {
+                Zoo::save_ascii(result["output"].as<std::string>(), world.get_state());
+            }
         }
         catch (const std::exception &ex) {
             std::cerr << ex.what() << std::endl;
@@ -94,6 +463,34 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    // Save a final checkpoint unless the last step already saved one, and wait for every checkpoint to be written
+    if (checkpoints) {
+        try {
+            if (!saved_last) {
+                checkpoints->checkpoint(world);
+            }
+            checkpoints->flush();
+        }
+        catch (const std::exception &ex) {
+            std::cerr << ex.what() << std::endl;
+            std::exit(-1);
+        }
+    }
+
+    // Write the totals of the whole run
+    if (stats_file.is_open()) {
+        if (stats_format == "json") {
+            stats_file << Stats::format_json(world.get_stats(), Zoo::get_io_stats(), world.get_generation());
+        } else {
+            stats_file << Stats::format_prometheus(world.get_stats(), Zoo::get_io_stats(), world.get_generation());
+        }
+        stats_file.close();
+        if (!stats_file) {
+            std::cerr << "The path given for --stats cannot be written." << std::endl;
+            std::exit(-1);
+        }
+    }
+
     // Destructors handle all the memory deallocation
     return 0;
 }
@@ -0,0 +1,704 @@
+/**
+ * Run with -h or --help to print the usage message.
+ * i.e.
+ * ./Game_of_Life_benchmark --sizes 1024,4096 --output results.json
+ *
+ * Measures the throughput of the engines and the file formats, and reports every measurement as one JSON document
+ * so that runs can be compared between commits and machines.
+ *      - world:    World::step on random soups of each size, density, topology and thread count, and on a field of
+ *                  gliders and a lone R-pentomino, where most of the tiles are skipped.
+ *      - batch:    WorldBatch stepping thousands of 64x64 soups together.
+ *      - sparse:   SparseWorld running an R-pentomino and a 1024x1024 soup on the unbounded plane.
+ *      - hashlife: HashLife jumping an R-pentomino and a light weight spaceship a million generations.
+ *      - grid:     Grid::rotate and Grid::transpose of soups of each size.
+ *      - io:       Saving and loading a soup as ascii, binary, rle and a snapshot.
+ *
+ * A measurement repeats a burst of work until --min-time has passed and reports the mean. Cell updates count every
+ * cell of the world in every generation, including the cells of tiles the engine skipped, so they measure the
+ * effective throughput of an engine rather than the work it did. Memory is the size of the state an engine holds,
+ * alongside the peak resident set size of the whole process so far.
+ *
+ * A case that cannot run, such as a 65536x65536 world on a machine without the memory for it, is reported with an
+ * "error" field instead of its measurements, and the remaining cases still run.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+// Uses cxxopts from https://github.com/jarro2783/cxxopts under the MIT license
+#include "cxxopts/cxxopts.hxx"
+
+#include "grid.h"
+#include "hashlife.h"
+#include "kernel.h"
+#include "snapshot.h"
+#include "sparse_world.h"
+#include "world.h"
+#include "world_batch.h"
+#include "zoo.h"
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * The number of iterations of a burst of work and the time they took, excluding any setup between them.
+     */
+    struct Timing {
+        std::uint64_t iterations = 0;
+        double seconds = 0.0;
+    };
+
+    /**
+     * measure(min_time, setup, run)
+     *
+     * Call setup and then run until the calls to run have taken at least min_time seconds, timing only run.
+     */
+    template<typename Setup, typename Run>
+    Timing measure(double min_time, Setup setup, Run run) {
+        Timing timing;
+        do {
+            setup();
+            Clock::time_point start = Clock::now();
+            run();
+            timing.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+            timing.iterations++;
+        } while (timing.seconds < min_time);
+        return timing;
+    }
+
+    template<typename Run>
+    Timing measure(double min_time, Run run) {
+        return measure(min_time, [] {}, run);
+    }
+
+    std::string quote(const std::string& text) {
+        std::string quoted = "\"";
+        for (char character : text) {
+            if (character == '"' || character == '\\') {
+                quoted += '\\';
+                quoted += character;
+            } else if ((unsigned char) character < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned int) (unsigned char) character);
+                quoted += escaped;
+            } else {
+                quoted += character;
+            }
+        }
+        return quoted + "\"";
+    }
+
+    /**
+     * A JSON object built one field at a time, in the order the fields are added.
+     */
+    class Record {
+    private:
+        std::string fields;
+
+        Record& add_field(const std::string& name, const std::string& value) {
+            fields += (fields.empty() ? "" : ", ") + quote(name) + ": " + value;
+            return *this;
+        }
+    public:
+        Record& add_string(const std::string& name, const std::string& value) {
+            return add_field(name, quote(value));
+        }
+
+        Record& add_count(const std::string& name, std::uint64_t value) {
+            return add_field(name, std::to_string(value));
+        }
+
+        Record& add_number(const std::string& name, double value) {
+            char number[32];
+            std::snprintf(number, sizeof(number), "%.6g", value);
+            return add_field(name, number);
+        }
+
+        Record& add_flag(const std::string& name, bool value) {
+            return add_field(name, value ? "true" : "false");
+        }
+
+        std::string str() const {
+            return "{" + fields + "}";
+        }
+    };
+
+    std::uint64_t get_peak_memory() {
+#if defined(__unix__) || defined(__APPLE__)
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#if defined(__APPLE__)
+            return (std::uint64_t) usage.ru_maxrss;
+#else
+            return (std::uint64_t) usage.ru_maxrss * 1024;
+#endif
+        }
+#endif
+        return 0;
+    }
+
+    std::uint64_t get_grid_bytes(const Grid& grid) {
+        return (std::uint64_t) grid.get_row_words() * grid.get_height() * sizeof(std::uint64_t);
+    }
+
+    /**
+     * Add the rates of a measurement of cells × generations cell updates to a record.
+     */
+    void add_rates(Record& record, const Timing& timing, std::uint64_t cells, std::uint64_t generations) {
+        double updates = (double) cells * (double) generations;
+        record.add_count("generations", generations)
+              .add_number("seconds", timing.seconds)
+              .add_number("cell_updates_per_second", updates / timing.seconds)
+              .add_number("ns_per_cell", timing.seconds * 1e9 / updates);
+    }
+
+    /**
+     * Add the file rates of a measurement that read or wrote a file of the given size each iteration to a record.
+     */
+    void add_file_rates(Record& record, const Timing& timing, std::uint64_t bytes, std::uint64_t cells) {
+        double seconds = timing.seconds / (double) timing.iterations;
+        record.add_count("file_bytes", bytes)
+              .add_number("seconds", seconds)
+              .add_number("mb_per_second", (double) bytes / 1e6 / seconds)
+              .add_number("cells_per_second", (double) cells / seconds);
+    }
+
+    /**
+     * make_soup(width, height, density, seed)
+     *
+     * Fill a grid at random so that each cell is alive with the given probability, rounded to a multiple of 1/256.
+     * Each word combines 8 random words, one per bit of the probability from the lowest: OR with a random word
+     * moves the chance of each bit halfway to 1, and AND moves it halfway to 0.
+     */
+    Grid make_soup(unsigned int width, unsigned int height, double density, std::uint64_t seed) {
+        unsigned int probability = (unsigned int) (density * 256.0 + 0.5);
+        Grid grid(width, height);
+        std::mt19937_64 random(seed);
+        std::uint64_t padding = (width % 64) ? (((std::uint64_t) 1 << (width % 64)) - 1) : ~(std::uint64_t) 0;
+        for (unsigned int y = 0; y < height; y++) {
+            std::uint64_t* row = grid.get_row(y);
+            for (unsigned int k = 0; k < grid.get_row_words(); k++) {
+                std::uint64_t word = 0;
+                if (probability >= 256) {
+                    word = ~(std::uint64_t) 0;
+                } else {
+                    for (unsigned int bit = 0; bit < 8; bit++) {
+                        word = ((probability >> bit) & 1) ? (word | random()) : (word & random());
+                    }
+                }
+                row[k] = word;
+            }
+            row[grid.get_row_words() - 1] &= padding;
+        }
+        return grid;
+    }
+
+    /**
+     * Fill a grid with gliders every 16 cells in each direction.
+     */
+    Grid make_glider_field(unsigned int width, unsigned int height) {
+        Grid grid(width, height);
+        Grid glider = Zoo::glider();
+        std::vector<Grid::Placement> placements;
+        for (unsigned int y = 0; y + glider.get_height() <= height; y += 16) {
+            for (unsigned int x = 0; x + glider.get_width() <= width; x += 16) {
+                placements.push_back({&glider, (int) x, (int) y, 0});
+            }
+        }
+        grid.stamp(placements, Grid::OR, Grid::CLIP, 0);
+        return grid;
+    }
+
+    /**
+     * Place a single R-pentomino in the middle of an empty grid.
+     */
+    Grid make_centred(unsigned int width, unsigned int height, const Grid& pattern) {
+        Grid grid(width, height);
+        grid.merge(pattern, (int) ((width - pattern.get_width()) / 2), (int) ((height - pattern.get_height()) / 2));
+        return grid;
+    }
+
+    std::vector<double> parse_list(const std::string& list, const std::string& option) {
+        std::vector<double> values;
+        std::stringstream stream(list);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            std::size_t end = 0;
+            double value = 0.0;
+            try {
+                value = std::stod(item, &end);
+            }
+            catch (const std::exception&) {
+                end = 0;
+            }
+            if (end == 0 || end != item.size() || value < 0.0) {
+                throw(std::invalid_argument("The value given for --" + option +
+                                            " is not a comma separated list of positive numbers."));
+            }
+            values.push_back(value);
+        }
+        if (values.empty()) {
+            throw(std::invalid_argument("The value given for --" + option + " is empty."));
+        }
+        return values;
+    }
+
+    /**
+     * The settings shared by every case, and the records of the cases that have run so far.
+     */
+    struct Benchmark {
+        double min_time;
+        unsigned int generations;
+        std::vector<std::string> results;
+
+        void add(const Record& record) {
+            results.push_back(record.str());
+        }
+
+        void add_error(Record record, const std::exception& ex) {
+            record.add_string("error", ex.what());
+            results.push_back(record.str());
+        }
+    };
+
+    /**
+     * Step a world in bursts of benchmark.generations from the given state, restarting from the state each time.
+     */
+    void run_world(Benchmark& benchmark, const Grid& grid, const std::string& pattern, double density,
+                   bool toroidal, unsigned int threads) {
+        Record record;
+        record.add_string("suite", "world")
+              .add_string("engine", "World")
+              .add_string("pattern", pattern);
+        if (density > 0.0) {
+            record.add_number("density", density);
+        }
+        record.add_count("width", grid.get_width())
+              .add_count("height", grid.get_height())
+              .add_flag("toroidal", toroidal);
+        try {
+            std::unique_ptr<World> world;
+            Timing timing = measure(benchmark.min_time,
+                    [&] {
+                        world.reset();
+                        world.reset(new World(grid));
+                        world->set_threads(threads);
+                    },
+                    [&] {
+                        for (unsigned int step = 0; step < benchmark.generations; step++) {
+                            world->step(toroidal);
+                        }
+                    });
+            record.add_count("threads", world->get_threads())
+                  .add_string("kernel", world->get_kernel_name());
+            add_rates(record, timing, (std::uint64_t) grid.get_width() * grid.get_height(),
+                      timing.iterations * benchmark.generations);
+            record.add_count("active_tiles", world->get_active_tiles())
+                  .add_count("tiles", world->get_tile_count())
+                  .add_count("memory_bytes", 2 * get_grid_bytes(grid))
+                  .add_count("peak_rss_bytes", get_peak_memory());
+            benchmark.add(record);
+        }
+        catch (const std::exception& ex) {
+            benchmark.add_error(record, ex);
+        }
+    }
+
+    void run_world_suite(Benchmark& benchmark, const std::vector<double>& sizes, const std::vector<double>& densities,
+                         const std::vector<double>& threads) {
+        for (double size : sizes) {
+            unsigned int side = (unsigned int) size;
+            std::vector<std::pair<std::string, double>> patterns;
+            for (double density : densities) {
+                patterns.push_back(std::make_pair("soup", density));
+            }
+            patterns.push_back(std::make_pair("glider_field", 0.0));
+            patterns.push_back(std::make_pair("r_pentomino", 0.0));
+
+            for (const auto& pattern : patterns) {
+                Grid grid;
+                try {
+                    if (pattern.first == "soup") {
+                        grid = make_soup(side, side, pattern.second, side);
+                    } else if (pattern.first == "glider_field") {
+                        grid = make_glider_field(side, side);
+                    } else {
+                        grid = make_centred(side, side, Zoo::r_pentomino());
+                    }
+                }
+                catch (const std::exception& ex) {
+                    Record record;
+                    record.add_string("suite", "world")
+                          .add_string("pattern", pattern.first)
+                          .add_count("width", side)
+                          .add_count("height", side);
+                    benchmark.add_error(record, ex);
+                    continue;
+                }
+                for (bool toroidal : {false, true}) {
+                    for (double thread_count : threads) {
+                        run_world(benchmark, grid, pattern.first, pattern.second, toroidal,
+                                  (unsigned int) thread_count);
+                    }
+                }
+            }
+        }
+    }
+
+    void run_batch_suite(Benchmark& benchmark, const std::vector<double>& densities,
+                         const std::vector<double>& threads) {
+        const unsigned int count = 4096;
+        const unsigned int side = 64;
+        for (double density : densities) {
+            for (bool toroidal : {false, true}) {
+                for (double thread_count : threads) {
+                    Record record;
+                    record.add_string("suite", "batch")
+                          .add_string("engine", "WorldBatch")
+                          .add_string("pattern", "soup")
+                          .add_number("density", density)
+                          .add_count("worlds", count)
+                          .add_count("width", side)
+                          .add_count("height", side)
+                          .add_flag("toroidal", toroidal);
+                    try {
+                        WorldBatch initial(count, side, side);
+                        for (unsigned int instance = 0; instance < count; instance++) {
+                            initial.set_state(instance, make_soup(side, side, density, instance));
+                        }
+                        initial.set_threads((unsigned int) thread_count);
+                        WorldBatch batch = initial;
+                        Timing timing = measure(benchmark.min_time,
+                                [&] { batch = initial; },
+                                [&] { batch.advance(benchmark.generations, toroidal); });
+                        record.add_count("threads", batch.get_threads())
+                              .add_string("kernel", Kernel::get_isa_name(batch.get_kernel()));
+                        add_rates(record, timing, (std::uint64_t) count * side * side,
+                                  timing.iterations * benchmark.generations);
+                        record.add_count("settled_worlds", batch.get_settled_count())
+                              .add_count("memory_bytes", (std::uint64_t) 2 * ((count + 63) / 64) * side * side *
+                                                         sizeof(std::uint64_t))
+                              .add_count("peak_rss_bytes", get_peak_memory());
+                        benchmark.add(record);
+                    }
+                    catch (const std::exception& ex) {
+                        benchmark.add_error(record, ex);
+                    }
+                }
+            }
+        }
+    }
+
+    void run_sparse_suite(Benchmark& benchmark) {
+        const unsigned int soup_side = 1024;
+        for (const std::string pattern : {"r_pentomino", "soup"}) {
+            Record record;
+            record.add_string("suite", "sparse")
+                  .add_string("engine", "SparseWorld")
+                  .add_string("pattern", pattern);
+            try {
+                Grid grid = (pattern == "soup") ? make_soup(soup_side, soup_side, 0.25, soup_side)
+                                                : Zoo::r_pentomino();
+                unsigned int generations = (pattern == "soup") ? benchmark.generations : 1024;
+                SparseWorld world;
+                Timing timing = measure(benchmark.min_time,
+                        [&] { world = SparseWorld(grid); },
+                        [&] { world.advance(generations); });
+                record.add_count("generations", timing.iterations * generations)
+                      .add_number("seconds", timing.seconds)
+                      .add_number("generations_per_second", (double) (timing.iterations * generations) /
+                                                            timing.seconds);
+                if (pattern == "soup") {
+                    record.add_number("density", 0.25)
+                          .add_number("cell_updates_per_second", (double) soup_side * soup_side *
+                                                                 (double) (timing.iterations * generations) /
+                                                                 timing.seconds);
+                }
+                record.add_count("alive_cells", world.get_alive_cells())
+                      .add_count("chunks", world.get_chunk_count())
+                      .add_count("peak_rss_bytes", get_peak_memory());
+                benchmark.add(record);
+            }
+            catch (const std::exception& ex) {
+                benchmark.add_error(record, ex);
+            }
+        }
+    }
+
+    void run_hashlife_suite(Benchmark& benchmark) {
+        const std::uint64_t generations = 1 << 20;
+        for (const std::string pattern : {"r_pentomino", "light_weight_spaceship"}) {
+            Record record;
+            record.add_string("suite", "hashlife")
+                  .add_string("engine", "HashLife")
+                  .add_string("pattern", pattern);
+            try {
+                Grid grid = (pattern == "r_pentomino") ? Zoo::r_pentomino() : Zoo::light_weight_spaceship();
+                std::unique_ptr<HashLife> life;
+                Timing timing = measure(benchmark.min_time,
+                        [&] {
+                            life.reset();
+                            life.reset(new HashLife(grid));
+                        },
+                        [&] { life->advance(generations); });
+                record.add_count("generations", timing.iterations * generations)
+                      .add_number("seconds", timing.seconds)
+                      .add_number("generations_per_second", (double) (timing.iterations * generations) /
+                                                            timing.seconds)
+                      .add_count("alive_cells", life->get_alive_cells())
+                      .add_count("nodes", life->get_node_count())
+                      .add_count("peak_rss_bytes", get_peak_memory());
+                benchmark.add(record);
+            }
+            catch (const std::exception& ex) {
+                benchmark.add_error(record, ex);
+            }
+        }
+    }
+
+    void run_grid_suite(Benchmark& benchmark, const std::vector<double>& sizes) {
+        for (double size : sizes) {
+            unsigned int side = (unsigned int) size;
+            for (const std::string operation : {"rotate_90", "rotate_180", "transpose"}) {
+                Record record;
+                record.add_string("suite", "grid")
+                      .add_string("operation", operation)
+                      .add_count("width", side)
+                      .add_count("height", side);
+                try {
+                    Grid grid = make_soup(side, side, 0.5, side);
+                    Grid result;
+                    Timing timing = measure(benchmark.min_time,
+                            [&] { result = Grid(); },
+                            [&] {
+                                if (operation == "rotate_90") {
+                                    result = grid.rotate(1);
+                                } else if (operation == "rotate_180") {
+                                    result = grid.rotate(2);
+                                } else {
+                                    result = grid.transpose();
+                                }
+                            });
+                    double seconds = timing.seconds / (double) timing.iterations;
+                    record.add_number("seconds", seconds)
+                          .add_number("cells_per_second", (double) side * side / seconds)
+                          .add_number("ns_per_cell", seconds * 1e9 / ((double) side * side))
+                          .add_count("memory_bytes", 2 * get_grid_bytes(grid))
+                          .add_count("peak_rss_bytes", get_peak_memory());
+                    benchmark.add(record);
+                }
+                catch (const std::exception& ex) {
+                    benchmark.add_error(record, ex);
+                }
+            }
+        }
+    }
+
+    std::uint64_t get_file_size(const std::string& path) {
+        std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+        return file ? (std::uint64_t) file.tellg() : 0;
+    }
+
+    void run_io_suite(Benchmark& benchmark, unsigned int side, const std::string& directory,
+                      const std::vector<double>& threads) {
+        Grid grid;
+        try {
+            grid = make_soup(side, side, 0.25, side);
+        }
+        catch (const std::exception& ex) {
+            Record record;
+            record.add_string("suite", "io")
+                  .add_count("width", side)
+                  .add_count("height", side);
+            benchmark.add_error(record, ex);
+            return;
+        }
+        const std::uint64_t cells = (std::uint64_t) side * side;
+
+        std::vector<std::pair<std::string, unsigned int>> formats = {
+                {"ascii", 1}, {"binary", 1}, {"rle", 1}};
+        for (double thread_count : threads) {
+            unsigned int count = (unsigned int) thread_count;
+            formats.push_back(std::make_pair("snapshot", count ? count : std::max(1u, std::thread::hardware_concurrency())));
+        }
+
+        for (const auto& format : formats) {
+            const std::string path = directory + "/Game_of_Life_benchmark." + format.first;
+            for (const std::string operation : {"save", "load"}) {
+                Record record;
+                record.add_string("suite", "io")
+                      .add_string("format", format.first)
+                      .add_string("operation", operation)
+                      .add_count("width", side)
+                      .add_count("height", side);
+                if (format.first == "snapshot") {
+                    record.add_count("threads", format.second);
+                }
+                try {
+                    Grid loaded;
+                    Timing timing = measure(benchmark.min_time, [&] {
+                        if (operation == "save") {
+                            if (format.first == "ascii") {
+                                Zoo::save_ascii(path, grid);
+                            } else if (format.first == "binary") {
+                                Zoo::save_binary(path, grid);
+                            } else if (format.first == "rle") {
+                                Zoo::save_rle(path, grid);
+                            } else {
+                                Snapshot::save(path, grid, 0, "B3/S23", format.second);
+                            }
+                        } else {
+                            if (format.first == "ascii") {
+                                loaded = Zoo::load_ascii(path);
+                            } else if (format.first == "binary") {
+                                loaded = Zoo::load_binary(path);
+                            } else if (format.first == "rle") {
+                                loaded = Zoo::load_rle(path);
+                            } else {
+                                loaded = Snapshot::load(path, format.second);
+                            }
+                        }
+                    });
+                    add_file_rates(record, timing, get_file_size(path), cells);
+                    benchmark.add(record);
+                }
+                catch (const std::exception& ex) {
+                    benchmark.add_error(record, ex);
+                }
+            }
+            std::remove(path.c_str());
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    cxxopts::Options options("Game_of_Life_benchmark",
+            "This program measures the throughput of the Game of Life engines and file formats, reported as JSON.");
+
+    // Declare the valid command line arguments and their types and default values.
+    options.add_options()
+            ("suites", "The comma separated suites to run, from world, batch, sparse, hashlife, grid and io.", cxxopts::value<std::string>()->default_value("world,batch,sparse,hashlife,grid,io"))
+            ("sizes", "The comma separated side lengths of the square worlds and grids to measure.", cxxopts::value<std::string>()->default_value("1024,4096,16384,65536"))
+            ("densities", "The comma separated chances of a cell being alive in the random soups.", cxxopts::value<std::string>()->default_value("0.05,0.25,0.5"))
+            ("j,threads", "The comma separated thread counts to step the worlds with. 0 uses every core.", cxxopts::value<std::string>()->default_value("1,0"))
+            ("g,generations", "The number of generations in each timed burst of steps.", cxxopts::value<int>()->default_value("16"))
+            ("min-time", "The minimum number of seconds to repeat each measurement for.", cxxopts::value<double>()->default_value("0.5"))
+            ("io-size", "The side length of the soup saved and loaded by the io suite.", cxxopts::value<int>()->default_value("4096"))
+            ("dir", "The directory to write the temporary files of the io suite to.", cxxopts::value<std::string>()->default_value("."))
+            ("o,output", "Save the JSON report to the provided path instead of printing it.", cxxopts::value<std::string>())
+            ("h,help", "Print usage.");
+
+    // Actually parse the command line arguments
+    auto result = options.parse(argc, argv);
+
+    // Print the help usage for this program
+    if (result.count("help")) {
+        std::cout << options.help() << std::endl;
+        std::exit(0);
+    }
+
+    // Parse the (potentially defaulted) parameters for this run
+    std::vector<double> sizes;
+    std::vector<double> densities;
+    std::vector<double> threads;
+    try {
+        sizes = parse_list(result["sizes"].as<std::string>(), "sizes");
+        densities = parse_list(result["densities"].as<std::string>(), "densities");
+        threads = parse_list(result["threads"].as<std::string>(), "threads");
+    }
+    catch (const std::exception &ex) {
+        std::cerr << ex.what() << std::endl;
+        std::exit(-1);
+    }
+    for (double size : sizes) {
+        if (size < 16.0 || size > 65536.0) {
+            std::cerr << "The sizes must be between 16 and 65536." << std::endl;
+            std::exit(-1);
+        }
+    }
+    for (double density : densities) {
+        if (density > 1.0) {
+            std::cerr << "The densities must be between 0 and 1." << std::endl;
+            std::exit(-1);
+        }
+    }
+
+    const int    generations = result["generations"].as<int>();
+    const double min_time    = result["min-time"].as<double>();
+    const int    io_size     = result["io-size"].as<int>();
+    if (generations < 1 || io_size < 1 || min_time < 0.0) {
+        std::cerr << "The generations and io size must be positive, and the minimum time cannot be negative." << std::endl;
+        std::exit(-1);
+    }
+
+    // Run each requested suite in turn
+    Benchmark benchmark;
+    benchmark.min_time = min_time;
+    benchmark.generations = (unsigned int) generations;
+
+    std::string suites = "," + result["suites"].as<std::string>() + ",";
+    auto wants = [&suites](const std::string& suite) { return suites.find("," + suite + ",") != std::string::npos; };
+    if (wants("world")) {
+        run_world_suite(benchmark, sizes, densities, threads);
+    }
+    if (wants("batch")) {
+        run_batch_suite(benchmark, densities, threads);
+    }
+    if (wants("sparse")) {
+        run_sparse_suite(benchmark);
+    }
+    if (wants("hashlife")) {
+        run_hashlife_suite(benchmark);
+    }
+    if (wants("grid")) {
+        run_grid_suite(benchmark, sizes);
+    }
+    if (wants("io")) {
+        run_io_suite(benchmark, (unsigned int) io_size, result["dir"].as<std::string>(), threads);
+    }
+
+    // Write the report, with one result per line so that runs can also be compared with diff
+    std::ostringstream report;
+    Record machine;
+    machine.add_string("kernel", Kernel::get_isa_name(Kernel::detect_isa()))
+           .add_count("hardware_threads", std::thread::hardware_concurrency());
+    report << "{\n  \"benchmark\": \"Game_of_Life\",\n  \"machine\": " << machine.str()
+           << ",\n  \"min_time\": " << min_time << ",\n  \"generations\": " << generations << ",\n  \"results\": [";
+    for (std::size_t i = 0; i < benchmark.results.size(); i++) {
+        report << (i ? ",\n    " : "\n    ") << benchmark.results[i];
+    }
+    report << "\n  ]\n}\n";
+
+    if (result.count("output")) {
+        std::ofstream output(result["output"].as<std::string>(), std::ios::out | std::ios::trunc);
+        output << report.str();
+        if (!output) {
+            std::cerr << "The path given for --output cannot be written." << std::endl;
+            std::exit(-1);
+        }
+    } else {
+        std::cout << report.str();
+    }
+
+    return 0;
+}
@@ -0,0 +1,448 @@
+/**
+ * Implements a class that saves periodic checkpoints of a simulation on its own thread.
+ *      - A checkpoint is taken by copying the state into a waiting grid, which is all the simulation waits for.
+ *        Saving happens on a writer thread, so a long run is never paused to serialise a huge grid.
+ *          - The state is double buffered: the writer swaps the waiting grid with the grid it last wrote, so the
+ *            next checkpoint copies into storage that is already allocated.
+ *          - If a checkpoint is taken while the last is still waiting to be written, it replaces it, so only
+ *            the newest state is ever written and a slow disk cannot hold up the simulation.
+ *
+ *      - Checkpoints are saved in the binary .bgol format or as compressed snapshots, see zoo.cpp and snapshot.cpp.
+ *          - Each checkpoint is written to "<prefix>.<generation>.bgol" or "<prefix>.<generation>.gsnap" through a
+ *            temporary file, which is renamed once it is complete.
+ *          - The index "<prefix>.latest" then names the file, its generation and its rule, and is replaced the
+ *            same way, so it always names a complete checkpoint.
+ *          - On POSIX systems each temporary file is synced to disk before it is renamed, and the directory after,
+ *            so the index still names a complete checkpoint after a crash or a power loss.
+ *          - A checkpoint that cannot be written, such as on a full disk, is reported by the next call rather
+ *            than ending the run, and its temporary file is removed.
+ *          - Only the newest few checkpoints are kept, and older files are removed once the index has moved on.
+ *
+ *      - Checkpointer::resume constructs a World from the checkpoint named by the index, at its generation and rule.
+ *
+ *      - Checkpoints can be taken every N generations, every T seconds, or both. Checkpointer::advance steps a
+ *        World in chunks that end on each due generation.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include "checkpointer.h"
+#include "snapshot.h"
+#include "zoo.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // With only a time interval, Checkpointer::advance reads the clock after chunks of this many generations.
+    const std::uint64_t CLOCK_STEPS = 64;
+
+    /**
+     * Wait for a file, or a directory opened as one, to reach the disk. Returns false if it could not be synced.
+     */
+    bool sync_path(const std::string& path, bool directory){
+#if defined(__unix__) || defined(__APPLE__)
+        int descriptor = ::open(path.c_str(), directory ? O_RDONLY : O_RDWR);
+        if(descriptor < 0){
+            return false;
+        }
+        bool synced = fsync(descriptor) == 0;
+        return ::close(descriptor) == 0 && synced;
+#else
+        (void) path;
+        (void) directory;
+        return true;
+#endif
+    }
+
+    /**
+     * Move a complete temporary file over its final path, replacing any file already there.
+     * The file is synced before it is renamed, and the directory holding it after, so the rename is durable.
+     */
+    void replace(const std::string& temporary, const std::string& path){
+        if(!sync_path(temporary, false) || std::rename(temporary.c_str(), path.c_str()) != 0){
+            std::remove(temporary.c_str());
+            throw(std::runtime_error("The file: '" + path + "' cannot be written."));
+        }
+        std::size_t slash = path.find_last_of('/');
+        std::string directory = (slash == std::string::npos) ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+        if(!sync_path(directory, true)){
+            throw(std::runtime_error("The file: '" + path + "' cannot be written."));
+        }
+    }
+}
+
+/**
+ * Checkpointer::Checkpointer(prefix, format, keep)
+ *
+ * Start a writer thread for checkpoints saved to files starting with a prefix.
+ * No checkpoints are taken until one is asked for or set_interval is called.
+ *
+ * @example
+ *
+ *      // Run for a long time, saving a snapshot every million generations or every ten minutes
+ *      Checkpointer checkpoints("runs/soup");
+ *      checkpoints.set_interval(1000000, 600.0);
+ *      checkpoints.advance(world, 1000000000, true);
+ *      checkpoints.flush();
+ *
+ *      // After a crash, carry on from the last complete checkpoint
+ *      World world = Checkpointer::resume("runs/soup");
+ *
+ * @param prefix
+ *      The path of the checkpoint files, without the generation and extension.
+ *
+ * @param format
+ *      The format of the checkpoint files, Checkpointer::SNAPSHOT by default.
+ *
+ * @param keep
+ *      The number of newest checkpoint files to keep, at least 1.
+ */
+Checkpointer::Checkpointer(const std::string& prefix, Format format, unsigned int keep):
+        prefix(prefix), format(format), keep(std::max(keep, 1u)), last_time(Clock::now()){
+    writer = std::thread(&Checkpointer::work, this);
+}
+
+/**
+ * Checkpointer::~Checkpointer()
+ *
+ * Write the waiting checkpoint, if any, and join the writer thread. Call flush first to find out whether
+ * every checkpoint was written.
+ */
+Checkpointer::~Checkpointer(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    queued.notify_all();
+    writer.join();
+}
+
+/**
+ * Checkpointer::set_interval(generations, seconds)
+ *
+ * Choose how often checkpoints are due.
+ *
+ * @param generations
+ *      A checkpoint is due at every generation that is a multiple of this. 0 does not checkpoint by generation.
+ *
+ * @param seconds
+ *      Optional parameter. A checkpoint is due once this many seconds have passed since the last one, or since
+ *      the Checkpointer was constructed. 0 does not checkpoint by time, which is the default.
+ */
+void Checkpointer::set_interval(std::uint64_t generations, double seconds){
+    std::lock_guard<std::mutex> lock(mutex);
+    every_generations = generations;
+    every_seconds = seconds;
+}
+
+/**
+ * Checkpointer::set_threads(new_threads)
+ *
+ * Choose how many threads the writer compresses snapshots with, 0 uses every core. Defaults to 1, so the
+ * writer takes one core from the simulation.
+ *
+ * @param new_threads
+ *      The number of threads passed to Snapshot::save.
+ */
+void Checkpointer::set_threads(unsigned int new_threads){
+    std::lock_guard<std::mutex> lock(mutex);
+    threads = new_threads;
+}
+
+/**
+ * Checkpointer::get_next_due(generation)
+ *
+ * Find the first generation after the given one that a run should stop at to check Checkpointer::is_due,
+ * which is the next multiple of the generation interval, or a few generations on when there is a time interval.
+ * The function should be callable from a constant context.
+ *
+ * @param generation
+ *      The current generation.
+ *
+ * @return
+ *      The generation to stop at next, or the largest std::uint64_t if no checkpoints are ever due.
+ */
+std::uint64_t Checkpointer::get_next_due(std::uint64_t generation) const{
+    std::uint64_t next = UINT64_MAX;
+    if(every_generations > 0){
+        next = generation + every_generations - generation % every_generations;
+    }
+    if(every_seconds > 0.0){
+        next = std::min(next, generation + CLOCK_STEPS);
+    }
+    return next;
+}
+
+/**
+ * Checkpointer::is_due(generation)
+ *
+ * Check whether a checkpoint of a generation is due, at a multiple of the generation interval or once the time
+ * interval has passed. A generation that was the last checkpoint is never due again.
+ * The function should be callable from a constant context.
+ *
+ * @param generation
+ *      The generation of the state that would be checkpointed.
+ *
+ * @return
+ *      True if a checkpoint should be taken.
+ */
+bool Checkpointer::is_due(std::uint64_t generation) const{
+    if(checkpointed && generation == last_generation){
+        return false;
+    }
+    if(every_generations > 0 && generation % every_generations == 0){
+        return true;
+    }
+    return every_seconds > 0.0 && std::chrono::duration<double>(Clock::now() - last_time).count() >= every_seconds;
+}
+
+/**
+ * Checkpointer::checkpoint(state, generation, rule)
+ *
+ * Copy a state to be written as a checkpoint, and return without waiting for it to be written.
+ * The state can be changed as soon as this returns.
+ *
+ * @param state
+ *      The grid to checkpoint.
+ *
+ * @param generation
+ *      The generation of the grid, which names the file and is restored by resume.
+ *
+ * @param rule
+ *      The rule the grid is being stepped with, which is restored by resume.
+ *
+ * @throws
+ *      std::runtime_error if an earlier checkpoint could not be written.
+ */
+void Checkpointer::checkpoint(const Grid& state, std::uint64_t generation, const Rule& rule){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!error.empty()){
+            throw(std::runtime_error("Checkpointer::checkpoint error: " + error));
+        }
+        // Copying into the grid of an earlier checkpoint of the same size only copies the words.
+        waiting = state;
+        waiting_generation = generation;
+        waiting_rule = rule.get_name();
+        has_waiting = true;
+        checkpointed = true;
+        last_generation = generation;
+        last_time = Clock::now();
+    }
+    queued.notify_one();
+}
+
+/**
+ * Checkpointer::checkpoint(world)
+ *
+ * Copy the state of a world to be written as a checkpoint, with its generation and rule.
+ *
+ * @param world
+ *      The world to checkpoint.
+ *
+ * @throws
+ *      std::runtime_error if an earlier checkpoint could not be written.
+ */
+void Checkpointer::checkpoint(const World& world){
+    checkpoint(world.get_state(), world.get_generation(), world.get_rule());
+}
+
+/**
+ * Checkpointer::advance(world, steps, toroidal)
+ *
+ * Advance a world with World::advance, taking a checkpoint whenever one is due. The world is advanced in
+ * chunks that end on each multiple of the generation interval, so large chunks keep the speed of advance.
+ *
+ * @param world
+ *      The world to advance.
+ *
+ * @param steps
+ *      The number of steps to advance the world forward.
+ *
+ * @param toroidal
+ *      Optional parameter. If true then the world is stepped as a torus. Defaults to false.
+ *
+ * @throws
+ *      std::runtime_error if an earlier checkpoint could not be written.
+ */
+void Checkpointer::advance(World& world, unsigned int steps, bool toroidal){
+    std::uint64_t target = world.get_generation() + steps;
+    while(world.get_generation() < target){
+        std::uint64_t chunk = std::min(target, get_next_due(world.get_generation())) - world.get_generation();
+        world.advance((unsigned int) chunk, toroidal);
+        if(is_due(world.get_generation())){
+            checkpoint(world);
+        }
+    }
+}
+
+/**
+ * Checkpointer::flush()
+ *
+ * Wait until the waiting checkpoint, if any, has been written.
+ *
+ * @throws
+ *      std::runtime_error if any checkpoint could not be written.
+ */
+void Checkpointer::flush(){
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this]{ return !has_waiting && !writing; });
+    if(!error.empty()){
+        throw(std::runtime_error("Checkpointer::flush error: " + error));
+    }
+}
+
+/**
+ * Checkpointer::get_index_path(prefix)
+ *
+ * Gets the path of the index naming the newest complete checkpoint with a prefix.
+ *
+ * @return
+ *      The prefix followed by ".latest".
+ */
+std::string Checkpointer::get_index_path(const std::string& prefix){
+    return prefix + ".latest";
+}
+
+/**
+ * Checkpointer::resume(prefix)
+ *
+ * Load the newest complete checkpoint with a prefix, as named by its index.
+ *
+ * @param prefix
+ *      The prefix the checkpoints were written with.
+ *
+ * @return
+ *      A world of the checkpointed state, at its generation and stepped with its rule.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if:
+ *          - There is no index for the prefix.
+ *          - The index ends unexpectedly, or its generation or rule cannot be read.
+ *          - The checkpoint cannot be loaded, under the same conditions as Zoo::load_binary or Snapshot::load.
+ */
+World Checkpointer::resume(const std::string& prefix){
+    std::string index_path = get_index_path(prefix);
+    std::ifstream index(index_path);
+    if(!index){
+        throw(std::runtime_error("The path given to function: Checkpointer::resume is incorrect."));
+    }
+    std::string path, generation_line, rule_line;
+    if(!std::getline(index, path) || !std::getline(index, generation_line) || !std::getline(index, rule_line)){
+        throw(std::runtime_error("The file: '" + index_path + "' ends unexpectedly."));
+    }
+
+    std::uint64_t generation;
+    Rule rule;
+    try{
+        std::size_t end = 0;
+        generation = std::stoull(generation_line, &end);
+        if(end != generation_line.size()){
+            throw(std::invalid_argument(generation_line));
+        }
+        rule = Rule(rule_line);
+    } catch(const std::logic_error&){
+        throw(std::runtime_error("The file: '" + index_path + "' has an invalid generation or rule."));
+    }
+
+    bool binary = path.size() >= 5 && path.compare(path.size() - 5, 5, ".bgol") == 0;
+    World world(binary ? Zoo::load_binary(path) : Snapshot::load(path));
+    world.set_generation(generation);
+    world.set_rule(rule);
+    return world;
+}
+
+/**
+ * Checkpointer::work()
+ *
+ * Private helper function run by the writer thread, which writes each waiting checkpoint until the
+ * Checkpointer is destroyed and nothing is waiting. After the first failure nothing more is written.
+ */
+void Checkpointer::work(){
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true){
+        queued.wait(lock, [this]{ return stopping || has_waiting; });
+        if(!has_waiting){
+            return;
+        }
+        std::swap(waiting, in_progress);
+        std::uint64_t generation = waiting_generation;
+        std::string rule = waiting_rule;
+        unsigned int snapshot_threads = threads;
+        has_waiting = false;
+        writing = true;
+        bool skip = !error.empty();
+        lock.unlock();
+
+        std::string failure;
+        if(!skip){
+            try{
+                write_checkpoint(generation, rule, snapshot_threads);
+            } catch(const std::exception& ex){
+                failure = ex.what();
+            }
+        }
+
+        lock.lock();
+        writing = false;
+        if(!failure.empty()){
+            error = failure;
+        }
+        finished.notify_all();
+    }
+}
+
+/**
+ * Checkpointer::write_checkpoint(generation, rule, snapshot_threads)
+ *
+ * Private helper function run by the writer thread, which saves the grid it took from the queue, points the
+ * index at it, and removes the checkpoints older than the newest few.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if the checkpoint or the index cannot be written.
+ */
+void Checkpointer::write_checkpoint(std::uint64_t generation, const std::string& rule,
+                                    unsigned int snapshot_threads){
+    std::string path = prefix + "." + std::to_string(generation) + (format == BINARY ? ".bgol" : ".gsnap");
+    std::string temporary = path + ".tmp";
+    try{
+        if(format == BINARY){
+            Zoo::save_binary(temporary, in_progress);
+        } else{
+            Snapshot::save(temporary, in_progress, generation, rule, snapshot_threads);
+        }
+    }
+    catch(const std::exception&){
+        std::remove(temporary.c_str());
+        throw;
+    }
+    replace(temporary, path);
+
+    // The index only moves on once the checkpoint it names is complete.
+    std::string index_path = get_index_path(prefix);
+    std::ofstream index(index_path + ".tmp", std::ios::out | std::ios::trunc);
+    index << path << "\n" << generation << "\n" << rule << "\n";
+    index.close();
+    if(!index){
+        std::remove((index_path + ".tmp").c_str());
+        throw(std::runtime_error("The file: '" + index_path + ".tmp' cannot be written."));
+    }
+    replace(index_path + ".tmp", index_path);
+
+    if(written_paths.empty() || written_paths.back() != path){
+        written_paths.push_back(path);
+    }
+    while(written_paths.size() > keep){
+        std::remove(written_paths.front().c_str());
+        written_paths.pop_front();
+    }
+}
@@ -0,0 +1,86 @@
+/**
+ * Declares a class that saves periodic checkpoints of a simulation on its own thread.
+ * Rich documentation for the api and behaviour the Checkpointer class can be found in checkpointer.cpp.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "grid.h"
+#include "rule.h"
+#include "world.h"
+
+/**
+ * Declare the structure of the Checkpointer class for saving long runs without pausing them.
+ *
+ * A Checkpointer keeps two grids, one being written by its writer thread and one waiting to be written.
+ *      - Checkpointer::checkpoint only copies the state into the waiting grid and returns.
+ *      - The writer saves each checkpoint to a new file, then points an index file at it, so a crash at
+ *        any moment leaves the index naming a complete checkpoint that Checkpointer::resume can load.
+ */
+class Checkpointer {
+public:
+    /**
+     * The file formats a Checkpointer can write, the binary .bgol format or a compressed snapshot.
+     */
+    enum Format {
+        BINARY,
+        SNAPSHOT
+    };
+
+    /**
+     * The number of checkpoint files kept when none is given.
+     */
+    static const unsigned int DEFAULT_KEEP = 2;
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    std::string prefix;
+    Format format;
+    unsigned int keep;
+    unsigned int threads = 1;
+    std::uint64_t every_generations = 0;
+    double every_seconds = 0.0;
+    std::uint64_t last_generation = 0;
+    Clock::time_point last_time;
+    Grid waiting;
+    std::uint64_t waiting_generation = 0;
+    std::string waiting_rule;
+    Grid in_progress;
+    std::deque<std::string> written_paths;
+    std::mutex mutex;
+    std::condition_variable queued;
+    std::condition_variable finished;
+    bool checkpointed = false;
+    bool has_waiting = false;
+    bool writing = false;
+    bool stopping = false;
+    std::string error;
+    std::thread writer;
+
+    void work();
+    void write_checkpoint(std::uint64_t generation, const std::string& rule, unsigned int snapshot_threads);
+public:
+    explicit Checkpointer(const std::string& prefix, Format format = SNAPSHOT, unsigned int keep = DEFAULT_KEEP);
+    ~Checkpointer();
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+    void set_interval(std::uint64_t generations, double seconds = 0.0);
+    void set_threads(unsigned int new_threads);
+    std::uint64_t get_next_due(std::uint64_t generation) const;
+    bool is_due(std::uint64_t generation) const;
+    void checkpoint(const Grid& state, std::uint64_t generation, const Rule& rule);
+    void checkpoint(const World& world);
+    void advance(World& world, unsigned int steps, bool toroidal = false);
+    void flush();
+    static std::string get_index_path(const std::string& prefix);
+    static World resume(const std::string& prefix);
+};
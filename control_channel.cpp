@@ -0,0 +1,184 @@
+/**
+ * Implements a class that reads control commands for a running simulation on its own thread.
+ *      - Each line read is one command, with surrounding spaces and a trailing carriage return removed.
+ *        Empty lines are dropped. What the commands mean is left to the simulation.
+ *      - The reader waits on the descriptor with poll and a short timeout, so the destructor can stop and join it
+ *        even when nothing is ever written, and an interactive terminal, a pipe or a socket all work the same way.
+ *          - Without poll, on platforms other than unix, the reader blocks on std::cin and is detached
+ *            when the ControlChannel is destroyed instead.
+ *      - The end of the input closes the channel; commands already read can still be taken.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#include "control_channel.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#else
+#include <iostream>
+#endif
+
+namespace {
+    // How long the reader waits for input before checking whether it should stop, in milliseconds.
+    const int POLL_MILLISECONDS = 100;
+
+    /**
+     * trim(line)
+     *
+     * Remove the spaces, tabs and carriage returns around a line.
+     */
+    std::string trim(const std::string& line){
+        std::size_t first = line.find_first_not_of(" \t\r");
+        if(first == std::string::npos){
+            return std::string();
+        }
+        return line.substr(first, line.find_last_not_of(" \t\r") - first + 1);
+    }
+}
+
+/**
+ * ControlChannel::ControlChannel(descriptor)
+ *
+ * Start a reader thread for a file descriptor. The descriptor must stay open until the ControlChannel is
+ * destroyed, and is not closed by it.
+ *
+ * @example
+ *
+ *      // Stop a long run early when "stop" is typed
+ *      ControlChannel control(0);
+ *      bool stop = false;
+ *      while(!stop){
+ *          world.step();
+ *          if(control.has_commands()){
+ *              for(const std::string& command : control.take_commands()){
+ *                  stop = stop || command == "stop";
+ *              }
+ *          }
+ *      }
+ *
+ * @param descriptor
+ *      The file descriptor to read commands from, 0 for stdin by default.
+ */
+ControlChannel::ControlChannel(int descriptor) : descriptor(descriptor), pending(false), stopping(false),
+                                                 closed(false){
+    reader = std::thread(&ControlChannel::read_lines, this);
+}
+
+/**
+ * ControlChannel::~ControlChannel()
+ *
+ * Stop the reader thread, dropping any commands that have not been taken.
+ */
+ControlChannel::~ControlChannel(){
+    stopping = true;
+#if defined(__unix__) || defined(__APPLE__)
+    reader.join();
+#else
+    reader.detach();
+#endif
+}
+
+/**
+ * ControlChannel::read_lines()
+ *
+ * Private helper function run by the reader thread, queuing each line read until the input ends or the
+ * ControlChannel is destroyed.
+ */
+void ControlChannel::read_lines(){
+    std::string line;
+#if defined(__unix__) || defined(__APPLE__)
+    char buffer[4096];
+    while(!stopping){
+        pollfd request = {descriptor, POLLIN, 0};
+        int ready = poll(&request, 1, POLL_MILLISECONDS);
+        if(ready == 0 || (ready < 0 && errno == EINTR)){
+            continue;
+        } else if(ready < 0){
+            break;
+        }
+        ssize_t count = read(descriptor, buffer, sizeof(buffer));
+        if(count < 0 && (errno == EINTR || errno == EAGAIN)){
+            continue;
+        } else if(count <= 0){
+            break;
+        }
+        std::vector<std::string> lines;
+        for(ssize_t i = 0; i < count; i++){
+            if(buffer[i] != '\n'){
+                line += buffer[i];
+                continue;
+            }
+            if(!trim(line).empty()){
+                lines.push_back(trim(line));
+            }
+            line.clear();
+        }
+        if(!lines.empty()){
+            std::lock_guard<std::mutex> lock(mutex);
+            commands.insert(commands.end(), lines.begin(), lines.end());
+            pending = true;
+        }
+    }
+#else
+    while(!stopping && std::getline(std::cin, line)){
+        if(trim(line).empty()){
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        commands.push_back(trim(line));
+        pending = true;
+    }
+#endif
+    // A last line without a newline is still a command.
+    if(!stopping && !trim(line).empty()){
+        std::lock_guard<std::mutex> lock(mutex);
+        commands.push_back(trim(line));
+        pending = true;
+    }
+    closed = true;
+}
+
+/**
+ * ControlChannel::has_commands()
+ *
+ * Checks whether any commands are waiting to be taken, without taking the lock, so it is cheap enough to call
+ * after every step. The function should be callable from a constant context.
+ *
+ * @return
+ *      True if ControlChannel::take_commands would return at least one command.
+ */
+bool ControlChannel::has_commands() const{
+    return pending;
+}
+
+/**
+ * ControlChannel::is_closed()
+ *
+ * Checks whether the input has ended, after which no more commands will arrive.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      True once the reader has stopped reading.
+ */
+bool ControlChannel::is_closed() const{
+    return closed;
+}
+
+/**
+ * ControlChannel::take_commands()
+ *
+ * Take every command waiting, in the order they were read.
+ *
+ * @return
+ *      The waiting commands, which may be empty.
+ */
+std::vector<std::string> ControlChannel::take_commands(){
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> taken(commands.begin(), commands.end());
+    commands.clear();
+    pending = false;
+    return taken;
+}
@@ -0,0 +1,43 @@
+/**
+ * Declares a class that reads control commands for a running simulation on its own thread.
+ * Rich documentation for the api and behaviour the ControlChannel class can be found in control_channel.cpp.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Declare the structure of the ControlChannel class for steering a simulation while it runs.
+ *
+ * A reader thread waits on a file descriptor, such as 0 for stdin, and queues each line it reads as a command.
+ * The simulation checks ControlChannel::has_commands between steps, which is a single atomic load, and only
+ * takes the lock to collect the commands when there are some, so reading never interrupts the stepping threads.
+ */
+class ControlChannel {
+private:
+    int descriptor;
+    std::mutex mutex;
+    std::deque<std::string> commands;
+    std::atomic<bool> pending;
+    std::atomic<bool> stopping;
+    std::atomic<bool> closed;
+    std::thread reader;
+
+    void read_lines();
+public:
+    explicit ControlChannel(int descriptor = 0);
+    ~ControlChannel();
+    ControlChannel(const ControlChannel&) = delete;
+    ControlChannel& operator=(const ControlChannel&) = delete;
+    bool has_commands() const;
+    bool is_closed() const;
+    std::vector<std::string> take_commands();
+};
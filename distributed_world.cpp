@@ -0,0 +1,988 @@
+/**
+ * Implements a class representing a 2d grid world split across the ranks of an MPI job.
+ *      - Only built with GOL_WITH_MPI, for example:
+ *          - mpicxx -std=c++17 -O2 -DGOL_WITH_MPI=1 my_program.cpp checkpointer.cpp control_channel.cpp
+ *            distributed_world.cpp frame_writer.cpp grid.cpp grid_pool.cpp hashlife.cpp kernel.cpp mapped_file.cpp
+ *            recorder.cpp rule.cpp snapshot.cpp sparse_world.cpp stats.cpp thread_pool.cpp world.cpp
+ *            world_batch.cpp zoo.cpp -o my_program
+ *          - mpirun -n 16 ./my_program
+ *          - The Game_of_Life*.cpp drivers each define main, so only one driver is built with the library.
+ *
+ *      - The ranks are arranged in a 2d Cartesian topology, and each holds one block of the grid.
+ *          - Blocks start on multiples of 64 columns and 64 rows, so every rank needs at least 64 columns and
+ *            64 rows except those in the last column and row of the topology.
+ *          - The rows and columns of the topology are the factor pair of the number of ranks that fits the world
+ *            with the least border to exchange, so a wide world is split into more columns than rows. The
+ *            topology is chosen again whenever the world is resized.
+ *          - A toroidal world has a periodic topology, so the blocks on one edge neighbour the blocks on the
+ *            opposite edge. A bounded world has no neighbours past its edges, and its border stays dead.
+ *
+ *      - Each rank keeps its block in a Grid with a border of one cell on every side, holding the edge cells of
+ *        the eight neighbouring blocks.
+ *          - Each step sends the edge rows, the edge columns and the corner cells of the block to its neighbours
+ *            with non-blocking messages, and steps the interior rows, which need no border, while they travel.
+ *          - Once the border has arrived, the first and last rows and the first and last word of every other
+ *            row are stepped again with it.
+ *          - Each rank steps its block with the bit-parallel Kernel. Run one rank per core.
+ *
+ *      - Worlds can be loaded from and saved to the binary .bgol format and snapshots with parallel I/O, where each
+ *        rank reads and writes only its own block.
+ *          - Binary files are read and written with MPI-IO a row of the block at a time. Bytes shared by the rows
+ *            of two blocks are written by the rank holding their first cell, after the other rank sends its part.
+ *          - Snapshots are read with Snapshot::load_region, which only reads the tiles covering the block, and
+ *            written by the collective Snapshot::save, with tiles that line up with the blocks.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#if GOL_WITH_MPI
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include "distributed_world.h"
+#include "snapshot.h"
+
+namespace {
+    // The neighbours of a block, and the tag of the message sent towards each of them.
+    enum Direction {
+        NORTH,
+        SOUTH,
+        WEST,
+        EAST,
+        NORTH_WEST,
+        NORTH_EAST,
+        SOUTH_WEST,
+        SOUTH_EAST
+    };
+
+    const int OPPOSITE[8] = {SOUTH, NORTH, EAST, WEST, SOUTH_EAST, SOUTH_WEST, NORTH_EAST, NORTH_WEST};
+    const int ROW_OFFSET[8] = {-1, 1, 0, 0, -1, -1, 1, 1};
+    const int COLUMN_OFFSET[8] = {0, 0, -1, 1, -1, 1, -1, 1};
+
+    std::uint64_t get_bit(const std::uint64_t* row, unsigned int x){
+        return (row[x / 64] >> (x % 64)) & 1;
+    }
+
+    void set_bit(std::uint64_t* row, unsigned int x, std::uint64_t value){
+        row[x / 64] = (row[x / 64] & ~((std::uint64_t)1 << (x % 64))) | (value << (x % 64));
+    }
+
+    /**
+     * shift_in(in, in_words, out, out_words)
+     *
+     * Copy a row of a block into a row of the bordered grid, one cell to the right of where it started.
+     */
+    void shift_in(const std::uint64_t* in, unsigned int in_words, std::uint64_t* out, unsigned int out_words){
+        for(unsigned int k = 0; k < out_words; k++){
+            std::uint64_t word = (k < in_words) ? in[k] << 1 : 0;
+            if(k > 0 && k - 1 < in_words){
+                word |= in[k - 1] >> 63;
+            }
+            out[k] = word;
+        }
+    }
+
+    /**
+     * shift_out(in, in_words, out, out_words, out_width)
+     *
+     * Copy the cells of a row of the bordered grid, without its border, into a row of a block out_width wide.
+     */
+    void shift_out(const std::uint64_t* in, unsigned int in_words, std::uint64_t* out, unsigned int out_words,
+                   unsigned int out_width){
+        for(unsigned int k = 0; k < out_words; k++){
+            out[k] = (in[k] >> 1) | ((k + 1 < in_words) ? in[k + 1] << 63 : 0);
+        }
+        if(out_width % 64 != 0){
+            out[out_words - 1] &= ((std::uint64_t)1 << (out_width % 64)) - 1;
+        }
+    }
+
+    /**
+     * read_bits(bytes, size, bit)
+     *
+     * Read the 64 bits of a buffer starting at a bit offset, least significant bit of each byte first,
+     * with the bits past the end of the buffer read as 0.
+     */
+    std::uint64_t read_bits(const unsigned char* bytes, std::size_t size, std::uint64_t bit){
+        std::uint64_t word = 0;
+        std::size_t first = (std::size_t) (bit / 8);
+        unsigned int shift = (unsigned int) (bit % 8);
+        for(unsigned int b = 0; b < 9 && first + b < size; b++){
+            std::uint64_t byte = bytes[first + b];
+            if(b == 0){
+                word |= byte >> shift;
+            } else if(8 * b >= shift){
+                word |= (8 * b - shift < 64) ? byte << (8 * b - shift) : 0;
+            }
+        }
+        return word;
+    }
+
+    /**
+     * Read the 8 cells of a row of a block starting at column x, with the cells past the end of the row as 0.
+     */
+    std::uint64_t read_byte(const std::uint64_t* row, unsigned int words, unsigned int x){
+        std::uint64_t bits = row[x / 64] >> (x % 64);
+        if(x % 64 > 56 && x / 64 + 1 < words){
+            bits |= row[x / 64 + 1] << (64 - x % 64);
+        }
+        return bits & 0xFF;
+    }
+
+    bool read_at(MPI_File file, std::uint64_t offset, unsigned char* bytes, std::size_t size){
+        const std::size_t PIECE = (std::size_t) 1 << 30;
+        for(std::size_t done = 0; done < size; done += PIECE){
+            int count = (int) std::min(PIECE, size - done);
+            if(MPI_File_read_at(file, (MPI_Offset) (offset + done), bytes + done, count, MPI_BYTE,
+                                MPI_STATUS_IGNORE) != MPI_SUCCESS){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool write_at(MPI_File file, std::uint64_t offset, const unsigned char* bytes, std::size_t size){
+        const std::size_t PIECE = (std::size_t) 1 << 30;
+        for(std::size_t done = 0; done < size; done += PIECE){
+            int count = (int) std::min(PIECE, size - done);
+            if(MPI_File_write_at(file, (MPI_Offset) (offset + done), bytes + done, count, MPI_BYTE,
+                                 MPI_STATUS_IGNORE) != MPI_SUCCESS){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * choose_dims(ranks, width, height, dims)
+     *
+     * Choose the rows and columns of the topology from the factor pairs of the number of ranks that give every
+     * rank a block of a world, taking the pair with the fewest border cells and, between equals, the one with
+     * more rows, whose edges are whole rows. Returns false if no pair fits the world.
+     */
+    bool choose_dims(int ranks, unsigned int width, unsigned int height, int dims[2]){
+        std::uint64_t columns = ((std::uint64_t) width + 63) / 64;
+        std::uint64_t rows = ((std::uint64_t) height + 63) / 64;
+        bool found = false;
+        std::uint64_t best = 0;
+        for(int r = ranks; r >= 1; r--){
+            int c = ranks / r;
+            if(r * c != ranks || (std::uint64_t) r > rows || (std::uint64_t) c > columns){
+                continue;
+            }
+            std::uint64_t border = (std::uint64_t) r * width + (std::uint64_t) c * height;
+            if(!found || border < best){
+                found = true;
+                best = border;
+                dims[0] = r;
+                dims[1] = c;
+            }
+        }
+        return found;
+    }
+
+    /**
+     * Close a file opened collectively, and throw on every rank if the file could not be read or written on any.
+     */
+    void close_file(MPI_File& file, MPI_Comm comm, bool succeeded, const std::string& message){
+        MPI_File_close(&file);
+        int failed = succeeded ? 0 : 1;
+        int any_failed = 0;
+        MPI_Allreduce(&failed, &any_failed, 1, MPI_INT, MPI_MAX, comm);
+        if(any_failed){
+            throw(std::runtime_error(message));
+        }
+    }
+}
+
+/**
+ * DistributedWorld::DistributedWorld(comm, width, height, toroidal)
+ *
+ * Collectively construct a world of dead cells split across every rank of a communicator. Every rank of the
+ * communicator must call it at once, with the same arguments.
+ *
+ * @example
+ *
+ *      // Split a 65536x65536 torus across every rank of the job
+ *      DistributedWorld world(MPI_COMM_WORLD, 65536, 65536, true);
+ *
+ * @param comm
+ *      The communicator of the ranks to split the world across, which is duplicated into a Cartesian topology
+ *      shaped to the world.
+ *
+ * @param width
+ *      The width of the world.
+ *
+ * @param height
+ *      The height of the world.
+ *
+ * @param toroidal
+ *      Optional parameter. If true then the world is a torus, where the left edge wraps to the right edge and the
+ *      top to the bottom, and the topology of the ranks is periodic. Defaults to false.
+ *
+ * @throws
+ *      std::invalid_argument if the world is too small to give every rank a block.
+ */
+DistributedWorld::DistributedWorld(MPI_Comm comm, unsigned int width, unsigned int height, bool toroidal):
+        toroidal(toroidal){
+    MPI_Comm_dup(comm, &this->comm);
+    // No topology has been chosen yet.
+    dims[0] = 0;
+    dims[1] = 0;
+    try{
+        decompose(width, height, "DistributedWorld::DistributedWorld");
+    } catch(...){
+        MPI_Comm_free(&this->comm);
+        throw;
+    }
+}
+
+/**
+ * DistributedWorld::~DistributedWorld()
+ *
+ * Collectively free the topology of the world. Every rank must destroy its world at once.
+ */
+DistributedWorld::~DistributedWorld(){
+    MPI_Comm_free(&comm);
+}
+
+/**
+ * DistributedWorld::get_column_start(column)
+ *
+ * Private helper function that gets the first column of the world held by a column of the topology,
+ * or the width of the world for the column past the last.
+ */
+unsigned int DistributedWorld::get_column_start(int column) const{
+    std::uint64_t units = (width + 63) / 64;
+    return (unsigned int) std::min<std::uint64_t>(width, 64 * (units * (unsigned int) column / (unsigned int) dims[1]));
+}
+
+/**
+ * DistributedWorld::get_row_start(row)
+ *
+ * Private helper function that gets the first row of the world held by a row of the topology,
+ * or the height of the world for the row past the last.
+ */
+unsigned int DistributedWorld::get_row_start(int row) const{
+    std::uint64_t units = (height + 63) / 64;
+    return (unsigned int) std::min<std::uint64_t>(height, 64 * (units * (unsigned int) row / (unsigned int) dims[0]));
+}
+
+/**
+ * DistributedWorld::get_owner(x, y)
+ *
+ * Private helper function that gets the rank holding a cell of the world.
+ */
+int DistributedWorld::get_owner(unsigned int x, unsigned int y) const{
+    int owner_coords[2] = {0, 0};
+    while(owner_coords[0] + 1 < dims[0] && get_row_start(owner_coords[0] + 1) <= y){
+        owner_coords[0]++;
+    }
+    while(owner_coords[1] + 1 < dims[1] && get_column_start(owner_coords[1] + 1) <= x){
+        owner_coords[1]++;
+    }
+    int owner;
+    MPI_Cart_rank(comm, owner_coords, &owner);
+    return owner;
+}
+
+/**
+ * DistributedWorld::arrange(new_dims)
+ *
+ * Private helper function that replaces the communicator of the world with a Cartesian topology of the given
+ * rows and columns, and finds this rank and its neighbours in it. Every rank must call it at once.
+ */
+void DistributedWorld::arrange(const int new_dims[2]){
+    dims[0] = new_dims[0];
+    dims[1] = new_dims[1];
+    int periods[2] = {toroidal, toroidal};
+    MPI_Comm topology;
+    MPI_Cart_create(comm, 2, dims, periods, 1, &topology);
+    MPI_Comm_free(&comm);
+    comm = topology;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Cart_coords(comm, rank, 2, coords);
+
+    for(int d = 0; d < 8; d++){
+        int neighbour[2] = {coords[0] + ROW_OFFSET[d], coords[1] + COLUMN_OFFSET[d]};
+        bool outside = neighbour[0] < 0 || neighbour[0] >= dims[0] || neighbour[1] < 0 || neighbour[1] >= dims[1];
+        if(outside && !toroidal){
+            neighbours[d] = MPI_PROC_NULL;
+            continue;
+        }
+        neighbour[0] = (neighbour[0] + dims[0]) % dims[0];
+        neighbour[1] = (neighbour[1] + dims[1]) % dims[1];
+        MPI_Cart_rank(comm, neighbour, &neighbours[d]);
+    }
+}
+
+/**
+ * DistributedWorld::decompose(new_width, new_height, function)
+ *
+ * Private helper function that sizes the world and gives this rank an empty block of it, arranging the ranks
+ * into a new topology first when the shape of the world calls for different rows and columns.
+ * Every rank must call it at once.
+ *
+ * @throws
+ *      std::invalid_argument if the world is too small to give every rank a block, naming the calling function.
+ */
+void DistributedWorld::decompose(unsigned int new_width, unsigned int new_height, const char* function){
+    int ranks;
+    MPI_Comm_size(comm, &ranks);
+    int new_dims[2];
+    if(!choose_dims(ranks, new_width, new_height, new_dims)){
+        throw(std::invalid_argument(std::string(function) + " error: a world of " + std::to_string(new_width) +
+                                    "x" + std::to_string(new_height) + " cells cannot be split into " +
+                                    std::to_string(ranks) + " blocks of at least 64x64 cells."));
+    }
+    if(new_dims[0] != dims[0] || new_dims[1] != dims[1]){
+        arrange(new_dims);
+    }
+    width = new_width;
+    height = new_height;
+    x0 = get_column_start(coords[1]);
+    x1 = get_column_start(coords[1] + 1);
+    y0 = get_row_start(coords[0]);
+    y1 = get_row_start(coords[0] + 1);
+    current_state = Grid(x1 - x0 + 2, y1 - y0 + 2);
+    next_state = Grid(x1 - x0 + 2, y1 - y0 + 2);
+    for(int side = 0; side < 2; side++){
+        send_columns[side].assign((y1 - y0 + 63) / 64, 0);
+        receive_columns[side].assign((y1 - y0 + 63) / 64, 0);
+    }
+    local_alive_cells = 0;
+}
+
+/**
+ * DistributedWorld::count_local_cells()
+ *
+ * Private helper function that counts the alive cells of the block, whose border cells must be dead.
+ */
+void DistributedWorld::count_local_cells(){
+    local_alive_cells = 0;
+    for(unsigned int y = 1; y <= y1 - y0; y++){
+        local_alive_cells += Kernel::count_cells(current_state.get_row(y), 0, current_state.get_row_words(), kernel);
+    }
+}
+
+/**
+ * DistributedWorld::get_width()
+ *
+ * Gets the width of the whole world.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The width of the world.
+ */
+unsigned int DistributedWorld::get_width() const{
+    return width;
+}
+
+/**
+ * DistributedWorld::get_height()
+ *
+ * Gets the height of the whole world.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The height of the world.
+ */
+unsigned int DistributedWorld::get_height() const{
+    return height;
+}
+
+/**
+ * DistributedWorld::is_toroidal()
+ *
+ * Gets whether the world is a torus, which is fixed when it is constructed.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      True if the world wraps at its edges.
+ */
+bool DistributedWorld::is_toroidal() const{
+    return toroidal;
+}
+
+/**
+ * DistributedWorld::get_rank()
+ *
+ * Gets the rank of the calling process in the topology of the world, which is chosen again when the world is
+ * resized.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The rank, from 0 to get_ranks() - 1.
+ */
+int DistributedWorld::get_rank() const{
+    return rank;
+}
+
+/**
+ * DistributedWorld::get_ranks()
+ *
+ * Gets the number of ranks the world is split across.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The number of ranks.
+ */
+int DistributedWorld::get_ranks() const{
+    return dims[0] * dims[1];
+}
+
+/**
+ * DistributedWorld::get_block(block_x0, block_y0, block_x1, block_y1)
+ *
+ * Gets the cells of the world held by this rank, which like Grid::crop span the range [x0, x1) by [y0, y1).
+ * The function should be callable from a constant context.
+ */
+void DistributedWorld::get_block(unsigned int& block_x0, unsigned int& block_y0, unsigned int& block_x1,
+                                 unsigned int& block_y1) const{
+    block_x0 = x0;
+    block_y0 = y0;
+    block_x1 = x1;
+    block_y1 = y1;
+}
+
+/**
+ * DistributedWorld::get_block_state()
+ *
+ * Gets a copy of the cells of the block held by this rank, without its border.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      A grid the size of the block.
+ */
+Grid DistributedWorld::get_block_state() const{
+    Grid block(x1 - x0, y1 - y0);
+    for(unsigned int y = 0; y < y1 - y0; y++){
+        shift_out(current_state.get_row(y + 1), current_state.get_row_words(), block.get_row(y),
+                  block.get_row_words(), block.get_width());
+    }
+    return block;
+}
+
+/**
+ * DistributedWorld::set_block_state(block)
+ *
+ * Replace the cells of the block held by this rank.
+ *
+ * @param block
+ *      A grid the size of the block given by get_block.
+ *
+ * @throws
+ *      std::invalid_argument if the grid is not the size of the block.
+ */
+void DistributedWorld::set_block_state(const Grid& block){
+    if(block.get_width() != x1 - x0 || block.get_height() != y1 - y0){
+        throw(std::invalid_argument("DistributedWorld::set_block_state error: the block of this rank is " +
+                                    std::to_string(x1 - x0) + "x" + std::to_string(y1 - y0) + " cells."));
+    }
+    std::fill(current_state.get_row(0), current_state.get_row(0) + current_state.get_row_words(), 0);
+    std::fill(current_state.get_row(y1 - y0 + 1), current_state.get_row(y1 - y0 + 1) + current_state.get_row_words(), 0);
+    for(unsigned int y = 0; y < y1 - y0; y++){
+        shift_in(block.get_row(y), block.get_row_words(), current_state.get_row(y + 1), current_state.get_row_words());
+        set_bit(current_state.get_row(y + 1), x1 - x0 + 1, 0);
+    }
+    count_local_cells();
+}
+
+/**
+ * DistributedWorld::get_state()
+ *
+ * Collectively gather the whole world onto rank 0, for worlds small enough to fit on one node.
+ * Every rank must call it at once.
+ *
+ * @return
+ *      On rank 0, a grid of the whole world. On every other rank, an empty grid.
+ */
+Grid DistributedWorld::get_state() const{
+    Grid block = get_block_state();
+    int ranks = get_ranks();
+    int words = (int) ((std::size_t) block.get_row_words() * block.get_height());
+    std::vector<int> counts(rank == 0 ? ranks : 0);
+    MPI_Gather(&words, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, comm);
+
+    std::vector<int> displacements(counts.size(), 0);
+    std::vector<std::uint64_t> gathered;
+    if(rank == 0){
+        std::size_t total = 0;
+        for(int r = 0; r < ranks; r++){
+            displacements[r] = (int) total;
+            total += (std::size_t) counts[r];
+        }
+        gathered.resize(total);
+    }
+    MPI_Gatherv(block.get_height() ? block.get_row(0) : nullptr, words, MPI_UINT64_T, gathered.data(),
+                counts.data(), displacements.data(), MPI_UINT64_T, 0, comm);
+    if(rank != 0){
+        return Grid();
+    }
+
+    Grid state(width, height);
+    for(int r = 0; r < ranks; r++){
+        int block_coords[2];
+        MPI_Cart_coords(comm, r, 2, block_coords);
+        unsigned int bx0 = get_column_start(block_coords[1]), bx1 = get_column_start(block_coords[1] + 1);
+        unsigned int by0 = get_row_start(block_coords[0]), by1 = get_row_start(block_coords[0] + 1);
+        Grid other(bx1 - bx0, by1 - by0);
+        for(unsigned int y = 0; y < by1 - by0; y++){
+            std::memcpy(other.get_row(y), gathered.data() + displacements[r] + (std::size_t) y * other.get_row_words(),
+                        other.get_row_words() * sizeof(std::uint64_t));
+        }
+        state.merge(other, (int) bx0, (int) by0);
+    }
+    return state;
+}
+
+/**
+ * DistributedWorld::set_state(state)
+ *
+ * Resize the world to a grid held by every rank and take the block of this rank from it.
+ * Every rank must call it at once, with the same grid.
+ *
+ * @param state
+ *      The cells of the whole world.
+ *
+ * @throws
+ *      std::invalid_argument if the grid is too small to give every rank a block.
+ */
+void DistributedWorld::set_state(const Grid& state){
+    decompose(state.get_width(), state.get_height(), "DistributedWorld::set_state");
+    set_block_state(state.crop((int) x0, (int) y0, (int) x1, (int) y1));
+}
+
+/**
+ * DistributedWorld::get_alive_cells()
+ *
+ * Collectively count the alive cells of the whole world. Every rank must call it at once.
+ *
+ * @return
+ *      The number of alive cells on every rank.
+ */
+std::uint64_t DistributedWorld::get_alive_cells() const{
+    std::uint64_t total = 0;
+    MPI_Allreduce(&local_alive_cells, &total, 1, MPI_UINT64_T, MPI_SUM, comm);
+    return total;
+}
+
+/**
+ * DistributedWorld::get_kernel()
+ *
+ * Gets the instruction set used to step the block of this rank.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The instruction set, the best supported by this CPU unless set_kernel was called.
+ */
+Kernel::Isa DistributedWorld::get_kernel() const{
+    return kernel;
+}
+
+/**
+ * DistributedWorld::set_kernel(isa)
+ *
+ * Choose the instruction set used to step the block of this rank.
+ *
+ * @param isa
+ *      The instruction set of the kernel to use.
+ *
+ * @throws
+ *      std::invalid_argument if the kernel is not supported by this CPU or was not compiled into this binary.
+ */
+void DistributedWorld::set_kernel(Kernel::Isa isa){
+    if(!Kernel::is_supported(isa)){
+        throw(std::invalid_argument("DistributedWorld::set_kernel error: the " +
+                                    std::string(Kernel::get_isa_name(isa)) +
+                                    " kernel is not supported on this machine."));
+    }
+    kernel = isa;
+}
+
+/**
+ * DistributedWorld::get_rule()
+ *
+ * Gets the rule used to step the world, Conway's Game of Life "B3/S23" unless set_rule was called.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The rule of the world.
+ */
+const Rule& DistributedWorld::get_rule() const{
+    return rule;
+}
+
+/**
+ * DistributedWorld::set_rule(new_rule)
+ *
+ * Change the rule used by the following steps. Every rank must set the same rule.
+ *
+ * @param new_rule
+ *      The rule to step with.
+ */
+void DistributedWorld::set_rule(const Rule& new_rule){
+    rule = new_rule;
+}
+
+/**
+ * DistributedWorld::get_generation()
+ *
+ * Gets the number of steps the world has been stepped through, or the generation it was loaded at.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The generation of the world.
+ */
+std::uint64_t DistributedWorld::get_generation() const{
+    return generation;
+}
+
+/**
+ * DistributedWorld::set_generation(new_generation)
+ *
+ * Set the generation counter, such as when resuming from a file that does not store it.
+ *
+ * @param new_generation
+ *      The generation of the current state.
+ */
+void DistributedWorld::set_generation(std::uint64_t new_generation){
+    generation = new_generation;
+}
+
+/**
+ * DistributedWorld::step()
+ *
+ * Collectively take one step in the rule of the world. Every rank must call it at once.
+ *      - The edge rows, edge columns and corner cells of each block are sent to its neighbours, and the border
+ *        of the block is received from them, with non-blocking messages.
+ *      - The rows of the block that do not touch the top or bottom border are stepped while the messages travel.
+ *        Their first and last words are stepped again once the left and right border has arrived, along with
+ *        the first and last rows.
+ *      - The result is identical to stepping the whole world with World::step.
+ */
+void DistributedWorld::step(){
+    unsigned int block_width = x1 - x0;
+    unsigned int block_height = y1 - y0;
+    unsigned int row_words = current_state.get_row_words();
+    int column_words = (int) send_columns[0].size();
+
+    // Pack the edge columns and corners of the block for the neighbours to the sides.
+    std::fill(send_columns[0].begin(), send_columns[0].end(), 0);
+    std::fill(send_columns[1].begin(), send_columns[1].end(), 0);
+    for(unsigned int y = 0; y < block_height; y++){
+        const std::uint64_t* row = current_state.get_row(y + 1);
+        send_columns[0][y / 64] |= get_bit(row, 1) << (y % 64);
+        send_columns[1][y / 64] |= get_bit(row, block_width) << (y % 64);
+    }
+    std::uint64_t send_corners[4] = {
+        get_bit(current_state.get_row(1), 1), get_bit(current_state.get_row(1), block_width),
+        get_bit(current_state.get_row(block_height), 1), get_bit(current_state.get_row(block_height), block_width)
+    };
+
+    // Messages from a missing neighbour complete at once without writing, so the edges of a bounded world stay dead.
+    std::uint64_t receive_corners[4] = {0, 0, 0, 0};
+    std::fill(receive_columns[0].begin(), receive_columns[0].end(), 0);
+    std::fill(receive_columns[1].begin(), receive_columns[1].end(), 0);
+    std::fill(current_state.get_row(0), current_state.get_row(0) + row_words, 0);
+    std::fill(current_state.get_row(block_height + 1), current_state.get_row(block_height + 1) + row_words, 0);
+
+    // Each message is tagged with the direction it travels in, which tells apart the messages between two ranks
+    // that neighbour each other on more than one side.
+    MPI_Request requests[16];
+    int count = 0;
+    MPI_Irecv(current_state.get_row(0), (int) row_words, MPI_UINT64_T, neighbours[NORTH], SOUTH, comm,
+              &requests[count++]);
+    MPI_Irecv(current_state.get_row(block_height + 1), (int) row_words, MPI_UINT64_T, neighbours[SOUTH], NORTH,
+              comm, &requests[count++]);
+    MPI_Irecv(receive_columns[0].data(), column_words, MPI_UINT64_T, neighbours[WEST], EAST, comm,
+              &requests[count++]);
+    MPI_Irecv(receive_columns[1].data(), column_words, MPI_UINT64_T, neighbours[EAST], WEST, comm,
+              &requests[count++]);
+    for(int c = 0; c < 4; c++){
+        MPI_Irecv(&receive_corners[c], 1, MPI_UINT64_T, neighbours[NORTH_WEST + c], OPPOSITE[NORTH_WEST + c], comm,
+                  &requests[count++]);
+    }
+    MPI_Isend(current_state.get_row(1), (int) row_words, MPI_UINT64_T, neighbours[NORTH], NORTH, comm,
+              &requests[count++]);
+    MPI_Isend(current_state.get_row(block_height), (int) row_words, MPI_UINT64_T, neighbours[SOUTH], SOUTH, comm,
+              &requests[count++]);
+    MPI_Isend(send_columns[0].data(), column_words, MPI_UINT64_T, neighbours[WEST], WEST, comm, &requests[count++]);
+    MPI_Isend(send_columns[1].data(), column_words, MPI_UINT64_T, neighbours[EAST], EAST, comm, &requests[count++]);
+    for(int c = 0; c < 4; c++){
+        MPI_Isend(&send_corners[c], 1, MPI_UINT64_T, neighbours[NORTH_WEST + c], NORTH_WEST + c, comm,
+                  &requests[count++]);
+    }
+
+    // The interior rows only read rows of the block, which are not written by the messages.
+    if(block_height > 2){
+        Kernel::step_rows(current_state, next_state, 2, block_height, false, rule, kernel);
+    }
+    MPI_Waitall(count, requests, MPI_STATUSES_IGNORE);
+
+    for(unsigned int y = 0; y < block_height; y++){
+        std::uint64_t* row = current_state.get_row(y + 1);
+        set_bit(row, 0, (receive_columns[0][y / 64] >> (y % 64)) & 1);
+        set_bit(row, block_width + 1, (receive_columns[1][y / 64] >> (y % 64)) & 1);
+    }
+    set_bit(current_state.get_row(0), 0, receive_corners[0]);
+    set_bit(current_state.get_row(0), block_width + 1, receive_corners[1]);
+    set_bit(current_state.get_row(block_height + 1), 0, receive_corners[2]);
+    set_bit(current_state.get_row(block_height + 1), block_width + 1, receive_corners[3]);
+
+    auto step_words = [&](unsigned int y, unsigned int k0, unsigned int k1){
+        Kernel::step_row_span(current_state.get_row(y - 1), current_state.get_row(y), current_state.get_row(y + 1),
+                              next_state.get_row(y), block_width + 2, k0, k1, false, rule, kernel, nullptr);
+    };
+    step_words(1, 0, row_words);
+    if(block_height > 1){
+        step_words(block_height, 0, row_words);
+    }
+    unsigned int last = block_width / 64;
+    for(unsigned int y = 2; y < block_height; y++){
+        step_words(y, 0, 1);
+        if(last > 0){
+            step_words(y, last, last + 1);
+        }
+    }
+
+    // The border of the next state is refilled by the next step, and is kept dead until then.
+    for(unsigned int y = 1; y <= block_height; y++){
+        set_bit(next_state.get_row(y), 0, 0);
+        set_bit(next_state.get_row(y), block_width + 1, 0);
+    }
+    std::swap(current_state, next_state);
+    generation++;
+    count_local_cells();
+}
+
+/**
+ * DistributedWorld::advance(steps)
+ *
+ * Collectively advance multiple steps. Every rank must call it at once.
+ *
+ * @param steps
+ *      The number of steps to advance the world forward.
+ */
+void DistributedWorld::advance(unsigned int steps){
+    for(unsigned int i = 0; i < steps; i++){
+        step();
+    }
+}
+
+/**
+ * DistributedWorld::load_binary(path)
+ *
+ * Collectively load a binary .bgol file, resizing the world to it. Every rank must call it at once.
+ * Each rank reads only the bytes of the rows of its own block with MPI-IO.
+ *
+ * @param path
+ *      The std::string path to the file to read in.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class on every rank if:
+ *          - The file cannot be opened.
+ *          - The file ends unexpectedly.
+ *          - The width or height is negative.
+ *      std::invalid_argument if the world in the file is too small to give every rank a block.
+ */
+void DistributedWorld::load_binary(const std::string& path){
+    MPI_File file;
+    if(MPI_File_open(comm, path.c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS){
+        throw(std::runtime_error("The path given to function: DistributedWorld::load_binary is incorrect."));
+    }
+
+    // Every rank reads the same header, so every rank fails in the same way.
+    MPI_Offset size = 0;
+    int header[2] = {0, 0};
+    MPI_File_get_size(file, &size);
+    if(size < (MPI_Offset) sizeof header || !read_at(file, 0, (unsigned char*) header, sizeof header)){
+        MPI_File_close(&file);
+        throw(std::runtime_error("The file: '" + path + "' ends unexpectedly."));
+    } else if(header[0] < 0 || header[1] < 0){
+        MPI_File_close(&file);
+        throw(std::runtime_error("The file: '" + path + "' has a negative width or height."));
+    }
+    std::uint64_t cells = (std::uint64_t) header[0] * (std::uint64_t) header[1];
+    if((std::uint64_t) size - sizeof header < (cells + 7) / 8){
+        MPI_File_close(&file);
+        throw(std::runtime_error("The file: '" + path + "' ends unexpectedly."));
+    }
+    try{
+        decompose((unsigned int) header[0], (unsigned int) header[1], "DistributedWorld::load_binary");
+    } catch(...){
+        MPI_File_close(&file);
+        throw;
+    }
+
+    Grid block(x1 - x0, y1 - y0);
+    std::vector<unsigned char> bytes;
+    bool succeeded = true;
+    for(unsigned int y = 0; y < y1 - y0 && succeeded; y++){
+        std::uint64_t offset = (std::uint64_t) (y0 + y) * width + x0;
+        std::uint64_t first = offset / 8;
+        std::size_t length = (std::size_t) ((offset + block.get_width() + 7) / 8 - first);
+        bytes.assign(length, 0);
+        succeeded = read_at(file, sizeof header + first, bytes.data(), length);
+        std::uint64_t* row = block.get_row(y);
+        for(unsigned int k = 0; k < block.get_row_words(); k++){
+            row[k] = read_bits(bytes.data(), length, offset % 8 + (std::uint64_t) k * 64);
+        }
+        if(block.get_width() % 64 != 0){
+            row[block.get_row_words() - 1] &= ((std::uint64_t)1 << (block.get_width() % 64)) - 1;
+        }
+    }
+    close_file(file, comm, succeeded, "The file: '" + path + "' ends unexpectedly.");
+    set_block_state(block);
+}
+
+/**
+ * DistributedWorld::save_binary(path)
+ *
+ * Collectively save the world as a binary .bgol file. Every rank must call it at once.
+ *      - Each rank writes the bytes of the file whose first cell lies in its block with MPI-IO.
+ *      - Where the rows of two blocks share a byte, the rank holding the rest of the byte first sends its cells
+ *        to the rank writing it, so no byte is written twice.
+ *
+ * @param path
+ *      The std::string path to the file to write to.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class on every rank if the file cannot be opened or written.
+ */
+void DistributedWorld::save_binary(const std::string& path) const{
+    Grid block = get_block_state();
+    unsigned int block_width = x1 - x0;
+    unsigned int row_words = block.get_row_words();
+    int ranks = get_ranks();
+
+    std::vector<std::vector<unsigned char>> rows(y1 - y0);
+    std::vector<std::uint64_t> first_bytes(y1 - y0);
+    std::vector<std::vector<std::uint64_t>> outgoing(ranks);
+    for(unsigned int y = 0; y < y1 - y0; y++){
+        const std::uint64_t* row = block.get_row(y);
+        std::uint64_t offset = (std::uint64_t) (y0 + y) * width + x0;
+        std::uint64_t end = offset + block_width;
+        first_bytes[y] = (offset + 7) / 8;
+        rows[y].assign((std::size_t) ((end + 7) / 8 - first_bytes[y]), 0);
+        for(std::size_t b = 0; b < rows[y].size(); b++){
+            unsigned int x = (unsigned int) (8 * (first_bytes[y] + b) - offset);
+            rows[y][b] = (unsigned char) read_byte(row, row_words, x);
+        }
+        if(offset % 8 != 0){
+            // The cells before the first whole byte finish a byte begun by another row.
+            unsigned int leading = std::min(8 - (unsigned int) (offset % 8), block_width);
+            std::uint64_t byte = offset / 8;
+            std::uint64_t value = (read_byte(row, row_words, 0) & ((1u << leading) - 1)) << (offset % 8);
+            int owner = get_owner((unsigned int) ((8 * byte) % width), (unsigned int) ((8 * byte) / width));
+            outgoing[owner].push_back(byte);
+            outgoing[owner].push_back(value);
+        }
+    }
+
+    std::vector<int> send_counts(ranks), send_displacements(ranks), receive_counts(ranks), receive_displacements(ranks);
+    std::vector<std::uint64_t> sent;
+    for(int r = 0; r < ranks; r++){
+        send_counts[r] = (int) outgoing[r].size();
+        send_displacements[r] = (int) sent.size();
+        sent.insert(sent.end(), outgoing[r].begin(), outgoing[r].end());
+    }
+    MPI_Alltoall(send_counts.data(), 1, MPI_INT, receive_counts.data(), 1, MPI_INT, comm);
+    int received_words = 0;
+    for(int r = 0; r < ranks; r++){
+        receive_displacements[r] = received_words;
+        received_words += receive_counts[r];
+    }
+    std::vector<std::uint64_t> received(received_words);
+    MPI_Alltoallv(sent.data(), send_counts.data(), send_displacements.data(), MPI_UINT64_T, received.data(),
+                  receive_counts.data(), receive_displacements.data(), MPI_UINT64_T, comm);
+    for(std::size_t i = 0; i + 1 < received.size(); i += 2){
+        unsigned int y = (unsigned int) ((8 * received[i]) / width) - y0;
+        rows[y][(std::size_t) (received[i] - first_bytes[y])] |= (unsigned char) received[i + 1];
+    }
+
+    MPI_File file;
+    if(MPI_File_open(comm, path.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS){
+        throw(std::runtime_error("The path given to function: DistributedWorld::save_binary is incorrect."));
+    }
+    int header[2] = {(int) width, (int) height};
+    std::uint64_t cells = (std::uint64_t) width * height;
+    bool succeeded = MPI_File_set_size(file, (MPI_Offset) (sizeof header + (cells + 7) / 8)) == MPI_SUCCESS;
+    if(rank == 0){
+        succeeded = write_at(file, 0, (const unsigned char*) header, sizeof header) && succeeded;
+    }
+    for(unsigned int y = 0; y < y1 - y0 && succeeded; y++){
+        succeeded = write_at(file, sizeof header + first_bytes[y], rows[y].data(), rows[y].size());
+    }
+    close_file(file, comm, succeeded, "The file: '" + path + "' cannot be written.");
+}
+
+/**
+ * DistributedWorld::load_snapshot(path)
+ *
+ * Collectively load a snapshot, resizing the world to it and taking its generation and rule.
+ * Every rank must call it at once. Each rank reads only the tiles of the snapshot covering its block.
+ *
+ * @param path
+ *      The std::string path to the file to read in.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class under the same conditions as Snapshot::load, or if the rule of
+ *      the snapshot is not a Life-like rule.
+ *      std::invalid_argument if the world in the file is too small to give every rank a block.
+ */
+void DistributedWorld::load_snapshot(const std::string& path){
+    Snapshot::Header header = Snapshot::load_header(path);
+    Rule new_rule;
+    try{
+        new_rule = Rule(header.rule);
+    } catch(const std::invalid_argument&){
+        throw(std::runtime_error("The file: '" + path + "' has a rule that is not a Life-like rule."));
+    }
+    decompose(header.width, header.height, "DistributedWorld::load_snapshot");
+    set_block_state(Snapshot::load_region(path, (int) x0, (int) y0, (int) x1, (int) y1));
+    rule = new_rule;
+    generation = header.generation;
+}
+
+/**
+ * DistributedWorld::save_snapshot(path, threads)
+ *
+ * Collectively save the world, its generation and its rule as a snapshot. Every rank must call it at once.
+ * The tiles are the largest size up to Snapshot::DEFAULT_TILE_SIZE that lines up with every block, so each
+ * rank compresses and writes only the tiles of its own block.
+ *
+ * @param path
+ *      The std::string path to the file to write to.
+ *
+ * @param threads
+ *      Optional parameter. The number of threads each rank compresses tiles with, 0 uses every core. Defaults to 1.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class on every rank if the file cannot be opened or written.
+ */
+void DistributedWorld::save_snapshot(const std::string& path, unsigned int threads) const{
+    unsigned int tile_size = Snapshot::DEFAULT_TILE_SIZE;
+    auto lines_up = [this](unsigned int size){
+        for(int c = 1; c < dims[1]; c++){
+            if(get_column_start(c) % size != 0){
+                return false;
+            }
+        }
+        for(int r = 1; r < dims[0]; r++){
+            if(get_row_start(r) % size != 0){
+                return false;
+            }
+        }
+        return true;
+    };
+    while(tile_size > 64 && !lines_up(tile_size)){
+        tile_size /= 2;
+    }
+    Snapshot::save(comm, path, get_block_state(), x0, y0, width, height, generation, rule.get_name(), threads,
+                   tile_size);
+}
+
+#endif
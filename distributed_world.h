@@ -0,0 +1,91 @@
+/**
+ * Declares a class representing a 2d grid world split across the ranks of an MPI job.
+ * Rich documentation for the api and behaviour the DistributedWorld class can be found in distributed_world.cpp.
+ *
+ * Only built with GOL_WITH_MPI, for example with mpicxx -DGOL_WITH_MPI=1.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#pragma once
+
+#if GOL_WITH_MPI
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mpi.h>
+#include "grid.h"
+#include "kernel.h"
+#include "rule.h"
+
+/**
+ * Declare the structure of the DistributedWorld class for simulating worlds too large for the memory of one node.
+ *
+ * A DistributedWorld splits the grid into a 2d block for each rank of a Cartesian process topology, which is
+ * periodic when the world is toroidal.
+ *      - Each rank holds its block with a border of one cell on every side, filled each step with the edge cells
+ *        of the eight neighbouring blocks.
+ *      - The border is exchanged with non-blocking messages while the interior rows of the block are stepped.
+ */
+class DistributedWorld {
+private:
+    MPI_Comm comm;
+    int rank;
+    int dims[2];
+    int coords[2];
+    int neighbours[8];
+    bool toroidal;
+    unsigned int width;
+    unsigned int height;
+    unsigned int x0;
+    unsigned int y0;
+    unsigned int x1;
+    unsigned int y1;
+    Grid current_state;
+    Grid next_state;
+    Kernel::Isa kernel = Kernel::detect_isa();
+    Rule rule;
+    std::uint64_t generation = 0;
+    std::uint64_t local_alive_cells = 0;
+    std::vector<std::uint64_t> send_columns[2];
+    std::vector<std::uint64_t> receive_columns[2];
+
+    unsigned int get_column_start(int column) const;
+    unsigned int get_row_start(int row) const;
+    int get_owner(unsigned int x, unsigned int y) const;
+    void arrange(const int new_dims[2]);
+    void decompose(unsigned int new_width, unsigned int new_height, const char* function);
+    void count_local_cells();
+public:
+    DistributedWorld(MPI_Comm comm, unsigned int width, unsigned int height, bool toroidal = false);
+    ~DistributedWorld();
+    DistributedWorld(const DistributedWorld&) = delete;
+    DistributedWorld& operator=(const DistributedWorld&) = delete;
+    unsigned int get_width() const;
+    unsigned int get_height() const;
+    bool is_toroidal() const;
+    int get_rank() const;
+    int get_ranks() const;
+    void get_block(unsigned int& block_x0, unsigned int& block_y0, unsigned int& block_x1,
+                   unsigned int& block_y1) const;
+    Grid get_block_state() const;
+    void set_block_state(const Grid& block);
+    Grid get_state() const;
+    void set_state(const Grid& state);
+    std::uint64_t get_alive_cells() const;
+    Kernel::Isa get_kernel() const;
+    void set_kernel(Kernel::Isa isa);
+    const Rule& get_rule() const;
+    void set_rule(const Rule& new_rule);
+    std::uint64_t get_generation() const;
+    void set_generation(std::uint64_t new_generation);
+    void step();
+    void advance(unsigned int steps);
+    void load_binary(const std::string& path);
+    void save_binary(const std::string& path) const;
+    void load_snapshot(const std::string& path);
+    void save_snapshot(const std::string& path, unsigned int threads = 1) const;
+};
+
+#endif
@@ -0,0 +1,263 @@
+/**
+ * Implements a class that writes frames of a simulation to a stream on its own thread.
+ *      - The simulation hands each frame to FrameWriter::write, which copies the grid into a queue and returns.
+ *        Formatting and writing happen on a writer thread, so stepping the world never waits on a terminal or disk.
+ *          - The queue is bounded, so a slow stream cannot use unbounded memory. When it is full FrameWriter::write
+ *            waits for the writer thread to catch up.
+ *          - The grids of written frames are kept and reused, so queuing a frame of the same size does not allocate.
+ *          - Text, such as a caption before each frame, is queued in order with the frames.
+ *
+ *      - FrameWriter::ASCII frames are identical to printing the grid with operator<<, and are built 8 cells at a
+ *        time into one buffer that is written with a single call. The stream is flushed whenever the queue runs
+ *        empty rather than after every line.
+ *
+ *      - FrameWriter::DELTA frames are a recording made by a Recorder, for streams opened with std::ios::binary,
+ *        so a Player can rebuild any frame of it. Each frame is recorded as the generation it was written with.
+ *          - The first frame is a key frame, and each frame after it holds only the words that changed since the
+ *            frame before. Every frame must be the size of the first.
+ *          - Recordings have no text, so queued text is only written by FrameWriter::ASCII.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#include <stdexcept>
+#include "frame_writer.h"
+
+/**
+ * FrameWriter::FrameWriter(output, format, capacity)
+ *
+ * Start a writer thread for a stream. The stream must stay open until the FrameWriter is destroyed,
+ * and must not be written to by anything else in the meantime.
+ *
+ * @example
+ *
+ *      // Print a world every step without waiting for the console
+ *      FrameWriter frames(std::cout);
+ *      for(int step = 0; step < 100; step++){
+ *          world.step();
+ *          frames.write("Step " + std::to_string(step + 1) + "\n");
+ *          frames.write(world.get_state(), world.get_generation());
+ *      }
+ *
+ * @param output
+ *      The stream to write frames to. DELTA frames need a stream opened with std::ios::binary.
+ *
+ * @param format
+ *      The encoding of the frames, FrameWriter::ASCII by default.
+ *
+ * @param capacity
+ *      The most entries that can wait in the queue before FrameWriter::write waits, at least 1.
+ */
+FrameWriter::FrameWriter(std::ostream& output, Format format, std::size_t capacity):
+        output(output), format(format), capacity(capacity > 0 ? capacity : 1), writing(false), stopping(false),
+        failed(false), next_generation(0), has_previous(false), recorder(output){
+    writer = std::thread(&FrameWriter::work, this);
+}
+
+/**
+ * FrameWriter::~FrameWriter()
+ *
+ * Write everything still queued, flush the stream, and join the writer thread.
+ */
+FrameWriter::~FrameWriter(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    queued.notify_all();
+    writer.join();
+    output.flush();
+}
+
+/**
+ * FrameWriter::write(text)
+ *
+ * Queue text to be written before the next frame, such as a caption. Text is written as it is.
+ *
+ * @param text
+ *      The text to write.
+ *
+ * @throws
+ *      std::runtime_error if an earlier write to the stream failed.
+ */
+void FrameWriter::write(const std::string& text){
+    Entry entry = {false, text, Grid(), 0};
+    push(entry);
+}
+
+/**
+ * FrameWriter::write(grid)
+ *
+ * Queue a copy of a grid to be written as the frame of the generation after the last one written,
+ * or of generation 0 for the first frame.
+ *
+ * @param grid
+ *      The grid to write.
+ *
+ * @throws
+ *      std::runtime_error if an earlier write to the stream failed.
+ */
+void FrameWriter::write(const Grid& grid){
+    write(grid, next_generation);
+}
+
+/**
+ * FrameWriter::write(grid, generation)
+ *
+ * Queue a copy of a grid to be written as the frame of a generation. The grid can be changed as soon as this
+ * returns. Only FrameWriter::DELTA records the generation.
+ *
+ * @param grid
+ *      The grid to write.
+ *
+ * @param generation
+ *      The generation of the grid, which must be greater than that of the last frame for FrameWriter::DELTA.
+ *
+ * @throws
+ *      std::runtime_error if an earlier write to the stream failed.
+ */
+void FrameWriter::write(const Grid& grid, std::uint64_t generation){
+    Entry entry = {true, std::string(), Grid(), generation};
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!spare_grids.empty()){
+            entry.grid = std::move(spare_grids.back());
+            spare_grids.pop_back();
+        }
+    }
+    // Copying into a reused grid of the same size only copies the words.
+    entry.grid = grid;
+    next_generation = generation + 1;
+    push(entry);
+}
+
+/**
+ * FrameWriter::flush()
+ *
+ * Wait until everything queued has been written and the stream has been flushed.
+ *
+ * @throws
+ *      std::runtime_error if a write to the stream failed.
+ */
+void FrameWriter::flush(){
+    std::unique_lock<std::mutex> lock(mutex);
+    written.wait(lock, [this]{ return queue.empty() && !writing; });
+    if(failed){
+        throw(std::runtime_error("FrameWriter::flush error: the frames could not be written to the stream."));
+    }
+    output.flush();
+}
+
+/**
+ * FrameWriter::push(entry)
+ *
+ * Private helper function that waits for room in the queue and moves an entry onto it.
+ */
+void FrameWriter::push(Entry& entry){
+    std::unique_lock<std::mutex> lock(mutex);
+    written.wait(lock, [this]{ return queue.size() < capacity || failed; });
+    if(failed){
+        throw(std::runtime_error("FrameWriter::write error: the frames could not be written to the stream."));
+    }
+    queue.push_back(std::move(entry));
+    queued.notify_one();
+}
+
+/**
+ * FrameWriter::work()
+ *
+ * Private helper function run by the writer thread, which writes queued entries in order until the
+ * FrameWriter is destroyed and the queue is empty. The stream is flushed whenever the queue runs empty.
+ */
+void FrameWriter::work(){
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true){
+        queued.wait(lock, [this]{ return stopping || !queue.empty(); });
+        if(queue.empty()){
+            return;
+        }
+        Entry entry = std::move(queue.front());
+        queue.pop_front();
+        writing = true;
+        bool skip = failed;
+        lock.unlock();
+        written.notify_all();
+
+        bool recorded = true;
+        if(!skip){
+            if(!entry.is_grid){
+                write_text(entry.text);
+            } else if(format == ASCII){
+                write_ascii(entry.grid);
+            } else{
+                recorded = write_delta(entry.grid, entry.generation);
+            }
+        }
+
+        lock.lock();
+        if(queue.empty() && !skip){
+            lock.unlock();
+            output.flush();
+            lock.lock();
+        }
+        if(entry.is_grid){
+            spare_grids.push_back(std::move(entry.grid));
+        }
+        failed = failed || !output || !recorded;
+        writing = false;
+        written.notify_all();
+    }
+}
+
+/**
+ * FrameWriter::write_text(text)
+ *
+ * Private helper function that writes queued text for ASCII. Recordings have no text, so DELTA drops it.
+ */
+void FrameWriter::write_text(const std::string& text){
+    if(format == ASCII){
+        output.write(text.data(), (std::streamsize) text.size());
+    }
+}
+
+/**
+ * FrameWriter::write_ascii(grid)
+ *
+ * Private helper function that writes a grid with the border of operator<<, built into one buffer.
+ */
+void FrameWriter::write_ascii(const Grid& grid){
+    std::size_t line = (std::size_t) grid.get_width() + 3;
+    buffer.assign(line * ((std::size_t) grid.get_height() + 2), ' ');
+    std::string border = "+" + std::string(grid.get_width(), '-') + "+\n";
+    buffer.replace(0, line, border);
+    for(unsigned int j = 0; j < grid.get_height(); j++){
+        char* row = &buffer[line * (j + 1)];
+        row[0] = '|';
+        grid.format_row(j, row + 1);
+        row[line - 2] = '|';
+        row[line - 1] = '\n';
+    }
+    buffer.replace(line * ((std::size_t) grid.get_height() + 1), line, border);
+    output.write(buffer.data(), (std::streamsize) buffer.size());
+}
+
+/**
+ * FrameWriter::write_delta(grid, generation)
+ *
+ * Private helper function that records a grid with the Recorder, as a difference from the previous frame
+ * once there is one, returning false if the Recorder could not write it.
+ */
+bool FrameWriter::write_delta(const Grid& grid, std::uint64_t generation){
+    try{
+        if(has_previous){
+            recorder.record_step(previous, grid, generation);
+        } else{
+            recorder.record(grid, generation);
+        }
+    } catch(const std::exception&){
+        return false;
+    }
+    previous = grid;
+    has_previous = true;
+    return true;
+}
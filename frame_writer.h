@@ -0,0 +1,82 @@
+/**
+ * Declares a class that writes frames of a simulation to a stream on its own thread.
+ * Rich documentation for the api and behaviour the FrameWriter class can be found in frame_writer.cpp.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "grid.h"
+#include "recorder.h"
+
+/**
+ * Declare the structure of the FrameWriter class for printing or recording grids without waiting on output.
+ */
+class FrameWriter {
+public:
+    /**
+     * The encodings a FrameWriter can write frames in.
+     */
+    enum Format {
+        ASCII,
+        DELTA
+    };
+
+    /**
+     * The number of queued entries used when none is given.
+     */
+    static const std::size_t DEFAULT_CAPACITY = 8;
+private:
+    /**
+     * One queued piece of output, either text or a copy of a grid and its generation.
+     */
+    struct Entry {
+        bool is_grid;
+        std::string text;
+        Grid grid;
+        std::uint64_t generation;
+    };
+
+    std::ostream& output;
+    Format format;
+    std::size_t capacity;
+    std::deque<Entry> queue;
+    std::vector<Grid> spare_grids;
+    std::mutex mutex;
+    std::condition_variable queued;
+    std::condition_variable written;
+    bool writing;
+    bool stopping;
+    bool failed;
+    std::uint64_t next_generation;
+    Grid previous;
+    bool has_previous;
+    Recorder recorder;
+    std::string buffer;
+    std::thread writer;
+
+    void push(Entry& entry);
+    void work();
+    void write_ascii(const Grid& grid);
+    bool write_delta(const Grid& grid, std::uint64_t generation);
+    void write_text(const std::string& text);
+public:
+    explicit FrameWriter(std::ostream& output, Format format = ASCII, std::size_t capacity = DEFAULT_CAPACITY);
+    ~FrameWriter();
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+    void write(const std::string& text);
+    void write(const Grid& grid);
+    void write(const Grid& grid, std::uint64_t generation);
+    void flush();
+};
@@ -0,0 +1,505 @@
+/**
+ * Implements a class representing a 2d grid world stepped on a CUDA device.
+ *      - Only built with CUDA, for example:
+ *          - nvcc -std=c++17 -O3 -DGOL_WITH_CUDA=1 -c gpu_world.cu
+ *          - g++ -std=c++17 -O3 -DGOL_WITH_CUDA=1 Game_of_Life.cpp gpu_world.o (the other .cpp files) -lcudart
+ *
+ *      - The current and next state live in device memory as the bit-packed rows of a Grid, and are swapped
+ *        after each step without copying.
+ *          - The state is copied to the device when the world is constructed or set, and back to the host only
+ *            by GpuWorld::get_state and GpuWorld::save_snapshot.
+ *          - The population is summed on the device and only the total is copied back. It is kept until the next
+ *            step, so asking for it again costs nothing.
+ *
+ *      - Each step is one launch of a kernel with a thread per word of the grid.
+ *          - Each thread sums the neighbours of its 64 cells with the same bitwise adders as the CPU Kernel,
+ *            reading the words around it from the current state.
+ *          - West and east neighbours are carried in from the adjacent words, and from the opposite edge of the
+ *            row on a torus, exactly as Kernel::step_row_span does, so both engines give identical results.
+ *          - Conway's Game of Life has its own instantiation with the shortest adder network, and any other
+ *            Life-like rule reads its masks as kernel arguments.
+ *
+ *      - GpuWorld::advance queues every step of a run on the default stream without waiting, and only checks
+ *        for errors once they are queued. The next copy back to the host waits for them to finish.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#ifndef GOL_WITH_CUDA
+#define GOL_WITH_CUDA 1
+#endif
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <cuda_runtime.h>
+#include "gpu_world.h"
+#include "snapshot.h"
+
+namespace {
+    // The threads of a step block cover 32 words of 8 rows, so a warp reads 32 consecutive words of a row.
+    const unsigned int BLOCK_WORDS = 32;
+    const unsigned int BLOCK_ROWS = 8;
+    const unsigned int MAX_GRID_ROWS = 65535;
+    const unsigned int COUNT_THREADS = 256;
+    const unsigned int MAX_COUNT_BLOCKS = 1024;
+
+    void check(cudaError_t error, const char* function){
+        if(error != cudaSuccess){
+            throw(std::runtime_error(std::string(function) + " error: " + cudaGetErrorString(error)));
+        }
+    }
+
+    /**
+     * evolve(nw, n, ne, w, c, e, sw, s, se)
+     *
+     * Apply Conway's Game of Life rules to 64 cells at once, with the adder network of the CPU Kernel.
+     *
+     * @return
+     *      The next state of the 64 cells in c.
+     */
+    __device__ __forceinline__ std::uint64_t evolve(std::uint64_t nw, std::uint64_t n, std::uint64_t ne,
+                                                    std::uint64_t w, std::uint64_t c, std::uint64_t e,
+                                                    std::uint64_t sw, std::uint64_t s, std::uint64_t se){
+        std::uint64_t top_ones = nw ^ n ^ ne;
+        std::uint64_t top_twos = (nw & n) | (ne & (nw ^ n));
+        std::uint64_t bottom_ones = sw ^ s ^ se;
+        std::uint64_t bottom_twos = (sw & s) | (se & (sw ^ s));
+        std::uint64_t middle_ones = w ^ e;
+        std::uint64_t middle_twos = w & e;
+
+        std::uint64_t ones = top_ones ^ bottom_ones ^ middle_ones;
+        std::uint64_t carry = (top_ones & bottom_ones) | (middle_ones & (top_ones ^ bottom_ones));
+
+        // The count is 2 or 3 exactly when one of the four weight two bits is set
+        std::uint64_t pair_a = top_twos ^ bottom_twos;
+        std::uint64_t pair_b = middle_twos ^ carry;
+        std::uint64_t two_or_more_pairs = (top_twos & bottom_twos) | (middle_twos & carry);
+        std::uint64_t exactly_one_two = (pair_a ^ pair_b) & ~two_or_more_pairs;
+        return exactly_one_two & (ones | c);
+    }
+
+    /**
+     * evolve_rule(nw, n, ne, w, c, e, sw, s, se, birth, survival)
+     *
+     * Apply any Life-like rule to 64 cells at once, matching the full 4 bit count against each count in the rule.
+     *
+     * @return
+     *      The next state of the 64 cells in c.
+     */
+    __device__ __forceinline__ std::uint64_t evolve_rule(std::uint64_t nw, std::uint64_t n, std::uint64_t ne,
+                                                         std::uint64_t w, std::uint64_t c, std::uint64_t e,
+                                                         std::uint64_t sw, std::uint64_t s, std::uint64_t se,
+                                                         unsigned int birth, unsigned int survival){
+        std::uint64_t top_ones = nw ^ n ^ ne;
+        std::uint64_t top_twos = (nw & n) | (ne & (nw ^ n));
+        std::uint64_t bottom_ones = sw ^ s ^ se;
+        std::uint64_t bottom_twos = (sw & s) | (se & (sw ^ s));
+        std::uint64_t middle_ones = w ^ e;
+        std::uint64_t middle_twos = w & e;
+
+        std::uint64_t ones = top_ones ^ bottom_ones ^ middle_ones;
+        std::uint64_t carry = (top_ones & bottom_ones) | (middle_ones & (top_ones ^ bottom_ones));
+
+        std::uint64_t pair_a = top_twos ^ bottom_twos;
+        std::uint64_t pair_a_carry = top_twos & bottom_twos;
+        std::uint64_t pair_b = middle_twos ^ carry;
+        std::uint64_t pair_b_carry = middle_twos & carry;
+        std::uint64_t twos = pair_a ^ pair_b;
+        std::uint64_t twos_carry = pair_a & pair_b;
+        std::uint64_t fours = pair_a_carry ^ pair_b_carry ^ twos_carry;
+        std::uint64_t eights = (pair_a_carry & pair_b_carry) | (twos_carry & (pair_a_carry ^ pair_b_carry));
+
+        std::uint64_t next = 0;
+        for(unsigned int count = 0; count <= 8; count++){
+            bool born = (birth >> count) & 1;
+            bool survives = (survival >> count) & 1;
+            if(!born && !survives){
+                continue;
+            }
+            std::uint64_t match = ((count & 1) ? ones : ~ones) & ((count & 2) ? twos : ~twos) &
+                                  ((count & 4) ? fours : ~fours) & ((count & 8) ? eights : ~eights);
+            if(born && survives){
+                next |= match;
+            } else{
+                next |= match & (survives ? c : ~c);
+            }
+        }
+        return next;
+    }
+
+    /**
+     * step_kernel<LIFE>(current, next, width, height, row_words, toroidal, birth, survival)
+     *
+     * Step every word of the grid once, with a thread per word. Rows past the grid rows of the launch are
+     * covered by striding down the grid.
+     */
+    template<bool LIFE>
+    __global__ void step_kernel(const std::uint64_t* current, std::uint64_t* next, unsigned int width,
+                                unsigned int height, unsigned int row_words, bool toroidal, unsigned int birth,
+                                unsigned int survival){
+        unsigned int k = blockIdx.x * blockDim.x + threadIdx.x;
+        if(k >= row_words){
+            return;
+        }
+        unsigned int last = row_words - 1;
+        unsigned int last_bit = (width - 1) % 64;
+
+        for(unsigned int y = blockIdx.y * blockDim.y + threadIdx.y; y < height; y += gridDim.y * blockDim.y){
+            const std::uint64_t* rows[3];
+            rows[1] = current + (std::size_t) y * row_words;
+            rows[0] = y > 0 ? rows[1] - row_words : (toroidal ? current + (std::size_t) (height - 1) * row_words : nullptr);
+            rows[2] = y + 1 < height ? rows[1] + row_words : (toroidal ? current : nullptr);
+
+            // Bits carried in from beyond the edges of the row are dead unless the row wraps around.
+            std::uint64_t west[3], centre[3], east[3];
+            for(int r = 0; r < 3; r++){
+                if(rows[r] == nullptr){
+                    west[r] = 0;
+                    centre[r] = 0;
+                    east[r] = 0;
+                    continue;
+                }
+                centre[r] = rows[r][k];
+                std::uint64_t west_in = k > 0 ? rows[r][k - 1] >> 63 : (toroidal ? (rows[r][last] >> last_bit) & 1 : 0);
+                std::uint64_t east_in = k < last ? rows[r][k + 1] << 63 : (toroidal ? (rows[r][0] & 1) << last_bit : 0);
+                west[r] = (centre[r] << 1) | west_in;
+                east[r] = (centre[r] >> 1) | east_in;
+            }
+
+            std::uint64_t word;
+            if(LIFE){
+                word = evolve(west[0], centre[0], east[0], west[1], centre[1], east[1], west[2], centre[2], east[2]);
+            } else{
+                word = evolve_rule(west[0], centre[0], east[0], west[1], centre[1], east[1], west[2], centre[2],
+                                   east[2], birth, survival);
+            }
+
+            // Cells just past the width can be born from the last column, so clear the padding.
+            if(k == last && width % 64 != 0){
+                word &= ((std::uint64_t)1 << (width % 64)) - 1;
+            }
+            next[(std::size_t) y * row_words + k] = word;
+        }
+    }
+
+    /**
+     * count_kernel(words, count, total)
+     *
+     * Add the alive cells of the words to a total. Each thread counts a stride of the words, each warp sums
+     * its threads with shuffles, and only the first thread of each warp adds to the total.
+     */
+    __global__ void count_kernel(const std::uint64_t* words, std::size_t count, unsigned long long* total){
+        unsigned long long sum = 0;
+        std::size_t stride = (std::size_t) gridDim.x * blockDim.x;
+        for(std::size_t i = (std::size_t) blockIdx.x * blockDim.x + threadIdx.x; i < count; i += stride){
+            sum += __popcll(words[i]);
+        }
+        for(int offset = warpSize / 2; offset > 0; offset /= 2){
+            sum += __shfl_down_sync(0xFFFFFFFF, sum, offset);
+        }
+        if(threadIdx.x % warpSize == 0){
+            atomicAdd(total, sum);
+        }
+    }
+}
+
+/**
+ * GpuWorld::GpuWorld(initial_state)
+ *
+ * Construct a world on the current CUDA device and copy a grid into it.
+ *
+ * @example
+ *
+ *      // Run a loaded world for a million generations on the GPU, and copy back only the result
+ *      GpuWorld world(Zoo::load_binary("world.bgol"));
+ *      world.advance(1000000, true);
+ *      Zoo::save_binary("world.bgol", world.get_state());
+ *
+ * @param initial_state
+ *      The state of the constructed world.
+ *
+ * @throws
+ *      std::runtime_error if there is no CUDA device, or the grid does not fit in its memory.
+ */
+GpuWorld::GpuWorld(const Grid& initial_state){
+    int devices = 0;
+    if(cudaGetDeviceCount(&devices) != cudaSuccess || devices == 0){
+        throw(std::runtime_error("GpuWorld::GpuWorld error: no CUDA device is available."));
+    }
+    try{
+        set_state(initial_state);
+    } catch(...){
+        release();
+        throw;
+    }
+}
+
+/**
+ * GpuWorld::~GpuWorld()
+ *
+ * Free the device memory of the world.
+ */
+GpuWorld::~GpuWorld(){
+    release();
+}
+
+/**
+ * GpuWorld::allocate(new_width, new_height)
+ *
+ * Private helper function that frees the device memory of the world and allocates it again for a new size.
+ * The contents of the new states are undefined.
+ *
+ * @throws
+ *      std::runtime_error if the device is out of memory.
+ */
+void GpuWorld::allocate(unsigned int new_width, unsigned int new_height){
+    release();
+    width = new_width;
+    height = new_height;
+    row_words = (new_width + 63) / 64;
+    std::size_t bytes = (std::size_t) row_words * new_height * sizeof(std::uint64_t);
+    check(cudaMalloc((void**) &population, sizeof(unsigned long long)), "GpuWorld::allocate");
+    if(bytes > 0){
+        check(cudaMalloc((void**) &current_state, bytes), "GpuWorld::allocate");
+        check(cudaMalloc((void**) &next_state, bytes), "GpuWorld::allocate");
+    }
+}
+
+/**
+ * GpuWorld::release()
+ *
+ * Private helper function that frees the device memory of the world.
+ */
+void GpuWorld::release(){
+    cudaFree(current_state);
+    cudaFree(next_state);
+    cudaFree(population);
+    current_state = nullptr;
+    next_state = nullptr;
+    population = nullptr;
+    width = 0;
+    height = 0;
+    row_words = 0;
+}
+
+/**
+ * GpuWorld::get_width()
+ *
+ * Gets the width of the world.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The width of the world.
+ */
+unsigned int GpuWorld::get_width() const{
+    return width;
+}
+
+/**
+ * GpuWorld::get_height()
+ *
+ * Gets the height of the world.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The height of the world.
+ */
+unsigned int GpuWorld::get_height() const{
+    return height;
+}
+
+/**
+ * GpuWorld::get_state()
+ *
+ * Copy the current state of the world back to the host, after waiting for every queued step.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      A grid of the current state.
+ *
+ * @throws
+ *      std::runtime_error if a queued step or the copy failed on the device.
+ */
+Grid GpuWorld::get_state() const{
+    Grid state(width, height);
+    std::size_t bytes = (std::size_t) row_words * height * sizeof(std::uint64_t);
+    if(bytes > 0){
+        check(cudaMemcpy(state.get_row(0), current_state, bytes, cudaMemcpyDeviceToHost), "GpuWorld::get_state");
+    }
+    return state;
+}
+
+/**
+ * GpuWorld::set_state(state)
+ *
+ * Replace the world with a grid, resizing the device memory if the grid is a different size.
+ *
+ * @param state
+ *      The new state of the world.
+ *
+ * @throws
+ *      std::runtime_error if the grid does not fit in the memory of the device.
+ */
+void GpuWorld::set_state(const Grid& state){
+    if(population == nullptr || state.get_width() != width || state.get_height() != height){
+        allocate(state.get_width(), state.get_height());
+    }
+    std::size_t bytes = (std::size_t) row_words * height * sizeof(std::uint64_t);
+    if(bytes > 0){
+        check(cudaMemcpy(current_state, state.get_row(0), bytes, cudaMemcpyHostToDevice), "GpuWorld::set_state");
+    }
+    population_valid = false;
+}
+
+/**
+ * GpuWorld::get_alive_cells()
+ *
+ * Count the alive cells of the world with a reduction on the device, copying back only the total.
+ * The count is kept until the world is next stepped or set.
+ *
+ * @return
+ *      The number of alive cells.
+ *
+ * @throws
+ *      std::runtime_error if a queued step or the reduction failed on the device.
+ */
+unsigned long long GpuWorld::get_alive_cells(){
+    if(population_valid){
+        return alive_cells;
+    }
+    std::size_t words = (std::size_t) row_words * height;
+    alive_cells = 0;
+    if(words > 0){
+        unsigned int blocks = (unsigned int) std::min<std::size_t>((words + COUNT_THREADS - 1) / COUNT_THREADS,
+                                                                   MAX_COUNT_BLOCKS);
+        check(cudaMemset(population, 0, sizeof(unsigned long long)), "GpuWorld::get_alive_cells");
+        count_kernel<<<blocks, COUNT_THREADS>>>(current_state, words, population);
+        check(cudaGetLastError(), "GpuWorld::get_alive_cells");
+        check(cudaMemcpy(&alive_cells, population, sizeof(unsigned long long), cudaMemcpyDeviceToHost),
+              "GpuWorld::get_alive_cells");
+    }
+    population_valid = true;
+    return alive_cells;
+}
+
+/**
+ * GpuWorld::get_rule()
+ *
+ * Gets the rule used to step the world, Conway's Game of Life "B3/S23" unless set_rule was called.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The rule of the world.
+ */
+const Rule& GpuWorld::get_rule() const{
+    return rule;
+}
+
+/**
+ * GpuWorld::set_rule(new_rule)
+ *
+ * Change the rule used by the following steps.
+ *
+ * @param new_rule
+ *      The rule to step with.
+ */
+void GpuWorld::set_rule(const Rule& new_rule){
+    rule = new_rule;
+}
+
+/**
+ * GpuWorld::get_generation()
+ *
+ * Gets the number of steps the world has been stepped through.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The generation of the world.
+ */
+std::uint64_t GpuWorld::get_generation() const{
+    return generation;
+}
+
+/**
+ * GpuWorld::set_generation(new_generation)
+ *
+ * Set the generation counter, such as when resuming from a saved world.
+ *
+ * @param new_generation
+ *      The generation of the current state.
+ */
+void GpuWorld::set_generation(std::uint64_t new_generation){
+    generation = new_generation;
+}
+
+/**
+ * GpuWorld::step(toroidal)
+ *
+ * Queue one step of the world on the device.
+ *
+ * @param toroidal
+ *      Optional parameter. If true then the edges of the world wrap around. Defaults to false.
+ *
+ * @throws
+ *      std::runtime_error if the step could not be launched.
+ */
+void GpuWorld::step(bool toroidal){
+    advance(1, toroidal);
+}
+
+/**
+ * GpuWorld::advance(steps, toroidal)
+ *
+ * Queue multiple steps of the world on the device, without waiting for any of them or copying anything back.
+ *
+ * @param steps
+ *      The number of steps to advance the world forward.
+ *
+ * @param toroidal
+ *      Optional parameter. If true then the edges of the world wrap around. Defaults to false.
+ *
+ * @throws
+ *      std::runtime_error if the steps could not be launched.
+ */
+void GpuWorld::advance(unsigned int steps, bool toroidal){
+    if(steps > 0 && row_words > 0 && height > 0){
+        dim3 threads(BLOCK_WORDS, BLOCK_ROWS);
+        dim3 blocks((row_words + BLOCK_WORDS - 1) / BLOCK_WORDS,
+                    std::min((height + BLOCK_ROWS - 1) / BLOCK_ROWS, MAX_GRID_ROWS));
+        bool life = rule == Rule();
+        for(unsigned int i = 0; i < steps; i++){
+            if(life){
+                step_kernel<true><<<blocks, threads>>>(current_state, next_state, width, height, row_words,
+                                                       toroidal, 0, 0);
+            } else{
+                step_kernel<false><<<blocks, threads>>>(current_state, next_state, width, height, row_words,
+                                                        toroidal, rule.get_birth(), rule.get_survival());
+            }
+            std::swap(current_state, next_state);
+        }
+        check(cudaGetLastError(), "GpuWorld::advance");
+    }
+    generation += steps;
+    population_valid = population_valid && steps == 0;
+}
+
+/**
+ * GpuWorld::save_snapshot(path, threads)
+ *
+ * Copy the world back to the host and save it, its generation and its rule as a snapshot.
+ * The function should be callable from a constant context.
+ *
+ * @param path
+ *      The std::string path to the file to write to.
+ *
+ * @param threads
+ *      Optional parameter. The number of threads to compress tiles with, 0 uses every core. Defaults to 1.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if the state cannot be copied back or the file cannot be written.
+ */
+void GpuWorld::save_snapshot(const std::string& path, unsigned int threads) const{
+    Snapshot::save(path, get_state(), generation, rule.get_name(), threads);
+}
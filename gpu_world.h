@@ -0,0 +1,63 @@
+/**
+ * Declares a class representing a 2d grid world stepped on a CUDA device.
+ * Rich documentation for the api and behaviour the GpuWorld class can be found in gpu_world.cu.
+ *
+ * Only built with GOL_WITH_CUDA, for example with nvcc -DGOL_WITH_CUDA=1 linked with -lcudart.
+ * The header uses no CUDA types, so it can be included from translation units built by the host compiler.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#pragma once
+
+#if GOL_WITH_CUDA
+
+#include <cstdint>
+#include <string>
+#include "grid.h"
+#include "rule.h"
+
+/**
+ * Declare the structure of the GpuWorld class for stepping a world on a GPU.
+ *
+ * A GpuWorld keeps its current and next state resident in device memory, in the bit-packed rows of a Grid.
+ *      - Each step is one kernel launch with a thread per word, and GpuWorld::advance queues every step of a
+ *        run without waiting for them.
+ *      - The state only returns to the host for GpuWorld::get_state and snapshots, and the population only
+ *        as the total of a reduction on the device.
+ */
+class GpuWorld {
+private:
+    unsigned int width = 0;
+    unsigned int height = 0;
+    unsigned int row_words = 0;
+    std::uint64_t* current_state = nullptr;
+    std::uint64_t* next_state = nullptr;
+    unsigned long long* population = nullptr;
+    bool population_valid = false;
+    unsigned long long alive_cells = 0;
+    Rule rule;
+    std::uint64_t generation = 0;
+
+    void allocate(unsigned int new_width, unsigned int new_height);
+    void release();
+public:
+    explicit GpuWorld(const Grid& initial_state);
+    ~GpuWorld();
+    GpuWorld(const GpuWorld&) = delete;
+    GpuWorld& operator=(const GpuWorld&) = delete;
+    unsigned int get_width() const;
+    unsigned int get_height() const;
+    Grid get_state() const;
+    void set_state(const Grid& state);
+    unsigned long long get_alive_cells();
+    const Rule& get_rule() const;
+    void set_rule(const Rule& new_rule);
+    std::uint64_t get_generation() const;
+    void set_generation(std::uint64_t new_generation);
+    void step(bool toroidal = false);
+    void advance(unsigned int steps, bool toroidal = false);
+    void save_snapshot(const std::string& path, unsigned int threads = 1) const;
+};
+
+#endif
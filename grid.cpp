@@ -3,21 +3,150 @@
  *      - New cells are initialized to Cell::DEAD.
  *      - Grids can be resized while retaining their contents in the remaining area.
  *      - Grids can be rotated, cropped, and merged together.
+ *          - Patterns can be stamped by row, clipped or wrapped at the edges, singly or as a batch in parallel.
  *      - Grids can return counts of the alive and dead cells.
+ *          - Grid::get_summary returns both counts and the bounding box of the alive cells from one pass.
  *      - Grids can be serialized directly to an ascii std::ostream.
  *
- * You are encouraged to use STL container types as an underlying storage mechanism for the grid cells.
+ *      - Cells are stored bit-packed in a std::vector of 64-bit words, one bit per cell.
+ *          - Each row is padded up to a whole number of words, so rows always start on a word boundary.
+ *          - Padding bits past the width of a row are always 0, so whole words can be counted with a popcount.
+ *          - The words come from GridPool, so the many small grids made by crop and rotate reuse freed blocks.
+ *
+ *      - Grids are rotated and transposed 64x64 cells at a time.
+ *          - Each block of 64 rows by one word is transposed as a bit matrix in registers and written out as one
+ *            word of 64 rows of the result, so both grids are read and written a block at a time rather than
+ *            a cell at a time down the columns, which would miss the cache on every cell of a large grid.
+ *          - Quarter turns are a transpose followed by mirroring each row or reversing the order of the rows.
+ *
+ *      - Grids can be resized, cropped and rotated in place, without allocating a second grid.
+ *          - Resizing and cropping move the kept words of each row to their new place in the same buffer,
+ *            in an order that never overwrites a word that has not been moved yet.
  *
  * @author 957552
  * @date March, 2020
  */
 #include <algorithm>
+#include <bitset>
+#include <cstring>
 #include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include "grid.h"
+#include "thread_pool.h"
 
 // Include the minimal number of headers needed to support your implementation.
 // #include ...
 
+namespace {
+    /**
+     * read_bits(row, words, x)
+     *
+     * Read the 64 bits of a packed row starting at column x, with bits past the end of the row read as 0.
+     */
+    std::uint64_t read_bits(const std::uint64_t* row, unsigned int words, unsigned int x){
+        unsigned int k = x / 64, shift = x % 64;
+        std::uint64_t bits = (k < words) ? row[k] >> shift : 0;
+        if(shift != 0 && k + 1 < words){
+            bits |= row[k + 1] << (64 - shift);
+        }
+        return bits;
+    }
+
+    /**
+     * write_bits(row, x, bits, mask)
+     *
+     * Overwrite the bits of a packed row starting at column x that are set in mask with the matching bits.
+     * Every column selected by mask must be within the row.
+     */
+    void write_bits(std::uint64_t* row, unsigned int x, std::uint64_t bits, std::uint64_t mask){
+        unsigned int k = x / 64, shift = x % 64;
+        row[k] = (row[k] & ~(mask << shift)) | (bits << shift);
+        if(shift != 0 && (mask >> (64 - shift)) != 0){
+            row[k + 1] = (row[k + 1] & ~(mask >> (64 - shift))) | (bits >> (64 - shift));
+        }
+    }
+
+    // A mask of the lowest count bits of a word, for count from 0 to 64.
+    std::uint64_t low_bits(unsigned int count){
+        return (count >= 64) ? ~(std::uint64_t)0 : (((std::uint64_t)1 << count) - 1);
+    }
+
+    /**
+     * blit_span(source, source_words, sx, row, dx, count, blit)
+     *
+     * Copy count columns of a packed row starting at column sx into another packed row starting at column dx,
+     * 64 columns at a time. Grid::OR only sets the alive columns, leaving the rest of the span as it was.
+     * Every column written must be within the destination row.
+     */
+    void blit_span(const std::uint64_t* source, unsigned int source_words, unsigned int sx,
+                   std::uint64_t* row, unsigned int dx, unsigned int count, Grid::Blit blit){
+        for(unsigned int i = 0; i < count; i += 64){
+            std::uint64_t mask = low_bits(count - i);
+            std::uint64_t bits = read_bits(source, source_words, sx + i) & mask;
+            write_bits(row, dx + i, bits, (blit == Grid::OR) ? bits : mask);
+        }
+    }
+
+    // Reverse the order of the bits of a word.
+    std::uint64_t reverse_bits(std::uint64_t word){
+        word = ((word >> 1) & 0x5555555555555555ULL) | ((word & 0x5555555555555555ULL) << 1);
+        word = ((word >> 2) & 0x3333333333333333ULL) | ((word & 0x3333333333333333ULL) << 2);
+        word = ((word >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((word & 0x0F0F0F0F0F0F0F0FULL) << 4);
+        word = ((word >> 8) & 0x00FF00FF00FF00FFULL) | ((word & 0x00FF00FF00FF00FFULL) << 8);
+        word = ((word >> 16) & 0x0000FFFF0000FFFFULL) | ((word & 0x0000FFFF0000FFFFULL) << 16);
+        return (word >> 32) | (word << 32);
+    }
+
+    /**
+     * reverse_row(row, words, width)
+     *
+     * Mirror a packed row of the given width in place, so column x moves to column width - 1 - x.
+     * The whole padded row is reversed and then shifted back down over the padding, which stays 0.
+     */
+    void reverse_row(std::uint64_t* row, unsigned int words, unsigned int width){
+        std::reverse(row, row + words);
+        for(unsigned int k = 0; k < words; k++){
+            row[k] = reverse_bits(row[k]);
+        }
+        unsigned int shift = words * 64 - width;
+        if(shift != 0){
+            for(unsigned int k = 0; k < words; k++){
+                row[k] = (row[k] >> shift) | ((k + 1 < words) ? row[k + 1] << (64 - shift) : 0);
+            }
+        }
+    }
+
+    /**
+     * transpose_block(block)
+     *
+     * Transpose a 64x64 bit matrix in place, where bit c of block[r] is column c of row r, so afterwards bit r
+     * of block[c] holds it. The quadrants of the matrix are swapped, then the quadrants of each quadrant, down to
+     * single bits, which takes 6 passes of 32 word operations rather than 4096 single bit moves.
+     *      - Hacker's Delight, Henry S. Warren, section 7-3.
+     */
+    void transpose_block(std::uint64_t block[64]){
+        std::uint64_t mask = 0x00000000FFFFFFFFULL;
+        for(unsigned int j = 32; j != 0; j >>= 1, mask ^= mask << j){
+            for(unsigned int k = 0; k < 64; k = ((k | j) + 1) & ~j){
+                std::uint64_t swapped = ((block[k] >> j) ^ block[k | j]) & mask;
+                block[k] ^= swapped << j;
+                block[k | j] ^= swapped;
+            }
+        }
+    }
+
+    // Check whether words are stored least significant byte first, which lets 8 characters be built in one word.
+    bool is_little_endian(){
+        std::uint16_t word = 1;
+        unsigned char first;
+        std::memcpy(&first, &word, 1);
+        return first == 1;
+    }
+}
+
 /**
  * Grid::Grid()
  *
@@ -30,8 +159,7 @@
  *      Grid grid;
  *
  */
-Grid::Grid(): width(0), height(0){
-    grid.resize(width*height);
+Grid::Grid(): width(0), height(0), row_words(0){
 }
 
 /**
@@ -57,14 +185,7 @@ Grid::Grid(): width(0), height(0){
  * @param square_size
  *      The edge size to use for the width and height of the grid.
  */
-Grid::Grid(unsigned int square_size): width(0), height(0){
-    this->height = square_size;
-    this->width = square_size;
-    grid.resize(width*height);
-
-    for(unsigned int i=0; i<width*height; i++){
-        grid[i] = DEAD;
-    }
+Grid::Grid(unsigned int square_size): Grid(square_size, square_size){
 }
 
 /**
@@ -83,14 +204,9 @@ Grid::Grid(unsigned int square_size): width(0), height(0){
  * @param height
  *      The height of the grid.
  */
-Grid::Grid(unsigned int width, unsigned int height): width(0), height(0){
-    this->width = width;
-    this->height = height;
-    grid.resize(width*height);
-
-    for(unsigned int i=0; i<width*height; i++){
-        grid[i] = DEAD;
-    }
+Grid::Grid(unsigned int width, unsigned int height): width(width), height(height), row_words((width + 63) / 64){
+    // Every bit starts as 0, which is Cell::DEAD.
+    grid.assign((std::size_t)row_words * height, 0);
 }
 
 /**
@@ -198,11 +314,10 @@ unsigned int Grid::get_total_cells() const{
  *      The number of alive cells.
  */
 unsigned int Grid::get_alive_cells() const{
+    // Padding bits are always 0, so a popcount over every word counts exactly the alive cells.
     unsigned int alive_cells = 0;
-    for(unsigned int i=0; i<get_total_cells(); i++){
-        if(grid[i] == ALIVE){
-            alive_cells++;
-        }
+    for(std::uint64_t word : grid){
+        alive_cells += (unsigned int) std::bitset<64>(word).count();
     }
     return alive_cells;
 }
@@ -231,13 +346,159 @@ unsigned int Grid::get_alive_cells() const{
  *      The number of dead cells.
  */
 unsigned int Grid::get_dead_cells() const{
-    unsigned int dead_cells = 0;
-    for(unsigned int i=0; i<get_total_cells(); i++){
-        if(grid[i] == DEAD){
-            dead_cells++;
+    return get_total_cells() - get_alive_cells();
+}
+
+/**
+ * Grid::get_summary()
+ *
+ * Counts the alive and dead cells and finds the smallest box holding every alive cell, in one pass over the grid.
+ * Each row is searched from both ends for its first and last non-zero word, and only the words between them are
+ * counted, so empty rows and the empty margins of sparse rows cost one comparison per word.
+ * The function should be callable from a constant context.
+ *
+ * @example
+ *
+ *      // Make a grid with a glider in it
+ *      Grid grid(64, 64);
+ *      grid.merge(Zoo::glider(), 10, 20);
+ *
+ *      // Print the number of alive cells and the size of the box around them to the console
+ *      Grid::Summary summary = grid.get_summary();
+ *      std::cout << summary.alive_cells << " in " << summary.x1 - summary.x0 << "x" << summary.y1 - summary.y0
+ *                << std::endl;
+ *
+ * @return
+ *      The counts and the bounding box spanning [x0, x1) by [y0, y1), which is empty at (0, 0) if no cell is alive.
+ */
+Grid::Summary Grid::get_summary() const{
+    Summary summary = {0, get_total_cells(), width, height, 0, 0};
+    for(unsigned int y = 0; y < height; y++){
+        const std::uint64_t* row = get_row(y);
+        unsigned int first = 0;
+        while(first < row_words && row[first] == 0){
+            first++;
+        }
+        if(first == row_words){
+            continue;
         }
+        unsigned int last = row_words - 1;
+        while(row[last] == 0){
+            last--;
+        }
+        for(unsigned int k = first; k <= last; k++){
+            summary.alive_cells += (unsigned int) std::bitset<64>(row[k]).count();
+        }
+        summary.x0 = std::min(summary.x0, first * 64 + (unsigned int) __builtin_ctzll(row[first]));
+        summary.x1 = std::max(summary.x1, last * 64 + 64 - (unsigned int) __builtin_clzll(row[last]));
+        summary.y0 = std::min(summary.y0, y);
+        summary.y1 = y + 1;
+    }
+    if(summary.alive_cells == 0){
+        summary.x0 = summary.y0 = 0;
+    }
+    summary.dead_cells -= summary.alive_cells;
+    return summary;
+}
+
+/**
+ * Grid::get_row_words()
+ *
+ * Gets the number of 64-bit words used to store each row of the grid, including padding.
+ * The function should be callable from a constant context.
+ *
+ * @example
+ *
+ *      // Make a grid
+ *      Grid grid(100, 4);
+ *
+ *      // Prints 2, since 100 cells need two 64-bit words
+ *      std::cout << grid.get_row_words() << std::endl;
+ *
+ * @return
+ *      The number of words per row.
+ */
+unsigned int Grid::get_row_words() const{
+    return row_words;
+}
+
+/**
+ * Grid::get_row(y)
+ *
+ * Gets a pointer to the packed words of a row, for code that processes whole words at a time.
+ * Bit (x % 64) of word (x / 64) holds the cell at column x. Any bits past the width must be left as 0.
+ * The row is not bounds checked.
+ *
+ * @example
+ *
+ *      // Make a grid
+ *      Grid grid(100, 4);
+ *
+ *      // Set the first 64 cells of row 2 alive in one write
+ *      grid.get_row(2)[0] = ~(std::uint64_t)0;
+ *
+ * @param y
+ *      The y coordinate of the row, which must be less than the height.
+ *
+ * @return
+ *      A pointer to the first of get_row_words() words in the row.
+ */
+std::uint64_t* Grid::get_row(unsigned int y){
+    return grid.data() + (std::size_t)y*row_words;
+}
+
+/**
+ * Grid::get_row(y)
+ *
+ * Gets a read-only pointer to the packed words of a row.
+ * The function should be callable from a constant context.
+ * The row is not bounds checked.
+ *
+ * @param y
+ *      The y coordinate of the row, which must be less than the height.
+ *
+ * @return
+ *      A read-only pointer to the first of get_row_words() words in the row.
+ */
+const std::uint64_t* Grid::get_row(unsigned int y) const{
+    return grid.data() + (std::size_t)y*row_words;
+}
+
+/**
+ * Grid::format_row(y, characters)
+ *
+ * Write the cells of a row as Cell::ALIVE and Cell::DEAD characters, for code that prints or saves whole rows.
+ * Cells are written 8 at a time by spreading each bit of a packed byte to a byte of a word.
+ * The function should be callable from a constant context.
+ * The row is not bounds checked.
+ *
+ * @example
+ *
+ *      // Print the middle row of a glider
+ *      Grid grid = Zoo::glider();
+ *      std::string line(grid.get_width(), ' ');
+ *      grid.format_row(1, &line[0]);
+ *      std::cout << line << std::endl;
+ *
+ * @param y
+ *      The y coordinate of the row, which must be less than the height.
+ *
+ * @param characters
+ *      The buffer to write get_width() characters to.
+ */
+void Grid::format_row(unsigned int y, char* characters) const{
+    const std::uint64_t every_byte = 0x0101010101010101ULL;
+    const std::uint64_t* row = get_row(y);
+    unsigned int i = 0;
+    for(; i + 8 <= width && is_little_endian(); i += 8){
+        std::uint64_t bits = (row[i / 64] >> (i % 64)) & 0xFF;
+        std::uint64_t spread = (((bits * every_byte) & 0x8040201008040201ULL) + every_byte * 0x7F) >> 7;
+        std::uint64_t word = every_byte * (unsigned char) DEAD + (spread & every_byte) * (ALIVE - DEAD);
+        std::memcpy(characters + i, &word, 8);
+    }
+    for(; i < width; i++){
+        characters[i] = ((row[i / 64] >> (i % 64)) & 1) ? (char) ALIVE : (char) DEAD;
     }
-    return dead_cells;
 }
 
 /**
@@ -284,27 +545,49 @@ void Grid::resize(unsigned int square_size){
  */
 
 void Grid::resize(unsigned int new_width, unsigned int new_height){
-    std::vector<Cell> old_grid = grid;
-    grid.resize(new_height*new_width);
-
-    for (unsigned int a = 0; a < new_height * new_width; a++){
-        grid[a] = DEAD;
+    unsigned int new_row_words = (new_width + 63) / 64;
+    std::size_t new_size = (std::size_t)new_row_words * new_height;
+    if(new_size > grid.size()){
+        grid.resize(new_size, 0);
     }
 
-    for(unsigned int j=0; j<std::min(height, new_height); j++){
-        for(unsigned int i=0; i<std::min(width, new_width); i++){
-            grid[(j*new_width)+i] = old_grid[(j*width)+i];
+    // Move the kept words of each row to its new place in the same buffer, clearing the rest of the row and
+    // any bits that now fall past the new width. Narrower rows move towards the front, so are moved first to
+    // last, and wider rows move towards the back, so are moved last to first.
+    unsigned int kept_rows = std::min(height, new_height);
+    unsigned int kept_words = (std::min(width, new_width) + 63) / 64;
+    std::uint64_t tail_mask = (new_width % 64 == 0) ? ~(std::uint64_t)0 : (get_mask(new_width) - 1);
+    std::uint64_t* words = grid.data();
+    for(unsigned int i=0; i<kept_rows; i++){
+        unsigned int j = (new_row_words <= row_words) ? i : kept_rows - 1 - i;
+        std::uint64_t* row = words + (std::size_t)j*new_row_words;
+        const std::uint64_t* old_row = words + (std::size_t)j*row_words;
+        if(row < old_row){
+            for(unsigned int k=0; k<kept_words; k++){
+                row[k] = old_row[k];
+            }
+        } else if(row > old_row){
+            for(unsigned int k=kept_words; k-- > 0;){
+                row[k] = old_row[k];
+            }
+        }
+        std::fill(row + kept_words, row + new_row_words, 0);
+        if(kept_words == new_row_words && kept_words > 0){
+            row[kept_words - 1] &= tail_mask;
         }
     }
+    std::fill(words + (std::size_t)kept_rows*new_row_words, words + new_size, 0);
+    grid.resize(new_size);
 
     width = new_width;
     height = new_height;
+    row_words = new_row_words;
 }
 
 /**
  * Grid::get_index(x, y)
  *
- * Private helper function to determine the 1d index of a 2d coordinate.
+ * Private helper function to determine the 1d index of the word holding a 2d coordinate.
  * Should not be visible from outside the Grid class.
  * The function should be callable from a constant context.
  *
@@ -315,11 +598,27 @@ void Grid::resize(unsigned int new_width, unsigned int new_height){
  *      The y coordinate of the cell.
  *
  * @return
- *      The 1d offset from the start of the data array where the desired cell is located.
+ *      The 1d offset from the start of the data array of the word where the desired cell is located.
 */
-unsigned int Grid::get_index(unsigned int x, unsigned int y) const{
-    // This equation lets you work in a 2D way with a 1D array.
-    return (y*width)+x;
+std::size_t Grid::get_index(unsigned int x, unsigned int y) const{
+    // Rows are padded to whole words, so each row starts row_words words after the previous one.
+    return ((std::size_t)y*row_words)+(x/64);
+}
+
+/**
+ * Grid::get_mask(x)
+ *
+ * Private helper function to determine which bit of its word holds column x.
+ * Should not be visible from outside the Grid class.
+ *
+ * @param x
+ *      The x coordinate of the cell.
+ *
+ * @return
+ *      A word with only the bit for column x set.
+*/
+std::uint64_t Grid::get_mask(unsigned int x){
+    return (std::uint64_t)1 << (x % 64);
 }
 
 /**
@@ -353,12 +652,12 @@ unsigned int Grid::get_index(unsigned int x, unsigned int y) const{
 
 
 Cell Grid::get(int x, int y) const{
-    if(x > (int)width || x < 0){
+    if(x >= (int)width || x < 0){
         throw(std::out_of_range("The value inputted for x in function: Grid::get(x,y) is out of bounds."));
-    } else if (y > (int)height || y < 0){
+    } else if (y >= (int)height || y < 0){
         throw(std::out_of_range("The value inputted for y in function: Grid::get(x,y) is out of bounds."));
     }
-    return Grid::operator()(x,y);
+    return get_unchecked((unsigned int)x, (unsigned int)y);
 }
 
 /**
@@ -389,13 +688,12 @@ Cell Grid::get(int x, int y) const{
  *      std::exception or sub-class if x,y is not a valid coordinate within the grid.
  */
 void Grid::set(const int x, const int y, const Cell value){
-    if(x > (int)width || x < 0){
+    if(x >= (int)width || x < 0){
         throw(std::out_of_range("The value inputted for x in function: Grid::set(x,y,value) is out of bounds."));
-    } else if (y > (int)height || y < 0){
+    } else if (y >= (int)height || y < 0){
         throw(std::out_of_range("The value inputted for y in function: Grid::set(x,y.value) is out of bounds."));
     }
-    Cell &old_value = Grid::operator()(x,y);
-    old_value = value;
+    set_unchecked((unsigned int)x, (unsigned int)y, value);
 }
 
 /**
@@ -417,7 +715,8 @@ void Grid::set(const int x, const int y, const Cell value){
  *
  *      // Extract a reference to an individual cell to avoid calculating it's
  *      // 1d index multiple times if you need to access the cell more than once.
- *      Cell &cell_reference = grid(1, 2);
+ *      // Cells are bit-packed, so the reference is a Grid::CellReference rather than a Cell&.
+ *      Grid::CellReference cell_reference = grid(1, 2);
  *      cell_reference = Cell::DEAD;
  *      cell_reference = Cell::ALIVE;
  *
@@ -428,24 +727,24 @@ void Grid::set(const int x, const int y, const Cell value){
  *      The y coordinate of the cell to access.
  *
  * @return
- *      A modifiable reference to the desired cell.
+ *      A modifiable Grid::CellReference to the desired cell.
  *
  * @throws
  *      std::runtime_error or sub-class if x,y is not a valid coordinate within the grid.
  */
-Cell& Grid::operator()(int x, int y){
-    if(x > (int)width || x < 0){
+Grid::CellReference Grid::operator()(int x, int y){
+    if(x >= (int)width || x < 0){
         throw(std::out_of_range("The value inputted for x in function: Grid::operator(x,y) is out of bounds."));
-    } else if (y > (int)height || y < 0){
+    } else if (y >= (int)height || y < 0){
         throw(std::out_of_range("The value inputted for y in function: Grid::operator(x,y) is out of bounds."));
     }
-    return grid[get_index(x,y)];
+    return CellReference(grid[get_index(x,y)], get_mask(x));
 }
 
 /**
  * Grid::operator()(x, y)
  *
- * Gets a read-only reference to the value at the desired coordinate.
+ * Gets the read-only value at the desired coordinate.
  * The operator should be callable from a constant context.
  * Should be implemented by invoking Grid::get_index(x, y).
  *
@@ -467,18 +766,80 @@ Cell& Grid::operator()(int x, int y){
  *      The y coordinate of the cell to access.
  *
  * @return
- *      A read-only reference to the desired cell.
+ *      The value of the desired cell.
  *
  * @throws
  *      std::exception or sub-class if x,y is not a valid coordinate within the grid.
  */
-const Cell& Grid::operator()(int x, int y) const{
-    if(x > (int)width || x < 0){
+Cell Grid::operator()(int x, int y) const{
+    if(x >= (int)width || x < 0){
         throw(std::out_of_range("The value inputted for x in function: Grid::operator(x,y) is out of bounds."));
-    } else if (y > (int)height || y < 0){
+    } else if (y >= (int)height || y < 0){
         throw(std::out_of_range("The value inputted for y in function: Grid::operator(x,y) is out of bounds."));
     }
-    return grid[get_index(x,y)];
+    return (grid[get_index(x,y)] & get_mask(x)) ? ALIVE : DEAD;
+}
+
+/**
+ * Grid::CellReference::CellReference(word, mask)
+ *
+ * Construct a reference to the single cell held by the set bit of mask within word.
+ * Only Grid::operator()(x, y) needs to construct these.
+ *
+ * @param word
+ *      The packed word holding the cell.
+ *
+ * @param mask
+ *      A word with only the bit for the cell set.
+ */
+Grid::CellReference::CellReference(std::uint64_t& word, std::uint64_t mask): word(word), mask(mask){
+}
+
+/**
+ * Grid::CellReference::operator Cell()
+ *
+ * Read the referenced cell.
+ *
+ * @return
+ *      Cell::ALIVE if the bit is set, Cell::DEAD otherwise.
+ */
+Grid::CellReference::operator Cell() const{
+    return (word & mask) ? ALIVE : DEAD;
+}
+
+/**
+ * Grid::CellReference::operator=(value)
+ *
+ * Overwrite the referenced cell, setting its bit for Cell::ALIVE and clearing it for anything else.
+ *
+ * @param value
+ *      The value to be written to the referenced cell.
+ *
+ * @return
+ *      A reference to this CellReference to enable assignment chaining.
+ */
+Grid::CellReference& Grid::CellReference::operator=(Cell value){
+    if(value == ALIVE){
+        word |= mask;
+    } else{
+        word &= ~mask;
+    }
+    return *this;
+}
+
+/**
+ * Grid::CellReference::operator=(other)
+ *
+ * Copy the value of another referenced cell into this one, i.e. grid(0, 0) = grid(1, 1).
+ *
+ * @param other
+ *      The referenced cell to read from.
+ *
+ * @return
+ *      A reference to this CellReference to enable assignment chaining.
+ */
+Grid::CellReference& Grid::CellReference::operator=(const CellReference& other){
+    return *this = (Cell) other;
 }
 
 /**
@@ -516,28 +877,92 @@ const Cell& Grid::operator()(int x, int y) const{
  *      or if the crop window has a negative size.
  */
 Grid Grid::crop(int x0, int y0, int x1, int y1) const{
-    if(x0 < 0 || x1 < 0 || y0 < 0 || y1 < 0){
-        throw(std::range_error("The value inputted for x and y in function: Grid::crop(x0,y0,x1,y1) is out of bounds."));
-    } else if(x0 > (int)width || x1 > (int)width || x1-x0 > (int)width){
-        throw(std::range_error("The value inputted for x in function: Grid::crop(x0,y0,x1,y1) is out of bounds."));
-    } else if (y0 > (int)height || y1 > (int)height || y1-y0 > (int)height){
-        throw(std::range_error("The value inputted for y in function: Grid::crop(x0,y0,x1,y1) is out of bounds."));
-    } else if (x0 > x1){
-        throw(std::range_error("Error x0 > x1 in function: Grid::crop(x0,y0,x1,y1)"));
-    } else if(y0 > y1){
-        throw(std::range_error("Error y0 > y1 in function: Grid::crop(x0,y0,x1,y1)"));
-    }
+    check_window(x0, y0, x1, y1, "Grid::crop(x0,y0,x1,y1)");
     Grid new_grid = Grid(x1-x0, y1-y0);
 
+    // Bounds are checked once above, so whole words are shifted across without any per-cell checks.
     for(unsigned int j=0; (int)j<(y1-y0); j++){
-        for(unsigned int i=0; (int)i<(x1-x0); i++){
-            new_grid.grid[(j*(x1-x0))+i] = grid[(j+y0)*((int)width)+(i+x0)];
+        const std::uint64_t* row = get_row(j + y0);
+        std::uint64_t* new_row = new_grid.get_row(j);
+        for(unsigned int k=0; k<new_grid.row_words; k++){
+            new_row[k] = read_bits(row, row_words, x0 + k*64) & low_bits(new_grid.width - k*64);
         }
     }
 
     return new_grid;
 }
 
+/**
+ * Grid::crop_in_place(x0, y0, x1, y1)
+ *
+ * Crop the grid to a window of itself, as Grid::crop does, but without making a second grid.
+ * Each kept row is shifted to its new place in the same buffer, which never needs to grow.
+ *
+ * @example
+ *
+ *      // Make a grid
+ *      Grid grid(4, 4);
+ *
+ *      // Trim a 1 cell border off all sides, leaving the centre 2x2
+ *      grid.crop_in_place(1, 1, 3, 3);
+ *
+ * @param x0
+ *      Left coordinate of the crop window on x-axis.
+ *
+ * @param y0
+ *      Top coordinate of the crop window on y-axis.
+ *
+ * @param x1
+ *      Right coordinate of the crop window on x-axis (1 greater than the largest index).
+ *
+ * @param y1
+ *      Bottom coordinate of the crop window on y-axis (1 greater than the largest index).
+ *
+ * @throws
+ *      std::exception or sub-class if x0,y0 or x1,y1 are not valid coordinates within the grid
+ *      or if the crop window has a negative size.
+ */
+void Grid::crop_in_place(int x0, int y0, int x1, int y1){
+    check_window(x0, y0, x1, y1, "Grid::crop_in_place(x0,y0,x1,y1)");
+    unsigned int new_width = x1 - x0, new_height = y1 - y0;
+    unsigned int new_row_words = (new_width + 63) / 64;
+
+    // Every word is written at or before the first word it is read from, and after both of its words are read,
+    // so shifting the rows down in order only overwrites words that are no longer needed.
+    for(unsigned int j=0; j<new_height; j++){
+        const std::uint64_t* row = grid.data() + (std::size_t)(j + y0)*row_words;
+        std::uint64_t* new_row = grid.data() + (std::size_t)j*new_row_words;
+        for(unsigned int k=0; k<new_row_words; k++){
+            new_row[k] = read_bits(row, row_words, x0 + k*64) & low_bits(new_width - k*64);
+        }
+    }
+    grid.resize((std::size_t)new_row_words * new_height);
+    width = new_width;
+    height = new_height;
+    row_words = new_row_words;
+}
+
+/**
+ * Grid::check_window(x0, y0, x1, y1, function)
+ *
+ * Private helper function that throws std::range_error, naming the function, if a crop window is not within
+ * the grid or has a negative size.
+ */
+void Grid::check_window(int x0, int y0, int x1, int y1, const char* function) const{
+    if(x0 < 0 || x1 < 0 || y0 < 0 || y1 < 0){
+        throw(std::range_error("The value inputted for x and y in function: " + std::string(function) +
+                               " is out of bounds."));
+    } else if(x0 > (int)width || x1 > (int)width || x1-x0 > (int)width){
+        throw(std::range_error("The value inputted for x in function: " + std::string(function) + " is out of bounds."));
+    } else if (y0 > (int)height || y1 > (int)height || y1-y0 > (int)height){
+        throw(std::range_error("The value inputted for y in function: " + std::string(function) + " is out of bounds."));
+    } else if (x0 > x1){
+        throw(std::range_error("Error x0 > x1 in function: " + std::string(function)));
+    } else if(y0 > y1){
+        throw(std::range_error("Error y0 > y1 in function: " + std::string(function)));
+    }
+}
+
 /**
  * Grid::merge(other, x0, y0, alive_only = false)
  *
@@ -591,20 +1016,157 @@ void Grid::merge(const Grid& other, int x0, int y0, bool alive_only){
     }
     else {
         for(unsigned int j=0; j<other.height; j++){
-            for(unsigned int i=0; i<other.width; i++){
-                if(!alive_only){
-                set((int)i+x0,(int)j+y0, other.grid[(j*(other.width))+i]);
-                }
-                if(alive_only){
-                    if(get((int)i+x0,(int)j+y0) != ALIVE){
-                        set((int)i+x0,(int)j+y0 ,other.grid[(j*(other.width))+i]);
-                    }
-                }
+            const std::uint64_t* other_row = other.get_row(j);
+            std::uint64_t* row = get_row(j + y0);
+            for(unsigned int k=0; k<other.row_words; k++){
+                // An alive_only merge never clears a cell, so only the alive cells of other are written.
+                std::uint64_t bits = other_row[k];
+                std::uint64_t mask = alive_only ? bits : low_bits(other.width - k*64);
+                write_bits(row, x0 + k*64, bits, mask);
             }
         }
     }
 }
 
+/**
+ * Grid::stamp_rows(pattern, x0, y0, blit, edge, y_begin, y_end)
+ *
+ * Private helper function that stamps a pattern with its top left corner at (x0, y0), writing only the rows of
+ * the grid in the range [y_begin, y_end), so disjoint row ranges can be stamped independently.
+ */
+void Grid::stamp_rows(const Grid& pattern, int x0, int y0, Blit blit, Edge edge,
+                      unsigned int y_begin, unsigned int y_end){
+    if(width == 0 || height == 0){
+        return;
+    }
+    long long left = ((long long) x0 % width + width) % width;
+    for(unsigned int j = 0; j < pattern.height; j++){
+        long long y = (long long) y0 + j;
+        if(edge == WRAP){
+            y = (y % height + height) % height;
+        }
+        if(y < (long long) y_begin || y >= (long long) y_end){
+            continue;
+        }
+        const std::uint64_t* source = pattern.get_row(j);
+        std::uint64_t* row = get_row((unsigned int) y);
+        if(edge == CLIP){
+            long long sx = std::max(0LL, -(long long) x0);
+            long long dx = std::max(0LL, (long long) x0);
+            long long count = std::min((long long) pattern.width - sx, (long long) width - dx);
+            if(count > 0){
+                blit_span(source, pattern.row_words, (unsigned int) sx, row, (unsigned int) dx,
+                          (unsigned int) count, blit);
+            }
+            continue;
+        }
+        // A wrapped row is written as spans, each running up to the right edge before carrying on from column 0.
+        for(unsigned int sx = 0, dx = (unsigned int) left; sx < pattern.width; dx = 0){
+            unsigned int count = std::min(pattern.width - sx, width - dx);
+            blit_span(source, pattern.row_words, sx, row, dx, count, blit);
+            sx += count;
+        }
+    }
+}
+
+/**
+ * Grid::stamp(pattern, x0, y0, blit = OR, edge = CLIP)
+ *
+ * Stamp a pattern on to the grid with its top left corner at (x0, y0), a row of 64 cells at a time.
+ * Unlike Grid::merge the pattern does not need to fit: the part left outside the grid is clipped, or wrapped
+ * around to the opposite edges as if the grid were a torus. The corner can be anywhere, including negative.
+ *
+ * @example
+ *
+ *      // Make a grid
+ *      Grid grid(64, 64);
+ *
+ *      // Add a glider to the alive cells already in the grid, half off the bottom right corner
+ *      grid.stamp(Zoo::glider(), 62, 62);
+ *
+ *      // Overwrite the top left corner with a spaceship, wrapping the part off the top edge to the bottom
+ *      grid.stamp(Zoo::light_weight_spaceship(), 0, -2, Grid::COPY, Grid::WRAP);
+ *
+ * @param pattern
+ *      The grid to stamp on to the current grid, which must not be the current grid.
+ *
+ * @param blit
+ *      Optional parameter. Grid::OR only sets the alive cells of the pattern, Grid::COPY overwrites every cell
+ *      under it. Defaults to Grid::OR.
+ *
+ * @param edge
+ *      Optional parameter. Either Grid::CLIP or Grid::WRAP for cells outside the grid. Defaults to Grid::CLIP.
+ */
+void Grid::stamp(const Grid& pattern, int x0, int y0, Blit blit, Edge edge){
+    stamp_rows(pattern, x0, y0, blit, edge, 0, height);
+}
+
+/**
+ * Grid::stamp(placements, blit = OR, edge = CLIP, threads = 1)
+ *
+ * Stamp a batch of patterns on to the grid in one pass, in the order given, as Grid::stamp would one at a time.
+ *      - Each distinct pattern and rotation is rotated once, however many times it is placed.
+ *      - The rows of the grid are split into bands stamped in parallel, each applying every placement that
+ *        reaches it, so no two threads write the same row and later placements still cover earlier ones.
+ *
+ * @example
+ *
+ *      // Scatter a thousand gliders facing every way across a large grid
+ *      Grid grid(4096, 4096), glider = Zoo::glider();
+ *      std::vector<Grid::Placement> placements;
+ *      for(int i = 0; i < 1000; i++){
+ *          placements.push_back({&glider, (i * 577) % 4096, (i * 1021) % 4096, i % 4});
+ *      }
+ *      grid.stamp(placements, Grid::OR, Grid::WRAP, 0);
+ *
+ * @param placements
+ *      The patterns to stamp, where to put their top left corners after rotating them, and how many quarter
+ *      turns clockwise to rotate them, as Grid::rotate takes. No pattern can be the current grid.
+ *
+ * @param threads
+ *      Optional parameter. The number of threads to stamp with. 0 uses every core. Defaults to 1.
+ *
+ * @throws
+ *      std::invalid_argument if a placement has no pattern.
+ */
+void Grid::stamp(const std::vector<Placement>& placements, Blit blit, Edge edge, unsigned int threads){
+    std::map<std::pair<const Grid*, int>, Grid> rotated;
+    std::vector<const Grid*> patterns(placements.size());
+    for(std::size_t i = 0; i < placements.size(); i++){
+        const Placement& placement = placements[i];
+        if(placement.pattern == nullptr){
+            throw(std::invalid_argument("Grid::stamp error: a placement has no pattern."));
+        }
+        int turns = (placement.rotation % 4 + 4) % 4;
+        if(turns == 0){
+            patterns[i] = placement.pattern;
+            continue;
+        }
+        auto key = std::make_pair(placement.pattern, turns);
+        auto found = rotated.find(key);
+        if(found == rotated.end()){
+            found = rotated.emplace(key, placement.pattern->rotate(turns)).first;
+        }
+        patterns[i] = &found->second;
+    }
+
+    threads = (threads == 0) ? std::max(1u, std::thread::hardware_concurrency()) : threads;
+    unsigned int bands = std::max(1u, std::min(threads, height));
+    auto stamp_band = [&](unsigned int band){
+        unsigned int y_begin = (unsigned int) ((std::uint64_t) height * band / bands);
+        unsigned int y_end = (unsigned int) ((std::uint64_t) height * (band + 1) / bands);
+        for(std::size_t i = 0; i < placements.size(); i++){
+            stamp_rows(*patterns[i], placements[i].x, placements[i].y, blit, edge, y_begin, y_end);
+        }
+    };
+    if(bands == 1){
+        stamp_band(0);
+    } else{
+        ThreadPool pool(bands);
+        pool.run(bands, stamp_band);
+    }
+}
+
 /**
  * Grid::rotate(rotation)
  *
@@ -628,34 +1190,108 @@ void Grid::merge(const Grid& other, int x0, int y0, bool alive_only){
  *      Returns a copy of the grid that has been rotated.
  */
 Grid Grid::rotate(int rotation) const{
-    Grid new_grid = Grid(width, height);
-
     rotation = std::abs(rotation % 4 + 4) % 4;
     // 0 = no rotation
     // 1 = 90 degrees clockwise
     // 2 = 180 degrees
     // 3 = 90 degrees anti-clockwise
+    if(rotation == 0){
+        return *this;
+    } else if(rotation == 2){
+        Grid new_grid = *this;
+        new_grid.rotate_in_place(2);
+        return new_grid;
+    }
+
+    // A clockwise turn takes column x of each row to row x, read bottom to top, and an anti-clockwise turn
+    // takes it to row width - 1 - x, read top to bottom.
+    Grid new_grid = transpose();
+    if(rotation == 1){
+        for(unsigned int j=0; j<new_grid.height; j++){
+            reverse_row(new_grid.get_row(j), new_grid.row_words, new_grid.width);
+        }
+    } else{
+        for(unsigned int j=0; j<new_grid.height / 2; j++){
+            std::swap_ranges(new_grid.get_row(j), new_grid.get_row(j) + new_grid.row_words,
+                             new_grid.get_row(new_grid.height - 1 - j));
+        }
+    }
+    return new_grid;
+}
 
-    for(unsigned int j=0; j<new_grid.height; j++){
-        for(unsigned int i=0; i<new_grid.width; i++){
-            if(rotation == 1){
-                new_grid.width = height;
-                new_grid.height = width;
-                new_grid.set((int)i,(int)j, get((int)j,(int)(height-1-i)));
-            } else if ( rotation == 2){
-                new_grid.set((int)i,(int)j, get((int)(width-i-1),(int)(height-j-1)));
-            } else if (rotation == 3){
-                new_grid.width = height;
-                new_grid.height = width;
-                new_grid.set((int)i,(int)j, get((int)(width-1-j),(int)i));
-            } else{
-                new_grid.set((int)i,(int)j, get((int)i,(int)j));
+/**
+ * Grid::transpose()
+ *
+ * Create a copy of the grid mirrored along its main diagonal, so the cell at (x, y) moves to (y, x).
+ * The grid is split into blocks of 64x64 cells, which are transposed as bit matrices.
+ * The function should be callable from a constant context.
+ *
+ * @example
+ *
+ *      // Make a 1x3 grid
+ *      Grid x(1,3);
+ *
+ *      // y is size 3x1
+ *      Grid y = x.transpose();
+ *
+ * @return
+ *      Returns a transposed copy of the grid, with the width and height swapped.
+ */
+Grid Grid::transpose() const{
+    Grid new_grid(height, width);
+    std::uint64_t block[64];
+    for(unsigned int by=0; by<new_grid.row_words; by++){
+        unsigned int rows = std::min(64u, height - by*64);
+        for(unsigned int bx=0; bx<row_words; bx++){
+            // Rows past the height are read as dead, which leaves the padding of the new rows at 0.
+            for(unsigned int r=0; r<64; r++){
+                block[r] = (r < rows) ? grid[(std::size_t)(by*64 + r)*row_words + bx] : 0;
+            }
+            transpose_block(block);
+            unsigned int columns = std::min(64u, width - bx*64);
+            for(unsigned int c=0; c<columns; c++){
+                new_grid.grid[(std::size_t)(bx*64 + c)*new_grid.row_words + by] = block[c];
             }
         }
     }
     return new_grid;
 }
 
+/**
+ * Grid::rotate_in_place(rotation)
+ *
+ * Rotate the grid by a multiple of 90 degrees, as Grid::rotate does, replacing its contents.
+ * A half turn mirrors every row and swaps the rows end to end without any new grid. A quarter turn changes
+ * the row layout, so it transposes into a copy from the pool and takes its words.
+ *
+ * @example
+ *
+ *      // Make a glider and turn it to fly the other way
+ *      Grid glider = Zoo::glider();
+ *      glider.rotate_in_place(2);
+ *
+ * @param rotation
+ *      An positive or negative integer to rotate by in 90 intervals.
+ */
+void Grid::rotate_in_place(int rotation){
+    rotation = std::abs(rotation % 4 + 4) % 4;
+    if(rotation % 2 == 1){
+        *this = rotate(rotation);
+        return;
+    }
+    if(rotation == 2){
+        for(unsigned int j=0; j<(height + 1) / 2; j++){
+            std::uint64_t* top = get_row(j);
+            std::uint64_t* bottom = get_row(height - 1 - j);
+            reverse_row(top, row_words, width);
+            if(top != bottom){
+                reverse_row(bottom, row_words, width);
+                std::swap_ranges(top, top + row_words, bottom);
+            }
+        }
+    }
+}
+
 /**
  * operator<<(output_stream, grid)
  *
@@ -693,29 +1329,19 @@ Grid Grid::rotate(int rotation) const{
  */
 std::ostream& operator<<(std::ostream& output_stream, const Grid& grid){
 
-    output_stream << "+";
-    for(unsigned int i=0; i < grid.get_width(); i++){
-        output_stream << "-";
-    }
-    output_stream << "+\n";
+    // Each line is built in a buffer and written with one call, rather than one stream insertion per cell.
+    std::string border = "+" + std::string(grid.get_width(), '-') + "+\n";
+    output_stream << border;
 
+    std::string line(grid.get_width() + 3, ' ');
+    line[0] = '|';
+    line[grid.get_width() + 1] = '|';
+    line[grid.get_width() + 2] = '\n';
     for(unsigned int j=0; j< grid.get_height(); j++){
-        output_stream << "|";
-        for(unsigned int i=0; i< grid.get_width(); i++){
-            if(grid.get((int)i,(int)j) == Cell::ALIVE){
-                output_stream << "#";
-            }
-            else{
-                output_stream << " ";
-            }
-        }
-        output_stream << "|\n";
+        grid.format_row(j, &line[1]);
+        output_stream.write(line.data(), (std::streamsize)line.size());
     }
 
-    output_stream << "+";
-    for(unsigned int i=0; i < grid.get_width(); i++){
-        output_stream << "-";
-    }
-    output_stream << "+\n";
+    output_stream << border;
     return output_stream;
 }
\ No newline at end of file
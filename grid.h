@@ -13,7 +13,10 @@
 // Add the minimal number of includes you need in order to declare the class.
 // #include ...
 
+#include <cstdint>
+#include <iosfwd>
 #include <vector>
+#include "grid_pool.h"
 
 /**
  * A Cell is a char limited to two named values for Cell::DEAD and Cell::ALIVE.
@@ -25,17 +28,70 @@ enum Cell : char {
 
 /**
  * Declare the structure of the Grid class for representing a 2d grid of cells.
+ *
+ * Cells are bit-packed, one bit per cell, with each row padded up to a whole number of 64-bit words.
+ *      - Bit (x % 64) of word (x / 64) in a row holds the cell at column x, a set bit is Cell::ALIVE.
+ *      - Padding bits past the width of a row are always kept as 0.
+ *
+ * Grid::get, Grid::set and Grid::operator() check their coordinates and throw when they are out of bounds.
+ * Grid::get_unchecked, Grid::set_unchecked and Grid::get_row skip the checks, for loops whose bounds are
+ * already known. The unchecked cell accessors are defined in this header so they inline into those loops.
+ *
+ * The words are allocated through PoolAllocator, so temporary grids reuse recently freed blocks.
  */
 class Grid {
     // How to draw an owl:
     //      Step 1. Draw a circle.
     //      Step 2. Draw the rest of the owl.
+public:
+    class CellReference;
+
+    /**
+     * The counts of a grid and the smallest box spanning [x0, x1) by [y0, y1) holding every alive cell,
+     * as returned by Grid::get_summary. The box is empty at (0, 0) when no cell is alive.
+     */
+    struct Summary {
+        unsigned int alive_cells;
+        unsigned int dead_cells;
+        unsigned int x0, y0, x1, y1;
+    };
+
+    /**
+     * How Grid::stamp writes a pattern, overwriting every cell under it or only setting its alive cells.
+     */
+    enum Blit {
+        COPY,
+        OR
+    };
+
+    /**
+     * What Grid::stamp does with the part of a pattern outside the grid, dropping it or wrapping it around.
+     */
+    enum Edge {
+        CLIP,
+        WRAP
+    };
+
+    /**
+     * One pattern of a batch for Grid::stamp, with its top left corner at (x, y) after turning it clockwise
+     * by rotation quarter turns. The pattern is not copied and must outlive the call.
+     */
+    struct Placement {
+        const Grid* pattern;
+        int x, y;
+        int rotation;
+    };
 private:
     unsigned int width;
     unsigned int height;
-    std::vector<Cell> grid;
+    unsigned int row_words;
+    std::vector<std::uint64_t, PoolAllocator<std::uint64_t>> grid;
 
-    unsigned int get_index(unsigned int x, unsigned int y) const;
+    std::size_t get_index(unsigned int x, unsigned int y) const;
+    static std::uint64_t get_mask(unsigned int x);
+    void check_window(int x0, int y0, int x1, int y1, const char* function) const;
+    void stamp_rows(const Grid& pattern, int x0, int y0, Blit blit, Edge edge, unsigned int y_begin,
+                    unsigned int y_end);
 public:
     Grid();
     explicit Grid(unsigned int square_size);
@@ -45,14 +101,60 @@ public:
     unsigned int get_total_cells() const;
     unsigned int get_alive_cells() const;
     unsigned int get_dead_cells() const;
+    Summary get_summary() const;
+    unsigned int get_row_words() const;
+    std::uint64_t* get_row(unsigned int y);
+    const std::uint64_t* get_row(unsigned int y) const;
+    void format_row(unsigned int y, char* characters) const;
     void resize(unsigned int square_size);
     void resize(unsigned int width, unsigned int height);
     Cell get(int x, int y) const;
     void set(int x, int y, Cell value);
-    Cell& operator()(int x, int y);
-    const Cell& operator()(int x, int y) const;
+    Cell get_unchecked(unsigned int x, unsigned int y) const;
+    void set_unchecked(unsigned int x, unsigned int y, Cell value);
+    CellReference operator()(int x, int y);
+    Cell operator()(int x, int y) const;
     Grid crop( int x0, int y0, int x1, int y1) const;
+    void crop_in_place(int x0, int y0, int x1, int y1);
     void merge(const Grid& other, int x0, int y0, bool alive_only = false);
+    void stamp(const Grid& pattern, int x0, int y0, Blit blit = OR, Edge edge = CLIP);
+    void stamp(const std::vector<Placement>& placements, Blit blit = OR, Edge edge = CLIP, unsigned int threads = 1);
     Grid rotate(int rotation) const;
+    void rotate_in_place(int rotation);
+    Grid transpose() const;
     friend std::ostream& operator<<(std::ostream& output_stream, const Grid& grid);
-};
\ No newline at end of file
+};
+
+/**
+ * A modifiable reference to a single bit-packed cell, returned by the non-const Grid::operator()(x, y).
+ */
+class Grid::CellReference {
+private:
+    std::uint64_t& word;
+    std::uint64_t mask;
+public:
+    CellReference(std::uint64_t& word, std::uint64_t mask);
+    operator Cell() const;
+    CellReference& operator=(Cell value);
+    CellReference& operator=(const CellReference& other);
+};
+
+/**
+ * Grid::get_unchecked(x, y)
+ *
+ * Returns the value of the cell at the desired coordinate, which must be within the grid.
+ */
+inline Cell Grid::get_unchecked(unsigned int x, unsigned int y) const{
+    return ((grid[(std::size_t)y * row_words + x / 64] >> (x % 64)) & 1) ? ALIVE : DEAD;
+}
+
+/**
+ * Grid::set_unchecked(x, y, value)
+ *
+ * Overwrites the value at the desired coordinate, which must be within the grid.
+ */
+inline void Grid::set_unchecked(unsigned int x, unsigned int y, Cell value){
+    std::uint64_t& word = grid[(std::size_t)y * row_words + x / 64];
+    std::uint64_t mask = (std::uint64_t)1 << (x % 64);
+    word = (value == ALIVE) ? (word | mask) : (word & ~mask);
+}
@@ -0,0 +1,143 @@
+/**
+ * Implements a pool of reusable memory blocks for the words of Grid objects.
+ *      - Cropping, rotating and merging patterns makes and drops many small grids, and without a pool every one of
+ *        them is a call to the heap both ways. Grid stores its words through PoolAllocator instead.
+ *
+ *      - Blocks are rounded up to a power of two of at least 64 bytes, and each size has a free list.
+ *          - A released block goes on the free list of the calling thread, and the next allocation of the same
+ *            size on that thread takes it back without touching the heap or any lock.
+ *          - Each thread keeps at most 8 blocks of each size and 64MB in total, releasing the rest to the heap.
+ *          - Blocks larger than 16MB are never kept, since a world that large is not a temporary.
+ *          - A thread's blocks are freed when the thread exits, or by GridPool::trim.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#include <new>
+#include "grid_pool.h"
+
+namespace {
+    const unsigned int MIN_CLASS = 6;
+    const unsigned int MAX_CLASS = 24;
+    const unsigned int MAX_BLOCKS_PER_CLASS = 8;
+    const std::size_t MAX_CACHED_BYTES = (std::size_t) 64 << 20;
+
+    // The free lists are plain arrays, which need no guard to reach from a thread_local, so the common
+    // allocate and release are only a few instructions.
+    thread_local void* free_blocks[MAX_CLASS + 1][MAX_BLOCKS_PER_CLASS];
+    thread_local unsigned int free_counts[MAX_CLASS + 1];
+    thread_local std::size_t cached_bytes;
+    thread_local bool exiting;
+
+    void clear_cache(){
+        for(unsigned int c = MIN_CLASS; c <= MAX_CLASS; c++){
+            while(free_counts[c] > 0){
+                ::operator delete(free_blocks[c][--free_counts[c]]);
+            }
+        }
+        cached_bytes = 0;
+    }
+
+    /**
+     * Returns the blocks of a thread to the heap when the thread exits. One is made the first time a thread
+     * keeps a block, and blocks released after it is destroyed go straight back to the heap.
+     */
+    struct CacheCleaner {
+        ~CacheCleaner(){
+            clear_cache();
+            exiting = true;
+        }
+    };
+
+    thread_local bool has_cleaner;
+
+    // The smallest size class holding a block of this many bytes, or MAX_CLASS + 1 if it is too large to keep.
+    unsigned int get_class(std::size_t bytes){
+        if(bytes > ((std::size_t) 1 << MAX_CLASS)){
+            return MAX_CLASS + 1;
+        }
+        if(bytes <= ((std::size_t) 1 << MIN_CLASS)){
+            return MIN_CLASS;
+        }
+        return 64 - (unsigned int) __builtin_clzll((unsigned long long) bytes - 1);
+    }
+}
+
+/**
+ * GridPool::allocate(bytes)
+ *
+ * Take a block of at least the given size from the free lists of the calling thread, or from the heap.
+ *
+ * @param bytes
+ *      The size of the block.
+ *
+ * @return
+ *      The block, which must be given back to GridPool::release with the same size.
+ *
+ * @throws
+ *      std::bad_alloc if the heap is exhausted.
+ */
+void* GridPool::allocate(std::size_t bytes){
+    unsigned int c = get_class(bytes);
+    if(c > MAX_CLASS){
+        return ::operator new(bytes);
+    }
+    if(free_counts[c] > 0){
+        cached_bytes -= (std::size_t) 1 << c;
+        return free_blocks[c][--free_counts[c]];
+    }
+    return ::operator new((std::size_t) 1 << c);
+}
+
+/**
+ * GridPool::release(block, bytes)
+ *
+ * Give a block back to the free lists of the calling thread, or to the heap if they are full.
+ * Blocks can be released on a different thread to the one that allocated them.
+ *
+ * @param block
+ *      A block from GridPool::allocate, or nullptr.
+ *
+ * @param bytes
+ *      The size the block was allocated with.
+ */
+void GridPool::release(void* block, std::size_t bytes){
+    if(!block){
+        return;
+    }
+    unsigned int c = get_class(bytes);
+    if(c > MAX_CLASS || exiting || free_counts[c] >= MAX_BLOCKS_PER_CLASS ||
+       cached_bytes + ((std::size_t) 1 << c) > MAX_CACHED_BYTES){
+        ::operator delete(block);
+        return;
+    }
+    if(!has_cleaner){
+        has_cleaner = true;
+        static thread_local CacheCleaner cleaner;
+        (void) cleaner;
+    }
+    free_blocks[c][free_counts[c]++] = block;
+    cached_bytes += (std::size_t) 1 << c;
+}
+
+/**
+ * GridPool::get_cached_bytes()
+ *
+ * Gets the total size of the blocks waiting for reuse on the calling thread.
+ *
+ * @return
+ *      The number of bytes held by the free lists of the calling thread.
+ */
+std::size_t GridPool::get_cached_bytes(){
+    return cached_bytes;
+}
+
+/**
+ * GridPool::trim()
+ *
+ * Return every block waiting for reuse on the calling thread to the heap, for example after building a large
+ * pattern out of many temporary grids.
+ */
+void GridPool::trim(){
+    clear_cache();
+}
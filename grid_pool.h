@@ -0,0 +1,54 @@
+/**
+ * Declares a pool of reusable memory blocks for the words of Grid objects, and an allocator that draws from it.
+ * Rich documentation for the api and behaviour of the pool can be found in grid_pool.cpp.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Declare the interface of the GridPool namespace for recycling the storage of short-lived grids.
+ */
+namespace GridPool {
+    void* allocate(std::size_t bytes);
+    void release(void* block, std::size_t bytes);
+    std::size_t get_cached_bytes();
+    void trim();
+}
+
+/**
+ * A standard allocator that takes its blocks from the GridPool of the calling thread,
+ * so a grid created, cropped or destroyed in a loop reuses the same few blocks instead of calling the heap.
+ */
+template<typename T>
+class PoolAllocator {
+public:
+    typedef T value_type;
+
+    PoolAllocator() = default;
+
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>&){
+    }
+
+    T* allocate(std::size_t count){
+        return static_cast<T*>(GridPool::allocate(count * sizeof(T)));
+    }
+
+    void deallocate(T* block, std::size_t count){
+        GridPool::release(block, count * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(const PoolAllocator<U>&) const{
+        return true;
+    }
+
+    template<typename U>
+    bool operator!=(const PoolAllocator<U>&) const{
+        return false;
+    }
+};
@@ -0,0 +1,1000 @@
+/**
+ * Implements a class simulating Conway's Game of Life on an unbounded plane with Gosper's HashLife algorithm.
+ *      - https://en.wikipedia.org/wiki/Hashlife
+ *
+ *      - The universe is a quadtree of Nodes. A node of level k is a square of 2^k by 2^k cells made of four
+ *        level k - 1 nodes, and level 0 nodes are single cells.
+ *          - Nodes are canonicalised through a hash table, so every distinct square is stored exactly once and
+ *            repeated structure, such as empty space or copies of the same still life, costs nothing extra.
+ *
+ *      - The centre of a level k node, a square of 2^(k-1) cells, can be advanced up to 2^(k-2) generations
+ *        without looking outside the node, since information travels at most one cell per generation.
+ *          - That result is memoised in the node, so advancing the same square again is a table lookup.
+ *          - Results are built recursively from the results of smaller overlapping nodes, which lets a step of
+ *            2^j generations cost roughly as much as a single generation while the structure repeats.
+ *
+ *      - HashLife takes and returns Grid objects, so patterns from the Zoo or a World can be advanced and the
+ *        result passed back to World(const Grid&).
+ *          - Unlike World, the plane is unbounded. Cells (0, 0) to (width - 1, height - 1) of the universe are the
+ *            cells of the initial grid, and cells can move to any coordinate, including negative ones.
+ *          - Universes can also be built node by node, with HashLife::join and HashLife::set_root, or block by
+ *            block with HashLife::set_block, so patterns far larger than any Grid can be loaded from file.
+ *
+ *      - Any Life-like Rule without birth on 0 neighbours can be simulated, since the memoised results only
+ *        depend on the rule through the 4x4 base case. Changing the rule forgets every result.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#include <algorithm>
+#include <stdexcept>
+#include "hashlife.h"
+
+namespace {
+    // Past this level the coordinates of a node's corners would no longer fit in a long long.
+    const unsigned int MAX_LEVEL = 62;
+
+    // The default node limit, roughly 320MB of nodes, before unreachable nodes are collected.
+    const std::size_t DEFAULT_MAX_NODES = 1 << 23;
+}
+
+/**
+ * HashLife::NodeKey::operator==(other)
+ *
+ * Compare the four children of two nodes, which identify a node of level 1 or more uniquely.
+ */
+bool HashLife::NodeKey::operator==(const NodeKey& other) const{
+    return nw == other.nw && ne == other.ne && sw == other.sw && se == other.se;
+}
+
+/**
+ * HashLife::NodeKeyHash::operator()(key)
+ *
+ * Hash the four children of a node for the canonicalisation table.
+ */
+std::size_t HashLife::NodeKeyHash::operator()(const NodeKey& key) const{
+    std::uint64_t hash = key.nw;
+    hash = hash * 0x9E3779B97F4A7C15ULL + key.ne;
+    hash = hash * 0x9E3779B97F4A7C15ULL + key.sw;
+    hash = hash * 0x9E3779B97F4A7C15ULL + key.se;
+    return (std::size_t) (hash ^ (hash >> 29));
+}
+
+/**
+ * HashLife::HashLife()
+ *
+ * Construct an empty universe, with an empty 0x0 window returned by HashLife::get_state().
+ *
+ * @example
+ *
+ *      // Make an empty universe
+ *      HashLife life;
+ *
+ */
+HashLife::HashLife(): root(0), origin_x(0), origin_y(0), width(0), height(0), generation(0),
+                      max_nodes(DEFAULT_MAX_NODES){
+    reset();
+    root = get_empty(3);
+}
+
+/**
+ * HashLife::HashLife(initial_state)
+ *
+ * Construct a universe containing the alive cells of a grid, placed with the top left of the grid at (0, 0).
+ * Everything outside the grid starts dead.
+ *
+ * @example
+ *
+ *      // Make a universe from an r-pentomino
+ *      HashLife life(Zoo::r_pentomino());
+ *
+ *      // This should be a compiler error! We want to prevent this from being allowed.
+ *      HashLife bad_life = Zoo::r_pentomino();
+ *
+ * @param initial_state
+ *      The grid of cells to start from.
+ */
+HashLife::HashLife(const Grid& initial_state): root(0), origin_x(0), origin_y(0),
+                                               width(initial_state.get_width()), height(initial_state.get_height()),
+                                               generation(0), max_nodes(DEFAULT_MAX_NODES){
+    reset();
+    unsigned int level = 3;
+    while(level < MAX_LEVEL && ((1ULL << level) < width || (1ULL << level) < height)){
+        level++;
+    }
+    root = build(initial_state, level, 0, 0);
+}
+
+/**
+ * HashLife::reset()
+ *
+ * Private helper function that empties the node store and recreates the two level 0 nodes,
+ * which are always NodeId 0 for a dead cell and NodeId 1 for an alive cell.
+ */
+void HashLife::reset(){
+    nodes.clear();
+    index.clear();
+    empty_nodes.clear();
+    nodes.push_back(Node{0, 0, 0, 0, 0, 0, 0, -1});
+    nodes.push_back(Node{0, 0, 0, 0, 1, 0, 0, -1});
+}
+
+/**
+ * HashLife::get_cell(alive)
+ *
+ * Get the level 0 node for a single cell.
+ *
+ * @param alive
+ *      True for the Cell::ALIVE node, false for the Cell::DEAD node.
+ *
+ * @return
+ *      NodeId 1 for an alive cell, and NodeId 0 for a dead cell.
+ */
+HashLife::NodeId HashLife::get_cell(bool alive) const{
+    return alive ? 1 : 0;
+}
+
+/**
+ * HashLife::get_empty(level)
+ *
+ * Get the node of the given level with no alive cells, creating it if needed.
+ *
+ * @param level
+ *      The level of the node, a square of 2^level cells.
+ *
+ * @return
+ *      The canonical empty node of that level.
+ */
+HashLife::NodeId HashLife::get_empty(unsigned int level){
+    while(empty_nodes.size() <= level){
+        if(empty_nodes.empty()){
+            empty_nodes.push_back(get_cell(false));
+        } else{
+            NodeId empty = empty_nodes.back();
+            empty_nodes.push_back(join(empty, empty, empty, empty));
+        }
+    }
+    return empty_nodes[level];
+}
+
+/**
+ * HashLife::join(nw, ne, sw, se)
+ *
+ * Get the canonical node made of four nodes of the same level, creating it if this square has not been seen
+ * before. Together with HashLife::get_cell, HashLife::get_block and HashLife::set_root this lets file loaders
+ * build a universe directly from its quadtree.
+ *
+ * @example
+ *
+ *      // Build a 16x16 node with a glider in its top left 8x8 block
+ *      HashLife life;
+ *      unsigned char rows[8] = {0x02, 0x04, 0x07, 0, 0, 0, 0, 0};
+ *      HashLife::NodeId empty = life.get_empty(3);
+ *      life.set_root(life.join(life.get_block(rows), empty, empty, empty), 0, 0);
+ *
+ * @param nw
+ *      The top left quadrant.
+ *
+ * @param ne
+ *      The top right quadrant.
+ *
+ * @param sw
+ *      The bottom left quadrant.
+ *
+ * @param se
+ *      The bottom right quadrant.
+ *
+ * @return
+ *      The node one level above its children.
+ *
+ * @throws
+ *      std::invalid_argument if the four nodes are not all the same level.
+ */
+HashLife::NodeId HashLife::join(NodeId nw, NodeId ne, NodeId sw, NodeId se){
+    NodeKey key = {nw, ne, sw, se};
+    auto found = index.find(key);
+    if(found != index.end()){
+        return found->second;
+    }
+    if(nodes[nw].level != nodes[ne].level || nodes[nw].level != nodes[sw].level || nodes[nw].level != nodes[se].level){
+        throw(std::invalid_argument("HashLife::join error: the four nodes must be the same level."));
+    }
+    Node node;
+    node.nw = nw;
+    node.ne = ne;
+    node.sw = sw;
+    node.se = se;
+    node.population = nodes[nw].population + nodes[ne].population + nodes[sw].population + nodes[se].population;
+    node.level = nodes[nw].level + 1;
+    node.result = 0;
+    node.result_log = -1;
+    NodeId id = (NodeId) nodes.size();
+    nodes.push_back(node);
+    index.emplace(key, id);
+    return id;
+}
+
+/**
+ * HashLife::get_block(rows)
+ *
+ * Get the level 3 node for an 8x8 block of cells, where bit x of rows[y] is the cell at (x, y).
+ *
+ * @param rows
+ *      The 8 rows of the block, top row first.
+ *
+ * @return
+ *      The canonical node for the block.
+ */
+HashLife::NodeId HashLife::get_block(const unsigned char rows[8]){
+    bool any = false;
+    for(int r = 0; r < 8; r++){
+        any = any || rows[r] != 0;
+    }
+    if(!any){
+        return get_empty(3);
+    }
+    NodeId quadrants[2][2];
+    for(int qy = 0; qy < 2; qy++){
+        for(int qx = 0; qx < 2; qx++){
+            NodeId pairs[2][2];
+            for(int py = 0; py < 2; py++){
+                for(int px = 0; px < 2; px++){
+                    int cx = qx * 4 + px * 2, cy = qy * 4 + py * 2;
+                    pairs[py][px] = join(get_cell((rows[cy] >> cx) & 1), get_cell((rows[cy] >> (cx + 1)) & 1),
+                                         get_cell((rows[cy + 1] >> cx) & 1), get_cell((rows[cy + 1] >> (cx + 1)) & 1));
+                }
+            }
+            quadrants[qy][qx] = join(pairs[0][0], pairs[0][1], pairs[1][0], pairs[1][1]);
+        }
+    }
+    return join(quadrants[0][0], quadrants[0][1], quadrants[1][0], quadrants[1][1]);
+}
+
+/**
+ * HashLife::build(grid, level, x, y)
+ *
+ * Private helper function to build the node of the given level covering the cells from (x, y) of a grid.
+ * Squares of 8x8 cells are read straight from the packed rows of the grid, and empty ones are skipped.
+ */
+HashLife::NodeId HashLife::build(const Grid& grid, unsigned int level, long long x, long long y){
+    if(x >= (long long) grid.get_width() || y >= (long long) grid.get_height()){
+        return get_empty(level);
+    }
+    if(level == 3){
+        // x is a multiple of 8, so each row of the square is one byte of a packed word.
+        unsigned char bits[8] = {0};
+        for(long long r = 0; r < 8 && y + r < (long long) grid.get_height(); r++){
+            bits[r] = (unsigned char) (grid.get_row((unsigned int) (y + r))[x / 64] >> (x % 64));
+        }
+        return get_block(bits);
+    }
+    long long half = 1LL << (level - 1);
+    NodeId nw = build(grid, level - 1, x, y);
+    NodeId ne = build(grid, level - 1, x + half, y);
+    NodeId sw = build(grid, level - 1, x, y + half);
+    NodeId se = build(grid, level - 1, x + half, y + half);
+    return join(nw, ne, sw, se);
+}
+
+/**
+ * HashLife::expand(node)
+ *
+ * Private helper function to surround the root with a border of empty space, doubling its size.
+ * The old root becomes the centre of the new one, so the origin moves up and left by a quarter of the new size.
+ */
+HashLife::NodeId HashLife::expand(NodeId node){
+    Node old = nodes[node];
+    if(old.level >= MAX_LEVEL){
+        throw(std::overflow_error("HashLife::expand error: the universe has grown too large to address."));
+    }
+    NodeId empty = get_empty(old.level - 1);
+    NodeId nw = join(empty, empty, empty, old.nw);
+    NodeId ne = join(empty, empty, old.ne, empty);
+    NodeId sw = join(empty, old.sw, empty, empty);
+    NodeId se = join(old.se, empty, empty, empty);
+    origin_x -= 1LL << (old.level - 1);
+    origin_y -= 1LL << (old.level - 1);
+    return join(nw, ne, sw, se);
+}
+
+/**
+ * HashLife::is_centred(node)
+ *
+ * Private helper function to check that every alive cell of a node of level 3 or more lies in its middle
+ * square of half its size, so that its centre can be advanced without any cell escaping it.
+ */
+bool HashLife::is_centred(NodeId node) const{
+    const Node& n = nodes[node];
+    std::uint64_t inner = nodes[nodes[nodes[n.nw].se].se].population;
+    inner += nodes[nodes[nodes[n.ne].sw].sw].population;
+    inner += nodes[nodes[nodes[n.sw].ne].ne].population;
+    inner += nodes[nodes[nodes[n.se].nw].nw].population;
+    return inner == n.population;
+}
+
+/**
+ * HashLife::evolve_4x4(node)
+ *
+ * Private helper function for the base case of the recursion, applying the rule of the universe
+ * once to the centre 2x2 cells of a 4x4 node.
+ *
+ * @return
+ *      The level 1 node of the centre after one generation.
+ */
+HashLife::NodeId HashLife::evolve_4x4(NodeId node){
+    // Level 0 node ids are 0 for dead and 1 for alive, so they can be read as cell values directly.
+    int cells[4][4];
+    const Node& n = nodes[node];
+    NodeId quadrants[4] = {n.nw, n.ne, n.sw, n.se};
+    for(int q = 0; q < 4; q++){
+        const Node& quadrant = nodes[quadrants[q]];
+        int x = (q % 2) * 2, y = (q / 2) * 2;
+        cells[y][x] = (int) quadrant.nw;
+        cells[y][x + 1] = (int) quadrant.ne;
+        cells[y + 1][x] = (int) quadrant.sw;
+        cells[y + 1][x + 1] = (int) quadrant.se;
+    }
+
+    NodeId next[2][2];
+    for(int y = 1; y <= 2; y++){
+        for(int x = 1; x <= 2; x++){
+            int neighbours = -cells[y][x];
+            for(int j = -1; j <= 1; j++){
+                for(int i = -1; i <= 1; i++){
+                    neighbours += cells[y + j][x + i];
+                }
+            }
+            next[y - 1][x - 1] = get_cell(rule.get_next(cells[y][x] != 0, (unsigned int) neighbours));
+        }
+    }
+    return join(next[0][0], next[0][1], next[1][0], next[1][1]);
+}
+
+/**
+ * HashLife::successor(node, step_log)
+ *
+ * Private helper function that advances the centre of a node of level k >= 2 by 2^min(step_log, k - 2)
+ * generations. The result is memoised in the node for that step size.
+ *
+ * The node is split into nine overlapping squares of half its size. Advancing each of those gives nine squares
+ * a quarter of its size, which overlap to cover the centre. For the largest step those are joined in fours and
+ * advanced a second time, otherwise the centres of the fours are already the answer.
+ *
+ * @return
+ *      The level k - 1 node at the centre of the node, advanced in time.
+ */
+HashLife::NodeId HashLife::successor(NodeId node, int step_log){
+    // Copy out of the store, since adding nodes below may reallocate it.
+    Node n = nodes[node];
+    if(n.population == 0){
+        return get_empty(n.level - 1);
+    }
+    int effective_log = std::min(step_log, (int) n.level - 2);
+    if(n.result_log == effective_log){
+        return n.result;
+    }
+
+    NodeId result;
+    if(n.level == 2){
+        result = evolve_4x4(node);
+    } else{
+        Node a = nodes[n.nw], b = nodes[n.ne], c = nodes[n.sw], d = nodes[n.se];
+        NodeId squares[3][3] = {
+                {n.nw, join(a.ne, b.nw, a.se, b.sw), n.ne},
+                {join(a.sw, a.se, c.nw, c.ne), join(a.se, b.sw, c.ne, d.nw), join(b.sw, b.se, d.nw, d.ne)},
+                {n.sw, join(c.ne, d.nw, c.se, d.sw), n.se}
+        };
+        NodeId advanced[3][3];
+        for(int j = 0; j < 3; j++){
+            for(int i = 0; i < 3; i++){
+                advanced[j][i] = successor(squares[j][i], effective_log);
+            }
+        }
+
+        NodeId quadrants[2][2];
+        for(int j = 0; j < 2; j++){
+            for(int i = 0; i < 2; i++){
+                NodeId p = advanced[j][i], q = advanced[j][i + 1], r = advanced[j + 1][i], s = advanced[j + 1][i + 1];
+                if(effective_log < (int) n.level - 2){
+                    // The first pass already advanced the full step, so just take the centre of the four.
+                    quadrants[j][i] = join(nodes[p].se, nodes[q].sw, nodes[r].ne, nodes[s].nw);
+                } else{
+                    quadrants[j][i] = successor(join(p, q, r, s), effective_log);
+                }
+            }
+        }
+        result = join(quadrants[0][0], quadrants[0][1], quadrants[1][0], quadrants[1][1]);
+    }
+
+    nodes[node].result = result;
+    nodes[node].result_log = effective_log;
+    return result;
+}
+
+/**
+ * HashLife::advance_pow2(step_log)
+ *
+ * Private helper function that advances the whole universe by 2^step_log generations.
+ * The root is expanded until it is large enough for the step and all alive cells are within its middle,
+ * so none of them can escape the centre that HashLife::successor returns.
+ */
+void HashLife::advance_pow2(int step_log){
+    if(nodes[root].population != 0){
+        while((int) nodes[root].level < step_log + 3 || !is_centred(root)){
+            root = expand(root);
+        }
+        unsigned int level = nodes[root].level;
+        root = successor(root, step_log);
+        origin_x += 1LL << (level - 2);
+        origin_y += 1LL << (level - 2);
+    }
+    generation += 1ULL << step_log;
+}
+
+/**
+ * HashLife::get_node(node)
+ *
+ * Gets the children, population and level of a node, for walking the quadtree.
+ * A reference is only valid until the next call that adds nodes.
+ * The function should be callable from a constant context.
+ *
+ * @param node
+ *      The node to look up.
+ *
+ * @return
+ *      A read-only reference to the node.
+ */
+const HashLife::Node& HashLife::get_node(NodeId node) const{
+    return nodes[node];
+}
+
+/**
+ * HashLife::get_root()
+ *
+ * Gets the node holding the whole universe.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The root node, whose top left cell is at (HashLife::get_origin_x(), HashLife::get_origin_y()).
+ */
+HashLife::NodeId HashLife::get_root() const{
+    return root;
+}
+
+/**
+ * HashLife::get_origin_x()
+ *
+ * Gets the x coordinate of the top left cell of the root node.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The x coordinate of the root.
+ */
+long long HashLife::get_origin_x() const{
+    return origin_x;
+}
+
+/**
+ * HashLife::get_origin_y()
+ *
+ * Gets the y coordinate of the top left cell of the root node.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The y coordinate of the root.
+ */
+long long HashLife::get_origin_y() const{
+    return origin_y;
+}
+
+/**
+ * HashLife::set_root(node, x, y)
+ *
+ * Replace the whole universe with a node built by HashLife::join, placing its top left cell at (x, y).
+ *
+ * @param node
+ *      The new root, of level 3 or more.
+ *
+ * @param x
+ *      The x coordinate of the top left cell of the node.
+ *
+ * @param y
+ *      The y coordinate of the top left cell of the node.
+ *
+ * @throws
+ *      std::invalid_argument if the node is below level 3 or too large for its corners to be addressed.
+ */
+void HashLife::set_root(NodeId node, long long x, long long y){
+    if(nodes[node].level < 3 || nodes[node].level > MAX_LEVEL){
+        throw(std::invalid_argument("HashLife::set_root error: the root must be between level 3 and level 62."));
+    }
+    root = node;
+    origin_x = x;
+    origin_y = y;
+}
+
+/**
+ * HashLife::set_generation(generation)
+ *
+ * Overwrite the generation counter, for example when loading a pattern saved at a later generation.
+ *
+ * @param generation
+ *      The new generation of the universe.
+ */
+void HashLife::set_generation(std::uint64_t generation){
+    this->generation = generation;
+}
+
+/**
+ * HashLife::get_rule()
+ *
+ * Gets the rule the universe is advanced with, Conway's Game of Life "B3/S23" unless set_rule was called.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The rule of the universe.
+ */
+const Rule& HashLife::get_rule() const{
+    return rule;
+}
+
+/**
+ * HashLife::set_rule(new_rule)
+ *
+ * Change the rule used by the following advances. The universe is kept, but every memoised result is
+ * forgotten since it was computed with the old rule.
+ *
+ * @example
+ *
+ *      // Make a universe, then advance it as HighLife
+ *      HashLife life(Zoo::glider());
+ *      life.set_rule(Rule("B36/S23"));
+ *      life.advance(1000);
+ *
+ * @param new_rule
+ *      The rule to advance with.
+ *
+ * @throws
+ *      std::invalid_argument if the rule gives birth to cells with no alive neighbours, which would fill
+ *      the empty space that HashLife assumes stays empty.
+ */
+void HashLife::set_rule(const Rule& new_rule){
+    if(new_rule.get_birth() & 1){
+        throw(std::invalid_argument("HashLife::set_rule error: " + new_rule.get_name() +
+                                    " would fill the unbounded plane."));
+    }
+    if(new_rule != rule){
+        rule = new_rule;
+        for(Node& node : nodes){
+            node.result_log = -1;
+        }
+    }
+}
+
+/**
+ * HashLife::get(x, y)
+ *
+ * Returns the value of the cell at any coordinate of the plane.
+ * The function should be callable from a constant context.
+ *
+ * @param x
+ *      The x coordinate of the cell, which may be negative.
+ *
+ * @param y
+ *      The y coordinate of the cell, which may be negative.
+ *
+ * @return
+ *      The value of the cell.
+ */
+Cell HashLife::get(long long x, long long y) const{
+    NodeId node = root;
+    long long size = 1LL << nodes[root].level;
+    x -= origin_x;
+    y -= origin_y;
+    if(x < 0 || y < 0 || x >= size || y >= size){
+        return DEAD;
+    }
+    while(nodes[node].level > 0 && nodes[node].population != 0){
+        size /= 2;
+        const Node& n = nodes[node];
+        node = (y < size) ? ((x < size) ? n.nw : n.ne) : ((x < size) ? n.sw : n.se);
+        x %= size;
+        y %= size;
+    }
+    return (nodes[node].population != 0) ? ALIVE : DEAD;
+}
+
+/**
+ * HashLife::set(x, y, value)
+ *
+ * Overwrites the value of the cell at any coordinate of the plane, growing the universe to reach it.
+ * Each call rebuilds the nodes on the path to the cell, so this is for placing patterns rather than
+ * stepping them.
+ *
+ * @param x
+ *      The x coordinate of the cell, which may be negative.
+ *
+ * @param y
+ *      The y coordinate of the cell, which may be negative.
+ *
+ * @param value
+ *      The value to be written to the cell.
+ *
+ * @throws
+ *      std::overflow_error if the universe would grow too large to address.
+ */
+void HashLife::set(long long x, long long y, Cell value){
+    while(x < origin_x || y < origin_y || x - origin_x >= (1LL << nodes[root].level) ||
+          y - origin_y >= (1LL << nodes[root].level)){
+        if(value != ALIVE){
+            return;
+        }
+        root = expand(root);
+    }
+    root = replace(root, x - origin_x, y - origin_y, get_cell(value == ALIVE));
+}
+
+/**
+ * HashLife::set_block(x, y, rows)
+ *
+ * Overwrites the 8x8 square of cells with its top left at (x, y), where bit i of rows[j] is the cell at
+ * (x + i, y + j). When the square lines up with the level 3 nodes of the universe it is replaced as one node,
+ * which is how file loaders fill a universe without placing one cell at a time.
+ *
+ * @param x
+ *      The x coordinate of the top left cell of the square, which may be negative.
+ *
+ * @param y
+ *      The y coordinate of the top left cell of the square, which may be negative.
+ *
+ * @param rows
+ *      The 8 rows of the square, top row first.
+ *
+ * @throws
+ *      std::overflow_error if the universe would grow too large to address.
+ */
+void HashLife::set_block(long long x, long long y, const unsigned char rows[8]){
+    bool any = false;
+    for(int r = 0; r < 8; r++){
+        any = any || rows[r] != 0;
+    }
+    while(x < origin_x || y < origin_y || x + 8 - origin_x > (1LL << nodes[root].level) ||
+          y + 8 - origin_y > (1LL << nodes[root].level)){
+        if(!any && nodes[root].population == 0){
+            return;
+        }
+        root = expand(root);
+    }
+    if((x - origin_x) % 8 == 0 && (y - origin_y) % 8 == 0){
+        root = replace(root, x - origin_x, y - origin_y, get_block(rows));
+        return;
+    }
+    for(int r = 0; r < 8; r++){
+        for(int i = 0; i < 8; i++){
+            set(x + i, y + r, ((rows[r] >> i) & 1) ? ALIVE : DEAD);
+        }
+    }
+}
+
+/**
+ * HashLife::replace(node, x, y, leaf)
+ *
+ * Private helper function that rebuilds a node with the square of the same level as leaf that contains the
+ * cell at (x, y) within it replaced by leaf.
+ */
+HashLife::NodeId HashLife::replace(NodeId node, long long x, long long y, NodeId leaf){
+    // join may grow the node table, so keep a copy of the node rather than a reference into it.
+    Node n = nodes[node];
+    if(n.level == nodes[leaf].level){
+        return leaf;
+    }
+    long long half = 1LL << (n.level - 1);
+    if(y < half){
+        if(x < half){
+            return join(replace(n.nw, x, y, leaf), n.ne, n.sw, n.se);
+        }
+        return join(n.nw, replace(n.ne, x - half, y, leaf), n.sw, n.se);
+    }
+    if(x < half){
+        return join(n.nw, n.ne, replace(n.sw, x, y - half, leaf), n.se);
+    }
+    return join(n.nw, n.ne, n.sw, replace(n.se, x - half, y - half, leaf));
+}
+
+/**
+ * HashLife::get_bounds(x0, y0, x1, y1)
+ *
+ * Find the smallest box containing every alive cell, spanning the range [x0, x1) by [y0, y1).
+ * Nodes that are empty, or already inside the box found so far, are not searched.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      False, leaving the coordinates untouched, if there are no alive cells.
+ */
+bool HashLife::get_bounds(long long& x0, long long& y0, long long& x1, long long& y1) const{
+    if(nodes[root].population == 0){
+        return false;
+    }
+    long long bounds[4] = {origin_x + (1LL << nodes[root].level), origin_y + (1LL << nodes[root].level),
+                           origin_x, origin_y};
+    find_bounds(root, origin_x, origin_y, bounds);
+    x0 = bounds[0];
+    y0 = bounds[1];
+    x1 = bounds[2];
+    y1 = bounds[3];
+    return true;
+}
+
+/**
+ * HashLife::find_bounds(node, x, y, bounds)
+ *
+ * Private helper function that grows bounds, as {x0, y0, x1, y1}, to include the alive cells of a node
+ * with its top left at (x, y).
+ */
+void HashLife::find_bounds(NodeId node, long long x, long long y, long long bounds[4]) const{
+    const Node& n = nodes[node];
+    long long size = 1LL << n.level;
+    if(n.population == 0 ||
+       (x >= bounds[0] && y >= bounds[1] && x + size <= bounds[2] && y + size <= bounds[3])){
+        return;
+    }
+    if(n.level == 0){
+        bounds[0] = std::min(bounds[0], x);
+        bounds[1] = std::min(bounds[1], y);
+        bounds[2] = std::max(bounds[2], x + 1);
+        bounds[3] = std::max(bounds[3], y + 1);
+        return;
+    }
+    long long half = size / 2;
+    find_bounds(n.nw, x, y, bounds);
+    find_bounds(n.ne, x + half, y, bounds);
+    find_bounds(n.sw, x, y + half, bounds);
+    find_bounds(n.se, x + half, y + half, bounds);
+}
+
+/**
+ * HashLife::get_generation()
+ *
+ * Gets the number of generations the universe has been advanced since it was constructed.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The current generation.
+ */
+std::uint64_t HashLife::get_generation() const{
+    return generation;
+}
+
+/**
+ * HashLife::get_alive_cells()
+ *
+ * Counts how many cells in the whole universe are alive, which is stored in the root node.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The number of alive cells.
+ */
+std::uint64_t HashLife::get_alive_cells() const{
+    return nodes[root].population;
+}
+
+/**
+ * HashLife::count_window(node, x, y, window)
+ *
+ * Private helper function that counts the alive cells of a node with its top left at (x, y) inside a window,
+ * as {x0, y0, x1, y1}. Nodes wholly inside the window give their stored population without being opened.
+ */
+std::uint64_t HashLife::count_window(NodeId node, long long x, long long y, const long long window[4]) const{
+    const Node& n = nodes[node];
+    long long size = 1LL << n.level;
+    if(n.population == 0 || x >= window[2] || y >= window[3] || x + size <= window[0] || y + size <= window[1]){
+        return 0;
+    } else if(x >= window[0] && y >= window[1] && x + size <= window[2] && y + size <= window[3]){
+        return n.population;
+    }
+    long long half = size / 2;
+    return count_window(n.nw, x, y, window) + count_window(n.ne, x + half, y, window) +
+           count_window(n.sw, x, y + half, window) + count_window(n.se, x + half, y + half, window);
+}
+
+/**
+ * HashLife::get_alive_cells(x0, y0, x1, y1)
+ *
+ * Counts how many cells are alive in the window spanning [x0, x1) by [y0, y1), which may be any size.
+ * Only the nodes crossing the edge of the window are opened, so the cost follows its perimeter, not its area.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The number of alive cells in the window.
+ *
+ * @throws
+ *      std::range_error if the window has a negative size.
+ */
+std::uint64_t HashLife::get_alive_cells(long long x0, long long y0, long long x1, long long y1) const{
+    if(x1 < x0 || y1 < y0){
+        throw(std::range_error("HashLife::get_alive_cells error: the window has a negative size."));
+    }
+    long long window[4] = {x0, y0, x1, y1};
+    return count_window(root, origin_x, origin_y, window);
+}
+
+/**
+ * HashLife::get_node_count()
+ *
+ * Gets the number of nodes currently stored, for monitoring memory use.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The number of nodes.
+ */
+std::size_t HashLife::get_node_count() const{
+    return nodes.size();
+}
+
+/**
+ * HashLife::set_max_nodes(max_nodes)
+ *
+ * Set how many nodes may be stored before HashLife::advance collects the unreachable ones.
+ *
+ * @param max_nodes
+ *      The number of nodes to allow. Each node takes about 40 bytes plus its hash table entry.
+ */
+void HashLife::set_max_nodes(std::size_t max_nodes){
+    this->max_nodes = max_nodes;
+}
+
+/**
+ * HashLife::collect_garbage()
+ *
+ * Rebuild the node store with only the nodes reachable from the current universe.
+ * This also discards every memoised result, so the next advance recomputes them.
+ */
+void HashLife::collect_garbage(){
+    HashLife fresh;
+    std::unordered_map<NodeId, NodeId> copied;
+    NodeId new_root = copy_into(fresh, root, copied);
+    nodes.swap(fresh.nodes);
+    index.swap(fresh.index);
+    empty_nodes.swap(fresh.empty_nodes);
+    root = new_root;
+}
+
+/**
+ * HashLife::copy_into(other, node, copied)
+ *
+ * Private helper function that recreates a node and everything below it in another store.
+ *
+ * @return
+ *      The id of the node in the other store.
+ */
+HashLife::NodeId HashLife::copy_into(HashLife& other, NodeId node, std::unordered_map<NodeId, NodeId>& copied) const{
+    const Node& n = nodes[node];
+    if(n.level == 0){
+        return node;
+    }
+    auto found = copied.find(node);
+    if(found != copied.end()){
+        return found->second;
+    }
+    NodeId nw = copy_into(other, n.nw, copied);
+    NodeId ne = copy_into(other, n.ne, copied);
+    NodeId sw = copy_into(other, n.sw, copied);
+    NodeId se = copy_into(other, n.se, copied);
+    NodeId id = other.join(nw, ne, sw, se);
+    copied.emplace(node, id);
+    return id;
+}
+
+/**
+ * HashLife::fill(grid, node, x, y, x0, y0)
+ *
+ * Private helper function that sets the alive cells of a node with its top left at (x, y) into a grid
+ * whose top left is at (x0, y0) of the universe. Empty nodes and nodes outside the grid are skipped.
+ */
+void HashLife::fill(Grid& grid, NodeId node, long long x, long long y, long long x0, long long y0) const{
+    const Node& n = nodes[node];
+    long long size = 1LL << n.level;
+    if(n.population == 0 || x >= x0 + (long long) grid.get_width() || y >= y0 + (long long) grid.get_height() ||
+       x + size <= x0 || y + size <= y0){
+        return;
+    }
+    if(n.level == 0){
+        grid.set_unchecked((unsigned int) (x - x0), (unsigned int) (y - y0), ALIVE);
+        return;
+    }
+    long long half = size / 2;
+    fill(grid, n.nw, x, y, x0, y0);
+    fill(grid, n.ne, x + half, y, x0, y0);
+    fill(grid, n.sw, x, y + half, x0, y0);
+    fill(grid, n.se, x + half, y + half, x0, y0);
+}
+
+/**
+ * HashLife::get_state()
+ *
+ * Return the cells of the universe in the window of the initial grid, from (0, 0) to (width - 1, height - 1).
+ * Cells that have moved outside the window are not included, use HashLife::get_state(x0, y0, x1, y1) to see them.
+ * The function should be callable from a constant context.
+ *
+ * @example
+ *
+ *      // Advance an r-pentomino in a large grid a million generations and continue in a World
+ *      Grid grid(512);
+ *      grid.merge(Zoo::r_pentomino(), 256, 256);
+ *      HashLife life(grid);
+ *      life.advance(1000000);
+ *      World world(life.get_state());
+ *
+ * @return
+ *      A grid the size of the initial grid.
+ */
+Grid HashLife::get_state() const{
+    return get_state(0, 0, width, height);
+}
+
+/**
+ * HashLife::get_state(x0, y0, x1, y1)
+ *
+ * Return the cells of any window of the universe, spanning the range [x0, x1) by [y0, y1) in universe coordinates.
+ * The function should be callable from a constant context.
+ *
+ * @param x0
+ *      Left coordinate of the window on x-axis.
+ *
+ * @param y0
+ *      Top coordinate of the window on y-axis.
+ *
+ * @param x1
+ *      Right coordinate of the window on x-axis (1 greater than the largest index).
+ *
+ * @param y1
+ *      Bottom coordinate of the window on y-axis (1 greater than the largest index).
+ *
+ * @return
+ *      A new grid of the window size containing the cells of the universe.
+ *
+ * @throws
+ *      std::range_error if the window has a negative size or is too large for a Grid.
+ */
+Grid HashLife::get_state(long long x0, long long y0, long long x1, long long y1) const{
+    if(x1 < x0 || y1 < y0){
+        throw(std::range_error("HashLife::get_state error: the window has a negative size."));
+    } else if(x1 - x0 > 0x7FFFFFFF || y1 - y0 > 0x7FFFFFFF){
+        throw(std::range_error("HashLife::get_state error: the window is too large for a Grid."));
+    }
+    Grid grid((unsigned int) (x1 - x0), (unsigned int) (y1 - y0));
+    fill(grid, root, origin_x, origin_y, x0, y0);
+    return grid;
+}
+
+/**
+ * HashLife::advance(steps)
+ *
+ * Advance the universe any number of generations.
+ * The steps are split into powers of two, each of which HashLife can jump in a single pass,
+ * so advancing 10^12 generations takes 40 passes rather than 10^12 steps.
+ *
+ * @example
+ *
+ *      // Make a universe from an r-pentomino
+ *      HashLife life(Zoo::r_pentomino());
+ *
+ *      // Jump a trillion generations ahead
+ *      life.advance(1000000000000ULL);
+ *
+ * @param steps
+ *      The number of generations to advance the universe.
+ *
+ * @throws
+ *      std::overflow_error if the pattern spreads too far for its coordinates to fit in a long long.
+ */
+void HashLife::advance(std::uint64_t steps){
+    for(int step_log = 0; step_log < 64; step_log++){
+        if((steps >> step_log) & 1){
+            if(nodes.size() > max_nodes){
+                collect_garbage();
+            }
+            advance_pow2(step_log);
+        }
+    }
+}
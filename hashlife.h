@@ -0,0 +1,98 @@
+/**
+ * Declares a class simulating Conway's Game of Life on an unbounded plane with Gosper's HashLife algorithm.
+ * Rich documentation for the api and behaviour the HashLife class can be found in hashlife.cpp.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "grid.h"
+#include "rule.h"
+
+/**
+ * Declare the structure of the HashLife class for jumping a pattern far into the future.
+ *
+ * The universe is a canonical quadtree: every distinct square of cells is stored exactly once as a Node,
+ * and each Node memoises the result of advancing its centre, so repeated structure is computed only once.
+ */
+class HashLife {
+public:
+    typedef std::uint32_t NodeId;
+
+    /**
+     * A square of 2^level by 2^level cells, made of four squares of 2^(level - 1) cells.
+     * Level 0 nodes are single cells and have no children.
+     */
+    struct Node {
+        NodeId nw, ne, sw, se;
+        std::uint64_t population;
+        unsigned int level;
+        NodeId result;
+        int result_log;
+    };
+private:
+    struct NodeKey {
+        NodeId nw, ne, sw, se;
+        bool operator==(const NodeKey& other) const;
+    };
+    struct NodeKeyHash {
+        std::size_t operator()(const NodeKey& key) const;
+    };
+
+    std::vector<Node> nodes;
+    std::unordered_map<NodeKey, NodeId, NodeKeyHash> index;
+    std::vector<NodeId> empty_nodes;
+    NodeId root;
+    long long origin_x;
+    long long origin_y;
+    unsigned int width;
+    unsigned int height;
+    std::uint64_t generation;
+    std::size_t max_nodes;
+    Rule rule;
+
+    void reset();
+    NodeId build(const Grid& grid, unsigned int level, long long x, long long y);
+    NodeId expand(NodeId node);
+    bool is_centred(NodeId node) const;
+    NodeId successor(NodeId node, int step_log);
+    NodeId evolve_4x4(NodeId node);
+    void advance_pow2(int step_log);
+    NodeId replace(NodeId node, long long x, long long y, NodeId leaf);
+    void find_bounds(NodeId node, long long x, long long y, long long bounds[4]) const;
+    std::uint64_t count_window(NodeId node, long long x, long long y, const long long window[4]) const;
+    void fill(Grid& grid, NodeId node, long long x, long long y, long long x0, long long y0) const;
+    NodeId copy_into(HashLife& other, NodeId node, std::unordered_map<NodeId, NodeId>& copied) const;
+public:
+    HashLife();
+    explicit HashLife(const Grid& initial_state);
+    NodeId get_cell(bool alive) const;
+    NodeId get_empty(unsigned int level);
+    NodeId get_block(const unsigned char rows[8]);
+    NodeId join(NodeId nw, NodeId ne, NodeId sw, NodeId se);
+    const Node& get_node(NodeId node) const;
+    NodeId get_root() const;
+    long long get_origin_x() const;
+    long long get_origin_y() const;
+    void set_root(NodeId node, long long x, long long y);
+    std::uint64_t get_generation() const;
+    void set_generation(std::uint64_t generation);
+    const Rule& get_rule() const;
+    void set_rule(const Rule& new_rule);
+    Cell get(long long x, long long y) const;
+    void set(long long x, long long y, Cell value);
+    void set_block(long long x, long long y, const unsigned char rows[8]);
+    bool get_bounds(long long& x0, long long& y0, long long& x1, long long& y1) const;
+    std::uint64_t get_alive_cells() const;
+    std::uint64_t get_alive_cells(long long x0, long long y0, long long x1, long long y1) const;
+    std::size_t get_node_count() const;
+    void set_max_nodes(std::size_t max_nodes);
+    void collect_garbage();
+    Grid get_state() const;
+    Grid get_state(long long x0, long long y0, long long x1, long long y1) const;
+    void advance(std::uint64_t steps);
+};
@@ -0,0 +1,974 @@
+/**
+ * Implements a Kernel namespace with the bit-parallel update step used by World.
+ *      - Grids are bit-packed, so one 64-bit word holds 64 neighbouring cells of a row.
+ *      - Instead of counting the neighbours of each cell, the eight neighbour bits of 64 cells are summed at
+ *        once with bitwise half and full adders, and the rules are applied to the resulting count bits.
+ *          - https://en.wikipedia.org/wiki/Adder_(electronics)
+ *
+ *      - The west and east neighbours of a word are formed by shifting it one bit and carrying in the
+ *        nearest bit of the adjacent word.
+ *          - Bounded grids carry in Cell::DEAD past the edges.
+ *          - Toroidal grids carry in the cell from the opposite edge, in both directions.
+ *
+ *      - The interior words of a row, which have a neighbour word on both sides, are processed several at once
+ *        with SIMD vectors when the CPU supports them.
+ *          - Kernel::AVX512 processes 512 cells per instruction and Kernel::AVX2 256 cells, on x86-64.
+ *          - Kernel::NEON processes 128 cells per instruction, on 64-bit ARM where NEON is always available.
+ *          - Kernel::SCALAR processes 64 cells per instruction and is always available.
+ *          - The same evolve() adder network is instantiated for each vector type using the compiler's vector
+ *            extensions, and each instantiation is compiled for its instruction set with a target attribute,
+ *            so a single binary carries every kernel and picks one at run time from CPUID.
+ *
+ *      - Every kernel is also instantiated for the rule it steps with, see rule.cpp.
+ *          - Conway's Game of Life uses evolve(), the shortest adder network.
+ *          - HighLife, Seeds and Day & Night have their masks folded into evolve_rule() at compile time.
+ *          - Any other Life-like rule uses evolve_rule() with its masks read at run time.
+ *
+ *      - Kernel::step_sliced_row steps WorldBatch rows, where the 64 bits of a word are the same cell in 64
+ *        different worlds. The same adder networks apply, with the neighbours read from the adjacent words.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "kernel.h"
+
+// The x86-64 and ARM kernels rely on GCC/Clang vector extensions and target attributes.
+#if defined(__GNUC__) && defined(__x86_64__)
+#define GOL_KERNEL_X86 1
+#endif
+#if defined(__GNUC__) && defined(__aarch64__)
+#define GOL_KERNEL_NEON 1
+#endif
+
+#if defined(__GNUC__)
+#define GOL_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define GOL_ALWAYS_INLINE inline
+#endif
+
+// The vector templates below are always inlined into functions compiled for their instruction set, so the
+// warnings about passing vectors by value to functions without it enabled do not apply.
+#if defined(__GNUC__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace {
+#if GOL_KERNEL_X86
+    typedef std::uint64_t u64x4 __attribute__((vector_size(32)));
+    typedef std::uint64_t u64x8 __attribute__((vector_size(64)));
+#endif
+#if GOL_KERNEL_NEON
+    typedef std::uint64_t u64x2 __attribute__((vector_size(16)));
+#endif
+
+    /**
+     * evolve(nw, n, ne, w, c, e, sw, s, se)
+     *
+     * Apply Conway's Game of Life rules to 64 cells at once, or to 64 cells per lane of a vector type.
+     * Each argument holds, for every bit position, the neighbour at that compass point of the cell in c.
+     *
+     * The top and bottom rows are summed with full adders and the west and east neighbours with a half adder,
+     * giving a ones bit and a twos bit for each. The three ones bits are summed again, and the four twos
+     * bits are reduced to the answer to "is exactly one of them set", which is all B3/S23 needs to know.
+     *
+     * @return
+     *      The next state of the 64 cells in c.
+     */
+    template<typename W>
+    GOL_ALWAYS_INLINE W evolve(const W& nw, const W& n, const W& ne, const W& w, const W& c, const W& e,
+                               const W& sw, const W& s, const W& se){
+        // Full adder over the row above
+        W top_ones = nw ^ n ^ ne;
+        W top_twos = (nw & n) | (ne & (nw ^ n));
+        // Full adder over the row below
+        W bottom_ones = sw ^ s ^ se;
+        W bottom_twos = (sw & s) | (se & (sw ^ s));
+        // Half adder over the west and east neighbours
+        W middle_ones = w ^ e;
+        W middle_twos = w & e;
+
+        // Sum the ones bits, the carry has weight two
+        W ones = top_ones ^ bottom_ones ^ middle_ones;
+        W carry = (top_ones & bottom_ones) | (middle_ones & (top_ones ^ bottom_ones));
+
+        // The count is 2 or 3 exactly when one of the four weight two bits is set
+        W pair_a = top_twos ^ bottom_twos;
+        W pair_b = middle_twos ^ carry;
+        W two_or_more_pairs = (top_twos & bottom_twos) | (middle_twos & carry);
+        W exactly_one_two = (pair_a ^ pair_b) & ~two_or_more_pairs;
+
+        // Alive with 2 or 3 neighbours survives, dead with exactly 3 is born
+        return exactly_one_two & (ones | c);
+    }
+
+    /**
+     * load<V>(words) and store<V>(words, value)
+     *
+     * Unaligned loads and stores of sizeof(V) / 8 consecutive words.
+     * Interior words are read at offsets of -1, 0 and +1 words, so vectors can never all be aligned.
+     */
+    template<typename V>
+    GOL_ALWAYS_INLINE V load(const std::uint64_t* words){
+        V value;
+        std::memcpy(&value, words, sizeof(V));
+        return value;
+    }
+
+    template<typename V>
+    GOL_ALWAYS_INLINE void store(std::uint64_t* words, const V& value){
+        std::memcpy(words, &value, sizeof(V));
+    }
+
+    /**
+     * select<W>(set, bits)
+     *
+     * Return bits if set is true and the complement of bits otherwise, for matching one bit of a count.
+     */
+    template<typename W>
+    GOL_ALWAYS_INLINE W select(bool set, const W& bits){
+        if(set){
+            return bits;
+        }
+        return ~bits;
+    }
+
+    /**
+     * evolve_rule(nw, n, ne, w, c, e, sw, s, se, birth, survival)
+     *
+     * Apply any Life-like rule to 64 cells at once, or to 64 cells per lane of a vector type.
+     * The neighbours are summed with the same adders as evolve(), carried on into a full 4 bit count, and each
+     * count named by the rule is matched bit by bit. When birth and survival are constants this folds down to
+     * a handful of operations for the counts in the rule.
+     *
+     * @return
+     *      The next state of the 64 cells in c.
+     */
+    template<typename W>
+    GOL_ALWAYS_INLINE W evolve_rule(const W& nw, const W& n, const W& ne, const W& w, const W& c, const W& e,
+                                    const W& sw, const W& s, const W& se, unsigned int birth, unsigned int survival){
+        W top_ones = nw ^ n ^ ne;
+        W top_twos = (nw & n) | (ne & (nw ^ n));
+        W bottom_ones = sw ^ s ^ se;
+        W bottom_twos = (sw & s) | (se & (sw ^ s));
+        W middle_ones = w ^ e;
+        W middle_twos = w & e;
+
+        W ones = top_ones ^ bottom_ones ^ middle_ones;
+        W carry = (top_ones & bottom_ones) | (middle_ones & (top_ones ^ bottom_ones));
+
+        // Sum the four weight two bits into the twos, fours and eights bits of the count
+        W pair_a = top_twos ^ bottom_twos;
+        W pair_a_carry = top_twos & bottom_twos;
+        W pair_b = middle_twos ^ carry;
+        W pair_b_carry = middle_twos & carry;
+        W twos = pair_a ^ pair_b;
+        W twos_carry = pair_a & pair_b;
+        W fours = pair_a_carry ^ pair_b_carry ^ twos_carry;
+        W eights = (pair_a_carry & pair_b_carry) | (twos_carry & (pair_a_carry ^ pair_b_carry));
+
+        W next = W();
+        for(unsigned int count = 0; count <= 8; count++){
+            bool born = (birth >> count) & 1;
+            bool survives = (survival >> count) & 1;
+            if(!born && !survives){
+                continue;
+            }
+            W match = select<W>(count & 1, ones) & select<W>(count & 2, twos) & select<W>(count & 4, fours) &
+                      select<W>(count & 8, eights);
+            if(born && survives){
+                next |= match;
+            } else{
+                next |= match & select<W>(survives, c);
+            }
+        }
+        return next;
+    }
+
+    /**
+     * LifeRule, FixedRule<BIRTH, SURVIVAL> and AnyRule
+     *
+     * The rules the kernels are instantiated for. Each applies its rule to 64 cells per lane of W.
+     *      - LifeRule uses the shortest adder network, evolve(), which only works for B3/S23.
+     *      - FixedRule bakes the masks of a common rule into evolve_rule() at compile time.
+     *      - AnyRule reads the masks of any other rule at run time.
+     */
+    struct LifeRule {
+        explicit LifeRule(const Rule&){
+        }
+
+        template<typename W>
+        GOL_ALWAYS_INLINE W apply(const W& nw, const W& n, const W& ne, const W& w, const W& c, const W& e,
+                                  const W& sw, const W& s, const W& se) const{
+            return evolve<W>(nw, n, ne, w, c, e, sw, s, se);
+        }
+    };
+
+    template<unsigned int BIRTH, unsigned int SURVIVAL>
+    struct FixedRule {
+        explicit FixedRule(const Rule&){
+        }
+
+        template<typename W>
+        GOL_ALWAYS_INLINE W apply(const W& nw, const W& n, const W& ne, const W& w, const W& c, const W& e,
+                                  const W& sw, const W& s, const W& se) const{
+            return evolve_rule<W>(nw, n, ne, w, c, e, sw, s, se, BIRTH, SURVIVAL);
+        }
+    };
+
+    struct AnyRule {
+        unsigned int birth;
+        unsigned int survival;
+
+        explicit AnyRule(const Rule& rule): birth(rule.get_birth()), survival(rule.get_survival()){
+        }
+
+        template<typename W>
+        GOL_ALWAYS_INLINE W apply(const W& nw, const W& n, const W& ne, const W& w, const W& c, const W& e,
+                                  const W& sw, const W& s, const W& se) const{
+            return evolve_rule<W>(nw, n, ne, w, c, e, sw, s, se, birth, survival);
+        }
+    };
+
+    // The masks of the rules with specialised kernels, bit n set for n neighbours.
+    const unsigned int LIFE_BIRTH = 0x008, LIFE_SURVIVAL = 0x00C;
+    const unsigned int HIGH_LIFE_BIRTH = 0x048, HIGH_LIFE_SURVIVAL = 0x00C;
+    const unsigned int SEEDS_BIRTH = 0x004, SEEDS_SURVIVAL = 0x000;
+    const unsigned int DAY_AND_NIGHT_BIRTH = 0x1C8, DAY_AND_NIGHT_SURVIVAL = 0x1D8;
+
+    typedef FixedRule<HIGH_LIFE_BIRTH, HIGH_LIFE_SURVIVAL> HighLifeRule;
+    typedef FixedRule<SEEDS_BIRTH, SEEDS_SURVIVAL> SeedsRule;
+    typedef FixedRule<DAY_AND_NIGHT_BIRTH, DAY_AND_NIGHT_SURVIVAL> DayAndNightRule;
+
+    /**
+     * evolve_scalar(above, row, below, k, rule)
+     *
+     * Apply a rule to word k of a row, which must have a neighbour word on both sides.
+     */
+    template<typename R>
+    GOL_ALWAYS_INLINE std::uint64_t evolve_scalar(const std::uint64_t* above, const std::uint64_t* row,
+                                                  const std::uint64_t* below, unsigned int k, const R& rule){
+        return rule.template apply<std::uint64_t>(
+                (above[k] << 1) | (above[k - 1] >> 63), above[k], (above[k] >> 1) | (above[k + 1] << 63),
+                (row[k] << 1) | (row[k - 1] >> 63), row[k], (row[k] >> 1) | (row[k + 1] << 63),
+                (below[k] << 1) | (below[k - 1] >> 63), below[k], (below[k] >> 1) | (below[k + 1] << 63));
+    }
+
+    /**
+     * reduce_or<V>(value)
+     *
+     * OR together the 64-bit lanes of a vector.
+     */
+    template<typename V>
+    GOL_ALWAYS_INLINE std::uint64_t reduce_or(const V& value){
+        std::uint64_t lanes[sizeof(V) / sizeof(std::uint64_t)];
+        std::memcpy(lanes, &value, sizeof(V));
+        std::uint64_t result = 0;
+        for(std::uint64_t lane : lanes){
+            result |= lane;
+        }
+        return result;
+    }
+
+    /**
+     * evolve_interior<V, track>(above, row, below, out, k0, k1, differences, rule)
+     *
+     * Apply a rule to the words [k0, k1) of a row, sizeof(V) / 8 words at a time, finishing any remainder
+     * one word at a time. Every word in the range must have a neighbour word on both sides, so 0 < k0
+     * and k1 < words in the row.
+     *
+     * If track is true then the changed bits of each group of Kernel::DIFFERENCE_WORDS words are ORed into
+     * differences[k / Kernel::DIFFERENCE_WORDS]. Vectors are kept aligned to multiples of their width so that
+     * none of them straddles two groups, and each group is reduced to a single word only once.
+     */
+    template<typename V, bool track, typename R>
+    GOL_ALWAYS_INLINE void evolve_interior(const std::uint64_t* above, const std::uint64_t* row, const std::uint64_t* below,
+                                           std::uint64_t* out, unsigned int k0, unsigned int k1,
+                                           std::uint64_t* differences, const R& rule){
+        const unsigned int lanes = sizeof(V) / sizeof(std::uint64_t);
+        const unsigned int group = Kernel::DIFFERENCE_WORDS;
+        unsigned int k = k0;
+        for(; k < k1 && k % lanes != 0; k++){
+            out[k] = evolve_scalar(above, row, below, k, rule);
+            if(track){
+                differences[k / group] |= out[k] ^ row[k];
+            }
+        }
+
+        V changed = V();
+        for(; k + lanes <= k1; k += lanes){
+            V a = load<V>(above + k), r = load<V>(row + k), b = load<V>(below + k);
+            V next = rule.template apply<V>(
+                    (a << 1) | (load<V>(above + k - 1) >> 63), a, (a >> 1) | (load<V>(above + k + 1) << 63),
+                    (r << 1) | (load<V>(row + k - 1) >> 63), r, (r >> 1) | (load<V>(row + k + 1) << 63),
+                    (b << 1) | (load<V>(below + k - 1) >> 63), b, (b >> 1) | (load<V>(below + k + 1) << 63));
+            store<V>(out + k, next);
+            if(track){
+                changed |= next ^ r;
+                if((k + lanes) % group == 0){
+                    differences[k / group] |= reduce_or<V>(changed);
+                    changed = V();
+                }
+            }
+        }
+        if(track && k > 0){
+            differences[(k - 1) / group] |= reduce_or<V>(changed);
+        }
+
+        for(; k < k1; k++){
+            out[k] = evolve_scalar(above, row, below, k, rule);
+            if(track){
+                differences[k / group] |= out[k] ^ row[k];
+            }
+        }
+    }
+
+    typedef void (*InteriorKernel)(const std::uint64_t*, const std::uint64_t*, const std::uint64_t*,
+                                   std::uint64_t*, unsigned int, unsigned int, std::uint64_t*, const Rule&);
+
+    // Each kernel chooses the tracking or non-tracking loop once per call rather than once per word.
+    template<typename R>
+    void evolve_interior_scalar(const std::uint64_t* above, const std::uint64_t* row, const std::uint64_t* below,
+                                std::uint64_t* out, unsigned int k0, unsigned int k1, std::uint64_t* differences,
+                                const Rule& rule){
+        if(differences){
+            evolve_interior<std::uint64_t, true>(above, row, below, out, k0, k1, differences, R(rule));
+        } else{
+            evolve_interior<std::uint64_t, false>(above, row, below, out, k0, k1, differences, R(rule));
+        }
+    }
+
+#if GOL_KERNEL_X86
+    template<typename R>
+    __attribute__((target("avx2")))
+    void evolve_interior_avx2(const std::uint64_t* above, const std::uint64_t* row, const std::uint64_t* below,
+                              std::uint64_t* out, unsigned int k0, unsigned int k1, std::uint64_t* differences,
+                              const Rule& rule){
+        if(differences){
+            evolve_interior<u64x4, true>(above, row, below, out, k0, k1, differences, R(rule));
+        } else{
+            evolve_interior<u64x4, false>(above, row, below, out, k0, k1, differences, R(rule));
+        }
+    }
+
+    template<typename R>
+    __attribute__((target("avx512f")))
+    void evolve_interior_avx512(const std::uint64_t* above, const std::uint64_t* row, const std::uint64_t* below,
+                                std::uint64_t* out, unsigned int k0, unsigned int k1, std::uint64_t* differences,
+                                const Rule& rule){
+        if(differences){
+            evolve_interior<u64x8, true>(above, row, below, out, k0, k1, differences, R(rule));
+        } else{
+            evolve_interior<u64x8, false>(above, row, below, out, k0, k1, differences, R(rule));
+        }
+    }
+#endif
+
+#if GOL_KERNEL_NEON
+    template<typename R>
+    void evolve_interior_neon(const std::uint64_t* above, const std::uint64_t* row, const std::uint64_t* below,
+                              std::uint64_t* out, unsigned int k0, unsigned int k1, std::uint64_t* differences,
+                              const Rule& rule){
+        if(differences){
+            evolve_interior<u64x2, true>(above, row, below, out, k0, k1, differences, R(rule));
+        } else{
+            evolve_interior<u64x2, false>(above, row, below, out, k0, k1, differences, R(rule));
+        }
+    }
+#endif
+
+    /**
+     * get_interior_kernel<R>(isa)
+     *
+     * Look up the interior kernel compiled for a rule and an instruction set, which must be supported by this CPU.
+     */
+    template<typename R>
+    InteriorKernel get_interior_kernel(Kernel::Isa isa){
+        switch(isa){
+#if GOL_KERNEL_X86
+            case Kernel::AVX2:
+                return evolve_interior_avx2<R>;
+            case Kernel::AVX512:
+                return evolve_interior_avx512<R>;
+#endif
+#if GOL_KERNEL_NEON
+            case Kernel::NEON:
+                return evolve_interior_neon<R>;
+#endif
+            default:
+                return evolve_interior_scalar<R>;
+        }
+    }
+
+    /**
+     * evolve_sliced<V>(above, row, below, out, k0, k1, rule)
+     *
+     * Apply a rule to the words [k0, k1) of a bit-sliced row, where every word holds one cell of 64 worlds,
+     * sizeof(V) / 8 words at a time. The neighbours of a word are the words beside it rather than the bits
+     * beside it, so no shifts are needed. Every word in the range must have a neighbour word on both sides.
+     *
+     * @return
+     *      The OR of every changed bit, which has bit i set if world i changed anywhere in the range.
+     */
+    template<typename V, typename R>
+    GOL_ALWAYS_INLINE std::uint64_t evolve_sliced(const std::uint64_t* above, const std::uint64_t* row,
+                                                  const std::uint64_t* below, std::uint64_t* out,
+                                                  unsigned int k0, unsigned int k1, const R& rule){
+        const unsigned int lanes = sizeof(V) / sizeof(std::uint64_t);
+        unsigned int k = k0;
+        V changed = V();
+        for(; k + lanes <= k1; k += lanes){
+            V r = load<V>(row + k);
+            V next = rule.template apply<V>(
+                    load<V>(above + k - 1), load<V>(above + k), load<V>(above + k + 1),
+                    load<V>(row + k - 1), r, load<V>(row + k + 1),
+                    load<V>(below + k - 1), load<V>(below + k), load<V>(below + k + 1));
+            store<V>(out + k, next);
+            changed |= next ^ r;
+        }
+        std::uint64_t result = reduce_or<V>(changed);
+        for(; k < k1; k++){
+            out[k] = rule.template apply<std::uint64_t>(above[k - 1], above[k], above[k + 1], row[k - 1], row[k],
+                                                        row[k + 1], below[k - 1], below[k], below[k + 1]);
+            result |= out[k] ^ row[k];
+        }
+        return result;
+    }
+
+    typedef std::uint64_t (*SlicedKernel)(const std::uint64_t*, const std::uint64_t*, const std::uint64_t*,
+                                          std::uint64_t*, unsigned int, unsigned int, const Rule&);
+
+    template<typename R>
+    std::uint64_t evolve_sliced_scalar(const std::uint64_t* above, const std::uint64_t* row, const std::uint64_t* below,
+                                       std::uint64_t* out, unsigned int k0, unsigned int k1, const Rule& rule){
+        return evolve_sliced<std::uint64_t>(above, row, below, out, k0, k1, R(rule));
+    }
+
+#if GOL_KERNEL_X86
+    template<typename R>
+    __attribute__((target("avx2")))
+    std::uint64_t evolve_sliced_avx2(const std::uint64_t* above, const std::uint64_t* row, const std::uint64_t* below,
+                                     std::uint64_t* out, unsigned int k0, unsigned int k1, const Rule& rule){
+        return evolve_sliced<u64x4>(above, row, below, out, k0, k1, R(rule));
+    }
+
+    template<typename R>
+    __attribute__((target("avx512f")))
+    std::uint64_t evolve_sliced_avx512(const std::uint64_t* above, const std::uint64_t* row,
+                                       const std::uint64_t* below, std::uint64_t* out, unsigned int k0,
+                                       unsigned int k1, const Rule& rule){
+        return evolve_sliced<u64x8>(above, row, below, out, k0, k1, R(rule));
+    }
+#endif
+
+#if GOL_KERNEL_NEON
+    template<typename R>
+    std::uint64_t evolve_sliced_neon(const std::uint64_t* above, const std::uint64_t* row, const std::uint64_t* below,
+                                     std::uint64_t* out, unsigned int k0, unsigned int k1, const Rule& rule){
+        return evolve_sliced<u64x2>(above, row, below, out, k0, k1, R(rule));
+    }
+#endif
+
+    /**
+     * get_sliced_kernel<R>(isa)
+     *
+     * Look up the bit-sliced kernel compiled for a rule and an instruction set, which must be supported by this CPU.
+     */
+    template<typename R>
+    SlicedKernel get_sliced_kernel(Kernel::Isa isa){
+        switch(isa){
+#if GOL_KERNEL_X86
+            case Kernel::AVX2:
+                return evolve_sliced_avx2<R>;
+            case Kernel::AVX512:
+                return evolve_sliced_avx512<R>;
+#endif
+#if GOL_KERNEL_NEON
+            case Kernel::NEON:
+                return evolve_sliced_neon<R>;
+#endif
+            default:
+                return evolve_sliced_scalar<R>;
+        }
+    }
+
+    /**
+     * step_sliced<R>(above, row, below, out, cells, toroidal, isa, rule)
+     *
+     * Kernel::step_sliced_row for one rule, with the first and last cells of the row read from the opposite
+     * edge or from dead cells.
+     */
+    template<typename R>
+    std::uint64_t step_sliced(const std::uint64_t* above, const std::uint64_t* row, const std::uint64_t* below,
+                              std::uint64_t* out, unsigned int cells, bool toroidal, Kernel::Isa isa,
+                              const Rule& rule){
+        const std::uint64_t* rows[3] = {above, row, below};
+        R edge_rule(rule);
+        std::uint64_t changed = 0;
+        unsigned int edges[2] = {0, cells - 1};
+        for(unsigned int e = 0; e < (cells > 1 ? 2u : 1u); e++){
+            unsigned int k = edges[e];
+            std::uint64_t west[3], centre[3], east[3];
+            for(int r = 0; r < 3; r++){
+                centre[r] = rows[r][k];
+                west[r] = k > 0 ? rows[r][k - 1] : (toroidal ? rows[r][cells - 1] : 0);
+                east[r] = k + 1 < cells ? rows[r][k + 1] : (toroidal ? rows[r][0] : 0);
+            }
+            out[k] = edge_rule.template apply<std::uint64_t>(west[0], centre[0], east[0], west[1], centre[1],
+                                                             east[1], west[2], centre[2], east[2]);
+            changed |= out[k] ^ row[k];
+        }
+        if(cells > 2){
+            changed |= get_sliced_kernel<R>(isa)(above, row, below, out, 1, cells - 1, rule);
+        }
+        return changed;
+    }
+
+    /**
+     * count_words(words, k0, k1)
+     *
+     * Count the set bits of the words [k0, k1).
+     */
+    GOL_ALWAYS_INLINE unsigned int count_words(const std::uint64_t* words, unsigned int k0, unsigned int k1){
+        unsigned int count = 0;
+        for(unsigned int k = k0; k < k1; k++){
+            count += (unsigned int) __builtin_popcountll(words[k]);
+        }
+        return count;
+    }
+
+    unsigned int count_words_scalar(const std::uint64_t* words, unsigned int k0, unsigned int k1){
+        return count_words(words, k0, k1);
+    }
+
+#if GOL_KERNEL_X86
+    // Every CPU with AVX2 has POPCNT, which baseline x86-64 code cannot assume and would emulate with shifts.
+    __attribute__((target("popcnt")))
+    unsigned int count_words_popcnt(const std::uint64_t* words, unsigned int k0, unsigned int k1){
+        return count_words(words, k0, k1);
+    }
+#endif
+
+    /**
+     * evolve_word(above, row, below, k, words, west_in, east_in, rule)
+     *
+     * Apply a rule to word k of a row of the given number of words, carrying in the given bits
+     * where word k has no neighbour word in the row.
+     *
+     * @param west_in
+     *      For each of the above, row and below rows, bit 0 is the west neighbour of the first cell
+     *      of the row, used when k is the first word.
+     *
+     * @param east_in
+     *      For each of the above, row and below rows, the east neighbour bits to OR in when k is the last word.
+     */
+    template<typename R>
+    inline std::uint64_t evolve_word(const std::uint64_t* above, const std::uint64_t* row, const std::uint64_t* below,
+                                     unsigned int k, unsigned int words, std::uint64_t west_in[3], std::uint64_t east_in[3],
+                                     const R& rule){
+        const std::uint64_t* rows[3] = {above, row, below};
+        std::uint64_t west[3], centre[3], east[3];
+        for(int r = 0; r < 3; r++){
+            centre[r] = rows[r][k];
+            west[r] = (centre[r] << 1) | (k > 0 ? rows[r][k - 1] >> 63 : west_in[r]);
+            east[r] = (centre[r] >> 1) | (k + 1 < words ? rows[r][k + 1] << 63 : east_in[r]);
+        }
+        return rule.template apply<std::uint64_t>(west[0], centre[0], east[0], west[1], centre[1], east[1],
+                                                  west[2], centre[2], east[2]);
+    }
+
+    /**
+     * step_span<R>(above, row, below, out, width, k0, k1, toroidal, isa, differences, rule)
+     *
+     * Kernel::step_row_span for one rule, with the first and last words of the row stepped by the same rule
+     * as the interior.
+     */
+    template<typename R>
+    void step_span(const std::uint64_t* above, const std::uint64_t* row, const std::uint64_t* below,
+                   std::uint64_t* out, unsigned int width, unsigned int k0, unsigned int k1,
+                   bool toroidal, Kernel::Isa isa, std::uint64_t* differences, const Rule& rule){
+        unsigned int words = (width + 63) / 64;
+        unsigned int last = words - 1;
+        unsigned int last_bit = (width - 1) % 64;
+        R edge_rule(rule);
+
+        // Bits carried in from beyond the edges of the row, dead unless the row wraps around.
+        std::uint64_t west_in[3] = {0, 0, 0};
+        std::uint64_t east_in[3] = {0, 0, 0};
+        if(toroidal){
+            const std::uint64_t* rows[3] = {above, row, below};
+            for(int r = 0; r < 3; r++){
+                west_in[r] = (rows[r][last] >> last_bit) & 1;
+                east_in[r] = (rows[r][0] & 1) << last_bit;
+            }
+        }
+
+        // Interior words always have a neighbour word on both sides, so need no edge handling.
+        unsigned int interior_begin = std::max(k0, 1u);
+        unsigned int interior_end = std::min(k1, last);
+        if(k0 == 0){
+            out[0] = evolve_word(above, row, below, 0, words, west_in, east_in, edge_rule);
+        }
+        if(interior_begin < interior_end){
+            get_interior_kernel<R>(isa)(above, row, below, out, interior_begin, interior_end, differences, rule);
+        }
+        if(k1 == words && last > 0){
+            out[last] = evolve_word(above, row, below, last, words, west_in, east_in, edge_rule);
+        }
+
+        // Cells just past the width can be born from the last column, so clear the padding.
+        if(k1 == words && width % 64 != 0){
+            out[last] &= ((std::uint64_t)1 << (width % 64)) - 1;
+        }
+
+        if(differences){
+            if(k0 == 0){
+                differences[0] |= out[0] ^ row[0];
+            }
+            if(k1 == words && last > 0){
+                differences[last / Kernel::DIFFERENCE_WORDS] |= out[last] ^ row[last];
+            }
+        }
+    }
+}
+
+/**
+ * Kernel::is_supported(isa)
+ *
+ * Check whether this binary was built with a kernel for an instruction set and the CPU it is running on
+ * supports that instruction set.
+ *
+ * @param isa
+ *      The instruction set to check.
+ *
+ * @return
+ *      True if stepping with the instruction set is possible.
+ */
+bool Kernel::is_supported(Isa isa){
+    switch(isa){
+        case SCALAR:
+            return true;
+#if GOL_KERNEL_X86
+        case AVX2:
+            return __builtin_cpu_supports("avx2");
+        case AVX512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+#if GOL_KERNEL_NEON
+        case NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+/**
+ * Kernel::detect_isa()
+ *
+ * Pick the widest supported instruction set, checking the CPU only the first time it is called.
+ *
+ * @example
+ *
+ *      // Print the kernel this machine will step worlds with, e.g. "avx2"
+ *      std::cout << Kernel::get_isa_name(Kernel::detect_isa()) << std::endl;
+ *
+ * @return
+ *      The instruction set of the fastest kernel this CPU can run.
+ */
+Kernel::Isa Kernel::detect_isa(){
+    static const Isa best = is_supported(AVX512) ? AVX512
+                          : is_supported(AVX2) ? AVX2
+                          : is_supported(NEON) ? NEON
+                          : SCALAR;
+    return best;
+}
+
+/**
+ * Kernel::get_isa_name(isa)
+ *
+ * Gets a short lower case name for an instruction set, for printing and reporting.
+ *
+ * @param isa
+ *      The instruction set to name.
+ *
+ * @return
+ *      One of "scalar", "neon", "avx2" or "avx512".
+ */
+const char* Kernel::get_isa_name(Isa isa){
+    switch(isa){
+        case NEON:
+            return "neon";
+        case AVX2:
+            return "avx2";
+        case AVX512:
+            return "avx512";
+        default:
+            return "scalar";
+    }
+}
+
+/**
+ * Kernel::step_row(above, row, below, out, width, toroidal, rule, isa)
+ *
+ * Compute the next state of one row of a bit-packed grid.
+ * The three input rows hold the row being updated and the rows either side of it, already wrapped or
+ * replaced with an all dead row by the caller as the topology requires.
+ * The padding bits past the width of out are cleared.
+ *
+ * @param above
+ *      The packed words of the row above.
+ *
+ * @param row
+ *      The packed words of the row being updated.
+ *
+ * @param below
+ *      The packed words of the row below.
+ *
+ * @param out
+ *      Where to write the packed words of the next state of the row. Must not alias the input rows.
+ *
+ * @param width
+ *      The number of cells in the row.
+ *
+ * @param toroidal
+ *      If true then the left edge of the row wraps to the right edge.
+ *
+ * @param rule
+ *      The Life-like rule to step with.
+ *
+ * @param isa
+ *      The instruction set to process interior words with. Must be supported by this CPU.
+ */
+void Kernel::step_row(const std::uint64_t* above, const std::uint64_t* row, const std::uint64_t* below,
+                      std::uint64_t* out, unsigned int width, bool toroidal, const Rule& rule, Isa isa){
+    step_row_span(above, row, below, out, width, 0, (width + 63) / 64, toroidal, rule, isa, nullptr);
+}
+
+/**
+ * Kernel::step_row_span(above, row, below, out, width, k0, k1, toroidal, rule, isa, differences)
+ *
+ * Compute the next state of the words [k0, k1) of one row of a bit-packed grid, leaving the other words of
+ * out untouched. This lets callers skip the parts of a row that are known not to change.
+ * The padding bits past the width are cleared if the last word of the row is in the span.
+ *
+ * Optionally records which cells changed while the words are still in registers, which is much cheaper
+ * than comparing the rows afterwards.
+ *
+ * @param above
+ *      The packed words of the row above.
+ *
+ * @param row
+ *      The packed words of the row being updated.
+ *
+ * @param below
+ *      The packed words of the row below.
+ *
+ * @param out
+ *      Where to write the packed words of the next state of the row. Must not alias the input rows.
+ *
+ * @param width
+ *      The number of cells in the row.
+ *
+ * @param k0
+ *      The first word to update.
+ *
+ * @param k1
+ *      One past the last word to update, at most the number of words in the row.
+ *
+ * @param toroidal
+ *      If true then the left edge of the row wraps to the right edge.
+ *
+ * @param rule
+ *      The Life-like rule to step with.
+ *
+ * @param isa
+ *      The instruction set to process interior words with. Must be supported by this CPU.
+ *
+ * @param differences
+ *      If not null, for each word k updated, the bits of out[k] ^ row[k] are ORed into
+ *      differences[k / Kernel::DIFFERENCE_WORDS], so a group of words is unchanged exactly when its entry stays 0.
+ */
+void Kernel::step_row_span(const std::uint64_t* above, const std::uint64_t* row, const std::uint64_t* below,
+                           std::uint64_t* out, unsigned int width, unsigned int k0, unsigned int k1,
+                           bool toroidal, const Rule& rule, Isa isa, std::uint64_t* differences){
+    k1 = std::min(k1, (width + 63) / 64);
+    if(k0 >= k1){
+        return;
+    }
+    unsigned int birth = rule.get_birth(), survival = rule.get_survival();
+    if(birth == LIFE_BIRTH && survival == LIFE_SURVIVAL){
+        step_span<LifeRule>(above, row, below, out, width, k0, k1, toroidal, isa, differences, rule);
+    } else if(birth == HIGH_LIFE_BIRTH && survival == HIGH_LIFE_SURVIVAL){
+        step_span<HighLifeRule>(above, row, below, out, width, k0, k1, toroidal, isa, differences, rule);
+    } else if(birth == SEEDS_BIRTH && survival == SEEDS_SURVIVAL){
+        step_span<SeedsRule>(above, row, below, out, width, k0, k1, toroidal, isa, differences, rule);
+    } else if(birth == DAY_AND_NIGHT_BIRTH && survival == DAY_AND_NIGHT_SURVIVAL){
+        step_span<DayAndNightRule>(above, row, below, out, width, k0, k1, toroidal, isa, differences, rule);
+    } else{
+        step_span<AnyRule>(above, row, below, out, width, k0, k1, toroidal, isa, differences, rule);
+    }
+}
+
+/**
+ * Kernel::step_sliced_row(above, row, below, out, cells, toroidal, rule, isa)
+ *
+ * Compute the next state of one row of 64 bit-sliced worlds, where word x of a row holds cell x of the row
+ * in each of 64 equally sized worlds, world i in bit i. Every world is stepped at once, and the neighbours of
+ * each cell are whole words, so the row is stepped several words at a time without any shifting.
+ *
+ * @param above
+ *      The words of the row above.
+ *
+ * @param row
+ *      The words of the row being updated.
+ *
+ * @param below
+ *      The words of the row below.
+ *
+ * @param out
+ *      Where to write the words of the next state of the row. Must not alias the input rows.
+ *
+ * @param cells
+ *      The number of cells, and words, in the row.
+ *
+ * @param toroidal
+ *      If true then the left edge of the row wraps to the right edge.
+ *
+ * @param rule
+ *      The Life-like rule to step with.
+ *
+ * @param isa
+ *      The instruction set to process interior words with. Must be supported by this CPU.
+ *
+ * @return
+ *      A word with bit i set if any cell of world i changed in this row.
+ */
+std::uint64_t Kernel::step_sliced_row(const std::uint64_t* above, const std::uint64_t* row, const std::uint64_t* below,
+                                      std::uint64_t* out, unsigned int cells, bool toroidal, const Rule& rule,
+                                      Isa isa){
+    if(cells == 0){
+        return 0;
+    }
+    unsigned int birth = rule.get_birth(), survival = rule.get_survival();
+    if(birth == LIFE_BIRTH && survival == LIFE_SURVIVAL){
+        return step_sliced<LifeRule>(above, row, below, out, cells, toroidal, isa, rule);
+    } else if(birth == HIGH_LIFE_BIRTH && survival == HIGH_LIFE_SURVIVAL){
+        return step_sliced<HighLifeRule>(above, row, below, out, cells, toroidal, isa, rule);
+    } else if(birth == SEEDS_BIRTH && survival == SEEDS_SURVIVAL){
+        return step_sliced<SeedsRule>(above, row, below, out, cells, toroidal, isa, rule);
+    } else if(birth == DAY_AND_NIGHT_BIRTH && survival == DAY_AND_NIGHT_SURVIVAL){
+        return step_sliced<DayAndNightRule>(above, row, below, out, cells, toroidal, isa, rule);
+    }
+    return step_sliced<AnyRule>(above, row, below, out, cells, toroidal, isa, rule);
+}
+
+/**
+ * Kernel::count_cells(words, k0, k1, isa)
+ *
+ * Count the alive cells in the words [k0, k1) of a packed row, whose padding bits are always 0.
+ * x86 kernels wider than Kernel::SCALAR count with the POPCNT instruction.
+ *
+ * @param words
+ *      The packed words of the row.
+ *
+ * @param k0
+ *      The first word to count.
+ *
+ * @param k1
+ *      One past the last word to count.
+ *
+ * @param isa
+ *      The instruction set of the kernel in use. Must be supported by this CPU.
+ *
+ * @return
+ *      The number of alive cells.
+ */
+unsigned int Kernel::count_cells(const std::uint64_t* words, unsigned int k0, unsigned int k1, Isa isa){
+#if GOL_KERNEL_X86
+    if(isa == AVX2 || isa == AVX512){
+        return count_words_popcnt(words, k0, k1);
+    }
+#endif
+    (void) isa;
+    return count_words_scalar(words, k0, k1);
+}
+
+/**
+ * Kernel::step_rows(current, next, y0, y1, toroidal, rule, isa)
+ *
+ * Compute the next state of the rows [y0, y1) of current into the same rows of next.
+ * Rows outside [y0, y1) of next are not touched, so disjoint row ranges can be stepped independently.
+ *
+ * @param current
+ *      The grid to read the current state from.
+ *
+ * @param next
+ *      The grid to write the next state to. Must be the same size as current and not the same object.
+ *
+ * @param y0
+ *      The first row to update.
+ *
+ * @param y1
+ *      One past the last row to update.
+ *
+ * @param toroidal
+ *      If true then the grid is treated as a torus, where the left edge wraps to the right edge
+ *      and the top to the bottom.
+ *
+ * @param rule
+ *      The Life-like rule to step with.
+ *
+ * @param isa
+ *      The instruction set to step with. Must be supported by this CPU.
+ */
+void Kernel::step_rows(const Grid& current, Grid& next, unsigned int y0, unsigned int y1, bool toroidal,
+                       const Rule& rule, Isa isa){
+    unsigned int width = current.get_width();
+    unsigned int height = current.get_height();
+    if(width == 0 || y0 >= y1){
+        return;
+    }
+
+    // Bounded grids are Cell::DEAD outside their top and bottom edges.
+    std::vector<std::uint64_t> dead_row(current.get_row_words(), 0);
+    for(unsigned int y = y0; y < y1; y++){
+        const std::uint64_t* above;
+        const std::uint64_t* below;
+        if(toroidal){
+            above = current.get_row((y + height - 1) % height);
+            below = current.get_row((y + 1) % height);
+        } else{
+            above = (y > 0) ? current.get_row(y - 1) : dead_row.data();
+            below = (y + 1 < height) ? current.get_row(y + 1) : dead_row.data();
+        }
+        step_row(above, current.get_row(y), below, next.get_row(y), width, toroidal, rule, isa);
+    }
+}
+
+/**
+ * Kernel::step(current, next, toroidal, rule, isa)
+ *
+ * Compute the next state of every cell of current into next.
+ *
+ * @param current
+ *      The grid to read the current state from.
+ *
+ * @param next
+ *      The grid to write the next state to. Must be the same size as current and not the same object.
+ *
+ * @param toroidal
+ *      If true then the grid is treated as a torus, where the left edge wraps to the right edge
+ *      and the top to the bottom.
+ *
+ * @param rule
+ *      The Life-like rule to step with.
+ *
+ * @param isa
+ *      The instruction set to step with. Must be supported by this CPU.
+ */
+void Kernel::step(const Grid& current, Grid& next, bool toroidal, const Rule& rule, Isa isa){
+    step_rows(current, next, 0, current.get_height(), toroidal, rule, isa);
+}
@@ -0,0 +1,47 @@
+/**
+ * Declares a Kernel namespace with the bit-parallel update step used by World.
+ * Rich documentation for the api and behaviour the Kernel namespace can be found in kernel.cpp.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#pragma once
+
+#include <cstdint>
+#include "grid.h"
+#include "rule.h"
+
+/**
+ * Declare the interface of the Kernel namespace for stepping bit-packed grids 64 cells at a time.
+ */
+namespace Kernel {
+    /**
+     * The instruction sets a kernel can be compiled for, from narrowest to widest.
+     */
+    enum Isa {
+        SCALAR,
+        NEON,
+        AVX2,
+        AVX512
+    };
+
+    /**
+     * The number of consecutive words that share one entry of the differences recorded by step_row_span.
+     */
+    const unsigned int DIFFERENCE_WORDS = 8;
+
+    bool is_supported(Isa isa);
+    Isa detect_isa();
+    const char* get_isa_name(Isa isa);
+    void step_row(const std::uint64_t* above, const std::uint64_t* row, const std::uint64_t* below,
+                  std::uint64_t* out, unsigned int width, bool toroidal, const Rule& rule, Isa isa);
+    void step_row_span(const std::uint64_t* above, const std::uint64_t* row, const std::uint64_t* below,
+                       std::uint64_t* out, unsigned int width, unsigned int k0, unsigned int k1,
+                       bool toroidal, const Rule& rule, Isa isa, std::uint64_t* differences);
+    std::uint64_t step_sliced_row(const std::uint64_t* above, const std::uint64_t* row, const std::uint64_t* below,
+                                  std::uint64_t* out, unsigned int cells, bool toroidal, const Rule& rule, Isa isa);
+    unsigned int count_cells(const std::uint64_t* words, unsigned int k0, unsigned int k1, Isa isa);
+    void step_rows(const Grid& current, Grid& next, unsigned int y0, unsigned int y1, bool toroidal,
+                   const Rule& rule, Isa isa);
+    void step(const Grid& current, Grid& next, bool toroidal, const Rule& rule, Isa isa);
+};
@@ -0,0 +1,259 @@
+/**
+ * Implements a class representing a file mapped into memory.
+ *      - Files can be mapped read-only, or created with a fixed size and mapped for writing.
+ *      - The contents are accessed as one contiguous block of bytes, so large files are read and written
+ *        by the operating system's pager rather than through a stream one byte at a time.
+ *      - The mapping is released, and written files are flushed, by MappedFile::close or when the MappedFile is
+ *        destroyed. Only MappedFile::close reports a failure, so writers should call it once they are done.
+ *      - Written files have their whole size reserved on disk before they are mapped, where the system allows it.
+ *        Storing to a page of a sparse file that the disk has no room for would kill the process with SIGBUS,
+ *        rather than failing in a way that can be reported.
+ *
+ *      - On POSIX systems the file is mapped with mmap.
+ *          - https://man7.org/linux/man-pages/man2/mmap.2.html
+ *      - Elsewhere the whole file is read into, or written from, a buffer with the same interface.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#include "mapped_file.h"
+
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+/**
+ * MappedFile::MappedFile(path)
+ *
+ * Map an existing file read-only. Check that the file opened with MappedFile::operator bool.
+ *
+ * @example
+ *
+ *      // Map a file and count its bytes
+ *      MappedFile file("path/to/file.bgol");
+ *      if(file){
+ *          std::cout << file.get_size() << std::endl;
+ *      }
+ *
+ * @param path
+ *      The std::string path to the file to read.
+ */
+MappedFile::MappedFile(const std::string& path): data(nullptr), size(0), writable(false), open(false), path(path){
+#if defined(__unix__) || defined(__APPLE__)
+    descriptor = ::open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if(descriptor < 0 || fstat(descriptor, &status) != 0){
+        return;
+    }
+    size = (std::size_t) status.st_size;
+    if(size > 0){
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if(mapping == MAP_FAILED){
+            return;
+        }
+        data = (unsigned char*) mapping;
+        // Files are read front to back, so ask for aggressive read-ahead.
+        madvise(mapping, size, MADV_SEQUENTIAL);
+    }
+    open = true;
+#else
+    std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+    if(!file){
+        return;
+    }
+    size = (std::size_t) file.tellg();
+    buffer.resize(size);
+    file.seekg(0);
+    if(!file.read((char*) buffer.data(), (std::streamsize) size)){
+        return;
+    }
+    data = buffer.data();
+    open = true;
+#endif
+}
+
+/**
+ * MappedFile::MappedFile(path, size)
+ *
+ * Create a file of the given size, replacing any existing file, and map it for writing.
+ * The file starts filled with zero bytes. Check that the file opened with MappedFile::operator bool,
+ * and call MappedFile::close once it has been written.
+ *
+ * @example
+ *
+ *      // Write a 16 byte file
+ *      MappedFile file("path/to/file.bin", 16);
+ *      if(file){
+ *          std::fill(file.get_data(), file.get_data() + file.get_size(), 0xFF);
+ *      }
+ *
+ * @param path
+ *      The std::string path to the file to write.
+ *
+ * @param size
+ *      The size of the file in bytes.
+ *
+ * @throws
+ *      std::runtime_error if the file was created but there is no room to reserve its size.
+ */
+MappedFile::MappedFile(const std::string& path, std::size_t size): data(nullptr), size(size), writable(true),
+                                                                   open(false), path(path){
+#if defined(__unix__) || defined(__APPLE__)
+    descriptor = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(descriptor < 0 || ftruncate(descriptor, (off_t) size) != 0){
+        return;
+    }
+#if defined(__linux__)
+    // Filesystems that cannot reserve space keep the sparse file, as other systems do. A file with no room is
+    // removed rather than left behind at a size it was never written to.
+    int reserved = (size > 0) ? posix_fallocate(descriptor, 0, (off_t) size) : 0;
+    if(reserved != 0 && reserved != EOPNOTSUPP){
+        release();
+        unlink(path.c_str());
+        throw(std::runtime_error("There is not enough space to write the file: '" + path + "'."));
+    }
+#endif
+    if(size > 0){
+        void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+        if(mapping == MAP_FAILED){
+            return;
+        }
+        data = (unsigned char*) mapping;
+    }
+    open = true;
+#else
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!file){
+        return;
+    }
+    buffer.assign(size, 0);
+    data = buffer.data();
+    open = true;
+#endif
+}
+
+/**
+ * MappedFile::~MappedFile()
+ *
+ * Release the mapping and close the file, if MappedFile::close has not already. The contents of a written file
+ * are saved first, but a failure cannot be reported from here.
+ */
+MappedFile::~MappedFile(){
+    release();
+}
+
+/**
+ * MappedFile::release()
+ *
+ * Private helper function that saves a written file, releases the mapping and closes the file, once.
+ *
+ * @return
+ *      False if any part of it failed.
+ */
+bool MappedFile::release(){
+    bool released = true;
+#if defined(__unix__) || defined(__APPLE__)
+    if(data){
+        released = !writable || msync(data, size, MS_ASYNC) == 0;
+        released = munmap(data, size) == 0 && released;
+        data = nullptr;
+    }
+    if(descriptor >= 0){
+        released = ::close(descriptor) == 0 && released;
+        descriptor = -1;
+    }
+#else
+    if(open && writable){
+        std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        file.write((const char*) buffer.data(), (std::streamsize) buffer.size());
+        file.close();
+        released = (bool) file;
+    }
+    data = nullptr;
+#endif
+    open = false;
+    return released;
+}
+
+/**
+ * MappedFile::close()
+ *
+ * Save a written file, release the mapping and close the file, reporting anything that failed.
+ * The contents can no longer be accessed afterwards.
+ *
+ * @example
+ *
+ *      // Write a 16 byte file, and find out if it could not be saved
+ *      MappedFile file("path/to/file.bin", 16);
+ *      if(file){
+ *          std::fill(file.get_data(), file.get_data() + file.get_size(), 0xFF);
+ *          file.close();
+ *      }
+ *
+ * @throws
+ *      std::runtime_error if the file could not be saved or closed.
+ */
+void MappedFile::close(){
+    if(!release()){
+        throw(std::runtime_error("The file: '" + path + "' cannot be written."));
+    }
+}
+
+/**
+ * MappedFile::operator bool()
+ *
+ * Check whether the file was opened and mapped, in the same way as testing a std::ifstream.
+ *
+ * @return
+ *      True if the contents of the file can be accessed.
+ */
+MappedFile::operator bool() const{
+    return open;
+}
+
+/**
+ * MappedFile::get_data()
+ *
+ * Gets the contents of the file, or nullptr if the file is empty or could not be opened.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      A pointer to the first byte of the file.
+ */
+const unsigned char* MappedFile::get_data() const{
+    return data;
+}
+
+/**
+ * MappedFile::get_data()
+ *
+ * Gets the modifiable contents of a file opened for writing, or nullptr if the file is empty or could not be
+ * opened. Files opened read-only must not be written through this pointer.
+ *
+ * @return
+ *      A pointer to the first byte of the file.
+ */
+unsigned char* MappedFile::get_data(){
+    return data;
+}
+
+/**
+ * MappedFile::get_size()
+ *
+ * Gets the size of the file in bytes.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The number of bytes in the file.
+ */
+std::size_t MappedFile::get_size() const{
+    return size;
+}
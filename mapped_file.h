@@ -0,0 +1,42 @@
+/**
+ * Declares a class representing a file mapped into memory.
+ * Rich documentation for the api and behaviour the MappedFile class can be found in mapped_file.cpp.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Declare the structure of the MappedFile class for reading and writing whole files as one block of memory.
+ */
+class MappedFile {
+private:
+    unsigned char* data;
+    std::size_t size;
+    bool writable;
+    bool open;
+    std::string path;
+#if defined(__unix__) || defined(__APPLE__)
+    int descriptor;
+#else
+    std::vector<unsigned char> buffer;
+#endif
+
+    bool release();
+public:
+    explicit MappedFile(const std::string& path);
+    MappedFile(const std::string& path, std::size_t size);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    explicit operator bool() const;
+    const unsigned char* get_data() const;
+    unsigned char* get_data();
+    std::size_t get_size() const;
+    void close();
+};
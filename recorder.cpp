@@ -0,0 +1,469 @@
+/**
+ * Implements a Recorder class for recording every generation of a run as a stream of differences,
+ * and a Player class for rebuilding any generation of a recording.
+ *      - Each frame of a recording holds the packed words of a generation that differ from the frame before,
+ *        XORed with the old words, so a step that changes a few cells costs a few bytes.
+ *          - The changed words are grouped into runs of consecutive words, and unchanged words between runs
+ *            are skipped with a count.
+ *          - A World with a Recorder set records each step straight from its two buffers, before they are
+ *            swapped, and only compares the tiles the step changed.
+ *
+ *      - Every keyframe_interval frames, and for the first frame, a key frame holds the whole generation
+ *        instead, as the runs of words with any alive cells.
+ *          - A Player indexes the frames of a file once, then rebuilds a generation from the nearest key frame
+ *            before it, or carries on from the generation it rebuilt last when that is closer.
+ *
+ *      - Recordings are composed of:
+ *          - The 8 byte magic "GOLDIFF\0", then a 4 byte version, width, height and keyframe interval.
+ *          - One frame per recorded generation, in increasing order of generation:
+ *              - A tag byte, 'K' for a key frame or 'D' for a difference frame, and a varint generation.
+ *              - Runs, each a varint number of words to skip from the end of the last run, and a varint number
+ *                of words followed by that many 8 byte words. A run of 0 words ends the frame.
+ *              - Words are numbered through the rows of the grid in the layout of Grid::get_row.
+ *          - Integers are little-endian, and varints hold 7 bits per byte with the top bit set on all but the last.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "recorder.h"
+#include "varint.h"
+
+namespace {
+    const char MAGIC[8] = {'G', 'O', 'L', 'D', 'I', 'F', 'F', '\0'};
+    const unsigned int VERSION = 1;
+    const std::size_t HEADER_BYTES = 24;
+
+    void put_u32(std::vector<unsigned char>& out, std::uint32_t value){
+        for(int b = 0; b < 4; b++){
+            out.push_back((unsigned char) (value >> (8 * b)));
+        }
+    }
+
+    void put_u64(std::vector<unsigned char>& out, std::uint64_t value){
+        for(int b = 0; b < 8; b++){
+            out.push_back((unsigned char) (value >> (8 * b)));
+        }
+    }
+
+    std::uint32_t read_u32(const unsigned char* bytes){
+        std::uint32_t value = 0;
+        for(int b = 0; b < 4; b++){
+            value |= (std::uint32_t) bytes[b] << (8 * b);
+        }
+        return value;
+    }
+
+    std::uint64_t read_u64(const unsigned char* bytes){
+        std::uint64_t value = 0;
+        for(int b = 0; b < 8; b++){
+            value |= (std::uint64_t) bytes[b] << (8 * b);
+        }
+        return value;
+    }
+
+    /**
+     * RunEncoder
+     *
+     * Groups words given in increasing order of their index into runs, and appends each finished run to a frame.
+     */
+    struct RunEncoder {
+        std::vector<unsigned char>& out;
+        std::vector<std::uint64_t> words;
+        std::uint64_t start;
+        std::uint64_t end;
+
+        void add(std::uint64_t index, std::uint64_t word){
+            if(!words.empty() && index != start + words.size()){
+                finish();
+            }
+            if(words.empty()){
+                start = index;
+            }
+            words.push_back(word);
+        }
+
+        void finish(){
+            if(words.empty()){
+                return;
+            }
+            Varint::put(out, start - end);
+            Varint::put(out, words.size());
+            for(std::uint64_t word : words){
+                put_u64(out, word);
+            }
+            end = start + words.size();
+            words.clear();
+        }
+    };
+}
+
+/**
+ * Recorder::Recorder(output, keyframe_interval)
+ *
+ * Construct a recorder that writes frames to a stream. Nothing is written until the first frame, which sets the
+ * size of every frame in the recording. The stream must stay open while the recorder is in use.
+ *
+ * @example
+ *
+ *      // Record a thousand generations of a world
+ *      std::ofstream file("path/to/run.gdiff", std::ios::out | std::ios::binary);
+ *      Recorder recorder(file);
+ *      World world(Zoo::r_pentomino());
+ *      world.set_recorder(&recorder);
+ *      world.advance(1000);
+ *
+ * @param output
+ *      The stream to write the recording to, opened with std::ios::binary.
+ *
+ * @param keyframe_interval
+ *      The number of frames from one key frame to the next. Smaller intervals make seeking faster and
+ *      recordings larger. 0 is treated as 1, making every frame a key frame.
+ */
+Recorder::Recorder(std::ostream& output, unsigned int keyframe_interval):
+        output(output), keyframe_interval(std::max(1u, keyframe_interval)), width(0), height(0), frame_count(0),
+        last_generation(0){
+}
+
+/**
+ * Recorder::get_frame_count()
+ *
+ * Gets the number of frames written so far.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The number of frames.
+ */
+std::uint64_t Recorder::get_frame_count() const{
+    return frame_count;
+}
+
+/**
+ * Recorder::record(grid, generation)
+ *
+ * Write a generation as a key frame.
+ *
+ * @param grid
+ *      The state of the generation.
+ *
+ * @param generation
+ *      The generation number, which must be greater than that of the last frame.
+ *
+ * @throws
+ *      std::invalid_argument if the grid is not the size of the first frame, or the generation does not increase.
+ *      std::runtime_error if the stream cannot be written to.
+ */
+void Recorder::record(const Grid& grid, std::uint64_t generation){
+    begin_frame(grid, generation, true);
+    RunEncoder runs = {buffer, {}, 0, 0};
+    std::uint64_t count = (std::uint64_t) grid.get_row_words() * grid.get_height();
+    // A grid without rows or columns has no words, and its key frame holds no runs.
+    const std::uint64_t* words = (count > 0) ? grid.get_row(0) : nullptr;
+    for(std::uint64_t k = 0; k < count; k++){
+        if(words[k] != 0){
+            runs.add(k, words[k]);
+        }
+    }
+    runs.finish();
+    end_frame();
+}
+
+/**
+ * Recorder::record_step(before, after, generation, changed_tiles, tile_rows, tile_words)
+ *
+ * Write the changes from one generation to the next as a difference frame, or as a key frame when one is due.
+ * The comparison can be limited to tiles known to have changed, as World::step does.
+ *
+ * @param before
+ *      The state of the previous generation, which must be the last frame recorded.
+ *
+ * @param after
+ *      The state of the new generation.
+ *
+ * @param generation
+ *      The generation number of after, which must be greater than that of the last frame.
+ *
+ * @param changed_tiles
+ *      Optional. One flag per tile of tile_rows rows by tile_words words, a row of tiles at a time.
+ *      Tiles with a 0 flag must be the same in both grids. Defaults to nullptr, which compares every word.
+ *
+ * @param tile_rows
+ *      The number of rows in a tile.
+ *
+ * @param tile_words
+ *      The number of words in a row of a tile.
+ *
+ * @throws
+ *      std::invalid_argument if the grids are not the size of the first frame, or the generation does not increase.
+ *      std::runtime_error if the stream cannot be written to.
+ */
+void Recorder::record_step(const Grid& before, const Grid& after, std::uint64_t generation,
+                           const unsigned char* changed_tiles, unsigned int tile_rows, unsigned int tile_words){
+    if(frame_count % keyframe_interval == 0){
+        record(after, generation);
+        return;
+    }
+    if(before.get_width() != after.get_width() || before.get_height() != after.get_height()){
+        throw(std::invalid_argument("Recorder::record_step error: the grids must be the same size."));
+    }
+    begin_frame(after, generation, false);
+    RunEncoder runs = {buffer, {}, 0, 0};
+    unsigned int row_words = after.get_row_words();
+    if(changed_tiles == nullptr){
+        tile_rows = after.get_height();
+        tile_words = row_words;
+    }
+    unsigned int columns = (tile_words == 0) ? 0 : (row_words + tile_words - 1) / tile_words;
+    for(unsigned int y = 0; y < after.get_height(); y++){
+        const std::uint64_t* old_row = before.get_row(y);
+        const std::uint64_t* new_row = after.get_row(y);
+        const unsigned char* changed = changed_tiles ? changed_tiles + (std::size_t) (y / tile_rows) * columns
+                                                     : nullptr;
+        for(unsigned int tx = 0; tx < columns; tx++){
+            if(changed && !changed[tx]){
+                continue;
+            }
+            unsigned int k1 = std::min(row_words, (tx + 1) * tile_words);
+            for(unsigned int k = tx * tile_words; k < k1; k++){
+                if(old_row[k] != new_row[k]){
+                    runs.add((std::uint64_t) y * row_words + k, old_row[k] ^ new_row[k]);
+                }
+            }
+        }
+    }
+    runs.finish();
+    end_frame();
+}
+
+/**
+ * Recorder::begin_frame(grid, generation, keyframe)
+ *
+ * Private helper function that checks a new frame and starts it in the buffer, after the header for the first frame.
+ */
+void Recorder::begin_frame(const Grid& grid, std::uint64_t generation, bool keyframe){
+    buffer.clear();
+    if(frame_count == 0){
+        width = grid.get_width();
+        height = grid.get_height();
+        buffer.insert(buffer.end(), MAGIC, MAGIC + sizeof MAGIC);
+        put_u32(buffer, VERSION);
+        put_u32(buffer, width);
+        put_u32(buffer, height);
+        put_u32(buffer, keyframe_interval);
+    } else{
+        if(grid.get_width() != width || grid.get_height() != height){
+            throw(std::invalid_argument("Recorder::record error: every frame must be the size of the first frame."));
+        }
+        if(generation <= last_generation){
+            throw(std::invalid_argument("Recorder::record error: the generations of frames must increase."));
+        }
+    }
+    buffer.push_back(keyframe ? 'K' : 'D');
+    Varint::put(buffer, generation);
+    last_generation = generation;
+}
+
+/**
+ * Recorder::end_frame()
+ *
+ * Private helper function that ends the frame in the buffer and writes it to the stream.
+ */
+void Recorder::end_frame(){
+    Varint::put(buffer, 0);
+    Varint::put(buffer, 0);
+    output.write((const char*) buffer.data(), (std::streamsize) buffer.size());
+    if(!output){
+        throw(std::runtime_error("Recorder::record error: the frame could not be written to the stream."));
+    }
+    frame_count++;
+}
+
+/**
+ * Player::Player(path)
+ *
+ * Open a recording made by a Recorder and index its frames. The file is memory mapped, and frames are only
+ * decoded when a generation is asked for.
+ *
+ * @example
+ *
+ *      // Print generation 500 of a recording
+ *      Player player("path/to/run.gdiff");
+ *      std::cout << player.get_state(500) << std::endl;
+ *
+ * @param path
+ *      The std::string path to the file to read in.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if:
+ *          - The file cannot be opened.
+ *          - The file is not a recording, or is truncated or malformed.
+ */
+Player::Player(const std::string& path): file(path), path(path), current(0){
+    if(!file){
+        throw(std::runtime_error("The path given to class: Player is incorrect."));
+    }
+    const unsigned char* data = file.get_data();
+    std::size_t size = file.get_size();
+    std::string invalid = "The file: '" + path + "' is not a valid recording.";
+    if(size < HEADER_BYTES || std::memcmp(data, MAGIC, sizeof MAGIC) != 0 || read_u32(data + 8) != VERSION){
+        throw(std::runtime_error(invalid));
+    }
+    state = Grid(read_u32(data + 12), read_u32(data + 16));
+    std::uint64_t words = (std::uint64_t) state.get_row_words() * state.get_height();
+
+    const unsigned char* bytes = data + HEADER_BYTES;
+    const unsigned char* end = data + size;
+    while(bytes != end){
+        Frame frame = {0, (std::size_t) (bytes - data), *bytes == 'K'};
+        if(*bytes != 'K' && *bytes != 'D'){
+            throw(std::runtime_error(invalid));
+        }
+        bytes++;
+        if(!Varint::get(bytes, end, frame.generation) || (frames.empty() && !frame.keyframe) ||
+           (!frames.empty() && frame.generation <= frames.back().generation)){
+            throw(std::runtime_error(invalid));
+        }
+        std::uint64_t index = 0;
+        while(true){
+            std::uint64_t skip;
+            std::uint64_t length;
+            if(!Varint::get(bytes, end, skip) || !Varint::get(bytes, end, length)){
+                throw(std::runtime_error(invalid));
+            }
+            if(length == 0){
+                break;
+            }
+            if(skip > words - index || length > words - index - skip ||
+               length > (std::uint64_t) (end - bytes) / 8){
+                throw(std::runtime_error(invalid));
+            }
+            index += skip + length;
+            bytes += length * 8;
+        }
+        frames.push_back(frame);
+    }
+    if(frames.empty()){
+        throw(std::runtime_error(invalid));
+    }
+    // No generation has been rebuilt yet.
+    current = frames.size();
+}
+
+/**
+ * Player::get_frame_count()
+ *
+ * Gets the number of frames in the recording.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The number of frames.
+ */
+std::size_t Player::get_frame_count() const{
+    return frames.size();
+}
+
+/**
+ * Player::get_first_generation()
+ *
+ * Gets the generation of the first frame in the recording.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The first generation recorded.
+ */
+std::uint64_t Player::get_first_generation() const{
+    return frames.front().generation;
+}
+
+/**
+ * Player::get_last_generation()
+ *
+ * Gets the generation of the last frame in the recording.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The last generation recorded.
+ */
+std::uint64_t Player::get_last_generation() const{
+    return frames.back().generation;
+}
+
+/**
+ * Player::get_state(generation)
+ *
+ * Rebuild a generation of the recording. Generations between recorded frames are the state of the frame before.
+ * Frames are applied from the nearest key frame, or onward from the last generation rebuilt when that lies
+ * between the key frame and the one asked for, so playing a recording forwards applies each frame once.
+ *
+ * @param generation
+ *      The generation to rebuild.
+ *
+ * @return
+ *      A read-only reference to the state, valid until the next call.
+ *
+ * @throws
+ *      std::out_of_range if the generation is before the first frame.
+ */
+const Grid& Player::get_state(std::uint64_t generation){
+    if(generation < frames.front().generation){
+        throw(std::out_of_range("Player::get_state error: the generation is before the start of the recording."));
+    }
+    std::size_t target = (std::size_t) (std::upper_bound(frames.begin(), frames.end(), generation,
+            [](std::uint64_t g, const Frame& frame){ return g < frame.generation; }) - frames.begin()) - 1;
+    std::size_t keyframe = target;
+    while(!frames[keyframe].keyframe){
+        keyframe--;
+    }
+    std::size_t next = keyframe;
+    if(current < frames.size() && current >= keyframe && current <= target){
+        next = current + 1;
+    }
+    for(; next <= target; next++){
+        apply(next);
+    }
+    current = target;
+    return state;
+}
+
+/**
+ * Player::apply(frame)
+ *
+ * Private helper function that decodes a frame onto the state, replacing it for a key frame.
+ * The frame was checked when the file was indexed.
+ */
+void Player::apply(std::size_t frame){
+    unsigned int row_words = state.get_row_words();
+    std::uint64_t count = (std::uint64_t) row_words * state.get_height();
+    // The frames of a grid without rows or columns were checked to hold no runs, so there is nothing to apply.
+    if(count == 0){
+        return;
+    }
+    std::uint64_t* words = state.get_row(0);
+    const unsigned char* bytes = file.get_data() + frames[frame].offset + 1;
+    const unsigned char* end = file.get_data() + file.get_size();
+    std::uint64_t generation;
+    Varint::get(bytes, end, generation);
+    if(frames[frame].keyframe){
+        std::fill(words, words + count, 0);
+    }
+    // Bits past the width of a row must stay 0 even in a damaged file.
+    std::uint64_t last_word = (state.get_width() % 64 == 0) ? ~(std::uint64_t) 0
+                                                            : ((std::uint64_t) 1 << (state.get_width() % 64)) - 1;
+    std::uint64_t index = 0;
+    while(true){
+        std::uint64_t skip;
+        std::uint64_t length;
+        Varint::get(bytes, end, skip);
+        Varint::get(bytes, end, length);
+        if(length == 0){
+            break;
+        }
+        index += skip;
+        for(std::uint64_t i = 0; i < length; i++, index++, bytes += 8){
+            std::uint64_t word = read_u64(bytes);
+            words[index] ^= (index % row_words == row_words - 1) ? word & last_word : word;
+        }
+    }
+}
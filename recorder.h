@@ -0,0 +1,79 @@
+/**
+ * Declares a Recorder class for recording every generation of a run as a stream of differences,
+ * and a Player class for rebuilding any generation of a recording.
+ * Rich documentation for the api and behaviour of both classes can be found in recorder.cpp.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "grid.h"
+#include "mapped_file.h"
+
+/**
+ * Declare the structure of the Recorder class for writing the changes between generations to a stream.
+ */
+class Recorder {
+public:
+    /**
+     * The number of frames between key frames used when none is given.
+     */
+    static const unsigned int DEFAULT_KEYFRAME_INTERVAL = 64;
+private:
+    std::ostream& output;
+    unsigned int keyframe_interval;
+    unsigned int width;
+    unsigned int height;
+    std::uint64_t frame_count;
+    std::uint64_t last_generation;
+    std::vector<unsigned char> buffer;
+
+    void begin_frame(const Grid& grid, std::uint64_t generation, bool keyframe);
+    void end_frame();
+public:
+    explicit Recorder(std::ostream& output, unsigned int keyframe_interval = DEFAULT_KEYFRAME_INTERVAL);
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+    std::uint64_t get_frame_count() const;
+    void record(const Grid& grid, std::uint64_t generation);
+    void record_step(const Grid& before, const Grid& after, std::uint64_t generation,
+                     const unsigned char* changed_tiles = nullptr, unsigned int tile_rows = 0,
+                     unsigned int tile_words = 0);
+};
+
+/**
+ * Declare the structure of the Player class for seeking through a recording made by a Recorder.
+ */
+class Player {
+private:
+    /**
+     * Where a frame starts in the file and the generation it holds.
+     */
+    struct Frame {
+        std::uint64_t generation;
+        std::size_t offset;
+        bool keyframe;
+    };
+
+    MappedFile file;
+    std::string path;
+    std::vector<Frame> frames;
+    Grid state;
+    std::size_t current;
+
+    void apply(std::size_t frame);
+public:
+    explicit Player(const std::string& path);
+    Player(const Player&) = delete;
+    Player& operator=(const Player&) = delete;
+    std::size_t get_frame_count() const;
+    std::uint64_t get_first_generation() const;
+    std::uint64_t get_last_generation() const;
+    const Grid& get_state(std::uint64_t generation);
+};
@@ -0,0 +1,213 @@
+/**
+ * Implements a class representing a Life-like cellular automaton rule in B/S notation.
+ *      - https://conwaylife.com/wiki/Rulestring
+ *      - A Life-like rule decides the next state of a cell from its current state and its number of alive
+ *        neighbours alone. "B3/S23" is Conway's Game of Life: a dead cell with 3 neighbours is born, and an
+ *        alive cell with 2 or 3 neighbours survives. Every other cell is Cell::DEAD in the next generation.
+ *
+ *      - Rules are stored as two 9 bit masks, where bit n is set if n neighbours give birth or survival.
+ *      - Rules can be parsed from:
+ *          - "B(digits)/S(digits)" or "S(digits)/B(digits)", in either case, such as "B36/S23" for HighLife.
+ *          - The older "(survival digits)/(birth digits)" form, such as "23/3" for Conway's Game of Life.
+ *
+ *      - Kernel steps the most common rules with code specialised for them at compile time, and every other rule
+ *        with the same adder network followed by a comparison against each neighbour count in the rule.
+ *          - Conway's Game of Life "B3/S23"
+ *          - HighLife "B36/S23"
+ *          - Seeds "B2/S"
+ *          - Day & Night "B3678/S34678"
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#include <cctype>
+#include <stdexcept>
+#include "rule.h"
+
+namespace {
+    /**
+     * parse_counts(notation, position, mask)
+     *
+     * Read a run of neighbour count digits from 0 to 8 into a mask, stopping at the first other character.
+     */
+    void parse_counts(const std::string& notation, std::size_t& position, unsigned int& mask){
+        while(position < notation.size() && notation[position] >= '0' && notation[position] <= '8'){
+            mask |= 1u << (notation[position++] - '0');
+        }
+    }
+}
+
+/**
+ * Rule::Rule()
+ *
+ * Construct Conway's Game of Life, "B3/S23".
+ */
+Rule::Rule(): birth(1u << 3), survival((1u << 2) | (1u << 3)){
+}
+
+/**
+ * Rule::Rule(notation)
+ *
+ * Parse a rule in B/S notation. Spaces are ignored.
+ *
+ * @example
+ *
+ *      // Make HighLife, which has a replicator
+ *      Rule high_life("B36/S23");
+ *
+ *      // Prints B36/S23
+ *      std::cout << high_life.get_name() << std::endl;
+ *
+ * @param notation
+ *      The rule, such as "B3/S23", "b36/s23", "S23/B3" or "23/3".
+ *
+ * @throws
+ *      std::invalid_argument if the notation is not a rule.
+ */
+Rule::Rule(const std::string& notation): birth(0), survival(0){
+    std::string rule;
+    for(char character : notation){
+        if(!std::isspace((unsigned char) character)){
+            rule += (char) std::toupper((unsigned char) character);
+        }
+    }
+    std::size_t slash = rule.find('/');
+    if(slash == std::string::npos || rule.find('/', slash + 1) != std::string::npos){
+        throw(std::invalid_argument("Rule::Rule error: '" + notation + "' is not a rule in B/S notation."));
+    }
+
+    std::size_t position = 0;
+    if(rule[0] != 'B' && rule[0] != 'S'){
+        // The older form lists survival before birth without letters.
+        parse_counts(rule, position, survival);
+        if(position == slash){
+            position++;
+            parse_counts(rule, position, birth);
+        }
+    } else{
+        bool seen[2] = {false, false};
+        for(int part = 0; part < 2; part++){
+            bool is_birth = position < rule.size() && rule[position] == 'B';
+            if(position >= rule.size() || (rule[position] != 'B' && rule[position] != 'S') || seen[is_birth]){
+                break;
+            }
+            seen[is_birth] = true;
+            position++;
+            parse_counts(rule, position, is_birth ? birth : survival);
+            if(part == 0 && position == slash){
+                position++;
+            }
+        }
+    }
+    if(position != rule.size()){
+        throw(std::invalid_argument("Rule::Rule error: '" + notation + "' is not a rule in B/S notation."));
+    }
+}
+
+/**
+ * Rule::Rule(birth, survival)
+ *
+ * Construct a rule from its masks, where bit n of each mask is set if n alive neighbours give birth or survival.
+ *
+ * @param birth
+ *      The neighbour counts that make a dead cell alive.
+ *
+ * @param survival
+ *      The neighbour counts that keep an alive cell alive.
+ *
+ * @throws
+ *      std::invalid_argument if either mask has bits above bit 8.
+ */
+Rule::Rule(unsigned int birth, unsigned int survival): birth(birth), survival(survival){
+    if((birth | survival) >> 9){
+        throw(std::invalid_argument("Rule::Rule error: a cell cannot have more than 8 neighbours."));
+    }
+}
+
+/**
+ * Rule::get_birth()
+ *
+ * Gets the neighbour counts that make a dead cell alive, as a mask where bit n is set for n neighbours.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The birth mask.
+ */
+unsigned int Rule::get_birth() const{
+    return birth;
+}
+
+/**
+ * Rule::get_survival()
+ *
+ * Gets the neighbour counts that keep an alive cell alive, as a mask where bit n is set for n neighbours.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The survival mask.
+ */
+unsigned int Rule::get_survival() const{
+    return survival;
+}
+
+/**
+ * Rule::get_name()
+ *
+ * Gets the rule in B/S notation, with the counts in increasing order.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The rule, such as "B3/S23".
+ */
+std::string Rule::get_name() const{
+    std::string name = "B";
+    for(unsigned int n = 0; n <= 8; n++){
+        if((birth >> n) & 1){
+            name += (char) ('0' + n);
+        }
+    }
+    name += "/S";
+    for(unsigned int n = 0; n <= 8; n++){
+        if((survival >> n) & 1){
+            name += (char) ('0' + n);
+        }
+    }
+    return name;
+}
+
+/**
+ * Rule::get_next(alive, neighbours)
+ *
+ * Apply the rule to a single cell.
+ * The function should be callable from a constant context.
+ *
+ * @param alive
+ *      True if the cell is Cell::ALIVE.
+ *
+ * @param neighbours
+ *      The number of alive neighbours of the cell, from 0 to 8.
+ *
+ * @return
+ *      True if the cell is Cell::ALIVE in the next generation.
+ */
+bool Rule::get_next(bool alive, unsigned int neighbours) const{
+    return (((alive ? survival : birth) >> neighbours) & 1) != 0;
+}
+
+/**
+ * Rule::operator==(other)
+ *
+ * Compare two rules, which are equal when they give birth and survival for the same counts.
+ */
+bool Rule::operator==(const Rule& other) const{
+    return birth == other.birth && survival == other.survival;
+}
+
+/**
+ * Rule::operator!=(other)
+ *
+ * Compare two rules, which differ when they give birth or survival for different counts.
+ */
+bool Rule::operator!=(const Rule& other) const{
+    return !(*this == other);
+}
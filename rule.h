@@ -0,0 +1,29 @@
+/**
+ * Declares a class representing a Life-like cellular automaton rule in B/S notation.
+ * Rich documentation for the api and behaviour the Rule class can be found in rule.cpp.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#pragma once
+
+#include <string>
+
+/**
+ * Declare the structure of the Rule class for choosing which neighbour counts give birth and survival.
+ */
+class Rule {
+private:
+    unsigned int birth;
+    unsigned int survival;
+public:
+    Rule();
+    explicit Rule(const std::string& notation);
+    Rule(unsigned int birth, unsigned int survival);
+    unsigned int get_birth() const;
+    unsigned int get_survival() const;
+    std::string get_name() const;
+    bool get_next(bool alive, unsigned int neighbours) const;
+    bool operator==(const Rule& other) const;
+    bool operator!=(const Rule& other) const;
+};
@@ -0,0 +1,651 @@
+/**
+ * Implements a Snapshot namespace with methods for saving and loading grids in a tiled, compressed file format.
+ *      - The grid is split into square tiles, a multiple of 64 cells wide, and each tile is compressed on its own.
+ *          - Tiles are encoded and decoded in parallel on a ThreadPool.
+ *          - The file is accessed through a MappedFile, so loading a region only reads the tiles it covers.
+ *
+ *      - Snapshot files are composed of, with every integer stored little-endian:
+ *          - The 8 byte magic string "GOLSNAP\0" followed by a 4 byte format version, currently 1.
+ *          - 4 byte unsigned ints for the grid width, the grid height and the tile size.
+ *          - An 8 byte unsigned int for the generation the grid was saved at.
+ *          - A 4 byte length followed by the characters of the rule, such as "B3/S23".
+ *          - The tile index, with an 8 byte offset from the start of the file and an 8 byte length for every tile,
+ *            in row-major order. Tiles with no alive cells have a length of 0 and no data.
+ *          - The data of each tile.
+ *
+ *      - Each tile is the packed 64-bit words of its rows, as laid out by Grid, compressed by run length.
+ *          - The data is a sequence of runs, each starting with a varint of (count << 1) | literal.
+ *          - A literal run is followed by count 8 byte words. Any other run is count words of cells that are all
+ *            Cell::DEAD, and the dead words at the end of a tile are left out altogether.
+ *          - https://en.wikipedia.org/wiki/Run-length_encoding
+ *
+ *      - Built with GOL_WITH_MPI, a grid split into blocks across MPI ranks can be saved collectively, with each
+ *        rank compressing the tiles of its own block and writing them with MPI-IO, so no rank holds the whole grid.
+ *        Each rank can then load its block back with Snapshot::load_region, which reads only the tiles it covers.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "mapped_file.h"
+#include "snapshot.h"
+#include "thread_pool.h"
+#include "varint.h"
+
+namespace {
+    const char MAGIC[8] = {'G', 'O', 'L', 'S', 'N', 'A', 'P', '\0'};
+    const unsigned int VERSION = 1;
+
+    // The size of the fixed part of the header, before the characters of the rule.
+    const std::size_t FIXED_HEADER_BYTES = 36;
+    const std::size_t INDEX_ENTRY_BYTES = 16;
+
+    void write_u32(unsigned char* bytes, std::uint32_t value){
+        for(int b = 0; b < 4; b++){
+            bytes[b] = (unsigned char) (value >> (8 * b));
+        }
+    }
+
+    void write_u64(unsigned char* bytes, std::uint64_t value){
+        for(int b = 0; b < 8; b++){
+            bytes[b] = (unsigned char) (value >> (8 * b));
+        }
+    }
+
+    std::uint32_t read_u32(const unsigned char* bytes){
+        std::uint32_t value = 0;
+        for(int b = 0; b < 4; b++){
+            value |= (std::uint32_t) bytes[b] << (8 * b);
+        }
+        return value;
+    }
+
+    std::uint64_t read_u64(const unsigned char* bytes){
+        std::uint64_t value = 0;
+        for(int b = 0; b < 8; b++){
+            value |= (std::uint64_t) bytes[b] << (8 * b);
+        }
+        return value;
+    }
+
+    /**
+     * Tiling
+     *
+     * The number of tiles and the rows and words of the grid covered by each of them.
+     */
+    struct Tiling {
+        unsigned int width;
+        unsigned int height;
+        unsigned int tile_size;
+        unsigned int columns;
+        unsigned int rows;
+
+        Tiling(unsigned int width, unsigned int height, unsigned int tile_size):
+                width(width), height(height), tile_size(tile_size),
+                columns((width + tile_size - 1) / tile_size), rows((height + tile_size - 1) / tile_size){
+        }
+
+        std::size_t get_count() const{
+            return (std::size_t) columns * rows;
+        }
+
+        unsigned int get_row_begin(unsigned int ty) const{
+            return ty * tile_size;
+        }
+
+        unsigned int get_row_end(unsigned int ty) const{
+            return std::min(height, (ty + 1) * tile_size);
+        }
+
+        unsigned int get_word_begin(unsigned int tx) const{
+            return tx * (tile_size / 64);
+        }
+
+        unsigned int get_word_end(unsigned int tx) const{
+            return std::min((width + 63) / 64, (tx + 1) * (tile_size / 64));
+        }
+    };
+
+    unsigned int get_thread_count(unsigned int threads){
+        return (threads == 0) ? std::max(1u, std::thread::hardware_concurrency()) : threads;
+    }
+
+    /**
+     * encode_tile(grid, tiling, tx, ty, out)
+     *
+     * Compress the words of one tile into out, leaving out empty if the tile has no alive cells.
+     */
+    void encode_tile(const Grid& grid, const Tiling& tiling, unsigned int tx, unsigned int ty,
+                     std::vector<unsigned char>& out){
+        std::uint64_t dead_words = 0;
+        std::vector<std::uint64_t> literals;
+        auto flush_literals = [&](){
+            Varint::put(out, (literals.size() << 1) | 1);
+            for(std::uint64_t word : literals){
+                std::size_t at = out.size();
+                out.resize(at + 8);
+                write_u64(out.data() + at, word);
+            }
+            literals.clear();
+        };
+
+        for(unsigned int y = tiling.get_row_begin(ty); y < tiling.get_row_end(ty); y++){
+            const std::uint64_t* row = grid.get_row(y);
+            for(unsigned int k = tiling.get_word_begin(tx); k < tiling.get_word_end(tx); k++){
+                if(row[k] == 0){
+                    if(!literals.empty()){
+                        flush_literals();
+                    }
+                    dead_words++;
+                } else{
+                    if(dead_words != 0){
+                        Varint::put(out, dead_words << 1);
+                        dead_words = 0;
+                    }
+                    literals.push_back(row[k]);
+                }
+            }
+        }
+        // Trailing dead words are implied by the end of the data.
+        if(!literals.empty()){
+            flush_literals();
+        }
+    }
+
+    /**
+     * decode_tile(bytes, length, target, row0, word0, rows, words)
+     *
+     * Decompress the data of one tile of rows x words words into a grid of dead cells, with the top left word
+     * of the tile at word word0 of row row0 of the target.
+     *
+     * @return
+     *      False if the data is malformed.
+     */
+    bool decode_tile(const unsigned char* bytes, std::size_t length, Grid& target, unsigned int row0,
+                     unsigned int word0, unsigned int rows, unsigned int words){
+        const unsigned char* end = bytes + length;
+        std::uint64_t total = (std::uint64_t) rows * words;
+        std::uint64_t position = 0;
+        while(bytes != end){
+            std::uint64_t token;
+            if(!Varint::get(bytes, end, token)){
+                return false;
+            }
+            std::uint64_t count = token >> 1;
+            if(count > total - position){
+                return false;
+            }
+            if(token & 1){
+                if(count > (std::uint64_t) (end - bytes) / 8){
+                    return false;
+                }
+                for(std::uint64_t i = 0; i < count; i++, position++, bytes += 8){
+                    unsigned int k = word0 + (unsigned int) (position % words);
+                    std::uint64_t word = read_u64(bytes);
+                    // Keep the padding past the width dead, even if the file says otherwise.
+                    if(k + 1 == target.get_row_words() && target.get_width() % 64 != 0){
+                        word &= ((std::uint64_t)1 << (target.get_width() % 64)) - 1;
+                    }
+                    target.get_row(row0 + (unsigned int) (position / words))[k] = word;
+                }
+            } else{
+                position += count;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * parse_header(file, path, header)
+     *
+     * Read and check the header of a mapped snapshot file.
+     *
+     * @return
+     *      A pointer to the start of the tile index.
+     */
+    const unsigned char* parse_header(const MappedFile& file, const std::string& path, Snapshot::Header& header){
+        const unsigned char* bytes = file.get_data();
+        std::size_t size = file.get_size();
+        if(size < FIXED_HEADER_BYTES){
+            throw(std::runtime_error("The file: '" + path + "' ends unexpectedly."));
+        } else if(std::memcmp(bytes, MAGIC, sizeof MAGIC) != 0){
+            throw(std::runtime_error("The file: '" + path + "' is not a snapshot."));
+        }
+        header.version = read_u32(bytes + 8);
+        header.width = read_u32(bytes + 12);
+        header.height = read_u32(bytes + 16);
+        header.tile_size = read_u32(bytes + 20);
+        header.generation = read_u64(bytes + 24);
+        std::uint32_t rule_length = read_u32(bytes + 32);
+        if(header.version != VERSION){
+            throw(std::runtime_error("The file: '" + path + "' has an unsupported snapshot version."));
+        } else if(header.tile_size == 0 || header.tile_size % 64 != 0){
+            throw(std::runtime_error("The file: '" + path + "' is corrupt."));
+        } else if(rule_length > size - FIXED_HEADER_BYTES){
+            throw(std::runtime_error("The file: '" + path + "' ends unexpectedly."));
+        }
+        header.rule.assign((const char*) bytes + FIXED_HEADER_BYTES, rule_length);
+
+        const unsigned char* index = bytes + FIXED_HEADER_BYTES + rule_length;
+        Tiling tiling(header.width, header.height, header.tile_size);
+        if(tiling.get_count() > (size - FIXED_HEADER_BYTES - rule_length) / INDEX_ENTRY_BYTES){
+            throw(std::runtime_error("The file: '" + path + "' ends unexpectedly."));
+        }
+        return index;
+    }
+
+    /**
+     * decode_tiles(file, path, header, index, tx0, ty0, tx1, ty1, target, threads)
+     *
+     * Decompress the tiles [tx0, tx1) by [ty0, ty1) in parallel into a grid whose top left is the top left
+     * of tile (tx0, ty0).
+     */
+    void decode_tiles(const MappedFile& file, const std::string& path, const Snapshot::Header& header,
+                      const unsigned char* index, unsigned int tx0, unsigned int ty0, unsigned int tx1,
+                      unsigned int ty1, Grid& target, unsigned int threads){
+        Tiling tiling(header.width, header.height, header.tile_size);
+        std::atomic<bool> corrupt(false);
+        auto decode_row = [&](unsigned int task){
+            unsigned int ty = ty0 + task;
+            for(unsigned int tx = tx0; tx < tx1; tx++){
+                const unsigned char* entry = index + ((std::size_t) ty * tiling.columns + tx) * INDEX_ENTRY_BYTES;
+                std::uint64_t offset = read_u64(entry), length = read_u64(entry + 8);
+                if(length == 0){
+                    continue;
+                }
+                if(offset > file.get_size() || length > file.get_size() - offset ||
+                   !decode_tile(file.get_data() + offset, (std::size_t) length, target,
+                                tiling.get_row_begin(ty) - tiling.get_row_begin(ty0),
+                                tiling.get_word_begin(tx) - tiling.get_word_begin(tx0),
+                                tiling.get_row_end(ty) - tiling.get_row_begin(ty),
+                                tiling.get_word_end(tx) - tiling.get_word_begin(tx))){
+                    // Exceptions cannot leave a pool task, so failures are reported once every task is done.
+                    corrupt = true;
+                }
+            }
+        };
+        ThreadPool pool(get_thread_count(threads));
+        pool.run(ty1 - ty0, decode_row);
+        if(corrupt){
+            throw(std::runtime_error("The file: '" + path + "' is corrupt."));
+        }
+    }
+}
+
+/**
+ * Snapshot::save(path, grid, generation, rule, threads, tile_size)
+ *
+ * Save a grid as a snapshot file, compressing its tiles in parallel.
+ * Tiles with no alive cells take no space beyond their index entry, so mostly empty grids save small.
+ *
+ * @example
+ *
+ *      // Save the state of a world on every core
+ *      Snapshot::save("path/to/file.gsnap", world.get_state(), world.get_generation(), "B3/S23", 0);
+ *
+ * @param path
+ *      The std::string path to the file to write to.
+ *
+ * @param grid
+ *      The grid to be written out to file.
+ *
+ * @param generation
+ *      Optional parameter. The generation of the grid, stored in the header. Defaults to 0.
+ *
+ * @param rule
+ *      Optional parameter. The rule the grid evolves under, stored in the header. Defaults to "B3/S23".
+ *
+ * @param threads
+ *      Optional parameter. The number of threads to compress tiles with, 0 uses every core. Defaults to 1.
+ *
+ * @param tile_size
+ *      Optional parameter. The edge size of a tile in cells. Defaults to Snapshot::DEFAULT_TILE_SIZE.
+ *
+ * @throws
+ *      std::invalid_argument if the tile size is not a positive multiple of 64.
+ *      std::runtime_error or sub-class if the file cannot be opened, there is no room for it, or it cannot be
+ *      written.
+ */
+void Snapshot::save(const std::string& path, const Grid& grid, std::uint64_t generation, const std::string& rule,
+                    unsigned int threads, unsigned int tile_size){
+    if(tile_size == 0 || tile_size % 64 != 0){
+        throw(std::invalid_argument("Snapshot::save error: the tile size must be a positive multiple of 64."));
+    }
+    Tiling tiling(grid.get_width(), grid.get_height(), tile_size);
+    ThreadPool pool(get_thread_count(threads));
+
+    std::vector<std::vector<unsigned char>> tiles(tiling.get_count());
+    pool.run(tiling.rows, [&](unsigned int ty){
+        for(unsigned int tx = 0; tx < tiling.columns; tx++){
+            encode_tile(grid, tiling, tx, ty, tiles[(std::size_t) ty * tiling.columns + tx]);
+        }
+    });
+
+    std::size_t index_start = FIXED_HEADER_BYTES + rule.size();
+    std::size_t data_start = index_start + tiles.size() * INDEX_ENTRY_BYTES;
+    std::vector<std::uint64_t> offsets(tiles.size());
+    std::size_t size = data_start;
+    for(std::size_t t = 0; t < tiles.size(); t++){
+        offsets[t] = tiles[t].empty() ? 0 : size;
+        size += tiles[t].size();
+    }
+
+    MappedFile file(path, size);
+    if(!file){
+        throw(std::runtime_error("The path given to function: Snapshot::save is incorrect."));
+    }
+    unsigned char* bytes = file.get_data();
+    std::memcpy(bytes, MAGIC, sizeof MAGIC);
+    write_u32(bytes + 8, VERSION);
+    write_u32(bytes + 12, grid.get_width());
+    write_u32(bytes + 16, grid.get_height());
+    write_u32(bytes + 20, tile_size);
+    write_u64(bytes + 24, generation);
+    write_u32(bytes + 32, (std::uint32_t) rule.size());
+    std::memcpy(bytes + FIXED_HEADER_BYTES, rule.data(), rule.size());
+    for(std::size_t t = 0; t < tiles.size(); t++){
+        write_u64(bytes + index_start + t * INDEX_ENTRY_BYTES, offsets[t]);
+        write_u64(bytes + index_start + t * INDEX_ENTRY_BYTES + 8, tiles[t].size());
+    }
+
+    pool.run(tiling.rows, [&](unsigned int ty){
+        for(unsigned int tx = 0; tx < tiling.columns; tx++){
+            std::size_t t = (std::size_t) ty * tiling.columns + tx;
+            if(!tiles[t].empty()){
+                std::memcpy(bytes + offsets[t], tiles[t].data(), tiles[t].size());
+            }
+        }
+    });
+    file.close();
+}
+
+/**
+ * Snapshot::load_header(path)
+ *
+ * Read only the header of a snapshot file, for its size, generation and rule.
+ *
+ * @example
+ *
+ *      // Print the generation a snapshot was taken at
+ *      std::cout << Snapshot::load_header("path/to/file.gsnap").generation << std::endl;
+ *
+ * @param path
+ *      The std::string path to the file to read in.
+ *
+ * @return
+ *      The header of the file.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if:
+ *          - The file cannot be opened.
+ *          - The file is not a snapshot, or has an unsupported version.
+ *          - The file ends unexpectedly.
+ */
+Snapshot::Header Snapshot::load_header(const std::string& path){
+    MappedFile file(path);
+    if(!file){
+        throw(std::runtime_error("The path given to function: Snapshot::load_header is incorrect."));
+    }
+    Header header;
+    parse_header(file, path, header);
+    return header;
+}
+
+/**
+ * Snapshot::load(path, threads)
+ *
+ * Load a whole snapshot file as a grid, decompressing its tiles in parallel.
+ *
+ * @example
+ *
+ *      // Load a snapshot on every core
+ *      Grid grid = Snapshot::load("path/to/file.gsnap", 0);
+ *
+ * @param path
+ *      The std::string path to the file to read in.
+ *
+ * @param threads
+ *      Optional parameter. The number of threads to decompress tiles with, 0 uses every core. Defaults to 1.
+ *
+ * @return
+ *      Returns the parsed grid.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if:
+ *          - The file cannot be opened.
+ *          - The file is not a snapshot, or has an unsupported version.
+ *          - The file ends unexpectedly or is corrupt.
+ */
+Grid Snapshot::load(const std::string& path, unsigned int threads){
+    MappedFile file(path);
+    if(!file){
+        throw(std::runtime_error("The path given to function: Snapshot::load is incorrect."));
+    }
+    Header header;
+    const unsigned char* index = parse_header(file, path, header);
+    Tiling tiling(header.width, header.height, header.tile_size);
+    Grid grid(header.width, header.height);
+    decode_tiles(file, path, header, index, 0, 0, tiling.columns, tiling.rows, grid, threads);
+    return grid;
+}
+
+/**
+ * Snapshot::load_region(path, x0, y0, x1, y1, threads)
+ *
+ * Load one region of a snapshot file, which like Grid::crop spans the range [x0, x1) by [y0, y1).
+ * Only the tiles overlapping the region are read from the file and decompressed.
+ *
+ * @example
+ *
+ *      // Load the top left 1000x1000 cells of a huge snapshot
+ *      Grid corner = Snapshot::load_region("path/to/file.gsnap", 0, 0, 1000, 1000);
+ *
+ * @param path
+ *      The std::string path to the file to read in.
+ *
+ * @param x0
+ *      Left coordinate of the region on x-axis.
+ *
+ * @param y0
+ *      Top coordinate of the region on y-axis.
+ *
+ * @param x1
+ *      Right coordinate of the region on x-axis (1 greater than the largest index).
+ *
+ * @param y1
+ *      Bottom coordinate of the region on y-axis (1 greater than the largest index).
+ *
+ * @param threads
+ *      Optional parameter. The number of threads to decompress tiles with, 0 uses every core. Defaults to 1.
+ *
+ * @return
+ *      A new grid of the region size containing the cells of the snapshot.
+ *
+ * @throws
+ *      std::range_error if the region is not within the snapshot or has a negative size.
+ *      std::runtime_error or sub-class under the same conditions as Snapshot::load.
+ */
+Grid Snapshot::load_region(const std::string& path, int x0, int y0, int x1, int y1, unsigned int threads){
+    MappedFile file(path);
+    if(!file){
+        throw(std::runtime_error("The path given to function: Snapshot::load_region is incorrect."));
+    }
+    Header header;
+    const unsigned char* index = parse_header(file, path, header);
+    if(x0 < 0 || y0 < 0 || x1 > (int) header.width || y1 > (int) header.height){
+        throw(std::range_error("The value inputted for x and y in function: Snapshot::load_region(path,x0,y0,x1,y1) is out of bounds."));
+    } else if(x0 > x1 || y0 > y1){
+        throw(std::range_error("The region in function: Snapshot::load_region(path,x0,y0,x1,y1) has a negative size."));
+    }
+
+    if(x0 == x1 || y0 == y1){
+        return Grid(x1 - x0, y1 - y0);
+    }
+
+    // Decode the whole tiles covering the region, then trim them to the region.
+    Tiling tiling(header.width, header.height, header.tile_size);
+    unsigned int tx0 = (unsigned int) x0 / header.tile_size, ty0 = (unsigned int) y0 / header.tile_size;
+    unsigned int tx1 = ((unsigned int) x1 + header.tile_size - 1) / header.tile_size;
+    unsigned int ty1 = ((unsigned int) y1 + header.tile_size - 1) / header.tile_size;
+    unsigned int left = tx0 * header.tile_size, top = ty0 * header.tile_size;
+    Grid tiles(std::min(header.width, tx1 * header.tile_size) - left,
+               std::min(header.height, ty1 * header.tile_size) - top);
+    decode_tiles(file, path, header, index, tx0, ty0, tx1, ty1, tiles, threads);
+    return tiles.crop(x0 - (int) left, y0 - (int) top, x1 - (int) left, y1 - (int) top);
+}
+
+#if GOL_WITH_MPI
+namespace {
+    /**
+     * write_at(file, offset, bytes, size)
+     *
+     * Write bytes to a file opened with MPI-IO, in pieces small enough for the int counts of MPI.
+     *
+     * @return
+     *      False if any piece could not be written.
+     */
+    bool write_at(MPI_File file, std::uint64_t offset, const unsigned char* bytes, std::size_t size){
+        const std::size_t PIECE = (std::size_t) 1 << 30;
+        for(std::size_t done = 0; done < size; done += PIECE){
+            int count = (int) std::min(PIECE, size - done);
+            if(MPI_File_write_at(file, (MPI_Offset) (offset + done), bytes + done, count, MPI_BYTE,
+                                 MPI_STATUS_IGNORE) != MPI_SUCCESS){
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+/**
+ * Snapshot::save(comm, path, block, x0, y0, width, height, generation, rule, threads, tile_size)
+ *
+ * Collectively save a grid split into blocks across the ranks of an MPI communicator as a single snapshot file,
+ * identical to the file Snapshot::save would write for the whole grid. Every rank must call it at once.
+ *      - Each rank compresses the tiles of its own block, and an exclusive scan of the compressed sizes gives
+ *        every rank the offset of its data, so the tile index and data are written by each rank in parallel.
+ *      - The blocks must not overlap, must together cover the grid, and must start and end on tile boundaries
+ *        or the edges of the grid, so that every tile lies within the block of a single rank.
+ *
+ * @example
+ *
+ *      // Save a world split into row bands of 256 cells across the ranks
+ *      Snapshot::save(MPI_COMM_WORLD, "path/to/file.gsnap", band, 0, rank * 256, width, height);
+ *
+ * @param comm
+ *      The communicator of the ranks holding the blocks of the grid.
+ *
+ * @param path
+ *      The std::string path to the file to write to.
+ *
+ * @param block
+ *      The cells of the grid held by this rank.
+ *
+ * @param x0
+ *      The column of the grid at the left of the block.
+ *
+ * @param y0
+ *      The row of the grid at the top of the block.
+ *
+ * @param width
+ *      The width of the whole grid.
+ *
+ * @param height
+ *      The height of the whole grid.
+ *
+ * @throws
+ *      std::invalid_argument if the tile size is not a positive multiple of 64, or the block does not cover whole
+ *      tiles of the grid.
+ *      Throws std::runtime_error or sub-class on every rank if the file cannot be opened or written on any rank.
+ */
+void Snapshot::save(MPI_Comm comm, const std::string& path, const Grid& block, unsigned int x0, unsigned int y0,
+                    unsigned int width, unsigned int height, std::uint64_t generation, const std::string& rule,
+                    unsigned int threads, unsigned int tile_size){
+    if(tile_size == 0 || tile_size % 64 != 0){
+        throw(std::invalid_argument("Snapshot::save error: the tile size must be a positive multiple of 64."));
+    }
+    std::uint64_t x1 = (std::uint64_t) x0 + block.get_width(), y1 = (std::uint64_t) y0 + block.get_height();
+    if(x1 > width || y1 > height || x0 % tile_size != 0 || y0 % tile_size != 0 ||
+       (x1 != width && x1 % tile_size != 0) || (y1 != height && y1 % tile_size != 0)){
+        throw(std::invalid_argument("Snapshot::save error: the block of each rank must cover whole tiles of the grid."));
+    }
+    Tiling tiling(width, height, tile_size);
+    Tiling local(block.get_width(), block.get_height(), tile_size);
+    ThreadPool pool(get_thread_count(threads));
+
+    std::vector<std::vector<unsigned char>> tiles(local.get_count());
+    pool.run(local.rows, [&](unsigned int ty){
+        for(unsigned int tx = 0; tx < local.columns; tx++){
+            encode_tile(block, local, tx, ty, tiles[(std::size_t) ty * local.columns + tx]);
+        }
+    });
+
+    // The data of the ranks follows the index in rank order.
+    std::uint64_t local_bytes = 0;
+    for(const std::vector<unsigned char>& tile : tiles){
+        local_bytes += tile.size();
+    }
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    std::uint64_t before = 0;
+    std::uint64_t total = 0;
+    MPI_Exscan(&local_bytes, &before, 1, MPI_UINT64_T, MPI_SUM, comm);
+    MPI_Allreduce(&local_bytes, &total, 1, MPI_UINT64_T, MPI_SUM, comm);
+    if(rank == 0){
+        before = 0;
+    }
+
+    std::size_t index_start = FIXED_HEADER_BYTES + rule.size();
+    std::uint64_t data_start = index_start + (std::uint64_t) tiling.get_count() * INDEX_ENTRY_BYTES;
+    MPI_File file;
+    if(MPI_File_open(comm, path.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS){
+        throw(std::runtime_error("The path given to function: Snapshot::save is incorrect."));
+    }
+    bool written = MPI_File_set_size(file, (MPI_Offset) (data_start + total)) == MPI_SUCCESS;
+
+    if(rank == 0){
+        std::vector<unsigned char> header(index_start);
+        std::memcpy(header.data(), MAGIC, sizeof MAGIC);
+        write_u32(header.data() + 8, VERSION);
+        write_u32(header.data() + 12, width);
+        write_u32(header.data() + 16, height);
+        write_u32(header.data() + 20, tile_size);
+        write_u64(header.data() + 24, generation);
+        write_u32(header.data() + 32, (std::uint32_t) rule.size());
+        std::memcpy(header.data() + FIXED_HEADER_BYTES, rule.data(), rule.size());
+        written = write_at(file, 0, header.data(), header.size()) && written;
+    }
+
+    // The index entries of a row of tiles in the block are next to each other in the file.
+    std::uint64_t offset = data_start + before;
+    std::vector<unsigned char> entries((std::size_t) local.columns * INDEX_ENTRY_BYTES);
+    std::vector<unsigned char> data;
+    data.reserve((std::size_t) local_bytes);
+    for(unsigned int ty = 0; ty < local.rows; ty++){
+        for(unsigned int tx = 0; tx < local.columns; tx++){
+            const std::vector<unsigned char>& tile = tiles[(std::size_t) ty * local.columns + tx];
+            write_u64(entries.data() + (std::size_t) tx * INDEX_ENTRY_BYTES, tile.empty() ? 0 : offset);
+            write_u64(entries.data() + (std::size_t) tx * INDEX_ENTRY_BYTES + 8, tile.size());
+            offset += tile.size();
+            data.insert(data.end(), tile.begin(), tile.end());
+        }
+        std::size_t first = (std::size_t) (y0 / tile_size + ty) * tiling.columns + x0 / tile_size;
+        written = write_at(file, index_start + first * INDEX_ENTRY_BYTES, entries.data(), entries.size()) && written;
+    }
+    written = write_at(file, data_start + before, data.data(), data.size()) && written;
+    MPI_File_close(&file);
+
+    // Every rank throws if any rank failed, so no rank is left waiting in a later collective call.
+    int failed = written ? 0 : 1;
+    int any_failed = 0;
+    MPI_Allreduce(&failed, &any_failed, 1, MPI_INT, MPI_MAX, comm);
+    if(any_failed){
+        throw(std::runtime_error("The file: '" + path + "' cannot be written."));
+    }
+}
+#endif
@@ -0,0 +1,51 @@
+/**
+ * Declares a Snapshot namespace with methods for saving and loading grids in a tiled, compressed file format.
+ * Rich documentation for the api and behaviour the Snapshot namespace can be found in snapshot.cpp.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "grid.h"
+
+#if GOL_WITH_MPI
+#include <mpi.h>
+#endif
+
+/**
+ * Declare the interface of the Snapshot namespace for checkpointing large, mostly empty worlds.
+ */
+namespace Snapshot {
+    /**
+     * The edge size of a tile used when none is given, in cells.
+     */
+    const unsigned int DEFAULT_TILE_SIZE = 256;
+
+    /**
+     * The information stored at the start of a snapshot file, before the tile index.
+     */
+    struct Header {
+        unsigned int version;
+        unsigned int width;
+        unsigned int height;
+        unsigned int tile_size;
+        std::uint64_t generation;
+        std::string rule;
+    };
+
+    void save(const std::string& path, const Grid& grid, std::uint64_t generation = 0,
+              const std::string& rule = "B3/S23", unsigned int threads = 1,
+              unsigned int tile_size = DEFAULT_TILE_SIZE);
+    Header load_header(const std::string& path);
+    Grid load(const std::string& path, unsigned int threads = 1);
+    Grid load_region(const std::string& path, int x0, int y0, int x1, int y1, unsigned int threads = 1);
+#if GOL_WITH_MPI
+    void save(MPI_Comm comm, const std::string& path, const Grid& block, unsigned int x0, unsigned int y0,
+              unsigned int width, unsigned int height, std::uint64_t generation = 0,
+              const std::string& rule = "B3/S23", unsigned int threads = 1,
+              unsigned int tile_size = DEFAULT_TILE_SIZE);
+#endif
+};
@@ -0,0 +1,502 @@
+/**
+ * Implements a class representing an unbounded, sparsely stored world for simulating a cellular automaton.
+ *      - SparseWorlds can be constructed empty or from an existing Grid with an initial state for the world.
+ *      - SparseWorlds can return the number of alive cells and the bounding box containing them.
+ *      - SparseWorlds can return any window of their state as a Grid.
+ *
+ *      - The plane is split into chunks of 64x64 cells, and only chunks containing an alive cell are stored.
+ *          - Chunks are kept in a hash table keyed by the chunk coordinate, so the world grows on demand in any
+ *            direction, including negative coordinates, and memory is proportional to the live population.
+ *          - Each row of a chunk is a single packed word, laid out like a row of a Grid.
+ *
+ *      - Stepping a world forward in time applies the rules of Conway's Game of Life, as World does.
+ *          - Any other Life-like Rule can be chosen, except rules with birth on 0 neighbours, which would fill
+ *            the whole plane in a single step.
+ *          - Only stored chunks, and the chunks next to an alive cell on their border, are recomputed.
+ *          - Chunks are stepped by the same Kernel as World, with the neighbouring words read from the chunks
+ *            around them.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include "sparse_world.h"
+
+namespace {
+    // Chunk coordinates are packed into two 32-bit halves of a key, which limits cells to this distance from 0.
+    const long long MAX_COORDINATE = (1LL << 37) - 1;
+
+    bool is_empty(const std::array<std::uint64_t, 64>& chunk){
+        for(std::uint64_t word : chunk){
+            if(word != 0){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    unsigned int count_bits(std::uint64_t word){
+        return (unsigned int) __builtin_popcountll(word);
+    }
+}
+
+/**
+ * SparseWorld::SparseWorld()
+ *
+ * Construct an empty world, with no alive cells.
+ *
+ * @example
+ *
+ *      // Make an empty unbounded world
+ *      SparseWorld world;
+ *
+ */
+SparseWorld::SparseWorld(): population(0){
+}
+
+/**
+ * SparseWorld::SparseWorld(initial_state)
+ *
+ * Construct a world containing the alive cells of a grid, placed with the top left of the grid at (0, 0).
+ * Everything outside the grid starts dead.
+ *
+ * @example
+ *
+ *      // Make a world from a glider, which can fly forever without reaching an edge
+ *      SparseWorld world(Zoo::glider());
+ *
+ *      // This should be a compiler error! We want to prevent this from being allowed.
+ *      SparseWorld bad_world = Zoo::glider();
+ *
+ * @param initial_state
+ *      The grid of cells to start from.
+ */
+SparseWorld::SparseWorld(const Grid& initial_state): population(0){
+    // Chunks are aligned to multiples of 64 cells like the words of a grid, so words are copied as they are.
+    for(unsigned int y = 0; y < initial_state.get_height(); y++){
+        const std::uint64_t* row = initial_state.get_row(y);
+        for(unsigned int k = 0; k < initial_state.get_row_words(); k++){
+            if(row[k] != 0){
+                chunks[get_key(k, y / 64)][y % 64] = row[k];
+                population += count_bits(row[k]);
+            }
+        }
+    }
+}
+
+/**
+ * SparseWorld::get_key(chunk_x, chunk_y)
+ *
+ * Private helper function to pack the coordinate of a chunk into a hash table key.
+ */
+std::uint64_t SparseWorld::get_key(long long chunk_x, long long chunk_y){
+    return ((std::uint64_t) (std::uint32_t) chunk_x << 32) | (std::uint32_t) chunk_y;
+}
+
+/**
+ * SparseWorld::get_chunk_x(key)
+ *
+ * Private helper function to unpack the x coordinate of a chunk from its key.
+ */
+long long SparseWorld::get_chunk_x(std::uint64_t key){
+    return (std::int32_t) (key >> 32);
+}
+
+/**
+ * SparseWorld::get_chunk_y(key)
+ *
+ * Private helper function to unpack the y coordinate of a chunk from its key.
+ */
+long long SparseWorld::get_chunk_y(std::uint64_t key){
+    return (std::int32_t) (key & 0xFFFFFFFF);
+}
+
+/**
+ * SparseWorld::find_chunk(chunk_x, chunk_y)
+ *
+ * Private helper function to look up a stored chunk.
+ *
+ * @return
+ *      A pointer to the chunk, or nullptr if the chunk has no alive cells.
+ */
+const SparseWorld::Chunk* SparseWorld::find_chunk(long long chunk_x, long long chunk_y) const{
+    auto found = chunks.find(get_key(chunk_x, chunk_y));
+    return (found == chunks.end()) ? nullptr : &found->second;
+}
+
+/**
+ * SparseWorld::get_alive_cells()
+ *
+ * Counts how many cells in the world are alive. The count is kept as the world changes, so this is O(1).
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The number of alive cells.
+ */
+std::uint64_t SparseWorld::get_alive_cells() const{
+    return population;
+}
+
+/**
+ * SparseWorld::get_chunk_count()
+ *
+ * Gets the number of 64x64 chunks stored, for monitoring memory use.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The number of chunks containing at least one alive cell.
+ */
+std::size_t SparseWorld::get_chunk_count() const{
+    return chunks.size();
+}
+
+/**
+ * SparseWorld::get(x, y)
+ *
+ * Returns the value of the cell at the desired coordinate.
+ * The function should be callable from a constant context.
+ *
+ * @param x
+ *      The x coordinate of the cell, which may be negative.
+ *
+ * @param y
+ *      The y coordinate of the cell, which may be negative.
+ *
+ * @return
+ *      The value of the cell at the desired coordinate.
+ */
+Cell SparseWorld::get(long long x, long long y) const{
+    // Arithmetic shifts round towards negative infinity, so negative cells fall into the chunk to their left.
+    const Chunk* chunk = find_chunk(x >> 6, y >> 6);
+    if(chunk && (((*chunk)[y & 63] >> (x & 63)) & 1)){
+        return ALIVE;
+    }
+    return DEAD;
+}
+
+/**
+ * SparseWorld::set(x, y, value)
+ *
+ * Overwrites the value at the desired coordinate, creating or removing chunks as needed.
+ *
+ * @param x
+ *      The x coordinate of the cell, which may be negative.
+ *
+ * @param y
+ *      The y coordinate of the cell, which may be negative.
+ *
+ * @param value
+ *      The value to be written to the cell.
+ *
+ * @throws
+ *      std::out_of_range if the coordinate is further than 2^37 - 1 cells from 0 on either axis.
+ */
+void SparseWorld::set(long long x, long long y, Cell value){
+    if(x < -MAX_COORDINATE || x > MAX_COORDINATE){
+        throw(std::out_of_range("The value inputted for x in function: SparseWorld::set(x,y,value) is out of bounds."));
+    } else if(y < -MAX_COORDINATE || y > MAX_COORDINATE){
+        throw(std::out_of_range("The value inputted for y in function: SparseWorld::set(x,y,value) is out of bounds."));
+    }
+    std::uint64_t key = get_key(x >> 6, y >> 6);
+    std::uint64_t mask = (std::uint64_t)1 << (x & 63);
+    auto found = chunks.find(key);
+    if(value == ALIVE){
+        std::uint64_t& word = (found == chunks.end()) ? chunks[key][y & 63] : found->second[y & 63];
+        population += (word & mask) ? 0 : 1;
+        word |= mask;
+    } else if(found != chunks.end()){
+        std::uint64_t& word = found->second[y & 63];
+        population -= (word & mask) ? 1 : 0;
+        word &= ~mask;
+        if(is_empty(found->second)){
+            chunks.erase(found);
+        }
+    }
+}
+
+/**
+ * SparseWorld::get_bounds(x0, y0, x1, y1)
+ *
+ * Find the smallest box containing every alive cell, spanning the range [x0, x1) by [y0, y1).
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      False, leaving the coordinates untouched, if there are no alive cells.
+ */
+bool SparseWorld::get_bounds(long long& x0, long long& y0, long long& x1, long long& y1) const{
+    if(chunks.empty()){
+        return false;
+    }
+    long long min_x = MAX_COORDINATE + 1, min_y = MAX_COORDINATE + 1;
+    long long max_x = -MAX_COORDINATE - 1, max_y = -MAX_COORDINATE - 1;
+    for(const auto& entry : chunks){
+        long long left = get_chunk_x(entry.first) * 64;
+        long long top = get_chunk_y(entry.first) * 64;
+        for(int r = 0; r < 64; r++){
+            std::uint64_t word = entry.second[r];
+            if(word != 0){
+                min_x = std::min(min_x, left + __builtin_ctzll(word));
+                max_x = std::max(max_x, left + 63 - __builtin_clzll(word));
+                min_y = std::min(min_y, top + r);
+                max_y = std::max(max_y, top + r);
+            }
+        }
+    }
+    x0 = min_x;
+    y0 = min_y;
+    x1 = max_x + 1;
+    y1 = max_y + 1;
+    return true;
+}
+
+/**
+ * SparseWorld::get_alive_cells(x0, y0, x1, y1)
+ *
+ * Counts how many cells are alive in the window spanning [x0, x1) by [y0, y1), without copying it.
+ * Only the stored chunks are visited, and the rows of each are masked to the window and counted a word at a time.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The number of alive cells in the window.
+ *
+ * @throws
+ *      std::range_error if the window has a negative size.
+ */
+std::uint64_t SparseWorld::get_alive_cells(long long x0, long long y0, long long x1, long long y1) const{
+    if(x1 < x0 || y1 < y0){
+        throw(std::range_error("The window in function: SparseWorld::get_alive_cells(x0,y0,x1,y1) has a negative size."));
+    }
+    std::uint64_t count = 0;
+    for(const auto& entry : chunks){
+        long long left = get_chunk_x(entry.first) * 64;
+        long long top = get_chunk_y(entry.first) * 64;
+        if(left >= x1 || left + 64 <= x0 || top >= y1 || top + 64 <= y0){
+            continue;
+        }
+        std::uint64_t mask = ~(std::uint64_t)0;
+        if(x0 > left){
+            mask &= ~(std::uint64_t)0 << (x0 - left);
+        }
+        if(x1 < left + 64){
+            mask &= ~(~(std::uint64_t)0 << (x1 - left));
+        }
+        for(long long y = std::max(top, y0); y < std::min(top + 64, y1); y++){
+            count += (std::uint64_t) __builtin_popcountll(entry.second[y - top] & mask);
+        }
+    }
+    return count;
+}
+
+/**
+ * SparseWorld::crop(x0, y0, x1, y1)
+ *
+ * Extract any window of the world as a Grid, which like Grid::crop spans the range [x0, x1) by [y0, y1).
+ * Unlike Grid::crop the window may lie anywhere on the plane, cells outside the stored chunks are dead.
+ * The function should be callable from a constant context.
+ *
+ * @example
+ *
+ *      // Look at the 100x100 cells around the origin
+ *      Grid window = world.crop(-50, -50, 50, 50);
+ *
+ * @param x0
+ *      Left coordinate of the crop window on x-axis.
+ *
+ * @param y0
+ *      Top coordinate of the crop window on y-axis.
+ *
+ * @param x1
+ *      Right coordinate of the crop window on x-axis (1 greater than the largest index).
+ *
+ * @param y1
+ *      Bottom coordinate of the crop window on y-axis (1 greater than the largest index).
+ *
+ * @return
+ *      A new grid of the cropped size containing the cells of the world.
+ *
+ * @throws
+ *      std::range_error if the crop window has a negative size or is too large for a Grid.
+ */
+Grid SparseWorld::crop(long long x0, long long y0, long long x1, long long y1) const{
+    if(x1 < x0 || y1 < y0){
+        throw(std::range_error("The crop window in function: SparseWorld::crop(x0,y0,x1,y1) has a negative size."));
+    } else if(x1 - x0 > 0x7FFFFFFF || y1 - y0 > 0x7FFFFFFF){
+        throw(std::range_error("The crop window in function: SparseWorld::crop(x0,y0,x1,y1) is too large for a Grid."));
+    }
+    Grid grid((unsigned int) (x1 - x0), (unsigned int) (y1 - y0));
+    for(const auto& entry : chunks){
+        long long left = get_chunk_x(entry.first) * 64;
+        long long top = get_chunk_y(entry.first) * 64;
+        if(left >= x1 || left + 64 <= x0 || top >= y1 || top + 64 <= y0){
+            continue;
+        }
+        for(long long y = std::max(top, y0); y < std::min(top + 64, y1); y++){
+            std::uint64_t word = entry.second[y - top];
+            std::uint64_t* row = grid.get_row((unsigned int) (y - y0));
+            while(word != 0){
+                long long x = left + __builtin_ctzll(word);
+                word &= word - 1;
+                if(x >= x0 && x < x1){
+                    row[(x - x0) / 64] |= (std::uint64_t)1 << ((x - x0) % 64);
+                }
+            }
+        }
+    }
+    return grid;
+}
+
+/**
+ * SparseWorld::get_state()
+ *
+ * Return the bounding box of the alive cells as a Grid, as found by SparseWorld::get_bounds.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      A grid just large enough to hold every alive cell, or a 0x0 grid if there are none.
+ */
+Grid SparseWorld::get_state() const{
+    long long x0, y0, x1, y1;
+    if(!get_bounds(x0, y0, x1, y1)){
+        return Grid();
+    }
+    return crop(x0, y0, x1, y1);
+}
+
+/**
+ * SparseWorld::get_rule()
+ *
+ * Gets the rule used to step the world, Conway's Game of Life "B3/S23" unless set_rule was called.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The rule of the world.
+ */
+const Rule& SparseWorld::get_rule() const{
+    return rule;
+}
+
+/**
+ * SparseWorld::set_rule(new_rule)
+ *
+ * Change the rule used by the following steps. The current state is kept.
+ *
+ * @param new_rule
+ *      The rule to step with.
+ *
+ * @throws
+ *      std::invalid_argument if the rule gives birth to cells with no alive neighbours.
+ */
+void SparseWorld::set_rule(const Rule& new_rule){
+    if(new_rule.get_birth() & 1){
+        throw(std::invalid_argument("SparseWorld::set_rule error: " + new_rule.get_name() +
+                                    " would fill the unbounded plane."));
+    }
+    rule = new_rule;
+}
+
+/**
+ * SparseWorld::step_chunk(key, out)
+ *
+ * Private helper function that computes the next state of one chunk from it and the eight chunks around it.
+ * The rows of the neighbourhood are laid out as 192 cell wide rows, of which the kernel updates the middle word.
+ *
+ * @return
+ *      True if the next state of the chunk has any alive cells.
+ */
+bool SparseWorld::step_chunk(std::uint64_t key, Chunk& out) const{
+    long long cx = get_chunk_x(key), cy = get_chunk_y(key);
+    std::uint64_t rows[66][3];
+    for(int i = 0; i < 3; i++){
+        const Chunk* above = find_chunk(cx + i - 1, cy - 1);
+        const Chunk* middle = find_chunk(cx + i - 1, cy);
+        const Chunk* below = find_chunk(cx + i - 1, cy + 1);
+        rows[0][i] = above ? (*above)[63] : 0;
+        for(int r = 0; r < 64; r++){
+            rows[r + 1][i] = middle ? (*middle)[r] : 0;
+        }
+        rows[65][i] = below ? (*below)[0] : 0;
+    }
+
+    std::uint64_t any = 0;
+    for(int r = 0; r < 64; r++){
+        std::uint64_t next[3];
+        Kernel::step_row_span(rows[r], rows[r + 1], rows[r + 2], next, 192, 1, 2, false, rule, kernel,
+                              nullptr);
+        out[r] = next[1];
+        any |= next[1];
+    }
+    return any != 0;
+}
+
+/**
+ * SparseWorld::step()
+ *
+ * Take one step in Conway's Game of Life, or in the rule given to set_rule, on the unbounded plane.
+ *
+ * Every stored chunk is recomputed, along with the chunks next to any alive cell on a stored chunk's border,
+ * since those are the only places a cell can be born. Chunks left with no alive cells are dropped.
+ *
+ * Rules: https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
+ *      - Any live cell with fewer than two live neighbours dies, as if by underpopulation.
+ *      - Any live cell with two or three live neighbours lives on to the next generation.
+ *      - Any live cell with more than three live neighbours dies, as if by overpopulation.
+ *      - Any dead cell with exactly three live neighbours becomes a live cell, as if by reproduction.
+ */
+void SparseWorld::step(){
+    std::vector<std::uint64_t> candidates;
+    candidates.reserve(chunks.size() * 2);
+    for(const auto& entry : chunks){
+        long long cx = get_chunk_x(entry.first), cy = get_chunk_y(entry.first);
+        const Chunk& chunk = entry.second;
+        std::uint64_t west = 0, east = 0;
+        for(std::uint64_t word : chunk){
+            west |= word & 1;
+            east |= word >> 63;
+        }
+        std::uint64_t top = chunk[0], bottom = chunk[63];
+
+        candidates.push_back(entry.first);
+        if(west) candidates.push_back(get_key(cx - 1, cy));
+        if(east) candidates.push_back(get_key(cx + 1, cy));
+        if(top) candidates.push_back(get_key(cx, cy - 1));
+        if(bottom) candidates.push_back(get_key(cx, cy + 1));
+        if(top & 1) candidates.push_back(get_key(cx - 1, cy - 1));
+        if(top >> 63) candidates.push_back(get_key(cx + 1, cy - 1));
+        if(bottom & 1) candidates.push_back(get_key(cx - 1, cy + 1));
+        if(bottom >> 63) candidates.push_back(get_key(cx + 1, cy + 1));
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    std::unordered_map<std::uint64_t, Chunk> next_chunks;
+    next_chunks.reserve(candidates.size());
+    std::uint64_t next_population = 0;
+    Chunk out;
+    for(std::uint64_t key : candidates){
+        if(step_chunk(key, out)){
+            for(std::uint64_t word : out){
+                next_population += count_bits(word);
+            }
+            next_chunks.emplace(key, out);
+        }
+    }
+    chunks.swap(next_chunks);
+    population = next_population;
+}
+
+/**
+ * SparseWorld::advance(steps)
+ *
+ * Advance multiple steps in the Game of Life.
+ * Implemented by invoking SparseWorld::step().
+ *
+ * @param steps
+ *      The number of steps to advance the world forward.
+ */
+void SparseWorld::advance(unsigned int steps){
+    for(unsigned int i = 0; i < steps; i++){
+        step();
+    }
+}
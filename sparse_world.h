@@ -0,0 +1,52 @@
+/**
+ * Declares a class representing an unbounded, sparsely stored world for simulating a cellular automaton.
+ * Rich documentation for the api and behaviour the SparseWorld class can be found in sparse_world.cpp.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include "grid.h"
+#include "kernel.h"
+#include "rule.h"
+
+/**
+ * Declare the structure of the SparseWorld class for representing huge, mostly empty universes.
+ *
+ * A SparseWorld only stores chunks of 64x64 cells containing at least one alive cell,
+ * in a hash table keyed by the coordinate of the chunk, so memory follows the population rather than the area.
+ */
+class SparseWorld {
+private:
+    typedef std::array<std::uint64_t, 64> Chunk;
+
+    std::unordered_map<std::uint64_t, Chunk> chunks;
+    std::uint64_t population;
+    Kernel::Isa kernel = Kernel::detect_isa();
+    Rule rule;
+
+    static std::uint64_t get_key(long long chunk_x, long long chunk_y);
+    static long long get_chunk_x(std::uint64_t key);
+    static long long get_chunk_y(std::uint64_t key);
+    const Chunk* find_chunk(long long chunk_x, long long chunk_y) const;
+    bool step_chunk(std::uint64_t key, Chunk& out) const;
+public:
+    SparseWorld();
+    explicit SparseWorld(const Grid& initial_state);
+    std::uint64_t get_alive_cells() const;
+    std::uint64_t get_alive_cells(long long x0, long long y0, long long x1, long long y1) const;
+    std::size_t get_chunk_count() const;
+    Cell get(long long x, long long y) const;
+    void set(long long x, long long y, Cell value);
+    bool get_bounds(long long& x0, long long& y0, long long& x1, long long& y1) const;
+    Grid crop(long long x0, long long y0, long long x1, long long y1) const;
+    Grid get_state() const;
+    const Rule& get_rule() const;
+    void set_rule(const Rule& new_rule);
+    void step();
+    void advance(unsigned int steps);
+};
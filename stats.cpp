@@ -0,0 +1,133 @@
+/**
+ * Implements the exporters for the counters and timers kept by World and the Zoo loaders.
+ *      - World keeps a Stats::WorldStats with the totals of its steps, split into phases:
+ *          - plan:   finding the tiles to recompute, and hashing the state when cycle detection starts.
+ *          - kernel: stepping the recomputed tiles, which fuses the neighbour counts, the rule, the population
+ *                    counts and the tile hashes into one pass over each row.
+ *          - record: handing the changed tiles to an attached Recorder.
+ *          - swap:   adding up the bands and swapping the buffers.
+ *          - cycle:  checking the state hash against the history for a repeating cycle.
+ *
+ *      - The Zoo loaders and savers add the size of each file and the time it took to a Stats::IoStats.
+ *
+ *      - Statistics can be exported as one JSON object on a line, for appending to a JSON lines log, or in the
+ *        Prometheus text exposition format.
+ *          - https://prometheus.io/docs/instrumenting/exposition_formats/
+ *
+ *      - Every counter is updated behind GOL_STATS, so building with -DGOL_WITH_STATS=0 leaves no trace of them in
+ *        World::step or the loaders.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#include <cstdio>
+#include "stats.h"
+
+namespace {
+    std::string format_number(double value){
+        char number[32];
+        std::snprintf(number, sizeof(number), "%.9g", value);
+        return number;
+    }
+
+    /**
+     * The name, help text and value of every exported statistic, in the order they are exported.
+     */
+    struct Field {
+        const char* name;
+        const char* help;
+        bool counter;
+        double value;
+    };
+
+    const unsigned int FIELD_COUNT = 19;
+
+    void get_fields(const Stats::WorldStats& world, const Stats::IoStats& io, std::uint64_t generation,
+                    Field fields[FIELD_COUNT]){
+        Field all[FIELD_COUNT] = {
+            {"generation", "The generation of the world.", false, (double) generation},
+            {"population", "The number of alive cells after the last step.", false, (double) world.population},
+            {"steps", "The number of steps taken.", true, (double) world.steps},
+            {"skipped_generations", "The generations skipped by advance over a detected cycle.", true,
+             (double) world.skipped_generations},
+            {"tiles_stepped", "The number of tiles recomputed.", true, (double) world.tiles_stepped},
+            {"cells_stepped", "The number of cells in the recomputed tiles.", true, (double) world.cells_stepped},
+            {"last_step_seconds", "The wall time of the last step.", false, world.last_step_seconds},
+            {"step_seconds", "The wall time of every step.", true, world.step_seconds},
+            {"plan_seconds", "The time spent finding the tiles to recompute.", true, world.plan_seconds},
+            {"kernel_seconds", "The time spent recomputing tiles.", true, world.kernel_seconds},
+            {"record_seconds", "The time spent recording changed tiles.", true, world.record_seconds},
+            {"swap_seconds", "The time spent swapping the buffers.", true, world.swap_seconds},
+            {"cycle_seconds", "The time spent checking for cycles.", true, world.cycle_seconds},
+            {"files_loaded", "The number of files loaded.", true, (double) io.files_loaded},
+            {"bytes_loaded", "The size of the files loaded.", true, (double) io.bytes_loaded},
+            {"load_seconds", "The time spent loading files.", true, io.load_seconds},
+            {"files_saved", "The number of files saved.", true, (double) io.files_saved},
+            {"bytes_saved", "The size of the files saved.", true, (double) io.bytes_saved},
+            {"save_seconds", "The time spent saving files.", true, io.save_seconds}
+        };
+        for(unsigned int i = 0; i < FIELD_COUNT; i++){
+            fields[i] = all[i];
+        }
+    }
+}
+
+/**
+ * Stats::get_seconds(start, end)
+ *
+ * Gets the time between two points of the statistics clock.
+ *
+ * @return
+ *      The seconds from start to end.
+ */
+double Stats::get_seconds(Clock::time_point start, Clock::time_point end){
+    return std::chrono::duration<double>(end - start).count();
+}
+
+/**
+ * Stats::format_json(world, io, generation)
+ *
+ * Format the statistics of a world and the file totals as a JSON object on a single line, ending in a newline.
+ *
+ * @example
+ *
+ *      // Append the statistics of a world to a JSON lines log
+ *      log << Stats::format_json(world.get_stats(), Zoo::get_io_stats(), world.get_generation());
+ *
+ * @return
+ *      The JSON line, such as {"generation": 10, "population": 5, ...}.
+ */
+std::string Stats::format_json(const WorldStats& world, const IoStats& io, std::uint64_t generation){
+    Field fields[FIELD_COUNT];
+    get_fields(world, io, generation, fields);
+    std::string line = "{";
+    for(unsigned int i = 0; i < FIELD_COUNT; i++){
+        line += (i ? ", \"" : "\"") + std::string(fields[i].name) + "\": " + format_number(fields[i].value);
+    }
+    return line + "}\n";
+}
+
+/**
+ * Stats::format_prometheus(world, io, generation)
+ *
+ * Format the statistics of a world and the file totals in the Prometheus text exposition format, with each
+ * metric named game_of_life_(name) and preceded by its help and type.
+ *
+ * @return
+ *      The metrics, one per line.
+ */
+std::string Stats::format_prometheus(const WorldStats& world, const IoStats& io, std::uint64_t generation){
+    Field fields[FIELD_COUNT];
+    get_fields(world, io, generation, fields);
+    std::string text;
+    for(unsigned int i = 0; i < FIELD_COUNT; i++){
+        std::string name = "game_of_life_" + std::string(fields[i].name);
+        if(fields[i].counter){
+            name += "_total";
+        }
+        text += "# HELP " + name + " " + fields[i].help + "\n";
+        text += "# TYPE " + name + (fields[i].counter ? " counter\n" : " gauge\n");
+        text += name + " " + format_number(fields[i].value) + "\n";
+    }
+    return text;
+}
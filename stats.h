@@ -0,0 +1,69 @@
+/**
+ * Declares the counters and timers kept by World and the Zoo loaders, and the formats they can be exported in.
+ * Rich documentation for the api and behaviour of the Stats namespace can be found in stats.cpp.
+ *
+ * Build with -DGOL_WITH_STATS=0 to remove every counter and timer from the hot paths. The structs and exporters
+ * remain, so code reading them still compiles, and every value stays zero.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#ifndef GOL_WITH_STATS
+#define GOL_WITH_STATS 1
+#endif
+
+// Keep a statement only when statistics are built in.
+#if GOL_WITH_STATS
+#define GOL_STATS(...) __VA_ARGS__
+#else
+#define GOL_STATS(...)
+#endif
+
+/**
+ * Declare the interface of the Stats namespace for reading where the time of a run goes.
+ */
+namespace Stats {
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * The totals of every step of a World since it was constructed or its statistics were reset.
+     *      - The seconds of each phase are wall time, so with several threads the kernel time is the time of the
+     *        slowest band. Neighbour counting and the rule are one fused pass of the Kernel, timed together.
+     */
+    struct WorldStats {
+        std::uint64_t steps = 0;
+        std::uint64_t skipped_generations = 0;
+        std::uint64_t tiles_stepped = 0;
+        std::uint64_t cells_stepped = 0;
+        std::uint64_t population = 0;
+        double last_step_seconds = 0.0;
+        double step_seconds = 0.0;
+        double plan_seconds = 0.0;
+        double kernel_seconds = 0.0;
+        double record_seconds = 0.0;
+        double swap_seconds = 0.0;
+        double cycle_seconds = 0.0;
+    };
+
+    /**
+     * The totals of the files loaded and saved by the Zoo namespace, across every thread.
+     */
+    struct IoStats {
+        std::uint64_t files_loaded = 0;
+        std::uint64_t bytes_loaded = 0;
+        double load_seconds = 0.0;
+        std::uint64_t files_saved = 0;
+        std::uint64_t bytes_saved = 0;
+        double save_seconds = 0.0;
+    };
+
+    double get_seconds(Clock::time_point start, Clock::time_point end);
+    std::string format_json(const WorldStats& world, const IoStats& io, std::uint64_t generation);
+    std::string format_prometheus(const WorldStats& world, const IoStats& io, std::uint64_t generation);
+}
@@ -0,0 +1,102 @@
+/**
+ * Checks that Snapshot::save throws, rather than crashing or returning normally, when its target cannot hold
+ * the file.
+ *
+ * Build from the root of the repository with the library sources, for example:
+ *      g++ -std=c++17 -O2 -I. tests/snapshot_save_test.cpp checkpointer.cpp control_channel.cpp frame_writer.cpp
+ *          grid.cpp grid_pool.cpp hashlife.cpp kernel.cpp mapped_file.cpp recorder.cpp rule.cpp snapshot.cpp
+ *          sparse_world.cpp stats.cpp thread_pool.cpp world.cpp world_batch.cpp zoo.cpp -pthread -o snapshot_save_test
+ *
+ * Each case prints PASS or FAIL, and the program returns the number of failures.
+ *      - A target in a directory that does not exist.
+ *      - /dev/full on Linux, which can never be sized.
+ *      - A file larger than the size limit of the process, set with setrlimit.
+ *      - If GOL_FULL_DIR names a directory on a small filesystem, such as a 1 MB tmpfs, a save too large for it.
+ *        Without the space being reserved first this case dies with SIGBUS instead.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include "grid.h"
+#include "snapshot.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <csignal>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    int failures = 0;
+
+    /**
+     * make_noise(side)
+     *
+     * Fill a grid with random cells, which compresses poorly, so its snapshot is about as large as the grid.
+     */
+    Grid make_noise(unsigned int side){
+        Grid grid(side, side);
+        std::mt19937_64 random(side);
+        for(unsigned int y = 0; y < side; y++){
+            std::uint64_t* row = grid.get_row(y);
+            for(unsigned int k = 0; k < grid.get_row_words(); k++){
+                row[k] = random();
+            }
+        }
+        return grid;
+    }
+
+    /**
+     * expect_throw(name, path, grid)
+     *
+     * Save a grid to a path that cannot hold it, and count a failure unless Snapshot::save throws.
+     */
+    void expect_throw(const std::string& name, const std::string& path, const Grid& grid){
+        try{
+            Snapshot::save(path, grid);
+        }
+        catch(const std::runtime_error& ex){
+            std::cout << "PASS " << name << ": " << ex.what() << std::endl;
+            return;
+        }
+        std::cout << "FAIL " << name << ": Snapshot::save returned normally." << std::endl;
+        failures++;
+    }
+}
+
+int main(){
+    Grid grid = make_noise(4096);
+
+    expect_throw("missing directory", "missing_directory/file.gsnap", grid);
+
+#if defined(__linux__)
+    expect_throw("/dev/full", "/dev/full", grid);
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+    // Going over the limit raises SIGXFSZ, which would end the test, so it is ignored to leave only the error.
+    std::signal(SIGXFSZ, SIG_IGN);
+    rlimit previous;
+    getrlimit(RLIMIT_FSIZE, &previous);
+    rlimit limit = previous;
+    limit.rlim_cur = 1 << 20;
+    setrlimit(RLIMIT_FSIZE, &limit);
+    std::string limited = "snapshot_save_test." + std::to_string((long long) getpid()) + ".gsnap";
+    expect_throw("file size limit", limited, grid);
+    setrlimit(RLIMIT_FSIZE, &previous);
+    std::remove(limited.c_str());
+#endif
+
+    if(const char* full_directory = std::getenv("GOL_FULL_DIR")){
+        expect_throw("full filesystem", std::string(full_directory) + "/file.gsnap", grid);
+    }
+
+    return failures;
+}
@@ -0,0 +1,142 @@
+/**
+ * Implements a class representing a persistent pool of worker threads.
+ *      - Threads are started once when the pool is constructed and joined when it is destroyed,
+ *        so running a batch of tasks does not pay for creating threads.
+ *      - A batch is a number of independent tasks identified by their index, which the workers
+ *        and the calling thread take from a shared counter until none are left.
+ *      - ThreadPool::run blocks until every task in the batch has finished.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#include "thread_pool.h"
+
+/**
+ * ThreadPool::ThreadPool(threads)
+ *
+ * Construct a pool that runs batches on the given number of threads, including the thread calling run.
+ * A pool of 0 or 1 threads starts no workers and runs every task on the calling thread.
+ *
+ * @example
+ *
+ *      // Make a pool that uses every core of the machine
+ *      ThreadPool pool(std::thread::hardware_concurrency());
+ *
+ * @param threads
+ *      The total number of threads to run tasks on.
+ */
+ThreadPool::ThreadPool(unsigned int threads): task(nullptr), task_count(0), next_task(0), busy_workers(0),
+                                              batch(0), stopping(false){
+    for(unsigned int i = 1; i < threads; i++){
+        workers.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+/**
+ * ThreadPool::~ThreadPool()
+ *
+ * Stop and join every worker thread.
+ */
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    start.notify_all();
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+}
+
+/**
+ * ThreadPool::get_threads()
+ *
+ * Gets the total number of threads batches are run on, including the calling thread.
+ *
+ * @return
+ *      The number of threads.
+ */
+unsigned int ThreadPool::get_threads() const{
+    return (unsigned int) workers.size() + 1;
+}
+
+/**
+ * ThreadPool::run(tasks, task)
+ *
+ * Run task(0) to task(tasks - 1) across the pool and wait for all of them to finish.
+ * Tasks may run in any order and on any thread, so they must not depend on each other.
+ * Only one batch runs at a time, concurrent callers wait their turn.
+ *
+ * @example
+ *
+ *      // Square every value in parallel
+ *      std::vector<int> values = {1, 2, 3, 4};
+ *      pool.run(values.size(), [&](unsigned int i){ values[i] *= values[i]; });
+ *
+ * @param tasks
+ *      The number of tasks in the batch.
+ *
+ * @param task
+ *      The function to call with the index of each task.
+ */
+void ThreadPool::run(unsigned int tasks, const std::function<void(unsigned int)>& task){
+    if(workers.empty() || tasks <= 1){
+        for(unsigned int i = 0; i < tasks; i++){
+            task(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> run_lock(run_mutex);
+    std::unique_lock<std::mutex> lock(mutex);
+    this->task = &task;
+    task_count = tasks;
+    next_task = 0;
+    busy_workers = 0;
+    batch++;
+    start.notify_all();
+
+    run_tasks(lock);
+    // Tasks may still be running on workers that took them before the counter ran out.
+    finished.wait(lock, [this]{ return busy_workers == 0; });
+    this->task = nullptr;
+}
+
+/**
+ * ThreadPool::run_tasks(lock)
+ *
+ * Private helper function that takes tasks from the current batch and runs them until none are left.
+ * The lock is released while each task runs.
+ */
+void ThreadPool::run_tasks(std::unique_lock<std::mutex>& lock){
+    while(next_task < task_count){
+        unsigned int index = next_task++;
+        lock.unlock();
+        (*task)(index);
+        lock.lock();
+    }
+}
+
+/**
+ * ThreadPool::work()
+ *
+ * Private helper function run by each worker thread, which waits for a new batch, helps to run it,
+ * and repeats until the pool is destroyed.
+ */
+void ThreadPool::work(){
+    unsigned long long seen_batch = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true){
+        start.wait(lock, [&]{ return stopping || batch != seen_batch; });
+        if(stopping){
+            return;
+        }
+        seen_batch = batch;
+        busy_workers++;
+        run_tasks(lock);
+        busy_workers--;
+        if(busy_workers == 0){
+            finished.notify_all();
+        }
+    }
+}
@@ -0,0 +1,42 @@
+/**
+ * Declares a class representing a persistent pool of worker threads.
+ * Rich documentation for the api and behaviour the ThreadPool class can be found in thread_pool.cpp.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Declare the structure of the ThreadPool class for running batches of independent tasks in parallel.
+ */
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex run_mutex;
+    std::mutex mutex;
+    std::condition_variable start;
+    std::condition_variable finished;
+    const std::function<void(unsigned int)>* task;
+    unsigned int task_count;
+    unsigned int next_task;
+    unsigned int busy_workers;
+    unsigned long long batch;
+    bool stopping;
+
+    void work();
+    void run_tasks(std::unique_lock<std::mutex>& lock);
+public:
+    explicit ThreadPool(unsigned int threads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    unsigned int get_threads() const;
+    void run(unsigned int tasks, const std::function<void(unsigned int)>& task);
+};
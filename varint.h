@@ -0,0 +1,51 @@
+/**
+ * Declares a Varint namespace with the variable length integers used by snapshots and recordings.
+ *      - Varints hold 7 bits per byte, least significant first, with the top bit set on every byte but the last.
+ *      - Both functions are defined in this header so they inline into the encoding and decoding loops.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Declare the interface of the Varint namespace for writing and reading unsigned integers 7 bits at a time.
+ */
+namespace Varint {
+    /**
+     * Varint::put(out, value)
+     *
+     * Append an unsigned integer to a buffer.
+     */
+    inline void put(std::vector<unsigned char>& out, std::uint64_t value){
+        while(value >= 0x80){
+            out.push_back((unsigned char) (value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((unsigned char) value);
+    }
+
+    /**
+     * Varint::get(bytes, end, value)
+     *
+     * Read an unsigned integer from the bytes before end, moving bytes past it.
+     * Returns false if the bytes end first or the integer does not fit in 64 bits.
+     */
+    inline bool get(const unsigned char*& bytes, const unsigned char* end, std::uint64_t& value){
+        value = 0;
+        for(int shift = 0; shift < 64; shift += 7){
+            if(bytes == end){
+                return false;
+            }
+            unsigned char byte = *bytes++;
+            value |= (std::uint64_t) (byte & 0x7F) << shift;
+            if(!(byte & 0x80)){
+                return true;
+            }
+        }
+        return false;
+    }
+};
@@ -3,16 +3,57 @@
  *      - Worlds can be constructed empty, from a size, or from an existing Grid with an initial state for the world.
  *      - Worlds can be resized.
  *      - Worlds can return counts of the alive and dead cells in the current Grid state.
- *      - Worlds can return their current Grid state.
+ *          - Each tile keeps a count of its alive cells, which is updated as its rows are written by a step,
+ *            so the total is kept up to date without rescanning the grid and reading it is O(1).
+ *      - Worlds can return a read-only reference to their current Grid state, without copying it.
+ *      - Worlds can answer queries about a window of their current state without copying the rest of it.
+ *          - A crop of the window, the alive cells in it, and the bounding box of every alive cell.
+ *          - The bounding box only reads tiles in the outermost rows and columns of tiles with alive cells,
+ *            so together with the count kept by each step, World::get_summary costs far less than a full pass.
+ *          - Tiles wholly inside a window are counted from the per tile counts, and empty tiles are skipped.
+ *          - The answer to each kind of query is kept until the next step, so repeating it costs nothing.
+ *      - Worlds count the generations they have been stepped through.
  *
  *      - A World holds two equally sized Grid objects for the current state and next state.
  *          - These buffers are swapped after each update step.
+ *          - With more than one thread, the rows of the current state are split into horizontal bands which are
+ *            stepped in parallel into the next state. Bands only read the current state and write disjoint rows
+ *            of the next state, so the result does not depend on the number of threads, including the
+ *            toroidal wrap between the first and last bands.
+ *
+ *      - The grid is divided into tiles of 32 rows by 512 columns, each with a flag recording whether the tile
+ *        changed in the last step.
+ *          - A tile can only change if it, or one of the eight tiles around it, changed in the last step.
+ *          - Only those tiles are recomputed, so the cost of a step scales with the activity in the world
+ *            rather than its area.
+ *          - Every tile that did not change holds the same cells in both buffers, so skipped tiles never need
+ *            to be copied into the next state.
  *
  *      - Stepping a world forward in time applies the rules of Conway's Game of Life.
  *          - https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
- *
- *      - Worlds have a private helper function used to count the number of alive cells in a 3x3 neighbours
- *        around a given cell.
+ *          - Any other Life-like Rule, such as HighLife "B36/S23", can be chosen instead.
+ *
+ *      - Stepping is done by the bit-parallel Kernel, which updates 64 cells of a row per word operation
+ *        rather than counting the alive cells in the 3x3 neighbourhood of each cell in turn.
+ *
+ *      - Worlds can detect when they settle into a still life or an oscillator, and skip the rest of the cycle.
+ *          - Each tile keeps a hash of its cells, rehashed only when a step changes the tile, and the hash of the
+ *            world is the XOR of the tile hashes, so it is kept up to date for the cost of the changed tiles.
+ *          - The hashes of the last few generations are kept in a table. When a hash repeats, the candidate
+ *            period is confirmed by comparing the cells one period later, so a hash collision is never mistaken
+ *            for a cycle.
+ *          - Once a cycle of period p is confirmed, advance skips every whole multiple of p generations and only
+ *            steps the remainder, giving exactly the state that stepping every generation would.
+ *
+ *      - Large worlds are advanced several generations per pass over memory, with temporal blocking.
+ *          - Each run of active tiles is copied with a halo into buffers small enough to stay in cache, and
+ *            stepped there for several generations before being written back, so memory is read and written
+ *            once per pass rather than once per generation.
+ *          - The halo is as many rows high as the generations of the pass, since that is as far as the wrong
+ *            cells past its edge can spread, so the tiles written back are exact.
+ *
+ *      - Worlds count the steps, tiles and cells they compute and the time each phase of a step takes, unless
+ *        built with GOL_WITH_STATS=0. The totals are read with get_stats and exported by the Stats namespace.
  *
  *      - Updating the world state can conditionally be performed using a toroidal topology.
  *          - Moving off the left edge you appear on the right edge and vice versa.
@@ -21,13 +62,71 @@
  * @author 957552
  * @date March, 2020
  */
+#include <algorithm>
+#include <functional>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include "grid.h"
+#include "kernel.h"
 #include "world.h"
 
 // Include the minimal number of headers needed to support your implementation.
 // #include ...
 
+namespace {
+    // Bands smaller than this many words cost more to hand to a thread than they take to step.
+    const unsigned int MIN_BAND_WORDS = 1024;
+
+    // Tiles are 32 rows of 8 words, i.e. 32x512 cells, large enough for the SIMD kernels to work on.
+    // The kernel records the changes of each tile column for free while stepping it.
+    const unsigned int TILE_ROWS = 32;
+    const unsigned int TILE_WORDS = Kernel::DIFFERENCE_WORDS;
+
+    // advance steps large worlds this many generations per pass over memory, in blocks of one row of tiles by
+    // up to BLOCK_TILES tiles with a halo of TEMPORAL_STEPS rows and one word. The halo must stay within one
+    // tile, see World::advance_blocked. A block of 32 tiles is 48 rows of 258 words, so both of its buffers fit
+    // in the L2 cache together.
+    const unsigned int TEMPORAL_STEPS = 8;
+    const unsigned int BLOCK_TILES = 32;
+
+    // Worlds whose two buffers fit in cache gain nothing from blocking, and are stepped a generation at a time.
+    const std::size_t MIN_BLOCKED_WORDS = (std::size_t) 1 << 18;
+
+    /**
+     * get_bits(row, width, x)
+     *
+     * Read the 64 cells of a row starting at column x, wrapping around past the last column.
+     */
+    std::uint64_t get_bits(const std::uint64_t* row, unsigned int width, unsigned int x){
+        unsigned int words = (width + 63) / 64;
+        std::uint64_t bits = 0;
+        unsigned int filled = 0;
+        while(filled < 64){
+            unsigned int count = std::min(64 - filled, width - x);
+            std::uint64_t piece = row[x / 64] >> (x % 64);
+            if(x % 64 != 0 && x / 64 + 1 < words){
+                piece |= row[x / 64 + 1] << (64 - x % 64);
+            }
+            if(count < 64){
+                piece &= ((std::uint64_t)1 << count) - 1;
+            }
+            bits |= piece << filled;
+            filled += count;
+            x = (x + count) % width;
+        }
+        return bits;
+    }
+
+    // The finaliser of SplitMix64, which spreads every input bit over the whole hash.
+    std::uint64_t mix(std::uint64_t hash){
+        hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+        return hash ^ (hash >> 31);
+    }
+}
+
 /**
  * World::World()
  *
@@ -110,6 +209,7 @@ World::World(unsigned int width, unsigned int height){
 World::World(const Grid& initial_state){
     current_state = initial_state;
     next_state = Grid(initial_state.get_width(), initial_state.get_height());
+    alive_cells = initial_state.get_alive_cells();
 }
 
 /**
@@ -196,7 +296,8 @@ unsigned int World::get_total_cells() const{
 /**
  * World::get_alive_cells()
  *
- * Counts how many cells in the world are alive.
+ * Gets how many cells in the world are alive.
+ * The count is kept up to date by World::step, so this does not rescan the grid.
  * The function should be callable from a constant context.
  *
  * @example
@@ -217,13 +318,13 @@ unsigned int World::get_total_cells() const{
  *      The number of alive cells.
  */
 unsigned int World::get_alive_cells() const{
-    return current_state.get_alive_cells();
+    return alive_cells;
 }
 
 /**
  * World::get_dead_cells()
  *
- * Counts how many cells in the world are dead.
+ * Gets how many cells in the world are dead, from the total and the count of alive cells.
  * The function should be callable from a constant context.
  *
  * @example
@@ -244,7 +345,7 @@ unsigned int World::get_alive_cells() const{
  *      The number of dead cells.
  */
 unsigned int World::get_dead_cells() const{
-    return current_state.get_dead_cells();
+    return get_total_cells() - alive_cells;
 }
 
 /**
@@ -271,10 +372,228 @@ unsigned int World::get_dead_cells() const{
  * @return
  *      A reference to the current state.
  */
-Grid World::get_state() const{
+const Grid& World::get_state() const{
     return current_state;
 }
 
+/**
+ * World::check_region(x0, y0, x1, y1, function)
+ *
+ * Private helper function that checks a window spans the range [x0, x1) by [y0, y1) inside the world.
+ *
+ * @throws
+ *      std::range_error naming the calling function if the window has a negative size or leaves the world.
+ */
+void World::check_region(int x0, int y0, int x1, int y1, const char* function) const{
+    if(x1 < x0 || y1 < y0){
+        throw(std::range_error(std::string(function) + " error: the window has a negative size."));
+    } else if(x0 < 0 || y0 < 0 || x1 > (int) get_width() || y1 > (int) get_height()){
+        throw(std::range_error(std::string(function) + " error: the window is outside the world."));
+    }
+}
+
+/**
+ * World::has_tile_counts()
+ *
+ * Private helper function to check whether the alive cells of every tile are known, which they are from the
+ * first step after the world was constructed or resized.
+ */
+bool World::has_tile_counts() const{
+    std::size_t tiles = (std::size_t) get_tile_columns() * get_tile_rows();
+    return changed_tiles.size() == tiles && tile_alive_cells.size() == tiles;
+}
+
+/**
+ * World::get_region(x0, y0, x1, y1)
+ *
+ * Gets a window of the current state, cropped straight from it without copying the rest of the world.
+ * The window is kept until the next step, so asking for the same window again does not crop it again.
+ * The function should be callable from a constant context, but not from several threads at once.
+ *
+ * @example
+ *
+ *      // Show the 512x512 window at the centre of a large world
+ *      const Grid& window = world.get_region(3840, 3840, 4352, 4352);
+ *      std::cout << window << std::endl;
+ *
+ * @return
+ *      A reference to the window spanning [x0, x1) by [y0, y1), valid until the next step or get_region.
+ *
+ * @throws
+ *      std::range_error if the window has a negative size or leaves the world.
+ */
+const Grid& World::get_region(int x0, int y0, int x1, int y1) const{
+    check_region(x0, y0, x1, y1, "World::get_region");
+    int window[4] = {x0, y0, x1, y1};
+    if(region_version != state_version || !std::equal(window, window + 4, region_window)){
+        region = current_state.crop(x0, y0, x1, y1);
+        std::copy(window, window + 4, region_window);
+        region_version = state_version;
+    }
+    return region;
+}
+
+/**
+ * World::get_region_alive_cells(x0, y0, x1, y1)
+ *
+ * Count the alive cells in a window of the current state without copying it.
+ * Tiles inside the window are added from the counts kept by each step, so only the rows of the tiles on the
+ * edges of the window are read. The count is kept until the next step.
+ * The function should be callable from a constant context, but not from several threads at once.
+ *
+ * @return
+ *      The number of alive cells in the window spanning [x0, x1) by [y0, y1).
+ *
+ * @throws
+ *      std::range_error if the window has a negative size or leaves the world.
+ */
+std::uint64_t World::get_region_alive_cells(int x0, int y0, int x1, int y1) const{
+    check_region(x0, y0, x1, y1, "World::get_region_alive_cells");
+    int window[4] = {x0, y0, x1, y1};
+    if(population_version == state_version && std::equal(window, window + 4, population_window)){
+        return region_population;
+    }
+
+    bool tile_counts = has_tile_counts();
+    unsigned int columns = get_tile_columns();
+    const int tile_width = (int) TILE_WORDS * 64;
+    std::uint64_t count = 0;
+    for(int ty = y0 / (int) TILE_ROWS; x0 < x1 && ty * (int) TILE_ROWS < y1; ty++){
+        int ty0 = std::max(y0, ty * (int) TILE_ROWS);
+        int ty1 = std::min(y1, (ty + 1) * (int) TILE_ROWS);
+        for(int tx = x0 / tile_width; tx * tile_width < x1; tx++){
+            int tx0 = std::max(x0, tx * tile_width);
+            int tx1 = std::min(x1, (tx + 1) * tile_width);
+            bool whole = ty0 == ty * (int) TILE_ROWS && ty1 == std::min((int) get_height(), (ty + 1) * (int) TILE_ROWS) &&
+                         tx0 == tx * tile_width && tx1 == std::min((int) get_width(), (tx + 1) * tile_width);
+            if(tile_counts && whole){
+                count += tile_alive_cells[(std::size_t) ty * columns + tx];
+                continue;
+            }
+            // A tile on the edge of the window is counted a word at a time, masked to the window.
+            unsigned int k0 = (unsigned int) tx0 / 64;
+            unsigned int k1 = (unsigned int) (tx1 - 1) / 64;
+            std::uint64_t first = ~(std::uint64_t)0 << (tx0 % 64);
+            std::uint64_t last = ~(std::uint64_t)0 >> (63 - (tx1 - 1) % 64);
+            for(int y = ty0; y < ty1; y++){
+                const std::uint64_t* row = current_state.get_row((unsigned int) y);
+                for(unsigned int k = k0; k <= k1; k++){
+                    std::uint64_t word = row[k];
+                    if(k == k0){
+                        word &= first;
+                    }
+                    if(k == k1){
+                        word &= last;
+                    }
+                    count += (std::uint64_t) __builtin_popcountll(word);
+                }
+            }
+        }
+    }
+
+    std::copy(window, window + 4, population_window);
+    region_population = count;
+    population_version = state_version;
+    return count;
+}
+
+/**
+ * World::get_bounds(x0, y0, x1, y1)
+ *
+ * Find the smallest box containing every alive cell of the current state, spanning the range [x0, x1) by
+ * [y0, y1), without copying the world. Tiles with no alive cells are skipped using the counts kept by each
+ * step. The box is kept until the next step.
+ * The function should be callable from a constant context, but not from several threads at once.
+ *
+ * @return
+ *      False, leaving the coordinates untouched, if there are no alive cells.
+ */
+bool World::get_bounds(int& x0, int& y0, int& x1, int& y1) const{
+    if(bounds_version != state_version){
+        int box[4] = {(int) get_width(), (int) get_height(), 0, 0};
+        if(!has_tile_counts()){
+            Grid::Summary summary = current_state.get_summary();
+            box[0] = (int) summary.x0;
+            box[1] = (int) summary.y0;
+            box[2] = (int) summary.x1;
+            box[3] = (int) summary.y1;
+        } else{
+            // Only the outermost rows and columns of tiles with alive cells can hold an edge of the box.
+            unsigned int columns = get_tile_columns();
+            unsigned int tiles_box[4] = {columns, get_tile_rows(), 0, 0};
+            for(unsigned int ty = 0; ty < get_tile_rows(); ty++){
+                for(unsigned int tx = 0; tx < columns; tx++){
+                    if(tile_alive_cells[(std::size_t) ty * columns + tx] != 0){
+                        tiles_box[0] = std::min(tiles_box[0], tx);
+                        tiles_box[1] = std::min(tiles_box[1], ty);
+                        tiles_box[2] = std::max(tiles_box[2], tx);
+                        tiles_box[3] = std::max(tiles_box[3], ty);
+                    }
+                }
+            }
+            unsigned int row_words = current_state.get_row_words();
+            for(unsigned int ty = tiles_box[1]; ty <= tiles_box[3] && tiles_box[0] < columns; ty++){
+                unsigned int y_end = std::min(get_height(), (ty + 1) * TILE_ROWS);
+                for(unsigned int tx = tiles_box[0]; tx <= tiles_box[2]; tx++){
+                    bool edge = tx == tiles_box[0] || tx == tiles_box[2] || ty == tiles_box[1] || ty == tiles_box[3];
+                    if(!edge || tile_alive_cells[(std::size_t) ty * columns + tx] == 0){
+                        continue;
+                    }
+                    unsigned int k_end = std::min(row_words, (tx + 1) * TILE_WORDS);
+                    for(unsigned int y = ty * TILE_ROWS; y < y_end; y++){
+                        const std::uint64_t* row = current_state.get_row(y);
+                        for(unsigned int k = tx * TILE_WORDS; k < k_end; k++){
+                            if(row[k] == 0){
+                                continue;
+                            }
+                            box[0] = std::min(box[0], (int) (k * 64 + __builtin_ctzll(row[k])));
+                            box[1] = std::min(box[1], (int) y);
+                            box[2] = std::max(box[2], (int) (k * 64 + 64 - __builtin_clzll(row[k])));
+                            box[3] = std::max(box[3], (int) y + 1);
+                        }
+                    }
+                }
+            }
+        }
+        has_bounds = box[2] > 0;
+        std::copy(box, box + 4, bounds);
+        bounds_version = state_version;
+    }
+    if(!has_bounds){
+        return false;
+    }
+    x0 = bounds[0];
+    y0 = bounds[1];
+    x1 = bounds[2];
+    y1 = bounds[3];
+    return true;
+}
+
+/**
+ * World::get_summary()
+ *
+ * Gets the counts of the current state and the smallest box holding every alive cell, as Grid::get_summary
+ * would, without another pass over the world. The alive cells are kept up to date by each step, and the box is
+ * found by World::get_bounds from the per tile counts the step leaves behind, so only the tiles on the edge of
+ * the alive region are read. The function should be callable from a constant context, but not from several
+ * threads at once.
+ *
+ * @example
+ *
+ *      // Save the final state of a large, mostly empty world cropped to its alive cells
+ *      Grid::Summary summary = world.get_summary();
+ *      Zoo::save_rle("path/to/file.rle", world.get_region(summary.x0, summary.y0, summary.x1, summary.y1));
+ *
+ * @return
+ *      The counts and the bounding box spanning [x0, x1) by [y0, y1), which is empty at (0, 0) if no cell is alive.
+ */
+Grid::Summary World::get_summary() const{
+    int box[4] = {0, 0, 0, 0};
+    get_bounds(box[0], box[1], box[2], box[3]);
+    return {get_alive_cells(), get_dead_cells(), (unsigned int) box[0], (unsigned int) box[1],
+            (unsigned int) box[2], (unsigned int) box[3]};
+}
+
 /**
  * World::resize(square_size)
  *
@@ -295,7 +614,7 @@ Grid World::get_state() const{
  *      The new edge size for both the width and height of the grid.
  */
 void World::resize(unsigned int square_size){
-    current_state.resize(square_size);
+    resize(square_size, square_size);
 }
 
 /**
@@ -322,74 +641,672 @@ void World::resize(unsigned int square_size){
  */
 void World::resize(unsigned int new_width, unsigned int new_height){
     current_state.resize(new_width, new_height);
+    state_version++;
+    // The first step after a resize recomputes every tile, so the next state only needs to be the right size.
+    next_state = Grid(new_width, new_height);
+    changed_tiles.clear();
+    alive_cells = current_state.get_alive_cells();
+    hashes_valid = false;
+    forget_history();
 }
 
 /**
- * World::count_neighbours(x, y, toroidal)
+ * World::get_kernel()
  *
- * Private helper function to count the number of alive neighbours of a cell.
- * The function should not be visible from outside the World class.
+ * Gets the instruction set of the kernel used to step the world.
+ * Worlds start with the widest kernel the CPU supports, picked by Kernel::detect_isa().
+ * The function should be callable from a constant context.
  *
- * Neighbours are considered within the 3x3 square centred around the cell at x,y in the current state grid.
- * Ignore the centre coordinate, a cell is not its own neighbour.
- * Attempt to keep the logic as simple, expressive, and readable as possible.
+ * @return
+ *      The instruction set of the selected kernel.
+ */
+Kernel::Isa World::get_kernel() const{
+    return kernel;
+}
+
+/**
+ * World::get_kernel_name()
  *
- * If toroidal = false then skip any neighbours that would be outside of the grid,
- * this assumes the grid is Cell::DEAD outside its bounds.
+ * Gets the name of the kernel used to step the world, for logging which one was chosen.
+ * The function should be callable from a constant context.
  *
- * If toroidal = true then correctly wrap out of bounds coordinates to the opposite side of the grid.
+ * @example
  *
- * This function is in World and not Grid because the 3x3 sized neighbourhood is specific to Conway's Game of Life,
- * while Grid is more generic to any 2D grid based cellular automaton.
+ *      // Make a world
+ *      World world(4, 4);
  *
- * @param x
- *      The x coordinate of the centre of the neighbourhood.
+ *      // Print the selected kernel to the console, e.g. "avx2"
+ *      std::cout << world.get_kernel_name() << std::endl;
  *
- * @param y
- *      The y coordinate of the centre of the neighbourhood.
+ * @return
+ *      The name of the selected kernel, as given by Kernel::get_isa_name().
+ */
+const char* World::get_kernel_name() const{
+    return Kernel::get_isa_name(kernel);
+}
+
+/**
+ * World::set_kernel(isa)
  *
- * @param toroidal
- *      If true then the step will consider the grid as a torus, where the left edge
- *      wraps to the right edge and the top to the bottom.
+ * Override the kernel used to step the world, e.g. to compare kernels against each other.
+ * Every kernel produces identical results.
+ *
+ * @example
+ *
+ *      // Make a world
+ *      World world(4, 4);
+ *
+ *      // Step with the portable 64-bit kernel
+ *      world.set_kernel(Kernel::SCALAR);
+ *
+ * @param isa
+ *      The instruction set of the kernel to use.
+ *
+ * @throws
+ *      std::invalid_argument if the kernel is not supported by this CPU or was not compiled into this binary.
+ */
+void World::set_kernel(Kernel::Isa isa){
+    if(!Kernel::is_supported(isa)){
+        throw(std::invalid_argument("World::set_kernel error: the " + std::string(Kernel::get_isa_name(isa)) +
+                                    " kernel is not supported on this machine."));
+    }
+    kernel = isa;
+}
+
+/**
+ * World::get_rule()
+ *
+ * Gets the rule used to step the world, Conway's Game of Life "B3/S23" unless set_rule was called.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The rule of the world.
+ */
+const Rule& World::get_rule() const{
+    return rule;
+}
+
+/**
+ * World::set_rule(new_rule)
+ *
+ * Change the rule used by the following steps. The current state is kept.
+ *
+ * @example
+ *
+ *      // Make a world
+ *      World world(64, 64);
+ *
+ *      // Step it as HighLife instead of Conway's Game of Life
+ *      world.set_rule(Rule("B36/S23"));
+ *
+ * @param new_rule
+ *      The rule to step with.
+ */
+void World::set_rule(const Rule& new_rule){
+    if(new_rule != rule){
+        rule = new_rule;
+        // Tiles that were stable under the old rule may not be under the new one, so recompute them all.
+        changed_tiles.clear();
+        forget_history();
+    }
+}
+
+/**
+ * World::get_threads()
+ *
+ * Gets the number of threads used to step the world, including the calling thread.
+ * The function should be callable from a constant context.
  *
  * @return
- *      Returns the number of alive neighbours.
- */
-int World::count_neighbours(int x, int y, bool toroidal){
-    int alive_neighbours  = 0;
-    if(toroidal){
-        for(int j = -1; j<=1; j++){
-            for(int i = -1; i <= 1; i++){
-                // formula will wrap around if x or y is out of bounds.
-                if(!(i == 0 && j == 0) &&
-                   current_state.get((i+x+get_width())%get_width(),(j+y+get_height())%get_height()) == ALIVE){
-                    alive_neighbours++;
+ *      The number of threads, 1 if the world steps serially.
+ */
+unsigned int World::get_threads() const{
+    return pool ? pool->get_threads() : 1;
+}
+
+/**
+ * World::set_threads(threads)
+ *
+ * Set the number of threads used to step the world.
+ * The worker threads are started once here and reused by every step.
+ * Worlds copied from this one share its threads.
+ *
+ * @example
+ *
+ *      // Make a world
+ *      World world(4096, 4096);
+ *
+ *      // Step using every core of the machine
+ *      world.set_threads(0);
+ *
+ * @param threads
+ *      The number of threads to use. 1 steps serially on the calling thread,
+ *      0 uses one thread per hardware thread of the machine.
+ */
+void World::set_threads(unsigned int threads){
+    if(threads == 0){
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if(threads == get_threads()){
+        return;
+    }
+    pool = (threads > 1) ? std::make_shared<ThreadPool>(threads) : nullptr;
+}
+
+/**
+ * World::get_band_count()
+ *
+ * Private helper function to decide how many horizontal bands of tile rows to split a step into.
+ * There is at most one band per thread and per row of tiles, and bands are kept large enough to be worth a thread.
+ *
+ * @return
+ *      The number of bands, 1 if the step should run serially.
+ */
+unsigned int World::get_band_count() const{
+    std::size_t words = (std::size_t) current_state.get_row_words() * get_height();
+    std::size_t bands = std::min<std::size_t>(get_threads(), get_tile_rows());
+    return (unsigned int) std::max<std::size_t>(1, std::min<std::size_t>(bands, words / MIN_BAND_WORDS));
+}
+
+/**
+ * World::get_tile_count()
+ *
+ * Gets the number of tiles the world is divided into for tracking which regions are active.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The number of tiles.
+ */
+unsigned int World::get_tile_count() const{
+    return get_tile_columns() * get_tile_rows();
+}
+
+/**
+ * World::get_active_tiles()
+ *
+ * Gets the number of tiles recomputed by the last step, for monitoring how much of the world is active.
+ * The first step after constructing or resizing a world recomputes every tile.
+ * The function should be callable from a constant context.
+ *
+ * @example
+ *
+ *      // Make a world with a single glider in a large empty grid
+ *      Grid grid(4096);
+ *      grid.merge(Zoo::glider(), 0, 0);
+ *      World world(grid);
+ *
+ *      // After the first step only the few tiles around the glider are recomputed
+ *      world.advance(2);
+ *      std::cout << world.get_active_tiles() << " of " << world.get_tile_count() << std::endl;
+ *
+ * @return
+ *      The number of tiles recomputed by the last step, 0 before the first step.
+ */
+unsigned int World::get_active_tiles() const{
+    return active_tiles;
+}
+
+/**
+ * World::get_generation()
+ *
+ * Gets the number of steps taken since the world was constructed, or since the generation was last set.
+ * Resizing a world does not change its generation.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The current generation.
+ */
+std::uint64_t World::get_generation() const{
+    return generation;
+}
+
+/**
+ * World::set_generation(generation)
+ *
+ * Overwrite the generation counter, for example when resuming from a snapshot saved at a later generation.
+ *
+ * @param generation
+ *      The new generation of the world.
+ */
+void World::set_generation(std::uint64_t generation){
+    this->generation = generation;
+    forget_history();
+}
+
+/**
+ * World::set_recorder(recorder)
+ *
+ * Record the current state and every following step with a Recorder, or stop recording.
+ * The current state is written as a key frame, and each step then writes the words it changed, found by
+ * comparing only the tiles the step marked as changed. The world must not be resized while recording.
+ *
+ * @example
+ *
+ *      // Record a run to a file
+ *      std::ofstream file("path/to/run.gdiff", std::ios::out | std::ios::binary);
+ *      Recorder recorder(file);
+ *      world.set_recorder(&recorder);
+ *      world.advance(1000);
+ *      world.set_recorder(nullptr);
+ *
+ * @param recorder
+ *      The recorder to write to, which must outlive its use by the world, or nullptr to stop recording.
+ *
+ * @throws
+ *      std::invalid_argument if the recorder already holds a frame at or after the current generation,
+ *      or holds frames of a different size.
+ */
+void World::set_recorder(Recorder* recorder){
+    if(recorder){
+        recorder->record(current_state, generation);
+    }
+    this->recorder = recorder;
+}
+
+/**
+ * World::set_cycle_detection(history)
+ *
+ * Start or stop watching for the world repeating an earlier state. While on, every step updates the hash of
+ * the tiles it changed and looks the new hash up among the last history generations. Once a cycle is
+ * confirmed, get_period and get_cycle_start describe it, and advance jumps over whole periods.
+ *
+ * @example
+ *
+ *      // Run a soup for up to a billion generations, which returns as soon as it settles
+ *      World world(Zoo::r_pentomino());
+ *      world.resize(256, 256);
+ *      world.set_cycle_detection(1024);
+ *      world.advance(1000000000);
+ *      std::cout << "Period " << world.get_period() << " from generation " << world.get_cycle_start() << std::endl;
+ *
+ * @param history
+ *      The number of past generations to remember, which is the longest period that can be detected.
+ *      0 turns detection off, which is the default.
+ */
+void World::set_cycle_detection(unsigned int history){
+    history_limit = history;
+    forget_history();
+    if(history == 0){
+        hashes_valid = false;
+        tile_hashes.clear();
+    }
+}
+
+/**
+ * World::get_hash()
+ *
+ * Gets a 64-bit hash of the cells of the current state. Equal states of the same size always have equal hashes.
+ * With cycle detection on this is read from the kept hash, and otherwise it is computed from every tile.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The hash of the current state.
+ */
+std::uint64_t World::get_hash() const{
+    if(hashes_valid){
+        return state_hash;
+    }
+    std::uint64_t hash = 0;
+    for(unsigned int ty = 0; ty < get_tile_rows(); ty++){
+        for(unsigned int tx = 0; tx < get_tile_columns(); tx++){
+            hash ^= hash_tile(current_state, ty, tx);
+        }
+    }
+    return hash;
+}
+
+/**
+ * World::get_period()
+ *
+ * Gets the period of the cycle the world has settled into, found by cycle detection.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      1 for a still life or an empty world, p for an oscillator of period p, or 0 if no cycle has been found.
+ */
+std::uint64_t World::get_period() const{
+    return cycle_period;
+}
+
+/**
+ * World::get_cycle_start()
+ *
+ * Gets the first generation of the cycle the world has settled into, found by cycle detection.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The generation the cycle started at, or 0 if no cycle has been found.
+ */
+std::uint64_t World::get_cycle_start() const{
+    return cycle_start;
+}
+
+/**
+ * World::get_stats()
+ *
+ * Gets the totals of the steps taken since the world was constructed or reset_stats was last called.
+ * Every value is zero when built with GOL_WITH_STATS=0.
+ * The function should be callable from a constant context.
+ *
+ * @example
+ *
+ *      // Print how much of the time of a run was spent in the kernel
+ *      World world(Zoo::load_ascii("path/to/file.gol"));
+ *      world.advance(1000);
+ *      std::cout << world.get_stats().kernel_seconds / world.get_stats().step_seconds << std::endl;
+ *
+ * @return
+ *      A read-only reference to the statistics of the world.
+ */
+const Stats::WorldStats& World::get_stats() const{
+    return stats;
+}
+
+/**
+ * World::reset_stats()
+ *
+ * Set every total of the statistics back to zero, keeping the population of the last step.
+ */
+void World::reset_stats(){
+    std::uint64_t population = stats.population;
+    stats = Stats::WorldStats();
+    stats.population = population;
+}
+
+/**
+ * World::hash_tile(state, tile_row, tile_column)
+ *
+ * Private helper function that hashes the cells of one tile of a grid, seeded with the position of the tile
+ * so the same cells in different tiles hash differently. Tiles of dead cells hash to 0.
+ */
+std::uint64_t World::hash_tile(const Grid& state, unsigned int tile_row, unsigned int tile_column) const{
+    unsigned int y0 = tile_row * TILE_ROWS;
+    unsigned int y1 = std::min(get_height(), y0 + TILE_ROWS);
+    unsigned int k0 = tile_column * TILE_WORDS;
+    unsigned int k1 = std::min(state.get_row_words(), k0 + TILE_WORDS);
+    std::uint64_t hash = 0;
+    std::uint64_t any = 0;
+    for(unsigned int y = y0; y < y1; y++){
+        const std::uint64_t* row = state.get_row(y);
+        for(unsigned int k = k0; k < k1; k++){
+            hash = (hash ^ row[k]) * 0x9E3779B97F4A7C15ULL;
+            hash ^= hash >> 29;
+            any |= row[k];
+        }
+    }
+    std::uint64_t position = (std::uint64_t) tile_row * get_tile_columns() + tile_column;
+    return any ? mix(hash + mix(position + 1)) : 0;
+}
+
+/**
+ * World::forget_history()
+ *
+ * Private helper function that drops the remembered hashes and any cycle found, for when the state or the
+ * rules change in a way that stepping does not.
+ */
+void World::forget_history(){
+    history.clear();
+    history_order.clear();
+    cycle_check = Grid();
+    candidate_period = 0;
+    cycle_period = 0;
+    cycle_start = 0;
+}
+
+/**
+ * World::remember(hash)
+ *
+ * Private helper function that adds the hash of the current generation to the history, forgetting the oldest
+ * generation once there are more than the history limit.
+ */
+void World::remember(std::uint64_t hash){
+    history[hash] = generation;
+    history_order.emplace_back(hash, generation);
+    if(history_order.size() > history_limit){
+        auto oldest = history.find(history_order.front().first);
+        if(oldest != history.end() && oldest->second == history_order.front().second){
+            history.erase(oldest);
+        }
+        history_order.pop_front();
+    }
+}
+
+/**
+ * World::detect_cycle()
+ *
+ * Private helper function run after each step with cycle detection on.
+ * A repeated hash makes a candidate cycle, which is confirmed if the cells one candidate period later are
+ * identical to the cells now. A state that repeats after p generations repeats every p generations after that,
+ * since each step depends only on the state before it.
+ */
+void World::detect_cycle(){
+    if(cycle_period){
+        return;
+    }
+    if(candidate_period && generation == candidate_start + 2 * candidate_period){
+        std::size_t words = (std::size_t) current_state.get_row_words() * get_height();
+        if(std::equal(current_state.get_row(0), current_state.get_row(0) + words, cycle_check.get_row(0))){
+            cycle_period = candidate_period;
+            cycle_start = candidate_start;
+            cycle_check = Grid();
+            return;
+        }
+        candidate_period = 0;
+    }
+    auto found = history.find(state_hash);
+    if(found != history.end() && !candidate_period){
+        candidate_start = found->second;
+        candidate_period = generation - found->second;
+        cycle_check = current_state;
+    }
+    remember(state_hash);
+}
+
+/**
+ * World::get_tile_columns()
+ *
+ * Private helper function to get the number of columns of tiles, the last of which may be partial.
+ *
+ * @return
+ *      The number of tiles across the width of the world.
+ */
+unsigned int World::get_tile_columns() const{
+    return (current_state.get_row_words() + TILE_WORDS - 1) / TILE_WORDS;
+}
+
+/**
+ * World::get_tile_rows()
+ *
+ * Private helper function to get the number of rows of tiles, the last of which may be partial.
+ *
+ * @return
+ *      The number of tiles down the height of the world.
+ */
+unsigned int World::get_tile_rows() const{
+    return (get_height() + TILE_ROWS - 1) / TILE_ROWS;
+}
+
+/**
+ * World::mark_active_tiles(toroidal)
+ *
+ * Private helper function that marks in the active map every tile that changed in the last step
+ * or is next to one that did, wrapping around the edges if the world is toroidal.
+ *
+ * @param toroidal
+ *      If true then tiles on opposite edges of the world are neighbours.
+ */
+void World::mark_active_tiles(bool toroidal){
+    int columns = (int) get_tile_columns();
+    int rows = (int) get_tile_rows();
+    active_map.assign(changed_tiles.size(), 0);
+    for(int ty = 0; ty < rows; ty++){
+        for(int tx = 0; tx < columns; tx++){
+            if(!changed_tiles[(std::size_t)ty * columns + tx]){
+                continue;
+            }
+            for(int j = -1; j <= 1; j++){
+                for(int i = -1; i <= 1; i++){
+                    int x = tx + i, y = ty + j;
+                    if(toroidal){
+                        x = (x + columns) % columns;
+                        y = (y + rows) % rows;
+                    } else if(x < 0 || x >= columns || y < 0 || y >= rows){
+                        continue;
+                    }
+                    active_map[(std::size_t)y * columns + x] = 1;
                 }
             }
         }
-    } else{
-        for(int j = -1; j<=1; j++){
-            for(int i = -1; i <= 1; i++){
-                // check if the x and y meet the edge conditions, then get the values.
-                if((i+x >= 0 && i+x < (int) get_width()) && (j+y >= 0 && j+y < (int) get_height()) &&
-                   !(i == 0 && j == 0) && current_state.get(i+x,j+y) == ALIVE){
-                    alive_neighbours++;
-                }
+    }
+}
+
+/**
+ * World::get_active_cells()
+ *
+ * Private helper function that counts the cells in the tiles marked in the active map, for the statistics.
+ * The marked tiles are clipped to the grid, so the cells of a full step are exactly the total cells.
+ *
+ * @return
+ *      The number of cells recomputed by one generation of the marked tiles.
+ */
+std::uint64_t World::get_active_cells() const{
+    unsigned int columns = get_tile_columns();
+    std::uint64_t cells = 0;
+    for(unsigned int ty = 0; ty < get_tile_rows(); ty++){
+        std::uint64_t tile_height = std::min(get_height() - ty * TILE_ROWS, TILE_ROWS);
+        for(unsigned int tx = 0; tx < columns; tx++){
+            if(active_map[(std::size_t)ty * columns + tx]){
+                cells += tile_height * std::min(get_width() - tx * TILE_WORDS * 64, TILE_WORDS * 64);
             }
         }
     }
-    return alive_neighbours;
+    return cells;
+}
+
+/**
+ * World::prepare_bands(count)
+ *
+ * Private helper function that sizes the scratch space of count bands and the row of dead cells to the world,
+ * and clears the results of the last step. Nothing is allocated unless the world or the thread count has grown.
+ */
+void World::prepare_bands(unsigned int count){
+    band_scratch.resize(count);
+    for(Band& band : band_scratch){
+        band.differences.resize(get_tile_columns());
+        band.counts.resize(get_tile_columns());
+        band.stepped = 0;
+        band.alive_change = 0;
+        band.hash_change = 0;
+    }
+    // Two words longer than a row, as World::advance_tile_row reads past both ends of a row.
+    dead_cells.assign((std::size_t) current_state.get_row_words() + 2, 0);
+}
+
+/**
+ * World::step_tile_row(tile_row, toroidal, dead_row, differences, counts, alive_change, hash_change)
+ *
+ * Private helper function that recomputes the active tiles in one row of tiles and records which of them changed.
+ * Consecutive active tiles are stepped together as one span of words, so the kernels see long runs of words.
+ *
+ * @param tile_row
+ *      The row of tiles to step.
+ *
+ * @param toroidal
+ *      If true then the step will consider the grid as a torus.
+ *
+ * @param dead_row
+ *      A row of dead cells to read past the top and bottom edges of a bounded world.
+ *
+ * @param differences
+ *      Scratch space with one word per tile column.
+ *
+ * @param counts
+ *      Scratch space with one count per tile column.
+ *
+ * @param alive_change
+ *      Incremented by the number of cells born minus the number that died in the recomputed tiles.
+ *
+ * @param hash_change
+ *      XORed with the old and new hashes of each changed tile, if the tile hashes are being kept.
+ *
+ * @return
+ *      The number of tiles that were recomputed.
+ */
+unsigned int World::step_tile_row(unsigned int tile_row, bool toroidal, const std::uint64_t* dead_row,
+                                  std::vector<std::uint64_t>& differences, std::vector<unsigned int>& counts,
+                                  long long& alive_change, std::uint64_t& hash_change){
+    unsigned int columns = get_tile_columns();
+    unsigned int width = get_width();
+    unsigned int height = get_height();
+    unsigned int row_words = current_state.get_row_words();
+    unsigned int y0 = tile_row * TILE_ROWS;
+    unsigned int y1 = std::min(height, y0 + TILE_ROWS);
+    const unsigned char* active = active_map.data() + (std::size_t)tile_row * columns;
+    unsigned char* changed = changed_tiles.data() + (std::size_t)tile_row * columns;
+    unsigned int* alive = tile_alive_cells.data() + (std::size_t)tile_row * columns;
+
+    unsigned int stepped = 0;
+    unsigned int tx = 0;
+    while(tx < columns){
+        if(!active[tx]){
+            tx++;
+            continue;
+        }
+        unsigned int run_end = tx;
+        while(run_end < columns && active[run_end]){
+            counts[run_end] = 0;
+            differences[run_end++] = 0;
+        }
+
+        unsigned int k0 = tx * TILE_WORDS;
+        unsigned int k1 = std::min(row_words, run_end * TILE_WORDS);
+        for(unsigned int y = y0; y < y1; y++){
+            const std::uint64_t* above;
+            const std::uint64_t* below;
+            if(toroidal){
+                above = current_state.get_row((y + height - 1) % height);
+                below = current_state.get_row((y + 1) % height);
+            } else{
+                above = (y > 0) ? current_state.get_row(y - 1) : dead_row;
+                below = (y + 1 < height) ? current_state.get_row(y + 1) : dead_row;
+            }
+            std::uint64_t* out = next_state.get_row(y);
+            Kernel::step_row_span(above, current_state.get_row(y), below, out, width, k0, k1, toroidal, rule,
+                                  kernel, differences.data());
+            // Count the new row while it is still in cache, which is much cheaper than a rescan later.
+            for(unsigned int t = tx; t < run_end; t++){
+                counts[t] += Kernel::count_cells(out, t * TILE_WORDS, std::min(k1, (t + 1) * TILE_WORDS), kernel);
+            }
+        }
+
+        for(unsigned int t = tx; t < run_end; t++){
+            changed[t] = differences[t] != 0;
+            alive_change += (long long) counts[t] - alive[t];
+            alive[t] = counts[t];
+            if(hashes_valid && changed[t]){
+                std::uint64_t& hash = tile_hashes[(std::size_t)tile_row * columns + t];
+                std::uint64_t new_hash = hash_tile(next_state, tile_row, t);
+                hash_change ^= hash ^ new_hash;
+                hash = new_hash;
+            }
+        }
+        stepped += run_end - tx;
+        tx = run_end;
+    }
+    return stepped;
 }
 
 /**
  * World::step(toroidal)
  *
- * Take one step in Conway's Game of Life.
+ * Take one step in Conway's Game of Life, or in the rule given to set_rule.
  *
  * Reads from the current state grid and writes to the next state grid. Then swaps the grids.
- * Should be implemented by invoking World::count_neighbours(x, y, toroidal).
+ * Implemented by Kernel::step, which sums the neighbours of 64 cells at a time with bitwise adders
+ * instead of counting the neighbours of each cell, so there are no per-cell bounds checks or branches.
  * Swapping the grids should be done in O(1) constant time, and should not invoke a copy.
- * Try and boil the logic down to the fewest and most simple conditional statements.
+ * With more than one thread the rows are stepped in bands on the thread pool, with identical results.
+ * Only tiles that changed in the last step, or border a tile that did, are recomputed.
  *
  * Rules: https://en.wikipedia.org/wiki/Conway%27s_Game_of_Life
  *      - Any live cell with fewer than two live neighbours dies, as if by underpopulation.
@@ -402,19 +1319,294 @@ int World::count_neighbours(int x, int y, bool toroidal){
  *      wraps to the right edge and the top to the bottom. Defaults to false.
  */
 void World::step(bool toroidal){
-    for(int j = 0; j < (int) current_state.get_height(); j++){
-        for(int i = 0; i < (int) current_state.get_width(); i++){
-            int num_neighbours = count_neighbours(i,j, toroidal);
-            if((num_neighbours == 2 && current_state.get(i,j) == ALIVE) || (num_neighbours ==3 && current_state.get(i,j) == ALIVE)){
-                next_state.set(i,j,ALIVE);
-            } else if(num_neighbours == 3 && current_state.get(i,j) == DEAD){
-                next_state.set(i,j,ALIVE);
+    GOL_STATS(Stats::Clock::time_point step_start = Stats::Clock::now();)
+
+    // Until a step has compared them, or when the edges change meaning, any tile may differ between the buffers.
+    std::size_t tiles = (std::size_t) get_tile_columns() * get_tile_rows();
+    if(changed_tiles.size() != tiles || toroidal != last_toroidal){
+        changed_tiles.assign(tiles, 1);
+        // Every tile is recomputed, so counting from zero leaves the total as the sum of the new counts.
+        tile_alive_cells.assign(tiles, 0);
+        alive_cells = 0;
+    }
+    mark_active_tiles(toroidal);
+
+    // The kept hash starts from a full hash of the state, after which only changed tiles are rehashed.
+    if(toroidal != last_toroidal){
+        forget_history();
+    }
+    if(history_limit > 0 && !hashes_valid){
+        tile_hashes.assign(tiles, 0);
+        state_hash = 0;
+        for(unsigned int ty = 0; ty < get_tile_rows(); ty++){
+            for(unsigned int tx = 0; tx < get_tile_columns(); tx++){
+                tile_hashes[(std::size_t)ty * get_tile_columns() + tx] = hash_tile(current_state, ty, tx);
+                state_hash ^= tile_hashes[(std::size_t)ty * get_tile_columns() + tx];
+            }
+        }
+        hashes_valid = true;
+    }
+    if(hashes_valid && history_order.empty()){
+        remember(state_hash);
+    }
+    GOL_STATS(Stats::Clock::time_point kernel_start = Stats::Clock::now();)
+
+    unsigned int band_count = get_band_count();
+    unsigned int rows = get_tile_rows();
+    prepare_bands(band_count);
+    auto step_band = [&](unsigned int b){
+        Band& band = band_scratch[b];
+        unsigned int r0 = (unsigned int) ((unsigned long long) rows * b / band_count);
+        unsigned int r1 = (unsigned int) ((unsigned long long) rows * (b + 1) / band_count);
+        for(unsigned int tile_row = r0; tile_row < r1; tile_row++){
+            band.stepped += step_tile_row(tile_row, toroidal, dead_cells.data(), band.differences, band.counts,
+                                          band.alive_change, band.hash_change);
+        }
+    };
+    // Passed by reference, the lambda is not copied into the heap by std::function on every step.
+    if(band_count <= 1){
+        step_band(0);
+    } else{
+        pool->run(band_count, std::ref(step_band));
+    }
+    GOL_STATS(Stats::Clock::time_point kernel_end = Stats::Clock::now();)
+
+    active_tiles = 0;
+    for(unsigned int b = 0; b < band_count; b++){
+        active_tiles += band_scratch[b].stepped;
+        alive_cells = (unsigned int) (alive_cells + band_scratch[b].alive_change);
+    }
+    last_toroidal = toroidal;
+    generation++;
+    GOL_STATS(Stats::Clock::time_point record_start = Stats::Clock::now();)
+    if(recorder){
+        recorder->record_step(current_state, next_state, generation, changed_tiles.data(), TILE_ROWS, TILE_WORDS);
+    }
+    GOL_STATS(Stats::Clock::time_point swap_start = Stats::Clock::now();)
+    std::swap(next_state, current_state);
+    state_version++;
+    GOL_STATS(Stats::Clock::time_point detect_start = Stats::Clock::now();)
+    if(hashes_valid){
+        for(unsigned int b = 0; b < band_count; b++){
+            state_hash ^= band_scratch[b].hash_change;
+        }
+        detect_cycle();
+    }
+
+#if GOL_WITH_STATS
+    Stats::Clock::time_point step_end = Stats::Clock::now();
+    stats.cells_stepped += get_active_cells();
+    stats.steps++;
+    stats.tiles_stepped += active_tiles;
+    stats.population = alive_cells;
+    stats.last_step_seconds = Stats::get_seconds(step_start, step_end);
+    stats.step_seconds += stats.last_step_seconds;
+    stats.plan_seconds += Stats::get_seconds(step_start, kernel_start);
+    stats.kernel_seconds += Stats::get_seconds(kernel_start, kernel_end);
+    stats.record_seconds += Stats::get_seconds(record_start, swap_start);
+    stats.swap_seconds += Stats::get_seconds(kernel_end, record_start) + Stats::get_seconds(swap_start, detect_start);
+    stats.cycle_seconds += Stats::get_seconds(detect_start, step_end);
+#endif
+}
+
+/**
+ * World::advance_tile_row(tile_row, steps, toroidal, buffers, dead_row, differences, counts, alive_change)
+ *
+ * Private helper function that advances the active tiles in one row of tiles through several generations,
+ * from the current state into the next state, and records which of them changed.
+ *      - Each run of active tiles, up to BLOCK_TILES long, is copied with a halo of steps rows and one word on
+ *        each side into a pair of local buffers, which are stepped in turn steps times.
+ *      - The cells next to the edge of a halo read dead cells past it and go wrong, one more cell in from the
+ *        edge each generation, so each generation steps one row fewer at each halo edge. After steps
+ *        generations only the halo is wrong, and the tiles themselves are exact.
+ *      - A bounded world needs no halo past its edges, where the dead cells read past the local buffer are
+ *        exactly right.
+ *
+ * @param buffers
+ *      The two local buffers, reused between calls and grown as needed.
+ *
+ * @param dead_row
+ *      A row of dead cells at least two words longer than a row of the world.
+ *
+ * @return
+ *      The number of tiles that were advanced.
+ */
+unsigned int World::advance_tile_row(unsigned int tile_row, unsigned int steps, bool toroidal,
+                                     std::vector<std::uint64_t> buffers[2], const std::uint64_t* dead_row,
+                                     std::vector<std::uint64_t>& differences, std::vector<unsigned int>& counts,
+                                     long long& alive_change){
+    unsigned int columns = get_tile_columns();
+    int width = (int) get_width();
+    int height = (int) get_height();
+    unsigned int row_words = current_state.get_row_words();
+    int y0 = (int) (tile_row * TILE_ROWS);
+    int y1 = std::min(height, y0 + (int) TILE_ROWS);
+    const unsigned char* active = active_map.data() + (std::size_t)tile_row * columns;
+    unsigned char* changed = changed_tiles.data() + (std::size_t)tile_row * columns;
+    unsigned int* alive = tile_alive_cells.data() + (std::size_t)tile_row * columns;
+
+    int top = y0 - (int) steps;
+    int bottom = y1 + (int) steps;
+    bool top_halo = toroidal || top > 0;
+    bool bottom_halo = toroidal || bottom < height;
+    if(!top_halo){
+        top = 0;
+    }
+    if(!bottom_halo){
+        bottom = height;
+    }
+    unsigned int local_rows = (unsigned int) (bottom - top);
+
+    unsigned int stepped = 0;
+    unsigned int tx = 0;
+    while(tx < columns){
+        if(!active[tx]){
+            tx++;
+            continue;
+        }
+        unsigned int run_end = tx;
+        while(run_end < columns && run_end - tx < BLOCK_TILES && active[run_end]){
+            counts[run_end] = 0;
+            differences[run_end++] = 0;
+        }
+
+        unsigned int k0 = tx * TILE_WORDS;
+        unsigned int k1 = std::min(row_words, run_end * TILE_WORDS);
+        int x0 = (int) k0 * 64;
+        int x1 = std::min(width, (int) k1 * 64);
+        bool left_halo = toroidal || k0 > 0;
+        bool right_halo = toroidal || k1 < row_words;
+        int left = left_halo ? ((x0 - 64) % width + width) % width : x0;
+        unsigned int local_width = (unsigned int) (x1 - x0) + (left_halo ? 64 : 0) + (right_halo ? 64 : 0);
+        unsigned int stride = (local_width + 63) / 64;
+        buffers[0].resize((std::size_t) local_rows * stride);
+        buffers[1].resize((std::size_t) local_rows * stride);
+
+        // The halo is whole words of the row, except where a torus wraps a row that ends part way into a word.
+        bool aligned = !toroidal || width % 64 == 0 || (k0 > 0 && k1 < row_words);
+        for(unsigned int r = 0; r < local_rows; r++){
+            const std::uint64_t* row = current_state.get_row((unsigned int) (((top + (int) r) % height + height) % height));
+            std::uint64_t* local = buffers[0].data() + (std::size_t) r * stride;
+            if(aligned){
+                unsigned int k = (unsigned int) left / 64;
+                for(unsigned int j = 0; j < stride; j++){
+                    local[j] = row[k];
+                    k = (k + 1 == row_words) ? 0 : k + 1;
+                }
             } else{
-                next_state.set(i,j,DEAD);
+                for(unsigned int j = 0; j < stride; j++){
+                    local[j] = get_bits(row, (unsigned int) width, (unsigned int) ((left + 64 * (long long) j) % width));
+                }
+            }
+            if(local_width % 64 != 0){
+                local[stride - 1] &= ((std::uint64_t)1 << (local_width % 64)) - 1;
             }
         }
+
+        for(unsigned int g = 1; g <= steps; g++){
+            const std::uint64_t* from = buffers[(g - 1) % 2].data();
+            std::uint64_t* to = buffers[g % 2].data();
+            unsigned int r0 = top_halo ? g : 0;
+            unsigned int r1 = bottom_halo ? local_rows - g : local_rows;
+            for(unsigned int r = r0; r < r1; r++){
+                const std::uint64_t* above = (r > 0) ? from + (std::size_t) (r - 1) * stride : dead_row;
+                const std::uint64_t* below = (r + 1 < local_rows) ? from + (std::size_t) (r + 1) * stride : dead_row;
+                Kernel::step_row_span(above, from + (std::size_t) r * stride, below, to + (std::size_t) r * stride,
+                                      local_width, 0, stride, false, rule, kernel, nullptr);
+            }
+        }
+
+        // A tile is marked changed if it differs from the last generation or from the other buffer, which still
+        // holds the state before the pass, so unmarked tiles keep holding the same cells in both buffers.
+        const std::uint64_t* last = buffers[steps % 2].data();
+        const std::uint64_t* before_last = buffers[(steps - 1) % 2].data();
+        unsigned int offset = left_halo ? 1 : 0;
+        for(int y = y0; y < y1; y++){
+            std::size_t r = (std::size_t) (y - top) * stride + offset;
+            const std::uint64_t* old = current_state.get_row((unsigned int) y);
+            std::uint64_t* out = next_state.get_row((unsigned int) y);
+            for(unsigned int k = k0; k < k1; k++){
+                std::uint64_t mask = (k + 1 == row_words && width % 64 != 0)
+                                     ? ((std::uint64_t)1 << (width % 64)) - 1 : ~(std::uint64_t)0;
+                std::uint64_t word = last[r + k - k0] & mask;
+                differences[k / TILE_WORDS] |= (word ^ (before_last[r + k - k0] & mask)) | (word ^ old[k]);
+                out[k] = word;
+            }
+            for(unsigned int t = tx; t < run_end; t++){
+                counts[t] += Kernel::count_cells(out, t * TILE_WORDS, std::min(k1, (t + 1) * TILE_WORDS), kernel);
+            }
+        }
+
+        for(unsigned int t = tx; t < run_end; t++){
+            changed[t] = differences[t] != 0;
+            alive_change += (long long) counts[t] - alive[t];
+            alive[t] = counts[t];
+        }
+        stepped += run_end - tx;
+        tx = run_end;
     }
+    return stepped;
+}
+
+/**
+ * World::advance_blocked(steps, toroidal)
+ *
+ * Private helper function that advances the world several generations in one pass over memory, with the same
+ * result as stepping them one at a time.
+ *      - Only runs after a step with the same edges, with no Recorder attached and cycle detection off, since
+ *        it keeps no record of the generations in between.
+ *      - A change spreads at most one cell per generation, and steps is at most TILE_ROWS, so a tile that is not
+ *        active now, with no change in any of the tiles around it, cannot change within steps generations.
+ *        Only the active tiles are advanced, as by steps calls to step.
+ *      - That only holds while every tile is at least steps cells high and wide. On a torus a partial last row or
+ *        column of tiles narrower than that lets a change cross it into the first within one pass, so
+ *        World::advance steps such worlds one generation at a time instead.
+ */
+void World::advance_blocked(unsigned int steps, bool toroidal){
+    GOL_STATS(Stats::Clock::time_point step_start = Stats::Clock::now();)
+    mark_active_tiles(toroidal);
+    GOL_STATS(Stats::Clock::time_point kernel_start = Stats::Clock::now();)
+
+    unsigned int band_count = get_band_count();
+    unsigned int rows = get_tile_rows();
+    prepare_bands(band_count);
+    auto advance_band = [&](unsigned int b){
+        Band& band = band_scratch[b];
+        unsigned int r0 = (unsigned int) ((unsigned long long) rows * b / band_count);
+        unsigned int r1 = (unsigned int) ((unsigned long long) rows * (b + 1) / band_count);
+        for(unsigned int tile_row = r0; tile_row < r1; tile_row++){
+            band.stepped += advance_tile_row(tile_row, steps, toroidal, band.buffers, dead_cells.data(),
+                                             band.differences, band.counts, band.alive_change);
+        }
+    };
+    if(band_count <= 1){
+        advance_band(0);
+    } else{
+        pool->run(band_count, std::ref(advance_band));
+    }
+    GOL_STATS(Stats::Clock::time_point kernel_end = Stats::Clock::now();)
+
+    active_tiles = 0;
+    for(unsigned int b = 0; b < band_count; b++){
+        active_tiles += band_scratch[b].stepped;
+        alive_cells = (unsigned int) (alive_cells + band_scratch[b].alive_change);
+    }
+    generation += steps;
     std::swap(next_state, current_state);
+    state_version++;
+
+#if GOL_WITH_STATS
+    Stats::Clock::time_point step_end = Stats::Clock::now();
+    stats.cells_stepped += get_active_cells() * steps;
+    stats.steps += steps;
+    stats.tiles_stepped += (std::uint64_t) active_tiles * steps;
+    stats.population = alive_cells;
+    stats.last_step_seconds = Stats::get_seconds(step_start, step_end) / steps;
+    stats.step_seconds += Stats::get_seconds(step_start, step_end);
+    stats.plan_seconds += Stats::get_seconds(step_start, kernel_start);
+    stats.kernel_seconds += Stats::get_seconds(kernel_start, kernel_end);
+    stats.swap_seconds += Stats::get_seconds(kernel_end, step_end);
+#endif
 }
 
 /**
@@ -423,6 +1615,14 @@ void World::step(bool toroidal){
  * Advance multiple steps in the Game of Life.
  * Should be implemented by invoking World::step(toroidal).
  *
+ * With cycle detection on, once the world is known to repeat every p generations, every whole multiple of p
+ * of the remaining steps is skipped by moving the generation counter on, and only the remainder is stepped.
+ * Skipping is done only while no Recorder is attached, since a recording has a frame for every step.
+ *
+ * Large worlds without a Recorder or cycle detection are advanced TEMPORAL_STEPS generations per pass over
+ * memory by World::advance_blocked, after a first step to find the changed tiles, giving exactly the same
+ * state as stepping each one.
+ *
  * @param steps
  *      The number of steps to advance the world forward.
  *
@@ -431,7 +1631,32 @@ void World::step(bool toroidal){
  *      wraps to the right edge and the top to the bottom. Defaults to false.
  */
 void World::advance(unsigned int steps, bool toroidal){
+    std::size_t tiles = (std::size_t) get_tile_columns() * get_tile_rows();
+    // On a torus the partial last row and column of tiles sit between the first and the one before them, so they
+    // must be as high and as wide as the halo for the tiles around them to be unreachable by changes further away
+    // within one pass.
+    const unsigned int tile_width = TILE_WORDS * 64;
+    bool blocked = !recorder && history_limit == 0 &&
+                   (std::size_t) current_state.get_row_words() * get_height() >= MIN_BLOCKED_WORDS &&
+                   (!toroidal || get_height() % TILE_ROWS == 0 || get_height() % TILE_ROWS >= TEMPORAL_STEPS) &&
+                   (!toroidal || get_width() % tile_width == 0 || get_width() % tile_width >= TEMPORAL_STEPS);
     for(unsigned int i = 0; i<steps; i++){
+        if(cycle_period && !recorder && toroidal == last_toroidal){
+            std::uint64_t remaining = steps - i;
+            std::uint64_t skipped = remaining - remaining % cycle_period;
+            generation += skipped;
+            GOL_STATS(stats.skipped_generations += skipped;)
+            i += (unsigned int) skipped;
+            if(i == steps){
+                break;
+            }
+        }
+        // Once a step has found the changed tiles for these edges, whole blocks of generations go in one pass.
+        if(blocked && steps - i >= TEMPORAL_STEPS && toroidal == last_toroidal && changed_tiles.size() == tiles){
+            advance_blocked(TEMPORAL_STEPS, toroidal);
+            i += TEMPORAL_STEPS - 1;
+            continue;
+        }
         step(toroidal);
     }
 }
\ No newline at end of file
@@ -13,22 +13,110 @@
 // Add the minimal number of includes you need in order to declare the class.
 // #include ...
 
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include "grid.h"
+#include "kernel.h"
+#include "recorder.h"
+#include "rule.h"
+#include "stats.h"
+#include "thread_pool.h"
 
 /**
  * Declare the structure of the World class for representing a 2d grid world.
  *
  * A World holds two equally sized Grid objects for the current state and next state.
  *      - These buffers should be swapped using std::swap after each update step.
+ *      - Steps can be split into horizontal bands of rows that run on a persistent ThreadPool.
+ *      - The grid is divided into tiles, and only tiles near a change in the last step are recomputed.
+ *      - advance steps large worlds several generations per pass, in blocks of tiles that stay in cache.
+ *      - The number of alive cells is kept up to date by each step rather than counted on request.
+ *      - Windows of the current state can be cropped, counted and bounded without copying the whole state.
+ *      - A Recorder can be attached to record the cells each step changes.
+ *      - Any Life-like Rule can be stepped, Conway's Game of Life by default.
+ *      - With cycle detection on, a hash of the state is kept per tile, and advance jumps over repeating cycles.
+ *      - Unless built with GOL_WITH_STATS=0, the work and time of each phase of a step are counted.
  */
 class World {
     // How to draw an owl:
     //      Step 1. Draw a circle.
     //      Step 2. Draw the rest of the owl.
 private:
+    /**
+     * The scratch space and results of stepping one band of rows, kept between steps so a step does not
+     * allocate, and on cache lines of its own so threads stepping neighbouring bands do not share one.
+     */
+    struct alignas(64) Band {
+        std::vector<std::uint64_t> buffers[2];
+        std::vector<std::uint64_t> differences;
+        std::vector<unsigned int> counts;
+        unsigned int stepped = 0;
+        long long alive_change = 0;
+        std::uint64_t hash_change = 0;
+    };
+
     Grid current_state;
     Grid next_state;
-    int count_neighbours(int x, int y, bool toroidal);
+    Kernel::Isa kernel = Kernel::detect_isa();
+    Rule rule;
+    std::shared_ptr<ThreadPool> pool;
+    std::vector<unsigned char> changed_tiles;
+    std::vector<unsigned char> active_map;
+    std::vector<unsigned int> tile_alive_cells;
+    std::vector<Band> band_scratch;
+    std::vector<std::uint64_t> dead_cells;
+    bool last_toroidal = false;
+    unsigned int active_tiles = 0;
+    unsigned int alive_cells = 0;
+    std::uint64_t generation = 0;
+    Recorder* recorder = nullptr;
+    unsigned int history_limit = 0;
+    bool hashes_valid = false;
+    std::vector<std::uint64_t> tile_hashes;
+    std::uint64_t state_hash = 0;
+    std::unordered_map<std::uint64_t, std::uint64_t> history;
+    std::deque<std::pair<std::uint64_t, std::uint64_t>> history_order;
+    Grid cycle_check;
+    std::uint64_t candidate_start = 0;
+    std::uint64_t candidate_period = 0;
+    std::uint64_t cycle_start = 0;
+    std::uint64_t cycle_period = 0;
+    Stats::WorldStats stats;
+    // Region queries are answered from the current state and kept until the version changes with the next step.
+    std::uint64_t state_version = 0;
+    mutable std::uint64_t region_version = ~(std::uint64_t)0;
+    mutable int region_window[4] = {0, 0, 0, 0};
+    mutable Grid region;
+    mutable std::uint64_t population_version = ~(std::uint64_t)0;
+    mutable int population_window[4] = {0, 0, 0, 0};
+    mutable std::uint64_t region_population = 0;
+    mutable std::uint64_t bounds_version = ~(std::uint64_t)0;
+    mutable bool has_bounds = false;
+    mutable int bounds[4] = {0, 0, 0, 0};
+    unsigned int get_band_count() const;
+    unsigned int get_tile_columns() const;
+    unsigned int get_tile_rows() const;
+    void mark_active_tiles(bool toroidal);
+    void prepare_bands(unsigned int count);
+    unsigned int step_tile_row(unsigned int tile_row, bool toroidal, const std::uint64_t* dead_row,
+                               std::vector<std::uint64_t>& differences, std::vector<unsigned int>& counts,
+                               long long& alive_change, std::uint64_t& hash_change);
+    unsigned int advance_tile_row(unsigned int tile_row, unsigned int steps, bool toroidal,
+                                  std::vector<std::uint64_t> buffers[2], const std::uint64_t* dead_row,
+                                  std::vector<std::uint64_t>& differences, std::vector<unsigned int>& counts,
+                                  long long& alive_change);
+    void advance_blocked(unsigned int steps, bool toroidal);
+    std::uint64_t get_active_cells() const;
+    void check_region(int x0, int y0, int x1, int y1, const char* function) const;
+    bool has_tile_counts() const;
+    std::uint64_t hash_tile(const Grid& state, unsigned int tile_row, unsigned int tile_column) const;
+    void forget_history();
+    void remember(std::uint64_t hash);
+    void detect_cycle();
 public:
     World();
     explicit World(unsigned int square_size);
@@ -39,9 +127,31 @@ public:
     unsigned int get_total_cells() const;
     unsigned int get_alive_cells() const;
     unsigned int get_dead_cells() const;
-    Grid get_state() const;
+    const Grid& get_state() const;
+    const Grid& get_region(int x0, int y0, int x1, int y1) const;
+    std::uint64_t get_region_alive_cells(int x0, int y0, int x1, int y1) const;
+    bool get_bounds(int& x0, int& y0, int& x1, int& y1) const;
+    Grid::Summary get_summary() const;
     void resize(unsigned int square_size);
     void resize(unsigned int new_width, unsigned int new_height);
+    Kernel::Isa get_kernel() const;
+    const char* get_kernel_name() const;
+    void set_kernel(Kernel::Isa isa);
+    const Rule& get_rule() const;
+    void set_rule(const Rule& new_rule);
+    unsigned int get_threads() const;
+    void set_threads(unsigned int threads);
+    unsigned int get_tile_count() const;
+    unsigned int get_active_tiles() const;
+    std::uint64_t get_generation() const;
+    void set_generation(std::uint64_t generation);
+    void set_recorder(Recorder* recorder);
+    void set_cycle_detection(unsigned int history);
+    std::uint64_t get_hash() const;
+    std::uint64_t get_period() const;
+    std::uint64_t get_cycle_start() const;
+    const Stats::WorldStats& get_stats() const;
+    void reset_stats();
     void step(bool toroidal = false);
     void advance(unsigned int steps, bool toroidal = false);
 };
\ No newline at end of file
@@ -0,0 +1,619 @@
+/**
+ * Implements a class for simulating many small, equally sized worlds together, such as a sweep over
+ * thousands of random soups or seeds from the Zoo.
+ *      - A WorldBatch holds a fixed number of worlds of the same width and height, all starting Cell::DEAD.
+ *          - Worlds are addressed by their instance number, from 0 to get_count() - 1.
+ *          - Cells can be read and written one at a time, or a pattern such as Zoo::glider() placed in a world.
+ *
+ *      - The worlds are bit-sliced: each group of 64 consecutive worlds is stored as one array of words,
+ *        where word x of row y holds cell (x, y) of world i of the group in bit i.
+ *          - Every word operation steps the same cell of 64 worlds, so a batch costs about as much to step as
+ *            a single World 64 times wider, and needs two allocations in total rather than two per world.
+ *          - The neighbours of a cell are in the words next to it, so Kernel::step_sliced_row steps a row
+ *            several words at a time without the shifting a packed Grid needs.
+ *          - Groups are split into bands of rows on a persistent ThreadPool, as World does.
+ *
+ *      - Every world follows the same Rule with the same topology, and steps together with the others.
+ *          - A world is settled once a step leaves it unchanged. It stays the same forever after, so
+ *            groups of 64 settled worlds are no longer stepped.
+ *          - The generation a world settled at, the first generation of its final state, is recorded, so
+ *            a sweep can tell extinct and stable worlds from those still running.
+ *          - Counting the alive cells of every world counts 64 worlds at once with bit-sliced counters.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "world_batch.h"
+
+namespace {
+    // Bands smaller than this many words cost more to hand to a thread than they take to step.
+    const unsigned int MIN_BAND_WORDS = 1024;
+
+    // Every world of a group that is not in use at the end of the last group has its bit clear.
+    const std::uint64_t ALL_LANES = ~(std::uint64_t) 0;
+}
+
+/**
+ * WorldBatch::WorldBatch(count, width, height)
+ *
+ * Construct a batch of worlds with the desired size, all filled with dead cells.
+ *
+ * @example
+ *
+ *      // Make 10000 worlds of 64x64 cells and start each with a glider in a different place
+ *      WorldBatch batch(10000, 64, 64);
+ *      for(unsigned int i = 0; i < batch.get_count(); i++){
+ *          batch.set_state(i, Zoo::glider(), i % 61, (i / 61) % 61);
+ *      }
+ *
+ * @param count
+ *      The number of worlds.
+ *
+ * @param width
+ *      The width of every world.
+ *
+ * @param height
+ *      The height of every world.
+ */
+WorldBatch::WorldBatch(unsigned int count, unsigned int width, unsigned int height):
+        count(count), width(width), height(height), slices((count + 63) / 64),
+        current_state((std::size_t) slices * width * height, 0), next_state((std::size_t) slices * width * height, 0),
+        settled(slices, 0), settled_generations(count, 0){
+}
+
+/**
+ * WorldBatch::get_index(slice, x, y)
+ *
+ * Private helper function to find the word holding cell (x, y) of a group of 64 worlds.
+ */
+std::size_t WorldBatch::get_index(unsigned int slice, unsigned int x, unsigned int y) const{
+    return ((std::size_t) slice * height + y) * width + x;
+}
+
+/**
+ * WorldBatch::check_instance(instance, function)
+ *
+ * Private helper function that throws std::out_of_range if an instance number is not a world of the batch.
+ */
+void WorldBatch::check_instance(unsigned int instance, const char* function) const{
+    if(instance >= count){
+        throw(std::out_of_range("The value inputted for instance in function: WorldBatch::" + std::string(function) +
+                                " is out of bounds."));
+    }
+}
+
+/**
+ * WorldBatch::unsettle(instance)
+ *
+ * Private helper function to mark a world as changed from outside, so it is stepped again.
+ */
+void WorldBatch::unsettle(unsigned int instance){
+    settled[instance / 64] &= ~((std::uint64_t) 1 << (instance % 64));
+}
+
+/**
+ * WorldBatch::get_live_lanes(slice)
+ *
+ * Private helper function to get the bits of a group that hold worlds, all of them except past the last world.
+ */
+std::uint64_t WorldBatch::get_live_lanes(unsigned int slice) const{
+    unsigned int lanes = std::min(64u, count - slice * 64);
+    return lanes == 64 ? ALL_LANES : ((std::uint64_t) 1 << lanes) - 1;
+}
+
+/**
+ * WorldBatch::get_count()
+ *
+ * Gets the number of worlds in the batch.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The number of worlds.
+ */
+unsigned int WorldBatch::get_count() const{
+    return count;
+}
+
+/**
+ * WorldBatch::get_width()
+ *
+ * Gets the width of every world in the batch.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The width of the worlds.
+ */
+unsigned int WorldBatch::get_width() const{
+    return width;
+}
+
+/**
+ * WorldBatch::get_height()
+ *
+ * Gets the height of every world in the batch.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The height of the worlds.
+ */
+unsigned int WorldBatch::get_height() const{
+    return height;
+}
+
+/**
+ * WorldBatch::get(instance, x, y)
+ *
+ * Returns the value of a cell of one world.
+ * The function should be callable from a constant context.
+ *
+ * @param instance
+ *      The world to read from.
+ *
+ * @param x
+ *      The x coordinate of the cell.
+ *
+ * @param y
+ *      The y coordinate of the cell.
+ *
+ * @return
+ *      Cell::ALIVE or Cell::DEAD.
+ *
+ * @throws
+ *      std::out_of_range if the instance or the coordinate is out of bounds.
+ */
+Cell WorldBatch::get(unsigned int instance, unsigned int x, unsigned int y) const{
+    check_instance(instance, "get(instance,x,y)");
+    if(x >= width || y >= height){
+        throw(std::out_of_range("The coordinate inputted in function: WorldBatch::get(instance,x,y) is out of bounds."));
+    }
+    return ((current_state[get_index(instance / 64, x, y)] >> (instance % 64)) & 1) ? Cell::ALIVE : Cell::DEAD;
+}
+
+/**
+ * WorldBatch::set(instance, x, y, value)
+ *
+ * Overwrites the value of a cell of one world. The world is no longer settled.
+ *
+ * @param instance
+ *      The world to write to.
+ *
+ * @param x
+ *      The x coordinate of the cell.
+ *
+ * @param y
+ *      The y coordinate of the cell.
+ *
+ * @param value
+ *      The value to store in the cell.
+ *
+ * @throws
+ *      std::out_of_range if the instance or the coordinate is out of bounds.
+ */
+void WorldBatch::set(unsigned int instance, unsigned int x, unsigned int y, Cell value){
+    check_instance(instance, "set(instance,x,y,value)");
+    if(x >= width || y >= height){
+        throw(std::out_of_range("The coordinate inputted in function: WorldBatch::set(instance,x,y,value) is out of bounds."));
+    }
+    std::uint64_t bit = (std::uint64_t) 1 << (instance % 64);
+    std::uint64_t& word = current_state[get_index(instance / 64, x, y)];
+    word = (value == Cell::ALIVE) ? (word | bit) : (word & ~bit);
+    unsettle(instance);
+}
+
+/**
+ * WorldBatch::get_state(instance)
+ *
+ * Copy the current state of one world out as a Grid, for example to print it or carry on in a World.
+ * The function should be callable from a constant context.
+ *
+ * @param instance
+ *      The world to copy.
+ *
+ * @return
+ *      A grid of the size of the worlds holding the cells of the world.
+ *
+ * @throws
+ *      std::out_of_range if the instance is out of bounds.
+ */
+Grid WorldBatch::get_state(unsigned int instance) const{
+    check_instance(instance, "get_state(instance)");
+    Grid grid(width, height);
+    unsigned int slice = instance / 64, lane = instance % 64;
+    for(unsigned int y = 0; y < height; y++){
+        const std::uint64_t* row = &current_state[get_index(slice, 0, y)];
+        std::uint64_t* packed = grid.get_row(y);
+        for(unsigned int x = 0; x < width; x++){
+            packed[x / 64] |= ((row[x] >> lane) & 1) << (x % 64);
+        }
+    }
+    return grid;
+}
+
+/**
+ * WorldBatch::set_state(instance, pattern, x, y)
+ *
+ * Replace one world with a pattern, with the top left of the pattern at (x, y) and every other cell dead.
+ * The world is no longer settled.
+ *
+ * @example
+ *
+ *      // Start the first world with an R-pentomino in the middle
+ *      WorldBatch batch(64, 32, 32);
+ *      batch.set_state(0, Zoo::r_pentomino(), 14, 14);
+ *
+ * @param instance
+ *      The world to replace.
+ *
+ * @param pattern
+ *      The cells to place in the world.
+ *
+ * @param x
+ *      Optional parameter. The x coordinate of the top left of the pattern. Defaults to 0.
+ *
+ * @param y
+ *      Optional parameter. The y coordinate of the top left of the pattern. Defaults to 0.
+ *
+ * @throws
+ *      std::out_of_range if the instance is out of bounds.
+ *      std::invalid_argument if the pattern does not fit in the world at (x, y).
+ */
+void WorldBatch::set_state(unsigned int instance, const Grid& pattern, unsigned int x, unsigned int y){
+    check_instance(instance, "set_state(instance,pattern,x,y)");
+    if((unsigned long long) x + pattern.get_width() > width || (unsigned long long) y + pattern.get_height() > height){
+        throw(std::invalid_argument("WorldBatch::set_state error: the pattern does not fit in the world."));
+    }
+    unsigned int slice = instance / 64, lane = instance % 64;
+    std::uint64_t bit = (std::uint64_t) 1 << lane;
+    for(unsigned int j = 0; j < height; j++){
+        std::uint64_t* row = &current_state[get_index(slice, 0, j)];
+        for(unsigned int i = 0; i < width; i++){
+            row[i] &= ~bit;
+        }
+    }
+    for(unsigned int j = 0; j < pattern.get_height(); j++){
+        const std::uint64_t* packed = pattern.get_row(j);
+        std::uint64_t* row = &current_state[get_index(slice, x, y + j)];
+        for(unsigned int i = 0; i < pattern.get_width(); i++){
+            row[i] |= ((packed[i / 64] >> (i % 64)) & 1) << lane;
+        }
+    }
+    unsettle(instance);
+}
+
+/**
+ * WorldBatch::get_alive_cells(instance)
+ *
+ * Counts the alive cells of one world.
+ * The function should be callable from a constant context.
+ *
+ * @param instance
+ *      The world to count.
+ *
+ * @return
+ *      The number of alive cells in the world.
+ *
+ * @throws
+ *      std::out_of_range if the instance is out of bounds.
+ */
+unsigned int WorldBatch::get_alive_cells(unsigned int instance) const{
+    check_instance(instance, "get_alive_cells(instance)");
+    unsigned int lane = instance % 64;
+    const std::uint64_t* words = &current_state[get_index(instance / 64, 0, 0)];
+    unsigned int alive = 0;
+    for(std::size_t k = 0; k < (std::size_t) width * height; k++){
+        alive += (unsigned int) ((words[k] >> lane) & 1);
+    }
+    return alive;
+}
+
+/**
+ * WorldBatch::get_alive_cells()
+ *
+ * Counts the alive cells of every world, 64 worlds at a time.
+ * Each group is summed into bit-sliced counters, where bit i of counter word b is bit b of the count of world i,
+ * so adding a word of 64 cells is a ripple of ANDs and XORs that stops as soon as the carry is 0.
+ * The function should be callable from a constant context.
+ *
+ * @example
+ *
+ *      // Find the worlds that died out
+ *      std::vector<unsigned int> alive = batch.get_alive_cells();
+ *      for(unsigned int i = 0; i < batch.get_count(); i++){
+ *          if(alive[i] == 0){
+ *              std::cout << "World " << i << " is extinct." << std::endl;
+ *          }
+ *      }
+ *
+ * @return
+ *      The number of alive cells in each world, indexed by instance.
+ */
+std::vector<unsigned int> WorldBatch::get_alive_cells() const{
+    std::vector<unsigned int> alive(count, 0);
+    for(unsigned int slice = 0; slice < slices; slice++){
+        std::uint64_t counters[33] = {0};
+        const std::uint64_t* words = &current_state[get_index(slice, 0, 0)];
+        for(std::size_t k = 0; k < (std::size_t) width * height; k++){
+            std::uint64_t carry = words[k];
+            for(int b = 0; carry != 0; b++){
+                std::uint64_t next_carry = counters[b] & carry;
+                counters[b] ^= carry;
+                carry = next_carry;
+            }
+        }
+        unsigned int lanes = std::min(64u, count - slice * 64);
+        for(unsigned int lane = 0; lane < lanes; lane++){
+            unsigned int total = 0;
+            for(int b = 0; b < 32; b++){
+                total |= (unsigned int) ((counters[b] >> lane) & 1) << b;
+            }
+            alive[slice * 64 + lane] = total;
+        }
+    }
+    return alive;
+}
+
+/**
+ * WorldBatch::is_settled(instance)
+ *
+ * Check whether a world has stopped changing: the last step it was stepped by left it as it was, so it
+ * is a still life or extinct and will never change again.
+ * The function should be callable from a constant context.
+ *
+ * @param instance
+ *      The world to check.
+ *
+ * @return
+ *      True if the world is settled.
+ *
+ * @throws
+ *      std::out_of_range if the instance is out of bounds.
+ */
+bool WorldBatch::is_settled(unsigned int instance) const{
+    check_instance(instance, "is_settled(instance)");
+    return (settled[instance / 64] >> (instance % 64)) & 1;
+}
+
+/**
+ * WorldBatch::get_settled_generation(instance)
+ *
+ * Gets the first generation of the final state of a settled world.
+ * The function should be callable from a constant context.
+ *
+ * @param instance
+ *      The world to check.
+ *
+ * @return
+ *      The generation the world reached its final state at, or the current generation if it has not settled.
+ *
+ * @throws
+ *      std::out_of_range if the instance is out of bounds.
+ */
+std::uint64_t WorldBatch::get_settled_generation(unsigned int instance) const{
+    return is_settled(instance) ? settled_generations[instance] : generation;
+}
+
+/**
+ * WorldBatch::get_settled_count()
+ *
+ * Counts the worlds that have stopped changing.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The number of settled worlds, get_count() once every world has settled.
+ */
+unsigned int WorldBatch::get_settled_count() const{
+    unsigned int total = 0;
+    for(std::uint64_t lanes : settled){
+        total += (unsigned int) __builtin_popcountll(lanes);
+    }
+    return total;
+}
+
+/**
+ * WorldBatch::get_kernel()
+ *
+ * Gets the instruction set of the kernel used to step the worlds.
+ * Batches start with the widest kernel the CPU supports, picked by Kernel::detect_isa().
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The instruction set of the selected kernel.
+ */
+Kernel::Isa WorldBatch::get_kernel() const{
+    return kernel;
+}
+
+/**
+ * WorldBatch::set_kernel(isa)
+ *
+ * Override the kernel used to step the worlds. Every kernel produces identical results.
+ *
+ * @param isa
+ *      The instruction set of the kernel to use.
+ *
+ * @throws
+ *      std::invalid_argument if the kernel is not supported by this CPU or was not compiled into this binary.
+ */
+void WorldBatch::set_kernel(Kernel::Isa isa){
+    if(!Kernel::is_supported(isa)){
+        throw(std::invalid_argument("WorldBatch::set_kernel error: the " + std::string(Kernel::get_isa_name(isa)) +
+                                    " kernel is not supported on this machine."));
+    }
+    kernel = isa;
+}
+
+/**
+ * WorldBatch::get_rule()
+ *
+ * Gets the rule every world is stepped with, Conway's Game of Life "B3/S23" unless set_rule was called.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The rule of the batch.
+ */
+const Rule& WorldBatch::get_rule() const{
+    return rule;
+}
+
+/**
+ * WorldBatch::set_rule(new_rule)
+ *
+ * Change the rule used by the following steps. The current states are kept, but no world is settled
+ * any more, since a world stable under the old rule may not be under the new one.
+ *
+ * @param new_rule
+ *      The rule to step with.
+ */
+void WorldBatch::set_rule(const Rule& new_rule){
+    if(new_rule != rule){
+        rule = new_rule;
+        std::fill(settled.begin(), settled.end(), 0);
+    }
+}
+
+/**
+ * WorldBatch::get_threads()
+ *
+ * Gets the number of threads used to step the worlds, including the calling thread.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The number of threads, 1 if the batch steps serially.
+ */
+unsigned int WorldBatch::get_threads() const{
+    return pool ? pool->get_threads() : 1;
+}
+
+/**
+ * WorldBatch::set_threads(threads)
+ *
+ * Set the number of threads used to step the worlds.
+ * The worker threads are started once here and reused by every step.
+ *
+ * @param threads
+ *      The number of threads to use. 1 steps serially on the calling thread,
+ *      0 uses one thread per hardware thread of the machine.
+ */
+void WorldBatch::set_threads(unsigned int threads){
+    if(threads == 0){
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if(threads == get_threads()){
+        return;
+    }
+    pool = (threads > 1) ? std::make_shared<ThreadPool>(threads) : nullptr;
+}
+
+/**
+ * WorldBatch::get_generation()
+ *
+ * Gets the number of steps taken since the batch was constructed.
+ * The function should be callable from a constant context.
+ *
+ * @return
+ *      The current generation.
+ */
+std::uint64_t WorldBatch::get_generation() const{
+    return generation;
+}
+
+/**
+ * WorldBatch::step(toroidal)
+ *
+ * Take one step of every world that has not settled, 64 worlds per word operation.
+ *
+ * The rows of every group with a world still running are split into bands, which are stepped in parallel
+ * on the thread pool. Groups where every world has settled hold the same cells in both buffers, so they are
+ * skipped without copying. Then the buffers are swapped, without a copy.
+ *
+ * @param toroidal
+ *      Optional parameter. If true then every world is a torus, where the left edge wraps to the right edge
+ *      and the top to the bottom. Defaults to false.
+ */
+void WorldBatch::step(bool toroidal){
+    // A world that is stable on a bounded grid may not be on a torus, and vice versa.
+    if(toroidal != last_toroidal){
+        std::fill(settled.begin(), settled.end(), 0);
+        last_toroidal = toroidal;
+    }
+
+    std::vector<unsigned int> running;
+    for(unsigned int slice = 0; slice < slices; slice++){
+        if((settled[slice] | ~get_live_lanes(slice)) != ALL_LANES){
+            running.push_back(slice);
+        }
+    }
+
+    std::size_t rows = running.size() * height;
+    std::vector<std::uint64_t> changes(rows, 0);
+    std::vector<std::uint64_t> dead_row(width, 0);
+    unsigned int bands = (unsigned int) std::min<std::size_t>(get_threads(), rows * width / MIN_BAND_WORDS);
+    bands = std::max(1u, bands);
+    auto step_band = [&](unsigned int band){
+        std::size_t r0 = rows * band / bands;
+        std::size_t r1 = rows * (band + 1) / bands;
+        for(std::size_t r = r0; r < r1; r++){
+            unsigned int slice = running[r / height];
+            unsigned int y = (unsigned int) (r % height);
+            const std::uint64_t* above;
+            const std::uint64_t* below;
+            if(toroidal){
+                above = &current_state[get_index(slice, 0, (y + height - 1) % height)];
+                below = &current_state[get_index(slice, 0, (y + 1) % height)];
+            } else{
+                above = (y > 0) ? &current_state[get_index(slice, 0, y - 1)] : dead_row.data();
+                below = (y + 1 < height) ? &current_state[get_index(slice, 0, y + 1)] : dead_row.data();
+            }
+            changes[r] = Kernel::step_sliced_row(above, &current_state[get_index(slice, 0, y)], below,
+                                                 &next_state[get_index(slice, 0, y)], width, toroidal, rule, kernel);
+        }
+    };
+    if(bands <= 1){
+        step_band(0);
+    } else{
+        pool->run(bands, step_band);
+    }
+
+    // Worlds that did not change in this step settled at the generation before it.
+    for(std::size_t i = 0; i < running.size(); i++){
+        unsigned int slice = running[i];
+        std::uint64_t changed = 0;
+        for(unsigned int y = 0; y < height; y++){
+            changed |= changes[i * height + y];
+        }
+        std::uint64_t newly_settled = ~changed & ~settled[slice] & get_live_lanes(slice);
+        for(std::uint64_t lanes = newly_settled; lanes != 0; lanes &= lanes - 1){
+            settled_generations[slice * 64 + (unsigned int) __builtin_ctzll(lanes)] = generation;
+        }
+        settled[slice] |= newly_settled;
+    }
+    generation++;
+    std::swap(next_state, current_state);
+}
+
+/**
+ * WorldBatch::advance(steps, toroidal)
+ *
+ * Advance every world multiple steps.
+ * Implemented by invoking WorldBatch::step(toroidal), and stops early once every world has settled.
+ *
+ * @param steps
+ *      The number of steps to advance the worlds forward.
+ *
+ * @param toroidal
+ *      Optional parameter. If true then every world is a torus, where the left edge wraps to the right edge
+ *      and the top to the bottom. Defaults to false.
+ */
+void WorldBatch::advance(unsigned int steps, bool toroidal){
+    for(unsigned int i = 0; i < steps; i++){
+        if(get_settled_count() == count && toroidal == last_toroidal){
+            generation += steps - i;
+            return;
+        }
+        step(toroidal);
+    }
+}
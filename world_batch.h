@@ -0,0 +1,67 @@
+/**
+ * Declares a class for simulating many small, equally sized worlds together.
+ * Rich documentation for the api and behaviour the WorldBatch class can be found in world_batch.cpp.
+ *
+ * @author 957552
+ * @date March, 2020
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "grid.h"
+#include "kernel.h"
+#include "rule.h"
+#include "thread_pool.h"
+
+/**
+ * Declare the structure of the WorldBatch class for stepping many independent worlds at once.
+ *
+ * A WorldBatch stores its worlds bit-sliced in groups of 64: word x of a row holds cell x of that row in each
+ * world of the group, so one word operation steps one cell of 64 worlds.
+ */
+class WorldBatch {
+private:
+    unsigned int count;
+    unsigned int width;
+    unsigned int height;
+    unsigned int slices;
+    std::vector<std::uint64_t> current_state;
+    std::vector<std::uint64_t> next_state;
+    std::vector<std::uint64_t> settled;
+    std::vector<std::uint64_t> settled_generations;
+    Kernel::Isa kernel = Kernel::detect_isa();
+    Rule rule;
+    std::shared_ptr<ThreadPool> pool;
+    bool last_toroidal = false;
+    std::uint64_t generation = 0;
+
+    std::size_t get_index(unsigned int slice, unsigned int x, unsigned int y) const;
+    void check_instance(unsigned int instance, const char* function) const;
+    void unsettle(unsigned int instance);
+    std::uint64_t get_live_lanes(unsigned int slice) const;
+public:
+    WorldBatch(unsigned int count, unsigned int width, unsigned int height);
+    unsigned int get_count() const;
+    unsigned int get_width() const;
+    unsigned int get_height() const;
+    Cell get(unsigned int instance, unsigned int x, unsigned int y) const;
+    void set(unsigned int instance, unsigned int x, unsigned int y, Cell value);
+    Grid get_state(unsigned int instance) const;
+    void set_state(unsigned int instance, const Grid& pattern, unsigned int x = 0, unsigned int y = 0);
+    unsigned int get_alive_cells(unsigned int instance) const;
+    std::vector<unsigned int> get_alive_cells() const;
+    bool is_settled(unsigned int instance) const;
+    std::uint64_t get_settled_generation(unsigned int instance) const;
+    unsigned int get_settled_count() const;
+    Kernel::Isa get_kernel() const;
+    void set_kernel(Kernel::Isa isa);
+    const Rule& get_rule() const;
+    void set_rule(const Rule& new_rule);
+    unsigned int get_threads() const;
+    void set_threads(unsigned int threads);
+    std::uint64_t get_generation() const;
+    void step(bool toroidal = false);
+    void advance(unsigned int steps, bool toroidal = false);
+};
@@ -18,16 +18,584 @@
  *                padded with zero or more 0 bits.
  *              - a 0 bit should be considered Cell::DEAD, a 1 bit should be considered Cell::ALIVE.
  *
+ *      - Patterns can be loaded from and saved to the RLE format used by most published pattern collections.
+ *          - https://conwaylife.com/wiki/Run_Length_Encoded
+ *          - RLE files are composed of:
+ *              - zero or more comment lines starting with (hash) '#'.
+ *              - a header line "x = (width), y = (height)", optionally followed by ", rule = (rule)".
+ *              - runs of cells, each an optional count followed by a tag: 'b' is Cell::DEAD, 'o' is Cell::ALIVE,
+ *                and '$' ends a row. Whitespace between runs is ignored and '!' ends the pattern.
+ *          - Files are parsed straight from a MappedFile into a Grid, a SparseWorld or a HashLife universe,
+ *            so a huge, mostly empty pattern never needs a dense copy.
+ *
+ *      - HashLife universes can be loaded from and saved to Golly's Macrocell format.
+ *          - https://conwaylife.com/wiki/Macrocell
+ *          - Macrocell files are composed of:
+ *              - a first line starting with "[M2]".
+ *              - optional lines "#R (rule)" and "#G (generation)", and other comment lines starting with '#'.
+ *              - one line per node, numbered from 1. A line of '.', '*' and '$' is an 8x8 leaf, written as RLE
+ *                with '.' for Cell::DEAD, '*' for Cell::ALIVE and '$' ending each row. Any other node is a line
+ *                "(level) (nw) (ne) (sw) (se)" naming its four children, where 0 is an empty child.
+ *              - the last node is the whole universe, centred on the cell (0, 0).
+ *          - The quadtree is read into, and written from, HashLife nodes directly.
+ *
+ *      - Unless built with GOL_WITH_STATS=0, the size of every file loaded or saved and the time it took are added
+ *        to totals shared by every thread, which are read with Zoo::get_io_stats.
+ *
  * @author 957552
  * @date March, 2020
  */
 #include <fstream>
 #include <iostream>
 #include <algorithm>
-#include <bitset>
-#include <cmath>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <climits>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include "mapped_file.h"
 #include "zoo.h"
 
+namespace {
+    std::atomic<std::uint64_t> files_loaded(0);
+    std::atomic<std::uint64_t> bytes_loaded(0);
+    std::atomic<std::uint64_t> load_nanoseconds(0);
+    std::atomic<std::uint64_t> files_saved(0);
+    std::atomic<std::uint64_t> bytes_saved(0);
+    std::atomic<std::uint64_t> save_nanoseconds(0);
+
+    /**
+     * Times a load or save from its construction to the end of the function it was made in, and adds the file and
+     * the time to the totals if the function returned normally. Streams made after it are closed first, so the
+     * size of a saved file is its final size.
+     */
+    class IoTimer {
+    private:
+        std::string path;
+        bool saving;
+        int exceptions;
+        Stats::Clock::time_point start;
+    public:
+        IoTimer(const std::string& path, bool saving): path(path), saving(saving),
+                                                       exceptions(std::uncaught_exceptions()),
+                                                       start(Stats::Clock::now()){
+        }
+
+        ~IoTimer(){
+            if(std::uncaught_exceptions() > exceptions){
+                return;
+            }
+            std::uint64_t nanoseconds = (std::uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    Stats::Clock::now() - start).count();
+            std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+            std::uint64_t bytes = file ? (std::uint64_t) file.tellg() : 0;
+            (saving ? files_saved : files_loaded) += 1;
+            (saving ? bytes_saved : bytes_loaded) += bytes;
+            (saving ? save_nanoseconds : load_nanoseconds) += nanoseconds;
+        }
+    };
+
+    /**
+     * is_little_endian()
+     *
+     * Check whether words are stored least significant byte first, in which case a row of whole bytes
+     * in a binary file has the same layout in memory as the words of a grid row.
+     */
+    bool is_little_endian(){
+        std::uint16_t word = 1;
+        unsigned char first;
+        std::memcpy(&first, &word, 1);
+        return first == 1;
+    }
+
+    // One copy of a byte in every byte of a word.
+    const std::uint64_t EVERY_BYTE = 0x0101010101010101ULL;
+
+    /**
+     * match_bytes(word, value)
+     *
+     * Compare the 8 bytes of a word with a byte value at once, setting the high bit of each byte that matches.
+     * Adding 0x7F to the low 7 bits of a byte only reaches its high bit when they are not all 0, so no
+     * carries cross between bytes and the result is exact.
+     */
+    std::uint64_t match_bytes(std::uint64_t word, unsigned char value){
+        std::uint64_t difference = word ^ (EVERY_BYTE * value);
+        return ~(((difference & (EVERY_BYTE * 0x7F)) + EVERY_BYTE * 0x7F) | difference | (EVERY_BYTE * 0x7F));
+    }
+
+    /**
+     * parse_row(characters, width, row)
+     *
+     * Classify the characters of one row of an ascii file 8 at a time, packing the Cell::ALIVE characters into
+     * the words of a grid row, which must start with every cell dead.
+     *
+     * @return
+     *      False if any character is not the ALIVE or DEAD character.
+     */
+    bool parse_row(const unsigned char* characters, int width, std::uint64_t* row){
+        int i = 0;
+        for(; i + 8 <= width; i += 8){
+            std::uint64_t word;
+            std::memcpy(&word, characters + i, 8);
+            std::uint64_t alive = match_bytes(word, (unsigned char) ALIVE);
+            std::uint64_t dead = match_bytes(word, (unsigned char) DEAD);
+            if((alive | dead) != EVERY_BYTE * 0x80){
+                return false;
+            }
+            // Gather the flag of byte b into bit b, whichever order the bytes were loaded in.
+            std::uint64_t flags = alive >> 7;
+            if(!is_little_endian()){
+                flags = __builtin_bswap64(flags);
+            }
+            std::uint64_t bits = (flags * 0x0102040810204080ULL) >> 56;
+            row[i / 64] |= bits << (i % 64);
+        }
+        for(; i < width; i++){
+            if(characters[i] == (unsigned char) ALIVE){
+                row[i / 64] |= (std::uint64_t)1 << (i % 64);
+            } else if(characters[i] != (unsigned char) DEAD){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * parse_int(characters, size, position, value)
+     *
+     * Read an integer in the same way as std::istream::operator>>, skipping leading whitespace and
+     * accepting an optional sign.
+     *
+     * @return
+     *      False if there is no integer at the position or it does not fit in an int.
+     */
+    bool parse_int(const unsigned char* characters, std::size_t size, std::size_t& position, int& value){
+        while(position < size && std::isspace(characters[position])){
+            position++;
+        }
+        bool negative = false;
+        if(position < size && (characters[position] == '+' || characters[position] == '-')){
+            negative = characters[position++] == '-';
+        }
+        if(position >= size || !std::isdigit(characters[position])){
+            return false;
+        }
+        long long magnitude = 0;
+        while(position < size && std::isdigit(characters[position])){
+            magnitude = magnitude * 10 + (characters[position++] - '0');
+            if(magnitude > 2147483648LL){
+                return false;
+            }
+        }
+        magnitude = negative ? -magnitude : magnitude;
+        if(magnitude > 2147483647LL){
+            return false;
+        }
+        value = (int) magnitude;
+        return true;
+    }
+
+    /**
+     * read_bits(bits, bytes, position)
+     *
+     * Read the 64 bits of a bit stream starting at a bit position, with bits past the end read as 0.
+     */
+    std::uint64_t read_bits(const unsigned char* bits, std::size_t bytes, std::uint64_t position){
+        std::size_t byte = (std::size_t) (position / 8);
+        unsigned int shift = (unsigned int) (position % 8);
+        std::uint64_t word = 0;
+        for(unsigned int b = 0; b < 8 && byte + b < bytes; b++){
+            word |= (std::uint64_t) bits[byte + b] << (8 * b);
+        }
+        word >>= shift;
+        if(shift != 0 && byte + 8 < bytes){
+            word |= (std::uint64_t) bits[byte + 8] << (64 - shift);
+        }
+        return word;
+    }
+
+    /**
+     * or_bits(bits, bytes, position, word)
+     *
+     * OR the 64 bits of a word into a bit stream starting at a bit position, dropping bits past the end.
+     */
+    void or_bits(unsigned char* bits, std::size_t bytes, std::uint64_t position, std::uint64_t word){
+        std::size_t byte = (std::size_t) (position / 8);
+        unsigned int shift = (unsigned int) (position % 8);
+        for(unsigned int b = 0; b < 8 && byte + b < bytes; b++){
+            bits[byte + b] |= (unsigned char) ((word << shift) >> (8 * b));
+        }
+        if(shift != 0 && byte + 8 < bytes){
+            bits[byte + 8] |= (unsigned char) (word >> (64 - shift));
+        }
+    }
+
+    /**
+     * parse_count(characters, size, position, value)
+     *
+     * Read an unsigned decimal number, skipping leading whitespace.
+     *
+     * @return
+     *      False if there is no number at the position or it has more than 18 digits.
+     */
+    bool parse_count(const unsigned char* characters, std::size_t size, std::size_t& position, long long& value){
+        while(position < size && std::isspace(characters[position])){
+            position++;
+        }
+        if(position >= size || !std::isdigit(characters[position])){
+            return false;
+        }
+        value = 0;
+        for(int digits = 0; position < size && std::isdigit(characters[position]); digits++){
+            if(digits == 18){
+                return false;
+            }
+            value = value * 10 + (characters[position++] - '0');
+        }
+        return true;
+    }
+
+    /**
+     * end_of_line(characters, size, position)
+     *
+     * Find the newline that ends the line containing a position, or the end of the characters if there is none.
+     */
+    std::size_t end_of_line(const unsigned char* characters, std::size_t size, std::size_t position){
+        const void* newline = (position < size) ? std::memchr(characters + position, '\n', size - position) : nullptr;
+        return newline ? (std::size_t) ((const unsigned char*) newline - characters) : size;
+    }
+
+    /**
+     * fill_run(row, x, length)
+     *
+     * Set a run of cells in a packed row, a word at a time.
+     */
+    void fill_run(std::uint64_t* row, std::uint64_t x, std::uint64_t length){
+        std::uint64_t end = x + length;
+        while(x < end){
+            unsigned int shift = (unsigned int) (x % 64);
+            std::uint64_t bits = std::min<std::uint64_t>(64 - shift, end - x);
+            row[x / 64] |= ((bits == 64) ? ~(std::uint64_t) 0 : ((std::uint64_t) 1 << bits) - 1) << shift;
+            x += bits;
+        }
+    }
+
+    /**
+     * find_bit(row, width, x, value)
+     *
+     * Find the first column from x of a packed row whose cell matches value, or width if there is none.
+     */
+    unsigned int find_bit(const std::uint64_t* row, unsigned int width, unsigned int x, bool value){
+        while(x < width){
+            std::uint64_t word = (value ? row[x / 64] : ~row[x / 64]) >> (x % 64);
+            if(word != 0){
+                return std::min(width, x + (unsigned int) __builtin_ctzll(word));
+            }
+            x += 64 - x % 64;
+        }
+        return width;
+    }
+
+    /**
+     * read_rle(path, header_read, alive_run)
+     *
+     * Parse an RLE file, passing its header to header_read and then each run of alive cells, as its first
+     * cell and length, to alive_run in row order. The body is skipped when alive_run is empty.
+     *
+     * @throws
+     *      Throws std::runtime_error or sub-class if:
+     *          - The file cannot be opened.
+     *          - The header line is missing or malformed.
+     *          - The file contains a tag other than 'b', 'o', '$' and '!'.
+     *          - An alive cell lies outside the width and height given by the header.
+     */
+    Zoo::RleHeader read_rle(const std::string& path, const std::function<void(const Zoo::RleHeader&)>& header_read,
+                            const std::function<void(long long, long long, long long)>& alive_run){
+        MappedFile file(path);
+        if(!file){
+            throw(std::runtime_error("The path given to function: Zoo::load_rle is incorrect."));
+        }
+        const unsigned char* data = file.get_data();
+        std::size_t size = file.get_size();
+        std::size_t position = 0;
+        while(true){
+            while(position < size && std::isspace(data[position])){
+                position++;
+            }
+            if(position >= size || data[position] != '#'){
+                break;
+            }
+            position = end_of_line(data, size, position);
+        }
+
+        // The header line is a list of "key = value" pairs separated by commas.
+        Zoo::RleHeader header = {-1, -1, "B3/S23"};
+        std::size_t end = end_of_line(data, size, position);
+        while(position < end){
+            std::size_t key = position;
+            while(position < end && std::isalpha(data[position])){
+                position++;
+            }
+            std::string name((const char*) data + key, position - key);
+            while(position < end && std::isspace(data[position])){
+                position++;
+            }
+            if(name.empty() || position >= end || data[position++] != '='){
+                throw(std::runtime_error("The file: '" + path + "' does not have a valid RLE header line."));
+            }
+            if(name == "x" || name == "y"){
+                long long& value = (name == "x") ? header.width : header.height;
+                if(!parse_count(data, end, position, value)){
+                    throw(std::runtime_error("The file: '" + path + "' does not have a valid RLE header line."));
+                }
+            }
+            std::size_t value = position;
+            while(position < end && data[position] != ','){
+                position++;
+            }
+            if(name == "rule"){
+                std::string rule((const char*) data + value, position - value);
+                rule.erase(0, rule.find_first_not_of(" \t\r"));
+                rule.erase(rule.find_last_not_of(" \t\r") + 1);
+                header.rule = rule;
+            }
+            position++;
+            while(position < end && std::isspace(data[position])){
+                position++;
+            }
+        }
+        if(header.width < 0 || header.height < 0){
+            throw(std::runtime_error("The file: '" + path + "' does not have a valid RLE header line."));
+        }
+        if(header_read){
+            header_read(header);
+        }
+        if(!alive_run){
+            return header;
+        }
+
+        long long x = 0;
+        long long y = 0;
+        long long count = 0;
+        for(position = end; position < size; position++){
+            unsigned char character = data[position];
+            if(std::isdigit(character)){
+                if(count >= 100000000000000LL){
+                    throw(std::runtime_error("The file: '" + path + "' has a run longer than any pattern."));
+                }
+                count = count * 10 + (character - '0');
+                continue;
+            }
+            if(std::isspace(character)){
+                continue;
+            }
+            long long length = (count == 0) ? 1 : count;
+            count = 0;
+            if(character == 'b'){
+                x = std::min(x + length, header.width);
+            } else if(character == 'o'){
+                if(y >= header.height || length > header.width - x){
+                    throw(std::runtime_error("The file: '" + path + "' has cells outside the size in its header."));
+                }
+                alive_run(x, y, length);
+                x += length;
+            } else if(character == '$'){
+                x = 0;
+                y = std::min(y + length, header.height);
+            } else if(character == '!'){
+                break;
+            } else{
+                throw(std::runtime_error("The file: '" + path + "' contains the unknown RLE tag '" +
+                                         std::string(1, (char) character) + "'."));
+            }
+        }
+        return header;
+    }
+
+    /**
+     * RleLine
+     *
+     * Collects the runs of an RLE body into lines of at most 70 characters, as the format recommends.
+     */
+    struct RleLine {
+        std::ofstream& file;
+        std::string line;
+
+        void write(std::uint64_t count, char tag){
+            if(count == 0){
+                return;
+            }
+            std::string run = (count > 1) ? std::to_string(count) + tag : std::string(1, tag);
+            if(line.size() + run.size() > 70){
+                file << line << "\n";
+                line.clear();
+            }
+            line += run;
+        }
+    };
+
+    /**
+     * MacrocellWriter
+     *
+     * Numbers and writes the nodes of a HashLife universe for Zoo::save_macrocell. Each distinct line is written
+     * once, children before parents, and its number is remembered for the lines that refer to it.
+     */
+    struct MacrocellWriter {
+        const HashLife& life;
+        std::ofstream& file;
+        unsigned int alignment;
+        long long bounds[4];
+        std::unordered_map<HashLife::NodeId, std::uint64_t> written;
+        std::unordered_map<std::string, std::uint64_t> lines;
+
+        /**
+         * add_line(line)
+         *
+         * Write a node line unless it has already been written, returning its number.
+         */
+        std::uint64_t add_line(const std::string& line){
+            auto found = lines.find(line);
+            if(found != lines.end()){
+                return found->second;
+            }
+            std::uint64_t number = lines.size() + 1;
+            lines.emplace(line, number);
+            file << line << "\n";
+            return number;
+        }
+
+        /**
+         * add_leaf(rows)
+         *
+         * Write an 8x8 leaf, where bit x of rows[y] is the cell at (x, y), returning its number, or 0 if it is empty.
+         * Trailing dead cells and rows are left out.
+         */
+        std::uint64_t add_leaf(const unsigned char rows[8]){
+            std::string line;
+            int last = 7;
+            while(last >= 0 && rows[last] == 0){
+                last--;
+            }
+            if(last < 0){
+                return 0;
+            }
+            for(int y = 0; y <= last; y++){
+                for(int x = 0; x < 8 && (rows[y] >> x) != 0; x++){
+                    line += ((rows[y] >> x) & 1) ? '*' : '.';
+                }
+                line += '$';
+            }
+            return add_line(line);
+        }
+
+        /**
+         * get_rows(node, x, y, rows)
+         *
+         * OR the alive cells of a node of level 3 or less, with its top left at (x, y) of an 8x8 leaf, into rows.
+         */
+        void get_rows(HashLife::NodeId node, int x, int y, unsigned char rows[8]) const{
+            const HashLife::Node& n = life.get_node(node);
+            if(n.population == 0){
+                return;
+            }
+            if(n.level == 0){
+                rows[y] |= (unsigned char) (1 << x);
+                return;
+            }
+            int half = 1 << (n.level - 1);
+            get_rows(n.nw, x, y, rows);
+            get_rows(n.ne, x + half, y, rows);
+            get_rows(n.sw, x, y + half, rows);
+            get_rows(n.se, x + half, y + half, rows);
+        }
+
+        /**
+         * write_node(node)
+         *
+         * Write a node of level 3 or more and everything below it, returning its number, or 0 if it is empty.
+         */
+        std::uint64_t write_node(HashLife::NodeId node){
+            const HashLife::Node& n = life.get_node(node);
+            if(n.population == 0){
+                return 0;
+            }
+            auto found = written.find(node);
+            if(found != written.end()){
+                return found->second;
+            }
+            std::uint64_t number;
+            if(n.level == 3){
+                unsigned char rows[8] = {0};
+                get_rows(node, 0, 0, rows);
+                number = add_leaf(rows);
+            } else{
+                std::string line = std::to_string(n.level);
+                for(HashLife::NodeId child : {n.nw, n.ne, n.sw, n.se}){
+                    line += " " + std::to_string(write_node(child));
+                }
+                number = add_line(line);
+            }
+            written.emplace(node, number);
+            return number;
+        }
+
+        /**
+         * write_square(level, x, y)
+         *
+         * Write the square of the plane of the given level with its top left at (x, y), returning its number,
+         * or 0 if it is empty. Squares at the alignment level line up with nodes of the universe, which are
+         * written as they are. If even 8x8 leaves do not line up, leaves are read a cell at a time.
+         */
+        std::uint64_t write_square(unsigned int level, long long x, long long y){
+            long long size = 1LL << level;
+            if(x >= bounds[2] || y >= bounds[3] || x + size <= bounds[0] || y + size <= bounds[1]){
+                return 0;
+            }
+            if(level == alignment){
+                HashLife::NodeId node = life.get_root();
+                long long node_x = life.get_origin_x();
+                long long node_y = life.get_origin_y();
+                while(life.get_node(node).level > level){
+                    const HashLife::Node& n = life.get_node(node);
+                    long long half = 1LL << (n.level - 1);
+                    bool east = x - node_x >= half;
+                    bool south = y - node_y >= half;
+                    node = south ? (east ? n.se : n.sw) : (east ? n.ne : n.nw);
+                    node_x += east ? half : 0;
+                    node_y += south ? half : 0;
+                }
+                return write_node(node);
+            }
+            if(level == 3){
+                unsigned char rows[8] = {0};
+                for(int j = 0; j < 8; j++){
+                    for(int i = 0; i < 8; i++){
+                        rows[j] |= (unsigned char) ((life.get(x + i, y + j) == ALIVE) << i);
+                    }
+                }
+                return add_leaf(rows);
+            }
+            long long half = size / 2;
+            std::uint64_t children[4] = {write_square(level - 1, x, y), write_square(level - 1, x + half, y),
+                                         write_square(level - 1, x, y + half),
+                                         write_square(level - 1, x + half, y + half)};
+            if((children[0] | children[1] | children[2] | children[3]) == 0){
+                return 0;
+            }
+            std::string line = std::to_string(level);
+            for(std::uint64_t child : children){
+                line += " " + std::to_string(child);
+            }
+            return add_line(line);
+        }
+    };
+}
+
 // Include the minimal number of headers needed to support your implementation.
 // #include ...
 
@@ -130,7 +698,8 @@ Grid Zoo::light_weight_spaceship(){
  * Zoo::load_ascii(path)
  *
  * Load an ascii file and parse it as a grid of cells.
- * Should be implemented using std::ifstream.
+ * The whole file is memory mapped with MappedFile, and each row is classified 8 characters at a time
+ * straight into the packed words of the grid.
  *
  * @example
  *
@@ -151,41 +720,33 @@ Grid Zoo::light_weight_spaceship(){
  *          - The character for a cell is not the ALIVE or DEAD character.
  */
 Grid Zoo::load_ascii(const std::string& path){
-    std::ifstream file(path);
+    GOL_STATS(IoTimer timer(path, false);)
+    MappedFile file(path);
     if(file){
+        const unsigned char* data = file.get_data();
+        std::size_t size = file.get_size();
+        std::size_t position = 0;
         int width;
         int height;
-        char buffer;
-        Grid new_grid;
-        file >> width;
-        file >> height;
-        if(width > 0 || height > 0){
-            new_grid = Grid(width,height);
-            for(int j=0; j<height; j++){
-                file.get(buffer);
-                if(buffer == '\n'){
-                    for(int i=0; i<width; i++){
-                        file.get(buffer);
-                        if(buffer == ALIVE){
-                            new_grid.set(i, j, ALIVE);
-                        } else if(buffer == DEAD){
-                            new_grid.set(i, j, DEAD);
-                        } else{
-                            throw(std::runtime_error("The character for a cell is not the ALIVE or DEAD character."));
-                        }
-                    }
-                } else{
-                    throw(std::runtime_error("Newline characters are not found when expected during parsing."));
-                }
-            }
-        } else{
+        if(!parse_int(data, size, position, width) || !parse_int(data, size, position, height) ||
+           width < 0 || height < 0 || (width == 0 && height == 0)){
             throw(std::runtime_error("The parsed width or height is not a positive integer."));
         }
 
-        file.close();
+        Grid new_grid(width, height);
+        for(int j=0; j<height; j++){
+            // Each row starts after the newline that ends the line before it.
+            if(position >= size || data[position] != '\n'){
+                throw(std::runtime_error("Newline characters are not found when expected during parsing."));
+            }
+            position++;
+            if(size - position < (std::size_t) width || !parse_row(data + position, width, new_grid.get_row(j))){
+                throw(std::runtime_error("The character for a cell is not the ALIVE or DEAD character."));
+            }
+            position += width;
+        }
         return new_grid;
     } else{
-        file.close();
         throw(std::runtime_error("The file cannot be opened."));
     }
 }
@@ -194,7 +755,8 @@ Grid Zoo::load_ascii(const std::string& path){
  * Zoo::save_ascii(path, grid)
  *
  * Save a grid as an ascii .gol file according to the specified file format.
- * Should be implemented using std::ofstream.
+ * Each row is expanded from the packed words of the grid 8 cells at a time into a buffer,
+ * which is written with one call.
  *
  * @example
  *
@@ -219,18 +781,14 @@ Grid Zoo::load_ascii(const std::string& path){
  *      Throws std::runtime_error or sub-class if the file cannot be opened.
  */
 void Zoo::save_ascii(const std::string& path, const Grid& grid){
+    GOL_STATS(IoTimer timer(path, true);)
     std::ofstream file(path);
     if(file){
         file << grid.get_width() << " " << grid.get_height() << "\n";
+        std::string line(grid.get_width() + 1, '\n');
         for(unsigned int j = 0; j<grid.get_height(); j++){
-            for(unsigned int i = 0; i<grid.get_width(); i++){
-                if(grid.get((int)i,(int)j) == DEAD){
-                    file << (char) DEAD;
-                } else if (grid.get((int)i,(int)j) == ALIVE){
-                    file << (char) ALIVE;
-                }
-            }
-            file << "\n";
+            grid.format_row(j, &line[0]);
+            file.write(line.data(), (std::streamsize)line.size());
         }
     } else{
         throw(std::runtime_error("The path given to function: Zoo::save_ascii is incorrect."));
@@ -242,7 +800,8 @@ void Zoo::save_ascii(const std::string& path, const Grid& grid){
  * Zoo::load_binary(path)
  *
  * Load a binary file and parse it as a grid of cells.
- * Should be implemented using std::ifstream.
+ * The file is memory mapped with MappedFile and unpacked in one pass, a word of cells at a time.
+ * Rows whose width is a multiple of 64 are copied straight into the grid.
  *
  * @example
  *
@@ -259,56 +818,51 @@ void Zoo::save_ascii(const std::string& path, const Grid& grid){
  *      Throws std::runtime_error or sub-class if:
  *          - The file cannot be opened.
  *          - The file ends unexpectedly.
+ *          - The width or height is negative.
  */
 Grid Zoo::load_binary(const std::string& path){
-    std::ifstream file(path, std::ios::in | std::ios::binary);
+    GOL_STATS(IoTimer timer(path, false);)
+    MappedFile file(path);
     if(file){
+        const unsigned char* data = file.get_data();
         int width;
         int height;
-        Grid new_grid;
-
-        file.read((char*)& width, sizeof width);
-        file.read((char*)& height, sizeof height);
-        new_grid = Grid(width,height);
-
-        // he equation below calculates height * width + bits needed to get to the nearest byte.
-        int* bits = new int[(int)(ceil(((double)height*(double)width/8)))*8];
-        char c;
-        int count = 0;
-        for (int j = 0; file.get(c); j++){
-            for (int i = 0; i < 8; i++){
-                //bitshift operator to read bit by bit since c++ smallest operator type is 1 Byte.
-                if((c >> i & 1) == 0 && count < (ceil(((double)height*(double)width/8)))*8){
-                    bits[j*8+i] = 0;
-                }
-                if((c >> i & 1) == 1 && count < (ceil(((double)height*(double)width/8)))*8){
-                    bits[j*8+i] = 1;
-                }
-                count++;
-            }
+        if(file.get_size() < sizeof width + sizeof height){
+            throw(std::runtime_error("The file: '" + path + "' ends unexpectedly."));
+        }
+        std::memcpy(&width, data, sizeof width);
+        std::memcpy(&height, data + sizeof width, sizeof height);
+        if(width < 0 || height < 0){
+            throw(std::runtime_error("The file: '" + path + "' has a negative width or height."));
         }
 
-        if(count < (ceil(((double)height*(double)width/8)))*8){
-            delete[] bits;
+        std::uint64_t cells = (std::uint64_t) width * (std::uint64_t) height;
+        std::size_t bytes = (std::size_t) ((cells + 7) / 8);
+        if(file.get_size() - sizeof width - sizeof height < bytes){
             throw(std::runtime_error("The file: '" + path + "' ends unexpectedly."));
         }
+        const unsigned char* bits = data + sizeof width + sizeof height;
 
-        // Make the grid from the array.
+        Grid new_grid(width, height);
+        unsigned int row_words = new_grid.get_row_words();
         for(int j=0; j<height; j++){
-            for(int i=0; i<width; i++){
-                if(bits[(j*width)+i] == 0){
-                    new_grid.set(i,j,DEAD);
-                } else if(bits[(j*width)+i] == 1){
-                    new_grid.set(i,j,ALIVE);
-                }
+            std::uint64_t* row = new_grid.get_row(j);
+            std::uint64_t offset = (std::uint64_t) j * width;
+            if(width % 64 == 0 && is_little_endian()){
+                // Rows start on a byte boundary and fill whole words, so they already have the layout of a grid row.
+                std::memcpy(row, bits + offset / 8, (std::size_t) width / 8);
+                continue;
+            }
+            for(unsigned int k=0; k<row_words; k++){
+                row[k] = read_bits(bits, bytes, offset + (std::uint64_t) k * 64);
+            }
+            // The bits after the row belong to the next row, so clear them from the padding.
+            if(width % 64 != 0){
+                row[row_words - 1] &= ((std::uint64_t)1 << (width % 64)) - 1;
             }
         }
-
-        delete[] bits;
-        file.close();
         return new_grid;
     } else{
-        file.close();
         throw(std::runtime_error("The path given to function: Zoo::load_binary is incorrect."));
     }
 }
@@ -317,7 +871,8 @@ Grid Zoo::load_binary(const std::string& path){
  * Zoo::save_binary(path, grid)
  *
  * Save a grid as an binary .bgol file according to the specified file format.
- * Should be implemented using std::ofstream.
+ * The file is created at its final size and memory mapped with MappedFile, then the rows of the grid are
+ * packed into it a word of cells at a time.
  *
  * @example
  *
@@ -339,34 +894,505 @@ Grid Zoo::load_binary(const std::string& path){
  *      The grid to be written out to file.
  *
  * @throws
- *      Throws std::runtime_error or sub-class if the file cannot be opened.
+ *      Throws std::runtime_error or sub-class if the file cannot be opened, there is no room for it, or it
+ *      cannot be written.
  */
 void Zoo::save_binary(const std::string &path, const Grid &grid){
-    std::ofstream file(path);
+    GOL_STATS(IoTimer timer(path, true);)
+    int width = (int) grid.get_width();
+    int height = (int) grid.get_height();
+    std::uint64_t cells = (std::uint64_t) width * (std::uint64_t) height;
+    std::size_t bytes = (std::size_t) ((cells + 7) / 8);
+    MappedFile file(path, sizeof width + sizeof height + bytes);
     if(file){
-        int width = (int) grid.get_width();
-        int height = (int) grid.get_height();
-        file.write(reinterpret_cast<const char *>(&width), sizeof(width));
-        file.write(reinterpret_cast<const char *>(&height), sizeof(height));
-
-        // bitset buffer
-        std::bitset<8> bits;
-        unsigned int count=0;
-        for(unsigned int j=0; j<grid.get_height(); j++){
-            for(unsigned int i=0; i<grid.get_width(); i++){
-                // set bit in bitset to true if ALIVE, else false.
-                bits.set(count % 8, grid.get((int)i, (int)j) == Cell::ALIVE);
-                count++;
-
-                // once the bitset reaches 8 bits. write that byte into the file and reset the bitset array for next byte.
-                if(count % 8 == 0 || count == grid.get_total_cells()){
-                    file.write((char*)(&bits), 1);
-                    bits.reset();
-                }
+        unsigned char* data = file.get_data();
+        std::memcpy(data, &width, sizeof width);
+        std::memcpy(data + sizeof width, &height, sizeof height);
+        unsigned char* bits = data + sizeof width + sizeof height;
+
+        // The file starts zeroed, and padding bits of the grid are 0, so rows can be ORed in back to back.
+        for(int j=0; j<height; j++){
+            const std::uint64_t* row = grid.get_row(j);
+            std::uint64_t offset = (std::uint64_t) j * width;
+            if(width % 64 == 0 && is_little_endian()){
+                std::memcpy(bits + offset / 8, row, (std::size_t) width / 8);
+                continue;
+            }
+            for(unsigned int k=0; k<grid.get_row_words(); k++){
+                or_bits(bits, bytes, offset + (std::uint64_t) k * 64, row[k]);
             }
         }
+        file.close();
     } else{
         throw(std::runtime_error("The path given to function: Zoo::save_binary is incorrect."));
     }
+}
+
+/**
+ * Zoo::load_rle_header(path)
+ *
+ * Read the size and rule given on the header line of an RLE file without parsing its cells.
+ *
+ * @example
+ *
+ *      // Check the size of a pattern before loading it
+ *      Zoo::RleHeader header = Zoo::load_rle_header("path/to/file.rle");
+ *      std::cout << header.width << "x" << header.height << " " << header.rule << std::endl;
+ *
+ * @param path
+ *      The std::string path to the file to read in.
+ *
+ * @return
+ *      The width, height and rule of the pattern. The rule is "B3/S23" if the header does not give one.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if:
+ *          - The file cannot be opened.
+ *          - The header line is missing or malformed.
+ */
+Zoo::RleHeader Zoo::load_rle_header(const std::string& path){
+    return read_rle(path, nullptr, nullptr);
+}
+
+/**
+ * Zoo::load_rle(path)
+ *
+ * Load an RLE file as a grid the size given by its header.
+ * Each run of alive cells is set in the packed words of the grid a word at a time.
+ *
+ * @example
+ *
+ *      // Load an RLE file from a directory
+ *      Grid grid = Zoo::load_rle("path/to/file.rle");
+ *
+ * @param path
+ *      The std::string path to the file to read in.
+ *
+ * @return
+ *      Returns the parsed grid.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if:
+ *          - The file cannot be opened.
+ *          - The header line is missing or malformed, or its size is too large for a Grid.
+ *          - The file contains a tag other than 'b', 'o', '$' and '!'.
+ *          - An alive cell lies outside the width and height given by the header.
+ */
+Grid Zoo::load_rle(const std::string& path){
+    GOL_STATS(IoTimer timer(path, false);)
+    Grid new_grid;
+    read_rle(path, [&](const RleHeader& header){
+        if(header.width > INT_MAX || header.height > INT_MAX){
+            throw(std::runtime_error("The file: '" + path + "' holds a pattern too large for a Grid."));
+        }
+        new_grid = Grid((unsigned int) header.width, (unsigned int) header.height);
+    }, [&](long long x, long long y, long long length){
+        fill_run(new_grid.get_row((unsigned int) y), (std::uint64_t) x, (std::uint64_t) length);
+    });
+    return new_grid;
+}
+
+/**
+ * Zoo::load_rle(path, world, x0, y0)
+ *
+ * Load an RLE file into a SparseWorld, adding its alive cells with the top left of the pattern at (x0, y0).
+ * Only the alive cells are visited, so patterns far larger than any Grid can be loaded.
+ *
+ * @example
+ *
+ *      // Place a pattern from file around the origin of a sparse world
+ *      SparseWorld world;
+ *      Zoo::load_rle("path/to/file.rle", world, -100, -100);
+ *
+ * @param path
+ *      The std::string path to the file to read in.
+ *
+ * @param world
+ *      The world to add the pattern to.
+ *
+ * @param x0
+ *      The x coordinate of the top left cell of the pattern.
+ *
+ * @param y0
+ *      The y coordinate of the top left cell of the pattern.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if:
+ *          - The file cannot be opened.
+ *          - The header line is missing or malformed.
+ *          - The file contains a tag other than 'b', 'o', '$' and '!'.
+ *          - An alive cell lies outside the width and height given by the header.
+ *      Throws std::out_of_range if a cell is too far from the origin for a SparseWorld.
+ */
+void Zoo::load_rle(const std::string& path, SparseWorld& world, long long x0, long long y0){
+    GOL_STATS(IoTimer timer(path, false);)
+    read_rle(path, nullptr, [&](long long x, long long y, long long length){
+        for(long long i = 0; i < length; i++){
+            world.set(x0 + x + i, y0 + y, ALIVE);
+        }
+    });
+}
+
+/**
+ * Zoo::load_rle(path, life, x0, y0)
+ *
+ * Load an RLE file into a HashLife universe, adding its alive cells with the top left of the pattern at (x0, y0).
+ * Each band of 8 rows is collected into 8x8 blocks, and when the universe starts empty those blocks are placed
+ * straight into a quadtree the size of the pattern with HashLife::set_block.
+ *
+ * @example
+ *
+ *      // Advance a pattern from file a billion generations
+ *      HashLife life;
+ *      Zoo::load_rle("path/to/file.rle", life);
+ *      life.advance(1000000000);
+ *
+ * @param path
+ *      The std::string path to the file to read in.
+ *
+ * @param life
+ *      The universe to add the pattern to.
+ *
+ * @param x0
+ *      The x coordinate of the top left cell of the pattern.
+ *
+ * @param y0
+ *      The y coordinate of the top left cell of the pattern.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if:
+ *          - The file cannot be opened.
+ *          - The header line is missing or malformed.
+ *          - The file contains a tag other than 'b', 'o', '$' and '!'.
+ *          - An alive cell lies outside the width and height given by the header.
+ *      Throws std::overflow_error if the universe would grow too large to address.
+ */
+void Zoo::load_rle(const std::string& path, HashLife& life, long long x0, long long y0){
+    GOL_STATS(IoTimer timer(path, false);)
+    if(life.get_alive_cells() != 0){
+        read_rle(path, nullptr, [&](long long x, long long y, long long length){
+            for(long long i = 0; i < length; i++){
+                life.set(x0 + x + i, y0 + y, ALIVE);
+            }
+        });
+        return;
+    }
+
+    std::map<long long, std::array<unsigned char, 8>> blocks;
+    long long band = 0;
+    auto place_band = [&](){
+        for(const auto& block : blocks){
+            life.set_block(x0 + block.first * 8, y0 + band * 8, block.second.data());
+        }
+        blocks.clear();
+    };
+    read_rle(path, [&](const RleHeader& header){
+        unsigned int level = 3;
+        while(level < 62 && ((1LL << level) < header.width || (1LL << level) < header.height)){
+            level++;
+        }
+        life.set_root(life.get_empty(level), x0, y0);
+    }, [&](long long x, long long y, long long length){
+        if(y / 8 != band){
+            place_band();
+            band = y / 8;
+        }
+        for(long long end = x + length; x < end;){
+            long long next = std::min(end, (x / 8 + 1) * 8);
+            blocks[x / 8][y % 8] |= (unsigned char) (((1u << (next - x)) - 1) << (x % 8));
+            x = next;
+        }
+    });
+    place_band();
+}
+
+/**
+ * Zoo::save_rle(path, grid, rule)
+ *
+ * Save a grid as an RLE file. Runs are found a word of cells at a time, trailing dead cells in a row are left
+ * out, and runs of empty rows are merged into one count.
+ *
+ * @example
+ *
+ *      // Save a glider to an RLE file in a directory
+ *      try {
+ *          Zoo::save_rle("path/to/file.rle", Zoo::glider());
+ *      }
+ *      catch (const std::exception &ex) {
+ *          std::cerr << ex.what() << std::endl;
+ *      }
+ *
+ * @param path
+ *      The std::string path to the file to write to.
+ *
+ * @param grid
+ *      The grid to be written out to file.
+ *
+ * @param rule
+ *      The rule to name in the header line.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if the file cannot be opened.
+ */
+void Zoo::save_rle(const std::string& path, const Grid& grid, const std::string& rule){
+    GOL_STATS(IoTimer timer(path, true);)
+    std::ofstream file(path);
+    if(file){
+        file << "x = " << grid.get_width() << ", y = " << grid.get_height() << ", rule = " << rule << "\n";
+        RleLine body = {file, std::string()};
+        std::uint64_t rows_ended = 0;
+        for(unsigned int j = 0; j < grid.get_height(); j++){
+            const std::uint64_t* row = grid.get_row(j);
+            unsigned int x = find_bit(row, grid.get_width(), 0, true);
+            if(x < grid.get_width()){
+                body.write(rows_ended, '$');
+                rows_ended = 0;
+            }
+            for(unsigned int dead = 0; x < grid.get_width();){
+                unsigned int alive = find_bit(row, grid.get_width(), x, false);
+                body.write(x - dead, 'b');
+                body.write(alive - x, 'o');
+                dead = alive;
+                x = find_bit(row, grid.get_width(), alive, true);
+            }
+            rows_ended++;
+        }
+        body.write(1, '!');
+        file << body.line << "\n";
+    } else{
+        throw(std::runtime_error("The path given to function: Zoo::save_rle is incorrect."));
+    }
     file.close();
 }
+
+/**
+ * Zoo::load_macrocell(path)
+ *
+ * Load a Macrocell file as a HashLife universe. Every node line becomes one canonical node, so the universe
+ * is rebuilt in the size of the file rather than the size of the pattern. As in Golly, the root is centred on
+ * the cell (0, 0), the generation is read from the "#G" line, and the rule from the "#R" line.
+ *
+ * @example
+ *
+ *      // Load a universe saved by Golly and look at its middle
+ *      HashLife life = Zoo::load_macrocell("path/to/file.mc");
+ *      Grid middle = life.get_state(-32, -32, 32, 32);
+ *
+ * @param path
+ *      The std::string path to the file to read in.
+ *
+ * @return
+ *      Returns the parsed universe.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if:
+ *          - The file cannot be opened.
+ *          - The first line does not start with "[M2]".
+ *          - A leaf has a character other than '.', '*' and '$', or a cell outside its 8x8 square.
+ *          - A node line is malformed or refers to a node that is not defined above it at the level below.
+ *          - The root node is smaller than 8x8 cells, or there are no nodes.
+ *          - The "#R" line is not a Life-like rule in B/S notation, or gives birth on 0 neighbours.
+ */
+HashLife Zoo::load_macrocell(const std::string& path){
+    GOL_STATS(IoTimer timer(path, false);)
+    MappedFile file(path);
+    if(!file){
+        throw(std::runtime_error("The path given to function: Zoo::load_macrocell is incorrect."));
+    }
+    const unsigned char* data = file.get_data();
+    std::size_t size = file.get_size();
+    if(size < 4 || std::memcmp(data, "[M2]", 4) != 0){
+        throw(std::runtime_error("The file: '" + path + "' is not a Macrocell file."));
+    }
+
+    HashLife life;
+    std::vector<HashLife::NodeId> nodes(1, 0);
+    for(std::size_t position = end_of_line(data, size, 0) + 1; position < size;){
+        std::size_t end = end_of_line(data, size, position);
+        // Drop a carriage return so files written on Windows parse too.
+        std::size_t line_end = (end > position && data[end - 1] == '\r') ? end - 1 : end;
+        std::size_t line = position;
+        position = end + 1;
+        if(line == line_end){
+            continue;
+        }
+        if(data[line] == '#'){
+            if(line_end - line > 2 && data[line + 1] == 'G'){
+                long long generation;
+                std::size_t number = line + 2;
+                if(!parse_count(data, line_end, number, generation)){
+                    throw(std::runtime_error("The file: '" + path + "' has a malformed generation line."));
+                }
+                life.set_generation((std::uint64_t) generation);
+            } else if(line_end - line > 2 && data[line + 1] == 'R'){
+                std::string notation((const char*) data + line + 2, line_end - line - 2);
+                try{
+                    life.set_rule(Rule(notation));
+                } catch(std::invalid_argument&){
+                    throw(std::runtime_error("The file: '" + path + "' has a rule HashLife cannot simulate."));
+                }
+            }
+            continue;
+        }
+
+        if(data[line] == '.' || data[line] == '*' || data[line] == '$'){
+            unsigned char rows[8] = {0};
+            int x = 0;
+            int y = 0;
+            for(std::size_t i = line; i < line_end; i++){
+                if(data[i] == '$'){
+                    x = 0;
+                    y++;
+                } else if((data[i] == '.' || data[i] == '*') && x < 8 && y < 8){
+                    rows[y] |= (unsigned char) ((data[i] == '*') << x);
+                    x++;
+                } else{
+                    throw(std::runtime_error("The file: '" + path + "' has a malformed leaf."));
+                }
+            }
+            nodes.push_back(life.get_block(rows));
+            continue;
+        }
+
+        long long values[5];
+        std::size_t number = line;
+        for(long long& value : values){
+            if(!parse_count(data, line_end, number, value)){
+                throw(std::runtime_error("The file: '" + path + "' has a malformed node line."));
+            }
+        }
+        long long level = values[0];
+        if(level < 1 || level > 62){
+            throw(std::runtime_error("The file: '" + path + "' has a node line with an invalid level."));
+        }
+        HashLife::NodeId children[4];
+        for(int c = 0; c < 4; c++){
+            long long child = values[c + 1];
+            if(level == 1){
+                if(child > 1){
+                    throw(std::runtime_error("The file: '" + path + "' has a level 1 node with an invalid cell."));
+                }
+                children[c] = life.get_cell(child == 1);
+            } else if(child == 0){
+                children[c] = life.get_empty((unsigned int) level - 1);
+            } else if(child < (long long) nodes.size() && life.get_node(nodes[child]).level == level - 1){
+                children[c] = nodes[child];
+            } else{
+                throw(std::runtime_error("The file: '" + path + "' has a node that refers to an undefined node."));
+            }
+        }
+        nodes.push_back(life.join(children[0], children[1], children[2], children[3]));
+    }
+
+    if(nodes.size() == 1 || life.get_node(nodes.back()).level < 3){
+        throw(std::runtime_error("The file: '" + path + "' has no root node of 8x8 cells or larger."));
+    }
+    long long half = 1LL << (life.get_node(nodes.back()).level - 1);
+    life.set_root(nodes.back(), -half, -half);
+    return life;
+}
+
+/**
+ * Zoo::save_macrocell(path, life)
+ *
+ * Save a HashLife universe as a Macrocell file, written straight from its nodes so shared structure is
+ * written once. As in Golly, the saved root is centred on the cell (0, 0). When the universe is not already
+ * centred, the nodes that line up with the centred square are reused and the squares around them are built.
+ *
+ * @example
+ *
+ *      // Save a universe a trillion generations on
+ *      HashLife life(Zoo::r_pentomino());
+ *      life.advance(1000000000000ULL);
+ *      Zoo::save_macrocell("path/to/file.mc", life);
+ *
+ * @param path
+ *      The std::string path to the file to write to.
+ *
+ * @param life
+ *      The universe to be written out to file. Its rule is named on the "#R" line.
+ *
+ * @throws
+ *      Throws std::runtime_error or sub-class if:
+ *          - The file cannot be opened.
+ *          - The universe is too far from the origin to be centred.
+ */
+void Zoo::save_macrocell(const std::string& path, const HashLife& life){
+    GOL_STATS(IoTimer timer(path, true);)
+    std::ofstream file(path);
+    if(!file){
+        throw(std::runtime_error("The path given to function: Zoo::save_macrocell is incorrect."));
+    }
+    file << "[M2] (Game_of_Life)\n";
+    file << "#R " << life.get_rule().get_name() << "\n";
+    if(life.get_generation() != 0){
+        file << "#G " << life.get_generation() << "\n";
+    }
+
+    MacrocellWriter writer = {life, file, 0, {0, 0, 0, 0}, {}, {}};
+    unsigned int root_level = life.get_node(life.get_root()).level;
+    if(!life.get_bounds(writer.bounds[0], writer.bounds[1], writer.bounds[2], writer.bounds[3])){
+        file << std::max(root_level, 4u) << " 0 0 0 0\n";
+        return;
+    }
+
+    // Find the smallest centred square holding the root, then the largest nodes that line up with it.
+    long long x = life.get_origin_x();
+    long long y = life.get_origin_y();
+    auto holds_root = [&](unsigned int level){
+        long long half = 1LL << (level - 1);
+        return x >= -half && y >= -half && x <= half - (1LL << root_level) && y <= half - (1LL << root_level);
+    };
+    unsigned int level = root_level;
+    while(level < 62 && !holds_root(level)){
+        level++;
+    }
+    if(!holds_root(level)){
+        throw(std::runtime_error("The universe given to function: Zoo::save_macrocell is too far from the origin."));
+    }
+    std::uint64_t offset = (std::uint64_t) (x + (1LL << (level - 1))) | (std::uint64_t) (y + (1LL << (level - 1)));
+    unsigned int alignment = (offset == 0) ? root_level : std::min(root_level, (unsigned int) __builtin_ctzll(offset));
+    writer.alignment = (alignment >= 3) ? alignment : 0;
+    writer.write_square(level, -(1LL << (level - 1)), -(1LL << (level - 1)));
+}
+
+/**
+ * Zoo::get_io_stats()
+ *
+ * Gets the number and size of the files loaded and saved by Zoo on every thread, and the time they took.
+ * Only files that loaded or saved without an error are counted. Every value is zero when built with
+ * GOL_WITH_STATS=0.
+ *
+ * @example
+ *
+ *      // Print the load rate of the files read so far
+ *      Stats::IoStats io = Zoo::get_io_stats();
+ *      std::cout << io.bytes_loaded / io.load_seconds / 1e6 << " MB/s" << std::endl;
+ *
+ * @return
+ *      A copy of the totals.
+ */
+Stats::IoStats Zoo::get_io_stats(){
+    Stats::IoStats io;
+    io.files_loaded = files_loaded;
+    io.bytes_loaded = bytes_loaded;
+    io.load_seconds = (double) load_nanoseconds * 1e-9;
+    io.files_saved = files_saved;
+    io.bytes_saved = bytes_saved;
+    io.save_seconds = (double) save_nanoseconds * 1e-9;
+    return io;
+}
+
+/**
+ * Zoo::reset_io_stats()
+ *
+ * Set the totals of the files loaded and saved back to zero.
+ */
+void Zoo::reset_io_stats(){
+    files_loaded = 0;
+    bytes_loaded = 0;
+    load_nanoseconds = 0;
+    files_saved = 0;
+    bytes_saved = 0;
+    save_nanoseconds = 0;
+}
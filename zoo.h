@@ -15,11 +15,23 @@
 #include <string>
 #include "grid.h"
 #include "world.h"
+#include "hashlife.h"
+#include "sparse_world.h"
+#include "stats.h"
 
 /**
  * Declare the interface of the Zoo namespace for constructing lifeforms and saving and loading them from file.
  */
 namespace Zoo {
+    /**
+     * The size and rule given on the header line of an RLE file.
+     */
+    struct RleHeader {
+        long long width;
+        long long height;
+        std::string rule;
+    };
+
     // How to draw an owl:
     //      Step 1. Draw a circle.
     //      Step 2. Draw the rest of the owl.
@@ -30,5 +42,14 @@ namespace Zoo {
     void save_ascii(const std::string& path, const Grid& grid);
     Grid load_binary(const std::string& path);
     void save_binary(const std::string& path, const Grid& grid);
+    RleHeader load_rle_header(const std::string& path);
+    Grid load_rle(const std::string& path);
+    void load_rle(const std::string& path, SparseWorld& world, long long x0 = 0, long long y0 = 0);
+    void load_rle(const std::string& path, HashLife& life, long long x0 = 0, long long y0 = 0);
+    void save_rle(const std::string& path, const Grid& grid, const std::string& rule = "B3/S23");
+    HashLife load_macrocell(const std::string& path);
+    void save_macrocell(const std::string& path, const HashLife& life);
+    Stats::IoStats get_io_stats();
+    void reset_io_stats();
 
 };
\ No newline at end of file